@@ -0,0 +1,110 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/basic_observers.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+thread_local uint64_t notifications{0};
+
+struct Observer
+{
+    void notify() { ++notifications; }
+};
+
+struct Observers : mir::BasicObservers<Observer>
+{
+    using BasicObservers::add;
+    using BasicObservers::remove;
+
+    void notify()
+    {
+        for_each([](std::shared_ptr<Observer> const& observer) { observer->notify(); });
+    }
+};
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 4)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <number of threads> <notifications per thread> <number of observers>"<<std::endl;
+        exit(1);
+    }
+
+    int const thread_count = std::atoi(argv[1]);
+    uint64_t const notification_count = std::atoll(argv[2]);
+    int const observer_count = std::atoi(argv[3]);
+
+    Observers observers;
+    for (int i = 0; i < observer_count; ++i)
+    {
+        observers.add(std::make_shared<Observer>());
+    }
+
+    // Keep one observer coming and going, as surfaces and input devices do
+    std::atomic<bool> notifying{true};
+    uint64_t churn_count{0};
+    std::thread churn{[&]
+        {
+            while (notifying)
+            {
+                auto const observer = std::make_shared<Observer>();
+                observers.add(observer);
+                observers.remove(observer);
+                ++churn_count;
+            }
+        }};
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> notifiers;
+    for (int i = 0; i < thread_count; ++i)
+    {
+        notifiers.emplace_back([&]
+        {
+            for (uint64_t n = 0; n != notification_count; ++n)
+            {
+                observers.notify();
+            }
+        });
+    }
+
+    for (auto& thread : notifiers)
+    {
+        thread.join();
+    }
+
+    auto duration = std::chrono::steady_clock::now() - start;
+
+    notifying = false;
+    churn.join();
+
+    auto const total = thread_count * notification_count;
+    auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    std::cout<<"Notifying "<<observer_count<<" observers "<<total<<" times from "<<thread_count<<" threads took "
+             <<ns<<"ns ("<<ns / std::max<uint64_t>(total, 1)<<"ns per notification, "
+             <<churn_count<<" observers added and removed meanwhile)"<<std::endl;
+    exit(0);
+}
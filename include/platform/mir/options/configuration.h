@@ -43,6 +43,8 @@ extern char const* const connector_report_opt;
 extern char const* const scene_report_opt;
 extern char const* const input_report_opt;
 extern char const* const seat_report_opt;
+extern char const* const metrics_socket_opt;
+extern char const* const trace_file_opt;
 extern char const* const touchspots_opt;
 extern char const* const cursor_opt;
 extern char const* const fatal_except_opt;
@@ -55,12 +57,19 @@ extern char const* const enable_mirclient_opt;
 
 extern char const* const name_opt;
 extern char const* const offscreen_opt;
+extern char const* const renderer_opt;
+extern char const* const gl_program_cache_opt;
+extern char const* const offscreen_frame_export_opt;
 
 extern char const* const enable_key_repeat_opt;
 
 extern char const* const off_opt_value;
 extern char const* const log_opt_value;
 extern char const* const lttng_opt_value;
+extern char const* const metrics_opt_value;
+extern char const* const trace_opt_value;
+extern char const* const gl_renderer_opt_value;
+extern char const* const software_renderer_opt_value;
 
 extern char const* const platform_graphics_lib;
 extern char const* const platform_input_lib;
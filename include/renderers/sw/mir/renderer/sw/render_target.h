@@ -0,0 +1,68 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_SW_RENDER_TARGET_H_
+#define MIR_RENDERER_SW_RENDER_TARGET_H_
+
+#include "mir/geometry/dimensions.h"
+#include "mir/geometry/rectangle.h"
+#include "mir/geometry/size.h"
+
+#include <vector>
+
+namespace mir
+{
+namespace renderer
+{
+namespace software
+{
+
+/**
+ * A CPU-addressable framebuffer for the software renderer.
+ *
+ * Pixels are 32-bit XRGB in native byte order (mir_pixel_format_xrgb_8888).
+ * The framebuffer keeps its contents between frames, so a renderer only
+ * needs to redraw the regions that changed.
+ */
+class RenderTarget
+{
+public:
+    virtual ~RenderTarget() = default;
+
+    /** Size of the framebuffer in pixels */
+    virtual geometry::Size size() const = 0;
+    /** Distance in bytes between the starts of consecutive rows */
+    virtual geometry::Stride stride() const = 0;
+    /** The framebuffer to draw into */
+    virtual unsigned char* pixels() = 0;
+    /**
+     * Publishes the contents of the framebuffer.
+     * \param [in] damage The regions redrawn since the previous commit, in
+     *                    framebuffer coordinates.
+     */
+    virtual void commit(std::vector<geometry::Rectangle> const& damage) = 0;
+
+protected:
+    RenderTarget() = default;
+    RenderTarget(RenderTarget const&) = delete;
+    RenderTarget& operator=(RenderTarget const&) = delete;
+};
+
+}
+}
+}
+
+#endif /* MIR_RENDERER_SW_RENDER_TARGET_H_ */
@@ -20,10 +20,12 @@
 #ifndef MIR_THREAD_SAFE_LIST_H_
 #define MIR_THREAD_SAFE_LIST_H_
 
-#include "mir/recursive_read_write_mutex.h"
-
 #include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace mir
 {
@@ -45,6 +47,16 @@ namespace mir
  *    - Element{}: value initialization should create an invalid element
  */
 
+/*
+ * for_each() never blocks: it takes no locks, and an element that is being
+ * changed at that moment is skipped. Changes (add(), remove(), remove_all()
+ * and clear()) are serialised against each other.
+ *
+ * The functor passed to for_each() may change the list, including removing
+ * the element it was called with. Once remove(), remove_all() or clear() has
+ * returned, the removed elements are no longer in use by for_each() on any
+ * other thread.
+ */
 template<class Element>
 class ThreadSafeList
 {
@@ -59,127 +71,224 @@ private:
     struct ListItem
     {
         ListItem() {}
-        RecursiveReadWriteMutex mutex;
         Element element{};
+        // Set while element is being changed: readers skip the item
+        std::atomic<bool> changing{false};
+        // Readers in the middle of copying element
+        std::atomic<unsigned> copying{0};
+        // for_each() calls that are using a copy of element
+        std::atomic<unsigned> in_use{0};
         std::atomic<ListItem*> next{nullptr};
 
         ~ListItem() { delete next.load(); }
     } head;
+
+    // The items for_each() is using on this thread, innermost first
+    struct Use
+    {
+        Use(ThreadSafeList* list, ListItem* item);
+        ~Use();
+
+        ThreadSafeList* const list;
+        ListItem* const item;
+        Use const* const outer;
+    };
+    static thread_local Use const* uses_on_this_thread;
+
+    Element change(ListItem& item, Element const& element);
+    void wait_until_unused(ListItem& item);
+
+    std::mutex change_mutex;
+
+    std::mutex unused_mutex;
+    std::condition_variable unused;
+    std::atomic<unsigned> waiting_until_unused{0};
 };
 
+template<class Element>
+thread_local typename ThreadSafeList<Element>::Use const* ThreadSafeList<Element>::uses_on_this_thread{nullptr};
+
+template<class Element>
+ThreadSafeList<Element>::Use::Use(ThreadSafeList* list, ListItem* item)
+    : list{list},
+      item{item},
+      outer{uses_on_this_thread}
+{
+    uses_on_this_thread = this;
+}
+
+template<class Element>
+ThreadSafeList<Element>::Use::~Use()
+{
+    uses_on_this_thread = outer;
+
+    --item->in_use;
+
+    if (list->waiting_until_unused)
+    {
+        std::lock_guard<decltype(list->unused_mutex)> lock{list->unused_mutex};
+        list->unused.notify_all();
+    }
+}
+
 template<class Element>
 void ThreadSafeList<Element>::for_each(
     std::function<void(Element const& element)> const& f)
 {
-    ListItem* current_item = &head;
-
-    while (current_item)
+    for (ListItem* current_item = &head; current_item; current_item = current_item->next)
     {
-        RecursiveReadLock lock{current_item->mutex};
+        ++current_item->copying;
+
+        if (current_item->changing)
+        {
+            --current_item->copying;
+            continue;
+        }
 
         // We need to take a copy in case we recursively remove during call
-        if (auto const copy_of_element = current_item->element) f(copy_of_element);
+        auto const copy_of_element = current_item->element;
+        if (copy_of_element) ++current_item->in_use;
 
-        current_item = current_item->next;
+        --current_item->copying;
+
+        if (copy_of_element)
+        {
+            Use const use{this, current_item};
+            f(copy_of_element);
+        }
     }
 }
 
 template<class Element>
 void ThreadSafeList<Element>::add(Element const& element)
 {
+    std::lock_guard<decltype(change_mutex)> lock{change_mutex};
+
     ListItem* current_item = &head;
 
-    do
+    for (;; current_item = current_item->next)
     {
-        // Note: we release the read lock to avoid two threads calling add at
-        // the same time mutually blocking the other's upgrade to write lock.
+        // An item still in use by for_each() may have a remove() waiting on it
+        if (!current_item->element && !current_item->in_use)
         {
-            RecursiveReadLock lock{current_item->mutex};
-            if (current_item->element) continue;
-        }
-
-        RecursiveWriteLock lock{current_item->mutex};
-
-        if (!current_item->element)
-        {
-            current_item->element = element;
+            change(*current_item, element);
             return;
         }
+
+        if (!current_item->next) break;
     }
-    while (current_item->next && (current_item = current_item->next));
 
     // No empty Items so append a new one
     auto new_item = new ListItem;
     new_item->element = element;
-
-    for (ListItem* expected{nullptr};
-        !current_item->next.compare_exchange_weak(expected, new_item);
-        expected = nullptr)
-    {
-        if (expected) current_item = expected;
-    }
+    current_item->next = new_item;
 }
 
 template<class Element>
 void ThreadSafeList<Element>::remove(Element const& element)
 {
-    ListItem* current_item = &head;
+    // Destroyed after unlocking, in case that calls back into the list
+    Element removed{};
+    ListItem* removed_from{nullptr};
 
-    do
     {
-        {
-            RecursiveReadLock lock{current_item->mutex};
-            if (current_item->element != element) continue;
-        }
+        std::lock_guard<decltype(change_mutex)> lock{change_mutex};
 
-        RecursiveWriteLock lock{current_item->mutex};
-
-        if (current_item->element == element)
+        for (ListItem* current_item = &head; current_item; current_item = current_item->next)
         {
-            current_item->element = Element{};
-            return;
+            if (current_item->element == element)
+            {
+                removed = change(*current_item, Element{});
+                removed_from = current_item;
+                break;
+            }
         }
     }
-    while ((current_item = current_item->next));
+
+    if (removed_from) wait_until_unused(*removed_from);
 }
 
 template<class Element>
 unsigned int ThreadSafeList<Element>::remove_all(Element const& element)
 {
-    ListItem* current_item = &head;
-    auto removed = 0u;
+    std::vector<Element> removed;
+    std::vector<ListItem*> removed_from;
 
-    do
     {
+        std::lock_guard<decltype(change_mutex)> lock{change_mutex};
+
+        for (ListItem* current_item = &head; current_item; current_item = current_item->next)
         {
-            RecursiveReadLock lock{current_item->mutex};
-            if (current_item->element != element) continue;
+            if (current_item->element == element)
+            {
+                removed.push_back(change(*current_item, Element{}));
+                removed_from.push_back(current_item);
+            }
         }
+    }
+
+    for (auto const item : removed_from)
+        wait_until_unused(*item);
+
+    return removed.size();
+}
 
-        RecursiveWriteLock lock{current_item->mutex};
+template<class Element>
+void ThreadSafeList<Element>::clear()
+{
+    std::vector<Element> removed;
+    std::vector<ListItem*> removed_from;
 
-        if (current_item->element == element)
+    {
+        std::lock_guard<decltype(change_mutex)> lock{change_mutex};
+
+        for (ListItem* current_item = &head; current_item; current_item = current_item->next)
         {
-            current_item->element = Element{};
-            ++removed;
+            if (current_item->element)
+            {
+                removed.push_back(change(*current_item, Element{}));
+                removed_from.push_back(current_item);
+            }
         }
     }
-    while ((current_item = current_item->next));
 
-    return removed;
+    for (auto const item : removed_from)
+        wait_until_unused(*item);
 }
 
 template<class Element>
-void ThreadSafeList<Element>::clear()
+Element ThreadSafeList<Element>::change(ListItem& item, Element const& element)
 {
-    ListItem* current_item = &head;
+    item.changing = true;
+
+    // Readers only hold this for as long as it takes to copy an element
+    while (item.copying)
+        std::this_thread::yield();
 
-    do
+    auto previous = item.element;
+    item.element = element;
+
+    item.changing = false;
+
+    return previous;
+}
+
+template<class Element>
+void ThreadSafeList<Element>::wait_until_unused(ListItem& item)
+{
+    // Uses further up this thread's stack can't finish until we return
+    unsigned int uses_by_this_thread{0};
+    for (auto use = uses_on_this_thread; use; use = use->outer)
     {
-        RecursiveWriteLock lock{current_item->mutex};
-        current_item->element = Element{};
+        if (use->item == &item) ++uses_by_this_thread;
     }
-    while ((current_item = current_item->next));
+
+    if (item.in_use == uses_by_this_thread) return;
+
+    std::unique_lock<decltype(unused_mutex)> lock{unused_mutex};
+    ++waiting_until_unused;
+    unused.wait(lock, [&]{ return item.in_use == uses_by_this_thread; });
+    --waiting_until_unused;
 }
 
 }
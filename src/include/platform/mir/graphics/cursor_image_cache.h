@@ -0,0 +1,108 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MIR_GRAPHICS_CURSOR_IMAGE_CACHE_H_
+#define MIR_GRAPHICS_CURSOR_IMAGE_CACHE_H_
+
+#include "mir/graphics/cursor_image.h"
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+/**
+ * A small least-recently-used cache of things prepared from cursor images
+ *
+ * Images are matched by size and pixels, not by identity: the same cursor reaches us through many CursorImage
+ * instances (each client setting it supplies its own) and an image's address may be reused once it is freed. The
+ * hotspot is not part of the key, as nothing derived from the pixels depends on it.
+ */
+template<typename Value>
+class CursorImageCache
+{
+public:
+    /// Enough for the handful of cursors a pointer typically moves between (arrow, text, hand, resize...)
+    static constexpr size_t default_capacity{4};
+
+    explicit CursorImageCache(size_t capacity = default_capacity)
+        : capacity{capacity}
+    {
+    }
+
+    /// The value prepared for an image with the same contents, calling create() to make it if there is none
+    auto get(CursorImage const& image, std::function<Value()> const& create) -> Value&
+    {
+        auto const size = image.size();
+        auto const pixels = static_cast<uint8_t const*>(image.as_argb_8888());
+        auto const bytes = size.width.as_uint32_t() * size.height.as_uint32_t() * 4;
+        auto const hash = hash_of(pixels, bytes);
+
+        for (auto entry = entries.begin(); entry != entries.end(); ++entry)
+        {
+            if (entry->hash == hash &&
+                entry->size == size &&
+                memcmp(entry->pixels.data(), pixels, bytes) == 0)
+            {
+                entries.splice(entries.begin(), entries, entry);
+                return entries.front().value;
+            }
+        }
+
+        auto value = create();
+
+        if (entries.size() >= capacity)
+            entries.pop_back();
+
+        entries.push_front(Entry{hash, size, {pixels, pixels + bytes}, std::move(value)});
+        return entries.front().value;
+    }
+
+private:
+    struct Entry
+    {
+        uint64_t hash;
+        geometry::Size size;
+        std::vector<uint8_t> pixels;
+        Value value;
+    };
+
+    /// FNV-1a; cheap enough to run over a cursor image on every change, and a mismatch is then caught without a
+    /// full comparison against each entry
+    static auto hash_of(uint8_t const* data, size_t bytes) -> uint64_t
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (auto i = data; i != data + bytes; ++i)
+        {
+            hash ^= *i;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    size_t const capacity;
+    std::list<Entry> entries; ///< Most recently used first
+};
+}
+}
+
+#endif /* MIR_GRAPHICS_CURSOR_IMAGE_CACHE_H_ */
@@ -92,6 +92,7 @@ namespace detail { class FrontendShell; }
 namespace time
 {
 class Clock;
+class AlarmFactory;
 }
 namespace scene
 {
@@ -119,6 +120,7 @@ class Display;
 class DisplayReport;
 class DisplayConfigurationObserver;
 class GraphicBufferAllocator;
+class VsyncPresentationClock;
 class Cursor;
 class CursorImage;
 class GLConfig;
@@ -161,6 +163,14 @@ class Configuration;
 namespace report
 {
 class ReportFactory;
+namespace metrics
+{
+class Registry;
+}
+namespace trace
+{
+class Tracer;
+}
 }
 
 namespace renderer
@@ -360,12 +370,19 @@ public:
     /** @} */
 
     virtual std::shared_ptr<time::Clock> the_clock();
+    virtual std::shared_ptr<time::AlarmFactory> the_alarm_factory();
     virtual std::shared_ptr<ServerActionQueue> the_server_action_queue();
     virtual std::shared_ptr<SharedLibraryProberReport>  the_shared_library_prober_report();
 
     virtual std::shared_ptr<ConsoleServices> the_console_services();
     auto default_reports() -> std::shared_ptr<void>;
 
+    /// The metrics updated by "metrics" reports and served on the metrics socket
+    auto the_metrics_registry() -> std::shared_ptr<report::metrics::Registry>;
+
+    /// The timeline recorded by "trace" reports
+    auto the_tracer() -> std::shared_ptr<report::trace::Tracer>;
+
 private:
     // We need to ensure the platform library is destroyed last as the
     // DisplayConfiguration can hold weak_ptrs to objects created from the library
@@ -380,6 +397,7 @@ protected:
     std::shared_ptr<frontend::SessionMediatorObserver> the_session_mediator_observer();
 
     virtual std::shared_ptr<scene::MediatingDisplayChanger> the_mediating_display_changer();
+    virtual std::shared_ptr<graphics::VsyncPresentationClock> the_presentation_clock();
     virtual std::shared_ptr<frontend::ProtobufIpcFactory> new_ipc_factory(
         std::shared_ptr<frontend::SessionAuthorizer> const& session_authorizer);
 
@@ -447,7 +465,9 @@ protected:
     CachedPtr<compositor::CompositorReport> compositor_report;
     CachedPtr<logging::Logger> logger;
     CachedPtr<graphics::DisplayReport> display_report;
+    CachedPtr<graphics::VsyncPresentationClock> presentation_clock;
     CachedPtr<time::Clock> clock;
+    CachedPtr<time::AlarmFactory> alarm_factory;
     CachedPtr<MainLoop> main_loop;
     CachedPtr<ServerStatusListener> server_status_listener;
     CachedPtr<graphics::DisplayConfigurationPolicy> display_configuration_policy;
@@ -489,6 +509,8 @@ private:
     std::shared_ptr<scene::BroadcastingSessionEventSink> the_broadcasting_session_event_sink();
 
     auto report_factory(char const* report_opt) -> std::unique_ptr<report::ReportFactory>;
+    CachedPtr<report::metrics::Registry> metrics_registry;
+    CachedPtr<report::trace::Tracer> tracer;
 
     CachedPtr<shell::detail::FrontendShell> frontend_shell;
     std::vector<mir::ExtensionDescription> the_extensions();
@@ -0,0 +1,63 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_PRESENTATION_CLOCK_H_
+#define MIR_GRAPHICS_PRESENTATION_CLOCK_H_
+
+#include "mir/graphics/frame.h"
+
+#include <chrono>
+#include <functional>
+
+namespace mir
+{
+namespace graphics
+{
+/**
+ * Source of the times at which composited frames reach the screen
+ */
+class PresentationClock
+{
+public:
+    struct Presentation
+    {
+        Frame frame;                        ///< Time (in CLOCK_MONOTONIC) and counter of the flip
+        std::chrono::nanoseconds refresh;   ///< Predicted time to the following flip, or zero if unknown
+        bool vsync;                         ///< Whether frame came from a page flip rather than "now"
+    };
+
+    /**
+     * Call \a handler once, with the timing of the next page flip of the
+     * output composited by the calling thread.
+     *
+     * This is meant to be called as a buffer is consumed, from the compositor
+     * thread consuming it. If the platform has not reported any page flips
+     * the handler is called immediately with the current time. Otherwise it
+     * is called from the thread reporting the flip (or from a timer, should
+     * the flip not come), so it must not block.
+     */
+    virtual void on_next_presentation(std::function<void(Presentation const&)> const& handler) = 0;
+
+protected:
+    PresentationClock() = default;
+    virtual ~PresentationClock() = default;
+    PresentationClock(PresentationClock const&) = delete;
+    PresentationClock& operator=(PresentationClock const&) = delete;
+};
+}
+}
+
+#endif /* MIR_GRAPHICS_PRESENTATION_CLOCK_H_ */
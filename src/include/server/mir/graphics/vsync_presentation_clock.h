@@ -0,0 +1,102 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_VSYNC_PRESENTATION_CLOCK_H_
+#define MIR_GRAPHICS_VSYNC_PRESENTATION_CLOCK_H_
+
+#include "mir/graphics/display_report.h"
+#include "mir/graphics/presentation_clock.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace time
+{
+class Alarm;
+class AlarmFactory;
+}
+
+namespace graphics
+{
+/**
+ * A PresentationClock driven by the page flips platforms report through DisplayReport
+ *
+ * All reports are forwarded to the wrapped DisplayReport.
+ *
+ * Handlers wait for the next flip reported from the thread that registers
+ * them. Platforms report flips from the thread compositing the output(s)
+ * that flipped, and that thread is also the one consuming the buffers shown
+ * on them, so this is the flip of the output the buffer was presented on.
+ * Handlers registered from a thread that has not reported a flip wait for a
+ * flip of any output. If no flip comes within \a flip_timeout the handlers
+ * are called with the current time instead.
+ */
+class VsyncPresentationClock : public DisplayReport, public PresentationClock
+{
+public:
+    VsyncPresentationClock(
+        std::shared_ptr<DisplayReport> const& wrapped,
+        std::shared_ptr<time::AlarmFactory> const& alarm_factory,
+        std::chrono::milliseconds flip_timeout = std::chrono::milliseconds{100});
+    ~VsyncPresentationClock();
+
+    void report_successful_setup_of_native_resources() override;
+    void report_successful_egl_make_current_on_construction() override;
+    void report_successful_egl_buffer_swap_on_construction() override;
+    void report_successful_display_construction() override;
+    void report_egl_configuration(EGLDisplay disp, EGLConfig cfg) override;
+    void report_vsync(unsigned int output_id, Frame const& frame) override;
+    void report_successful_drm_mode_set_crtc_on_construction() override;
+    void report_drm_master_failure(int error) override;
+    void report_vt_switch_away_failure() override;
+    void report_vt_switch_back_failure() override;
+
+    void on_next_presentation(std::function<void(Presentation const&)> const& handler) override;
+
+private:
+    using Handler = std::function<void(Presentation const&)>;
+
+    struct Pending
+    {
+        std::vector<Handler> handlers;
+        uint64_t generation{0};                 ///< Incremented each time handlers are called
+        std::unique_ptr<time::Alarm> timeout;   ///< For the handlers of this generation
+    };
+
+    void start_timeout(unsigned int output_id, uint64_t generation);
+    void present_without_flip(unsigned int output_id, uint64_t generation);
+
+    uint64_t const id;  ///< Tells this clock's reports apart from others' in a thread's record
+    std::shared_ptr<DisplayReport> const wrapped;
+    std::shared_ptr<time::AlarmFactory> const alarm_factory;
+    std::chrono::milliseconds const flip_timeout;
+
+    std::mutex mutex;
+    bool flips_reported{false};
+    std::unordered_map<unsigned int, Frame> last_frame;
+    /// By the first output reported from the thread waiting for a flip, which outlives that thread
+    std::unordered_map<unsigned int, Pending> pending;
+};
+}
+}
+
+#endif /* MIR_GRAPHICS_VSYNC_PRESENTATION_CLOCK_H_ */
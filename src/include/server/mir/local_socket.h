@@ -0,0 +1,37 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_LOCAL_SOCKET_H_
+#define MIR_LOCAL_SOCKET_H_
+
+#include "mir/fd.h"
+
+#include <string>
+
+namespace mir
+{
+/**
+ *  Listen for connections on a non-blocking unix stream socket at \a path,
+ *  replacing any socket left there and restricting it to the current user.
+ *  \a description names the socket's purpose in errors (e.g. "metrics").
+ *
+ *  \throws std::invalid_argument if \a path doesn't fit a socket address
+ *  \throws std::system_error if the socket can't be set up
+ */
+auto listen_on_local_socket(std::string const& path, std::string const& description) -> Fd;
+}
+
+#endif /* MIR_LOCAL_SOCKET_H_ */
@@ -20,9 +20,10 @@
 #define MIR_SCENE_SESSION_CONTAINER_H_
 
 #include <functional>
-#include <vector>
+#include <list>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
 
 namespace mir
 {
@@ -50,7 +51,11 @@ public:
     SessionContainer& operator=(const SessionContainer&) = delete;
 
 private:
-    std::vector<std::shared_ptr<Session>> apps;
+    using Sessions = std::list<std::shared_ptr<Session>>;
+
+    Sessions apps;
+    /// The position of each session in apps
+    std::unordered_map<Session const*, Sessions::iterator> index;
     mutable std::mutex guard;
 };
 
@@ -0,0 +1,71 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_TIME_TIMER_WHEEL_H_
+#define MIR_TIME_TIMER_WHEEL_H_
+
+#include "mir/time/alarm_factory.h"
+#include "mir/time/types.h"
+
+#include <chrono>
+#include <memory>
+
+namespace mir
+{
+namespace graphics
+{
+class EventHandlerRegister;
+}
+
+namespace time
+{
+class Clock;
+
+/**
+ * An AlarmFactory whose alarms share a single timerfd
+ *
+ * Pending alarms are kept in a hierarchical timing wheel, so scheduling and
+ * cancelling are O(1) regardless of how many alarms are outstanding. When
+ * the timerfd fires every alarm that has come due is dispatched in one batch
+ * from the thread servicing the EventHandlerRegister.
+ *
+ * Alarm deadlines are rounded up to the next tick, so an alarm never fires
+ * early but may fire up to one tick late.
+ */
+class TimerWheel : public AlarmFactory
+{
+public:
+    TimerWheel(
+        std::shared_ptr<graphics::EventHandlerRegister> const& event_register,
+        std::shared_ptr<Clock> const& clock,
+        std::chrono::milliseconds tick = std::chrono::milliseconds{1});
+    ~TimerWheel() override;
+
+    std::unique_ptr<Alarm> create_alarm(std::function<void()> const& callback) override;
+    std::unique_ptr<Alarm> create_alarm(std::unique_ptr<LockableCallback> callback) override;
+
+private:
+    class Wheel;
+    class AlarmImpl;
+
+    std::shared_ptr<Clock> const clock;
+    std::shared_ptr<Wheel> const wheel;
+};
+
+}
+}
+
+#endif // MIR_TIME_TIMER_WHEEL_H_
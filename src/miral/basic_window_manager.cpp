@@ -91,13 +91,13 @@ miral::BasicWindowManager::~BasicWindowManager()
 void miral::BasicWindowManager::add_session(std::shared_ptr<scene::Session> const& session)
 {
     Locker lock{this};
-    policy->advise_new_app(app_info[session] = ApplicationInfo(session));
+    policy->advise_new_app(app_info[session.get()] = ApplicationInfo(session));
 }
 
 void miral::BasicWindowManager::remove_session(std::shared_ptr<scene::Session> const& session)
 {
     Locker lock{this};
-    auto info = app_info.find(session);
+    auto info = app_info.find(session.get());
     if (info == app_info.end())
     {
         log_debug(
@@ -107,7 +107,7 @@ void miral::BasicWindowManager::remove_session(std::shared_ptr<scene::Session> c
         return;
     }
     policy->advise_delete_app(info->second);
-    app_info.erase(session);
+    app_info.erase(info);
 }
 
 auto miral::BasicWindowManager::add_surface(
@@ -132,7 +132,7 @@ auto miral::BasicWindowManager::add_surface(
     spec.update(parameters);
     auto const surface = build(session, parameters);
     Window const window{session, surface};
-    auto& window_info = this->window_info.emplace(window, WindowInfo{window, spec}).first->second;
+    auto& window_info = this->window_info.emplace(surface.get(), WindowInfo{window, spec}).first->second;
 
     if (spec.parent().is_set() && spec.parent().value().lock())
         window_info.parent(info_for(spec.parent().value()).window());
@@ -196,7 +196,7 @@ void miral::BasicWindowManager::remove_surface(
     std::weak_ptr<scene::Surface> const& surface)
 {
     Locker lock{this};
-    if (app_info.find(session) == app_info.end())
+    if (app_info.find(session.get()) == app_info.end())
     {
         log_debug(
             "BasicWindowManager::remove_surface() called with unknown or already removed session %s (PID: %d)",
@@ -214,6 +214,8 @@ void miral::BasicWindowManager::remove_surface(
 void miral::BasicWindowManager::remove_window(Application const& application, miral::WindowInfo const& info)
 {
     bool const is_active_window{mru_active_windows.top() == info.window()};
+    // The surface may not outlive destroy_surface() (e.g. on force_close()), so take its key now
+    auto const key = std::shared_ptr<scene::Surface>(info.window()).get();
     auto const workspaces_containing_window = workspaces_containing(info.window());
 
     {
@@ -244,7 +246,7 @@ void miral::BasicWindowManager::remove_window(Application const& application, mi
 
     // NB erase() invalidates info, but we want to keep access to "parent".
     auto const parent = info.parent();
-    erase(info);
+    erase(info, key);
 
     if (is_active_window)
     {
@@ -310,7 +312,7 @@ void miral::BasicWindowManager::refocus(
     focus_next_application();
 }
 
-void miral::BasicWindowManager::erase(miral::WindowInfo const& info)
+void miral::BasicWindowManager::erase(miral::WindowInfo const& info, scene::Surface const* key)
 {
     if (auto const parent = info.parent())
         info_for(parent).remove_child(info.window());
@@ -318,7 +320,7 @@ void miral::BasicWindowManager::erase(miral::WindowInfo const& info)
     for (auto& child : info.children())
         info_for(child).parent({});
 
-    window_info.erase(info.window());
+    window_info.erase(key);
 }
 
 #pragma GCC diagnostic push
@@ -506,7 +508,7 @@ auto miral::BasicWindowManager::find_application(std::function<bool(ApplicationI
     {
         if (predicate(info.second))
         {
-            return Application{info.first};
+            return info.second.application();
         }
     }
 
@@ -516,13 +518,13 @@ auto miral::BasicWindowManager::find_application(std::function<bool(ApplicationI
 auto miral::BasicWindowManager::info_for(std::weak_ptr<scene::Session> const& session) const
 -> ApplicationInfo&
 {
-    return const_cast<ApplicationInfo&>(app_info.at(session));
+    return const_cast<ApplicationInfo&>(app_info.at(session.lock().get()));
 }
 
 auto miral::BasicWindowManager::info_for(std::weak_ptr<scene::Surface> const& surface) const
 -> WindowInfo&
 {
-    return const_cast<WindowInfo&>(window_info.at(surface));
+    return const_cast<WindowInfo&>(window_info.at(surface.lock().get()));
 }
 
 auto miral::BasicWindowManager::info_for(Window const& window) const
@@ -1655,7 +1657,7 @@ auto miral::BasicWindowManager::surface_known(
     std::weak_ptr<scene::Surface> const& surface,
     std::string const& action) -> bool
 {
-    if (window_info.find(surface) != window_info.end())
+    if (window_info.find(surface.lock().get()) != window_info.end())
     {
         return true;
     }
@@ -39,8 +39,9 @@
 #include <boost/bimap/multiset_of.hpp>
 #include <experimental/optional>
 
-#include <map>
 #include <mutex>
+#include <set>
+#include <unordered_map>
 
 namespace mir
 {
@@ -218,8 +219,12 @@ private:
         std::set<Window> attached_windows; ///< Maximized/anchored/etc windows attached to this area
     };
 
-    using SurfaceInfoMap = std::map<std::weak_ptr<mir::scene::Surface>, WindowInfo, std::owner_less<std::weak_ptr<mir::scene::Surface>>>;
-    using SessionInfoMap = std::map<std::weak_ptr<mir::scene::Session>, ApplicationInfo, std::owner_less<std::weak_ptr<mir::scene::Session>>>;
+    /// Keyed by the address of the surface or session. A surface can go before its entry is erased,
+    /// so the key is taken while it is still alive (see remove_window())
+    /// @{
+    using SurfaceInfoMap = std::unordered_map<mir::scene::Surface const*, WindowInfo>;
+    using SessionInfoMap = std::unordered_map<mir::scene::Session const*, ApplicationInfo>;
+    /// @}
 
     mir::shell::FocusController* const focus_controller;
     std::shared_ptr<mir::shell::DisplayLayout> const display_layout;
@@ -277,7 +282,7 @@ private:
 
     void move_tree(miral::WindowInfo& root, mir::geometry::Displacement movement);
     void set_tree_depth_layer(miral::WindowInfo& root, MirDepthLayer new_layer);
-    void erase(miral::WindowInfo const& info);
+    void erase(miral::WindowInfo const& info, mir::scene::Surface const* key);
     void validate_modification_request(WindowSpecification const& modifications, WindowInfo const& window_info) const;
     void place_and_size(WindowInfo& root, Point const& new_pos, Size const& new_size);
     void place_attached_to_zone(
@@ -29,17 +29,61 @@ bool visible(miral::Window const& window)
     std::shared_ptr<mir::scene::Surface> const& surface{window};
     return surface->state() != mir_window_state_hidden;
 }
+
+auto key_for(miral::Window const& window) -> mir::scene::Surface const*
+{
+    return std::shared_ptr<mir::scene::Surface>{window}.get();
+}
 }
 
 void miral::MRUWindowList::push(Window const& window)
 {
-    windows.erase(remove(begin(windows), end(windows), window), end(windows));
-    windows.push_back(window);
+    auto const key = key_for(window);
+
+    // A window whose surface has gone can't become active (and can't be keyed)
+    if (!key)
+        return;
+
+    auto const existing = index.find(key);
+
+    if (existing == index.end())
+    {
+        index[key] = windows.insert(end(windows), window);
+    }
+    else if (*existing->second == window)
+    {
+        windows.splice(end(windows), windows, existing->second);
+    }
+    else
+    {
+        // A window erased only after its surface had gone, and the surface's address since reused
+        windows.erase(existing->second);
+        existing->second = windows.insert(end(windows), window);
+    }
 }
 
 void miral::MRUWindowList::erase(Window const& window)
 {
-    windows.erase(remove(begin(windows), end(windows), window), end(windows));
+    auto const existing = index.find(key_for(window));
+
+    if (existing != index.end() && *existing->second == window)
+    {
+        windows.erase(existing->second);
+        index.erase(existing);
+    }
+    else
+    {
+        // The surface has already gone, so the window can't be looked up by it
+        for (auto i = begin(index); i != end(index); ++i)
+        {
+            if (*i->second == window)
+            {
+                windows.erase(i->second);
+                index.erase(i);
+                break;
+            }
+        }
+    }
 }
 
 auto miral::MRUWindowList::top() const -> Window
@@ -22,7 +22,8 @@
 #include <miral/window.h>
 
 #include <functional>
-#include <vector>
+#include <list>
+#include <unordered_map>
 
 namespace miral
 {
@@ -39,7 +40,13 @@ public:
     void enumerate(Enumerator const& enumerator) const;
 
 private:
-    std::vector<Window> windows;
+    using Windows = std::list<Window>;
+
+    /// Least recently pushed first
+    Windows windows;
+
+    /// The position of each window in windows, so that push() and erase() don't have to search
+    std::unordered_map<mir::scene::Surface const*, Windows::iterator> index;
 };
 }
 
@@ -897,3 +897,73 @@ xcursor_load_theme(const char *theme, int size,
 	if (inherits)
 		free(inherits);
 }
+
+/** Load one cursor of a theme
+ *
+ * This function looks for the named cursor in the given theme and then,
+ * failing that, in the themes it inherits, returning the first match.
+ * Unlike xcursor_load_theme() it only reads the one cursor file, so it is
+ * cheap enough to call as each cursor is first needed. The user is expected
+ * to destroy the XcursorImages object returned with XcursorImagesDestroy().
+ *
+ * \param theme The name of the theme to search
+ * \param name The name of the cursor, which is also the name of its file
+ * \param size The desired size of the cursor images
+ * \return The cursor images, or NULL if no theme has the cursor
+ */
+XcursorImages *
+xcursor_load_images(const char *theme, const char *name, int size)
+{
+	char *full, *dir;
+	char *inherits = NULL;
+	const char *path, *i;
+	XcursorImages *images = NULL;
+	FILE *f;
+
+	/* A cursor is a file in the theme's cursors directory, and nothing else */
+	if (!name || !*name || strchr(name, '/'))
+		return NULL;
+
+	if (!theme)
+		theme = "default";
+
+	for (path = XcursorLibraryPath();
+	     path && !images;
+	     path = _XcursorNextPath(path)) {
+		dir = _XcursorBuildThemeDir(path, theme);
+		if (!dir)
+			continue;
+
+		full = _XcursorBuildFullname(dir, "cursors", name);
+
+		if (full) {
+			f = fopen(full, "r");
+			if (f) {
+				images = XcursorFileLoadImages(f, size);
+				fclose(f);
+			}
+			free(full);
+		}
+
+		if (!images && !inherits) {
+			full = _XcursorBuildFullname(dir, "", "index.theme");
+			if (full) {
+				inherits = _XcursorThemeInherits(full);
+				free(full);
+			}
+		}
+
+		free(dir);
+	}
+
+	for (i = inherits; i && !images; i = _XcursorNextPath(i))
+		images = xcursor_load_images(i, name, size);
+
+	if (inherits)
+		free(inherits);
+
+	if (images)
+		XcursorImagesSetName(images, name);
+
+	return images;
+}
@@ -59,4 +59,7 @@ void
 xcursor_load_theme(const char *theme, int size,
 		    void (*load_callback)(XcursorImages *, void *),
 		    void *user_data);
+
+XcursorImages *
+xcursor_load_images(const char *theme, const char *name, int size);
 #endif
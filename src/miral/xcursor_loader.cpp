@@ -142,23 +142,34 @@ xcursor_name_for_mir_cursor(std::string const& mir_cursor_name)
 }
 }
 
-miral::XCursorLoader::XCursorLoader()
+miral::XCursorLoader::XCursorLoader() :
+    XCursorLoader{"default"}
 {
-    load_cursor_theme("default");
 }
 
-miral::XCursorLoader::XCursorLoader(std::string const& theme)
+miral::XCursorLoader::XCursorLoader(std::string const& theme) :
+    theme{theme}
 {
-    load_cursor_theme(theme);
 }
 
-// Each XcursorImages represents images for the different sizes of a given symbolic cursor.
-void miral::XCursorLoader::load_appropriately_sized_image(_XcursorImages *images)
+auto miral::XCursorLoader::image_locked(std::lock_guard<std::mutex> const&, std::string const& xcursor_name)
+-> std::shared_ptr<mg::CursorImage>
 {
-    // We would rather take this lock in load_cursor_theme but the Xcursor lib style
-    // makes it difficult to use our standard 'pass the lg around to _locked members' pattern
-    std::lock_guard<std::mutex> lg(guard);
+    auto const loaded = loaded_images.find(xcursor_name);
+    if (loaded != loaded_images.end())
+        return loaded->second;
+
+    auto& image = loaded_images[xcursor_name];
 
+    // Cursors are named by their square dimension...called the nominal size in XCursor terminology, so we just look up by width.
+    // Later we verify the actual size.
+    auto const images = xcursor_load_images(
+        theme.c_str(), xcursor_name.c_str(), mi::default_cursor_size.width.as_uint32_t());
+
+    if (!images)
+        return image;
+
+    // Each XcursorImages represents images for the different sizes of a given symbolic cursor.
     // We have to save all the images as XCursor expects us to free them.
     // This contains the actual image data though, so we need to ensure they stay alive
     // with the lifetime of the mg::CursorImage instance which refers to them.
@@ -173,25 +184,13 @@ void miral::XCursorLoader::load_appropriately_sized_image(_XcursorImages *images
         if (candidate->width == mi::default_cursor_size.width.as_uint32_t() &&
             candidate->height == mi::default_cursor_size.height.as_uint32_t())
         {
-            loaded_images[std::string(images->name)] = std::make_shared<XCursorImage>(candidate, saved_xcursor_library_resource);
-            return;
+            image = std::make_shared<XCursorImage>(candidate, saved_xcursor_library_resource);
+            return image;
         }
     }
 
-    loaded_images[std::string(images->name)] = std::make_shared<XCursorImage>(images->images[0], saved_xcursor_library_resource);
-}
-
-void miral::XCursorLoader::load_cursor_theme(std::string const& theme_name)
-{
-    // Cursors are named by their square dimension...called the nominal size in XCursor terminology, so we just look up by width.
-    // Later we verify the actual size.
-    xcursor_load_theme(theme_name.c_str(), mi::default_cursor_size.width.as_uint32_t(),
-        [](XcursorImages* images, void *this_ptr)  -> void
-        {
-            // Can't use lambda capture as this lambda is thunked to a C function ptr
-            auto p = static_cast<miral::XCursorLoader*>(this_ptr);
-            p->load_appropriately_sized_image(images);
-        }, this);
+    image = std::make_shared<XCursorImage>(images->images[0], saved_xcursor_library_resource);
+    return image;
 }
 
 std::shared_ptr<mg::CursorImage> miral::XCursorLoader::image(
@@ -202,14 +201,9 @@ std::shared_ptr<mg::CursorImage> miral::XCursorLoader::image(
 
     std::lock_guard<std::mutex> lg(guard);
 
-    auto it = loaded_images.find(xcursor_name);
-    if (it != loaded_images.end())
-        return it->second;
+    if (auto const image = image_locked(lg, xcursor_name))
+        return image;
 
     // Fall back
-    it = loaded_images.find("arrow");
-    if (it != loaded_images.end())
-        return it->second;
-
-    return nullptr;
+    return image_locked(lg, "arrow");
 }
@@ -53,12 +53,15 @@ protected:
     XCursorLoader& operator=(XCursorLoader const&) = delete;
 
 private:
+    std::string const theme;
+
     std::mutex guard;
 
+    /// Cursors are loaded from the theme as they are first asked for; a null image records one the theme lacks
     std::map<std::string, std::shared_ptr<mir::graphics::CursorImage>> loaded_images;
 
-    void load_cursor_theme(std::string const& theme_name);
-    void load_appropriately_sized_image(_XcursorImages *images);
+    auto image_locked(std::lock_guard<std::mutex> const&, std::string const& xcursor_name)
+        -> std::shared_ptr<mir::graphics::CursorImage>;
 };
 }
 
@@ -44,6 +44,11 @@ char const* const mo::shared_library_prober_report_opt = "shared-library-prober-
 char const* const mo::shell_report_opt            = "shell-report";
 char const* const mo::name_opt                    = "name";
 char const* const mo::offscreen_opt               = "offscreen";
+char const* const mo::renderer_opt                = "renderer";
+char const* const mo::gl_program_cache_opt        = "gl-program-cache";
+char const* const mo::offscreen_frame_export_opt  = "offscreen-frame-export";
+char const* const mo::metrics_socket_opt          = "metrics-socket";
+char const* const mo::trace_file_opt              = "trace-file";
 char const* const mo::touchspots_opt              = "enable-touchspots";
 char const* const mo::cursor_opt                  = "cursor";
 char const* const mo::fatal_except_opt            = "on-fatal-error-except";
@@ -57,6 +62,10 @@ char const* const mo::enable_mirclient_opt        = "enable-mirclient";
 char const* const mo::off_opt_value = "off";
 char const* const mo::log_opt_value = "log";
 char const* const mo::lttng_opt_value = "lttng";
+char const* const mo::metrics_opt_value = "metrics";
+char const* const mo::trace_opt_value = "trace";
+char const* const mo::gl_renderer_opt_value = "gl";
+char const* const mo::software_renderer_opt_value = "software";
 
 char const* const mo::platform_graphics_lib = "platform-graphics-lib";
 char const* const mo::platform_input_lib = "platform-input-lib";
@@ -161,27 +170,35 @@ mo::DefaultConfiguration::DefaultConfiguration(
         (enable_input_opt, po::value<bool>()->default_value(enable_input_default),
             "Enable input.")
         (compositor_report_opt, po::value<std::string>()->default_value(off_opt_value),
-            "Compositor reporting [{log,lttng,off}]")
+            "Compositor reporting [{log,lttng,metrics,trace,off}]")
         (connector_report_opt, po::value<std::string>()->default_value(off_opt_value),
             "How to handle the Connector report. [{log,lttng,off}]")
         (display_report_opt, po::value<std::string>()->default_value(off_opt_value),
-            "How to handle the Display report. [{log,lttng,off}]")
+            "How to handle the Display report. [{log,lttng,metrics,trace,off}]")
         (input_report_opt, po::value<std::string>()->default_value(off_opt_value),
-            "How to handle to Input report. [{log,lttng,off}]")
+            "How to handle to Input report. [{log,lttng,metrics,trace,off}]")
         (legacy_input_report_opt, po::value<std::string>()->default_value(off_opt_value),
             "How to handle the Legacy Input report. [{log,off}]")
         (seat_report_opt, po::value<std::string>()->default_value(off_opt_value),
             "How to handle to Seat report. [{log,off}]")
         (session_mediator_report_opt, po::value<std::string>()->default_value(off_opt_value),
-            "How to handle the SessionMediator report. [{log,lttng,off}]")
+            "How to handle the SessionMediator report. [{log,lttng,metrics,trace,off}]")
         (msg_processor_report_opt, po::value<std::string>()->default_value(off_opt_value),
             "How to handle the MessageProcessor report. [{log,lttng,off}]")
         (scene_report_opt, po::value<std::string>()->default_value(off_opt_value),
-            "How to handle the scene report. [{log,lttng,off}]")
+            "How to handle the scene report. [{log,lttng,metrics,trace,off}]")
         (shared_library_prober_report_opt, po::value<std::string>()->default_value(log_opt_value),
             "How to handle the SharedLibraryProber report. [{log,lttng,off}]")
         (shell_report_opt, po::value<std::string>()->default_value(off_opt_value),
          "How to handle the Shell report. [{log,off}]")
+        (metrics_socket_opt, po::value<std::string>(),
+            "Socket path on which to serve the metrics gathered by \"metrics\" "
+            "reports, in the Prometheus text format.")
+        (trace_file_opt, po::value<std::string>(),
+            "File to write the Chrome trace-event JSON recorded by \"trace\" "
+            "reports to. Recording starts with the server; SIGUSR2 stops it "
+            "and writes the file, and starts it again. "
+            "(default: $XDG_RUNTIME_DIR/mir-trace-<pid>.json)")
         (composite_delay_opt, po::value<int>()->default_value(0),
             "Compositor frame delay in milliseconds (how long to wait for new "
             "frames from clients before compositing). Higher values result in "
@@ -191,6 +208,16 @@ mo::DefaultConfiguration::DefaultConfiguration(
             "When nested, the name Mir uses when registering with the host.")
         (offscreen_opt,
             "Render to offscreen buffers instead of the real outputs.")
+        (renderer_opt, po::value<std::string>()->default_value(gl_renderer_opt_value),
+            "Renderer used to composite the outputs [{gl,software}]. "
+            "The software renderer needs no GPU but requires --offscreen.")
+        (gl_program_cache_opt, po::value<std::string>(),
+            "Directory in which the GL renderer caches its linked shader "
+            "programs, or \"off\" to always build them from source. "
+            "(default: $XDG_CACHE_HOME/mir/shaders)")
+        (offscreen_frame_export_opt, po::value<std::string>(),
+            "Socket path on which to export the frames of offscreen outputs as "
+            "shared memory. Requires --renderer=software.")
         (touchspots_opt,
             "Display visualization of touchspots (e.g. for screencasting).")
         (cursor_opt,
@@ -309,12 +309,12 @@ class WlShmBuffer :
 public:
     WlShmBuffer(
         SharedWlBuffer buffer,
-        std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
+        std::shared_ptr<mgc::ShmTexturePool> textures,
         mir::geometry::Size const& size,
         mir::geometry::Stride stride,
         MirPixelFormat format,
         std::function<void()>&& on_consumed)
-        : ShmBuffer(size, format, std::move(egl_delegate)),
+        : ShmBuffer(size, format, std::move(textures)),
           on_consumed{std::move(on_consumed)},
           buffer{std::move(buffer)},
           stride_{stride}
@@ -337,6 +337,7 @@ public:
                 {
                     upload_to_texture(pixels, stride());
                 });
+            uploaded = true;
             on_consumed();
             on_consumed = [](){};
         }
@@ -390,7 +391,7 @@ private:
 auto mg::wayland::buffer_from_wl_shm(
     wl_resource* buffer,
     std::shared_ptr<Executor> executor,
-    std::shared_ptr<common::EGLContextExecutor> egl_delegate,
+    std::shared_ptr<common::ShmTexturePool> textures,
     std::function<void()>&& on_consumed) -> std::shared_ptr<Buffer>
 {
     auto const shm_buffer = wl_shm_buffer_get(buffer);
@@ -400,7 +401,7 @@ auto mg::wayland::buffer_from_wl_shm(
     }
     return std::make_shared<WlShmBuffer>(
         SharedWlBuffer{buffer, std::move(executor)},
-        std::move(egl_delegate),
+        std::move(textures),
         mir::geometry::Size{
             wl_shm_buffer_get_width(shm_buffer),
             wl_shm_buffer_get_height(shm_buffer)
@@ -35,7 +35,7 @@ class Buffer;
 
 namespace common
 {
-class EGLContextExecutor;
+class ShmTexturePool;
 }
 
 namespace wayland
@@ -50,14 +50,14 @@ namespace wayland
  *
  * \param buffer        [in]    The Wayland SHM buffer to import
  * \param executor      [in]    An Executor that will defer work to the Wayland event loop
- * \param egl_delegate  [in]    An EGL-context-thread delegator
+ * \param textures      [in]    The pool to take the buffer's GL texture from
  * \param on_consumed   [in]    Closure to call when the compositor has consumed this buffer
  * \return                      An mg::Buffer supporting being rendered from in GL and read by the CPU.
  */
 auto buffer_from_wl_shm(
     wl_resource* buffer,
     std::shared_ptr<Executor> executor,
-    std::shared_ptr<common::EGLContextExecutor> egl_delegate,
+    std::shared_ptr<common::ShmTexturePool> textures,
     std::function<void()>&& on_consumed) -> std::shared_ptr<Buffer>;
 }
 }
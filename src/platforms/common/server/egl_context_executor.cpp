@@ -19,6 +19,8 @@
 #include "egl_context_executor.h"
 #include "mir/renderer/gl/context.h"
 
+#include <algorithm>
+
 namespace mgc = mir::graphics::common;
 
 mgc::EGLContextExecutor::EGLContextExecutor(
@@ -34,43 +36,111 @@ mgc::EGLContextExecutor::~EGLContextExecutor() noexcept
         std::lock_guard<std::mutex> lock{mutex};
         shutdown_requested = true;
     }
-    new_work.notify_all();
+    new_work.notify_one();
     egl_thread.join();
 }
 
 void mgc::EGLContextExecutor::spawn(
     std::function<void()>&& functor)
 {
+    bool was_empty;
     {
         std::lock_guard<std::mutex> lock{mutex};
+        was_empty = queue_empty();
+        flush_texture_deletions();
         work_queue.emplace_back(std::move(functor));
+        note_queued(was_empty);
     }
-    new_work.notify_all();
+    // If the queue wasn't empty the EGL thread has already been woken for it
+    if (was_empty)
+        new_work.notify_one();
+}
+
+void mgc::EGLContextExecutor::delete_texture(GLuint texture)
+{
+    bool was_empty;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        was_empty = queue_empty();
+        textures_to_delete.push_back(texture);
+        note_queued(was_empty);
+    }
+    if (was_empty)
+        new_work.notify_one();
+}
+
+auto mgc::EGLContextExecutor::metrics() const -> Metrics
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    auto result = stats;
+    result.queue_depth = work_queue.size() + textures_to_delete.size();
+    return result;
+}
+
+bool mgc::EGLContextExecutor::queue_empty() const
+{
+    return work_queue.empty() && textures_to_delete.empty();
+}
+
+void mgc::EGLContextExecutor::flush_texture_deletions()
+{
+    if (textures_to_delete.empty())
+        return;
+
+    stats.textures_deleted += textures_to_delete.size();
+    work_queue.emplace_back(
+        [textures = std::move(textures_to_delete)]()
+        {
+            glDeleteTextures(textures.size(), textures.data());
+        });
+    textures_to_delete.clear();
+}
+
+void mgc::EGLContextExecutor::note_queued(bool was_empty)
+{
+    if (was_empty)
+        oldest_queued = Clock::now();
+
+    stats.peak_queue_depth =
+        std::max(stats.peak_queue_depth, work_queue.size() + textures_to_delete.size());
 }
 
 void mgc::EGLContextExecutor::process_loop(mgc::EGLContextExecutor* const me)
 {
     me->ctx->make_current();
 
-    std::unique_lock<std::mutex> lock{me->mutex};
-    while (!me->shutdown_requested)
+    // Swapped with the work queue each time round, so that neither vector
+    // needs to reallocate once they've grown to the usual batch size.
+    std::vector<std::function<void()>> batch;
+
+    while (true)
     {
-        for (auto& work : me->work_queue)
         {
-            work();
-        }
-        me->work_queue.clear();
+            std::unique_lock<std::mutex> lock{me->mutex};
+            me->new_work.wait(lock, [me]() { return me->shutdown_requested || !me->queue_empty(); });
 
-        me->new_work.wait(lock);
-    }
+            // Once shutdown is requested we keep going until the queue is drained,
+            // including any work queued by the work we're draining.
+            if (me->queue_empty())
+                break;
 
-    // Drain the work-queue
-    for (auto& work : me->work_queue)
-    {
-        work();
+            me->flush_texture_deletions();
+            batch.swap(me->work_queue);
+
+            me->stats.batches++;
+            me->stats.functors_run += batch.size();
+            me->stats.max_latency = std::max<std::chrono::nanoseconds>(
+                me->stats.max_latency,
+                Clock::now() - me->oldest_queued);
+        }
+
+        for (auto& work : batch)
+        {
+            work();
+        }
+        // Ensure any functor cleanup happens with the EGL context current, too.
+        batch.clear();
     }
-    // …and ensure any functor cleanup happens with the EGL context current, too.
-    me->work_queue.clear();
 
     me->ctx->release_current();
 }
@@ -21,6 +21,10 @@
 
 #include "mir/executor.h"
 
+#include MIR_SERVER_GL_H
+
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <future>
 #include <thread>
@@ -42,9 +46,27 @@ namespace graphics
 {
 namespace common
 {
+/**
+ * Runs work on a dedicated thread with an EGL context current
+ *
+ * spawn() only ever holds the queue lock long enough to append to the queue;
+ * the EGL thread takes the whole queue at once and runs it without the lock
+ * held, so callers (such as the Wayland thread releasing buffers) are never
+ * blocked behind GL work.
+ */
 class EGLContextExecutor : public Executor
 {
 public:
+    struct Metrics
+    {
+        std::size_t queue_depth;            ///< Work queued but not yet started
+        std::size_t peak_queue_depth;       ///< The deepest the queue has been
+        std::uint64_t batches;              ///< Times the EGL thread has taken the queue
+        std::uint64_t functors_run;
+        std::uint64_t textures_deleted;
+        std::chrono::nanoseconds max_latency;   ///< Longest wait between queueing and running
+    };
+
     EGLContextExecutor(std::unique_ptr<renderer::gl::Context> context);
     ~EGLContextExecutor() noexcept;
 
@@ -52,13 +74,35 @@ public:
      * Run a run a function on a thread with a current EGL context
      */
     void spawn(std::function<void()>&& functor) override;
+
+    /**
+     * Delete a texture on the EGL thread
+     *
+     * Consecutive deletions are coalesced into a single glDeleteTextures()
+     * call. They stay ordered with respect to spawn()ed work: a deletion
+     * happens after all work spawned before it, and before all work spawned
+     * after it.
+     */
+    void delete_texture(GLuint texture);
+
+    auto metrics() const -> Metrics;
 private:
+    using Clock = std::chrono::steady_clock;
+
     static void process_loop(EGLContextExecutor* const me);
 
+    // These must be called with mutex held
+    bool queue_empty() const;
+    void flush_texture_deletions();
+    void note_queued(bool was_empty);
+
     std::unique_ptr<renderer::gl::Context> const ctx;
-    std::mutex mutex;
+    std::mutex mutable mutex;
     std::condition_variable new_work;
     std::vector<std::function<void()>> work_queue;
+    std::vector<GLuint> textures_to_delete;
+    Clock::time_point oldest_queued;
+    Metrics stats{0, 0, 0, 0, 0, std::chrono::nanoseconds::zero()};
     bool shutdown_requested{false};
 
     std::thread egl_thread;
@@ -21,7 +21,6 @@
 #include "shm_buffer.h"
 #include "mir/graphics/program_factory.h"
 #include "mir/graphics/program.h"
-#include "egl_context_executor.h"
 
 #define MIR_LOG_COMPONENT "gfx-common"
 #include "mir/log.h"
@@ -97,32 +96,46 @@ bool mgc::ShmBuffer::supports(MirPixelFormat mir_format)
 mgc::ShmBuffer::ShmBuffer(
     geom::Size const& size,
     MirPixelFormat const& format,
-    std::shared_ptr<EGLContextExecutor> egl_delegate)
+    std::shared_ptr<ShmTexturePool> textures)
     : size_{size},
       pixel_format_{format},
-      egl_delegate{std::move(egl_delegate)}
+      textures{std::move(textures)}
 {
 }
 
 mgc::MemoryBackedShmBuffer::MemoryBackedShmBuffer(
     geom::Size const& size,
     MirPixelFormat const& pixel_format,
-    std::shared_ptr<EGLContextExecutor> egl_delegate)
-    : ShmBuffer(size, pixel_format, std::move(egl_delegate)),
+    std::shared_ptr<ShmTexturePool> textures)
+    : ShmBuffer(size, pixel_format, std::move(textures)),
       stride_{MIR_BYTES_PER_PIXEL(pixel_format) * size.width.as_uint32_t()},
-      pixels{new unsigned char[stride_.as_int() * size.height.as_int()]}
+      pixels{
+          new unsigned char[stride_.as_int() * size.height.as_int()],
+          std::default_delete<unsigned char[]>()}
 {
 }
 
+mgc::MemoryBackedShmBuffer::MemoryBackedShmBuffer(
+    geom::Size const& size,
+    MirPixelFormat const& pixel_format,
+    std::shared_ptr<ShmTexturePool> textures,
+    std::shared_ptr<unsigned char> pixels)
+    : ShmBuffer(size, pixel_format, std::move(textures)),
+      stride_{MIR_BYTES_PER_PIXEL(pixel_format) * size.width.as_uint32_t()},
+      pixels{std::move(pixels)}
+{
+}
+
+auto mgc::MemoryBackedShmBuffer::storage_size(geom::Size const& size, MirPixelFormat pixel_format) -> size_t
+{
+    return MIR_BYTES_PER_PIXEL(pixel_format) * size.width.as_uint32_t() * size.height.as_uint32_t();
+}
+
 mgc::ShmBuffer::~ShmBuffer() noexcept
 {
-    if (tex_id != 0)
+    if (tex.id != 0)
     {
-        egl_delegate->spawn(
-            [id = tex_id]()
-            {
-                glDeleteTextures(1, &id);
-            });
+        textures->release(tex, size_, pixel_format_);
     }
 }
 
@@ -161,15 +174,30 @@ void mgc::ShmBuffer::upload_to_texture(void const* pixels, geom::Stride const& s
         glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride_in_px);
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            format,
-            size().width.as_int(), size().height.as_int(),
-            0,
-            format,
-            type,
-            pixels);
+        if (tex.has_storage)
+        {
+            glTexSubImage2D(
+                GL_TEXTURE_2D,
+                0,
+                0, 0,
+                size().width.as_int(), size().height.as_int(),
+                format,
+                type,
+                pixels);
+        }
+        else
+        {
+            glTexImage2D(
+                GL_TEXTURE_2D,
+                0,
+                format,
+                size().width.as_int(), size().height.as_int(),
+                0,
+                format,
+                type,
+                pixels);
+            tex.has_storage = true;
+        }
 
         // Be nice to other users of the GL context by reverting our changes to shared state
         glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);     // 0 is default, meaning “use width”
@@ -189,6 +217,7 @@ void mgc::MemoryBackedShmBuffer::write(unsigned char const* data, size_t data_si
     if (data_size != stride_.as_uint32_t()*size().height.as_uint32_t())
         BOOST_THROW_EXCEPTION(std::logic_error("Size is not equal to number of pixels in buffer"));
     memcpy(pixels.get(), data, data_size);
+    needs_upload = true;
 }
 
 void mgc::MemoryBackedShmBuffer::read(std::function<void(unsigned char const*)> const& do_with_pixels)
@@ -203,12 +232,14 @@ mg::NativeBufferBase* mgc::ShmBuffer::native_buffer_base()
 
 void mgc::ShmBuffer::bind()
 {
-    bool const needs_initialisation = tex_id == 0;
-    if (needs_initialisation)
+    bool needs_initialisation = false;
+    if (tex.id == 0)
     {
-        glGenTextures(1, &tex_id);
+        // A recycled texture has already been initialised
+        tex = textures->acquire(size_, pixel_format_);
+        needs_initialisation = !tex.has_storage;
     }
-    glBindTexture(GL_TEXTURE_2D, tex_id);
+    glBindTexture(GL_TEXTURE_2D, tex.id);
     if (needs_initialisation)
     {
         // The ShmBuffer *should* be immutable, so we can just upload once.
@@ -219,10 +250,21 @@ void mgc::ShmBuffer::bind()
     }
 }
 
+auto mgc::ShmBuffer::has_texture() const -> bool
+{
+    return tex.id != 0;
+}
+
 void mgc::MemoryBackedShmBuffer::bind()
 {
+    // A newly acquired texture has someone else's contents, if any
+    auto const had_texture = has_texture();
+    auto const written = needs_upload.exchange(false);
+
     mgc::ShmBuffer::bind();
-    upload_to_texture(pixels.get(), stride_);
+
+    if (!had_texture || written)
+        upload_to_texture(pixels.get(), stride_);
 }
 
 auto mgc::MemoryBackedShmBuffer::native_buffer_handle() const -> std::shared_ptr<mg::NativeBuffer>
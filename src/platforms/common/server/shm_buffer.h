@@ -28,6 +28,9 @@
 #include "mir_toolkit/mir_native_buffer.h"
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/graphics/texture.h"
+#include "shm_texture_pool.h"
+
+#include <atomic>
 
 #include MIR_SERVER_GL_H
 
@@ -39,8 +42,6 @@ namespace graphics
 {
 namespace common
 {
-class EGLContextExecutor;
-
 class ShmBuffer :
     public BufferBasic,
     public NativeBufferBase,
@@ -63,15 +64,18 @@ protected:
     ShmBuffer(
         geometry::Size const& size,
         MirPixelFormat const& format,
-        std::shared_ptr<EGLContextExecutor> egl_delegate);
+        std::shared_ptr<ShmTexturePool> textures);
 
     /// \note This must be called with a current GL context
     void upload_to_texture(void const* pixels, geometry::Stride const& stride);
+
+    /// Whether a texture has been bound to this buffer, and so holds whatever was last uploaded to it
+    auto has_texture() const -> bool;
 private:
     geometry::Size const size_;
     MirPixelFormat const pixel_format_;
-    std::shared_ptr<EGLContextExecutor> const egl_delegate;
-    GLuint tex_id{0};
+    std::shared_ptr<ShmTexturePool> const textures;
+    ShmTexturePool::Texture tex{0, false};
 };
 
 class MemoryBackedShmBuffer :
@@ -82,7 +86,20 @@ public:
     MemoryBackedShmBuffer(
         geometry::Size const& size,
         MirPixelFormat const& pixel_format,
-        std::shared_ptr<EGLContextExecutor> egl_delegate);
+        std::shared_ptr<ShmTexturePool> textures);
+
+    /**
+     * Use caller-provided storage for the pixels
+     *
+     * \param [in] pixels   At least storage_size(size, pixel_format) bytes
+     */
+    MemoryBackedShmBuffer(
+        geometry::Size const& size,
+        MirPixelFormat const& pixel_format,
+        std::shared_ptr<ShmTexturePool> textures,
+        std::shared_ptr<unsigned char> pixels);
+
+    static auto storage_size(geometry::Size const& size, MirPixelFormat pixel_format) -> size_t;
 
     void write(unsigned char const* data, size_t size) override;
     void read(std::function<void(unsigned char const*)> const& do_with_pixels) override;
@@ -96,7 +113,10 @@ public:
     MemoryBackedShmBuffer& operator=(MemoryBackedShmBuffer const&) = delete;
 private:
     geometry::Stride const stride_;
-    std::unique_ptr<unsigned char[]> const pixels;
+    std::shared_ptr<unsigned char> const pixels;
+
+    /// Set by write(), so a buffer that is bound repeatedly (a cursor, say) is only uploaded when it has changed
+    std::atomic<bool> needs_upload{true};
 };
 
 }
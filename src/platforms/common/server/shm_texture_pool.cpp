@@ -0,0 +1,106 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "shm_texture_pool.h"
+#include "egl_context_executor.h"
+
+#include <algorithm>
+
+namespace mgc = mir::graphics::common;
+namespace geom = mir::geometry;
+
+std::size_t const mgc::ShmTexturePool::default_budget;
+
+mgc::ShmTexturePool::ShmTexturePool(
+    std::shared_ptr<EGLContextExecutor> egl_delegate,
+    std::size_t budget)
+    : egl_delegate{std::move(egl_delegate)},
+      budget{budget}
+{
+}
+
+mgc::ShmTexturePool::~ShmTexturePool()
+{
+    delete_textures(std::move(pool));
+}
+
+auto mgc::ShmTexturePool::acquire(geom::Size size, MirPixelFormat format) -> Texture
+{
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+
+        // Prefer the most recently released: it's the most likely to be idle in the driver's caches
+        auto const match = std::find_if(
+            pool.rbegin(), pool.rend(),
+            [&](Pooled const& pooled) { return pooled.size == size && pooled.format == format; });
+
+        if (match != pool.rend())
+        {
+            Texture const recycled{match->id, true};
+            pool_bytes -= match->bytes;
+            pool.erase(std::next(match).base());
+            return recycled;
+        }
+
+        // While a window is being resized no two buffers are the same size. The texture object
+        // can still be recycled; it just needs its storage respecified.
+        if (!pool.empty())
+        {
+            Texture const recycled{pool.back().id, false};
+            pool_bytes -= pool.back().bytes;
+            pool.pop_back();
+            return recycled;
+        }
+    }
+
+    Texture texture{0, false};
+    glGenTextures(1, &texture.id);
+    return texture;
+}
+
+void mgc::ShmTexturePool::release(Texture texture, geom::Size size, MirPixelFormat format)
+{
+    std::size_t const bytes = size.width.as_uint32_t() * size.height.as_uint32_t() * MIR_BYTES_PER_PIXEL(format);
+
+    std::list<Pooled> evicted;
+
+    if (!texture.has_storage || bytes > budget)
+    {
+        evicted.push_back({texture.id, size, format, bytes});
+    }
+    else
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+
+        pool.push_back({texture.id, size, format, bytes});
+        pool_bytes += bytes;
+
+        while (pool_bytes > budget)
+        {
+            pool_bytes -= pool.front().bytes;
+            evicted.splice(evicted.end(), pool, pool.begin());
+        }
+    }
+
+    delete_textures(std::move(evicted));
+}
+
+void mgc::ShmTexturePool::delete_textures(std::list<Pooled> textures)
+{
+    for (auto const& texture : textures)
+        egl_delegate->delete_texture(texture.id);
+}
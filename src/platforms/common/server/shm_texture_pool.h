@@ -0,0 +1,114 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MIR_GRAPHICS_COMMON_SHM_TEXTURE_POOL_H_
+#define MIR_GRAPHICS_COMMON_SHM_TEXTURE_POOL_H_
+
+#include "mir/geometry/size.h"
+#include "mir_toolkit/common.h"
+
+#include MIR_SERVER_GL_H
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+
+namespace mir
+{
+namespace graphics
+{
+namespace common
+{
+class EGLContextExecutor;
+
+/**
+ * Recycles the GL textures of released ShmBuffers
+ *
+ * A wl_shm client typically commits a fresh buffer of the same size and format
+ * every frame. Instead of each buffer creating a texture and allocating its
+ * storage, only for the texture to be deleted when the buffer is released, the
+ * texture goes back into the pool and is handed to the next buffer of the same
+ * size and format. That buffer can then upload into the existing storage.
+ * Failing a match, a buffer of another size or format gets a pooled texture
+ * whose storage it has to respecify.
+ *
+ * Pooled textures are kept up to a memory budget; beyond that the least
+ * recently released are deleted on the EGLContextExecutor.
+ */
+class ShmTexturePool
+{
+public:
+    static std::size_t const default_budget{64 * 1024 * 1024};
+
+    struct Texture
+    {
+        GLuint id;
+        /// Storage for the size and format has been allocated, so the texture
+        /// can be updated with glTexSubImage2D()
+        bool has_storage;
+    };
+
+    ShmTexturePool(
+        std::shared_ptr<EGLContextExecutor> egl_delegate,
+        std::size_t budget = default_budget);
+    ~ShmTexturePool();
+
+    /**
+     * Get a texture for a buffer of the given size and format
+     *
+     * A texture that isn't an exact match from the pool has no storage (and,
+     * if newly generated, no parameters set).
+     *
+     * \note This must be called with a current GL context
+     */
+    auto acquire(geometry::Size size, MirPixelFormat format) -> Texture;
+
+    /**
+     * Give back a texture from acquire()
+     *
+     * This may be called from any thread.
+     */
+    void release(Texture texture, geometry::Size size, MirPixelFormat format);
+
+private:
+    ShmTexturePool(ShmTexturePool const&) = delete;
+    ShmTexturePool& operator=(ShmTexturePool const&) = delete;
+
+    struct Pooled
+    {
+        GLuint id;
+        geometry::Size size;
+        MirPixelFormat format;
+        std::size_t bytes;
+    };
+
+    void delete_textures(std::list<Pooled> textures);
+
+    std::shared_ptr<EGLContextExecutor> const egl_delegate;
+    std::size_t const budget;
+
+    std::mutex mutex;
+    /// Least recently released first
+    std::list<Pooled> pool;
+    std::size_t pool_bytes{0};
+};
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_COMMON_SHM_TEXTURE_POOL_H_ */
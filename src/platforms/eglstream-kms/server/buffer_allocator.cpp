@@ -97,7 +97,8 @@ std::unique_ptr<mir::renderer::gl::Context> context_for_output(mg::Display const
 mge::BufferAllocator::BufferAllocator(mg::Display const& output)
     : wayland_ctx{context_for_output(output)},
       egl_delegate{
-          std::make_shared<mgc::EGLContextExecutor>(context_for_output(output))}
+          std::make_shared<mgc::EGLContextExecutor>(context_for_output(output))},
+      shm_textures{std::make_shared<mgc::ShmTexturePool>(egl_delegate)}
 {
 }
 
@@ -120,7 +121,7 @@ std::shared_ptr<mg::Buffer> mge::BufferAllocator::alloc_software_buffer(geom::Si
                 "Trying to create SHM buffer with unsupported pixel format"));
     }
 
-    return std::make_shared<mgc::MemoryBackedShmBuffer>(size, format, egl_delegate);
+    return std::make_shared<mgc::MemoryBackedShmBuffer>(size, format, shm_textures);
 }
 
 std::vector<MirPixelFormat> mge::BufferAllocator::supported_pixel_formats()
@@ -576,6 +577,6 @@ auto mge::BufferAllocator::buffer_from_shm(
     return mg::wayland::buffer_from_wl_shm(
         buffer,
         std::move(wayland_executor),
-        egl_delegate,
+        shm_textures,
         std::move(on_consumed));
 }
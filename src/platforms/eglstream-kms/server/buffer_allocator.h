@@ -24,6 +24,7 @@
 #include "mir/graphics/buffer_id.h"
 #include "mir/graphics/egl_extensions.h"
 #include "egl_context_executor.h"
+#include "shm_texture_pool.h"
 
 #include "wayland-eglstream-controller.h"
 
@@ -95,6 +96,7 @@ private:
     EGLExtensions::NVStreamAttribExtensions const nv_extensions;
     std::shared_ptr<renderer::gl::Context> const wayland_ctx;
     std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
+    std::shared_ptr<common::ShmTexturePool> const shm_textures;
     std::unique_ptr<gl::Program> shader;
     static struct wl_eglstream_controller_interface const impl;
 };
@@ -192,15 +192,6 @@ private:
     mir::Fd prime_fd;
 };
 
-struct GBMBODeleter
-{
-    void operator()(gbm_bo* handle) const
-    {
-        if (handle)
-            gbm_bo_destroy(handle);
-    }
-};
-
 auto make_texture_binder(
     mgm::BufferImportMethod const buffer_import_method,
     std::shared_ptr<gbm_bo> const& bo,
@@ -247,11 +238,14 @@ mgm::BufferAllocator::BufferAllocator(
     mg::Display const& output,
     gbm_device* device,
     BypassOption bypass_option,
-    mgm::BufferImportMethod const buffer_import_method)
+    mgm::BufferImportMethod const buffer_import_method,
+    std::size_t buffer_pool_budget)
     : ctx{context_for_output(output)},
       egl_delegate{
           std::make_shared<mgc::EGLContextExecutor>(context_for_output(output))},
+      shm_textures{std::make_shared<mgc::ShmTexturePool>(egl_delegate)},
       device(device),
+      buffer_pool(std::make_shared<BufferPool>(device, buffer_pool_budget)),
       egl_extensions(std::make_shared<mg::EGLExtensions>()),
       bypass_option(buffer_import_method == mgm::BufferImportMethod::dma_buf ?
                         mgm::BypassOption::prohibited :
@@ -306,17 +300,7 @@ std::shared_ptr<mg::Buffer> mgm::BufferAllocator::alloc_hardware_buffer(
 std::shared_ptr<mg::Buffer> mgm::BufferAllocator::alloc_buffer(
     geom::Size size, uint32_t native_format, uint32_t native_flags)
 {
-    gbm_bo *bo_raw = gbm_bo_create(
-        device,
-        size.width.as_uint32_t(),
-        size.height.as_uint32_t(),
-        native_format,
-        native_flags);
-
-    if (!bo_raw)
-        BOOST_THROW_EXCEPTION(std::runtime_error("Failed to create GBM buffer object"));
-
-    std::shared_ptr<gbm_bo> bo{bo_raw, GBMBODeleter()};
+    auto const bo = buffer_pool->create_bo(size, native_format, native_flags);
 
     return std::make_shared<GBMBuffer>(
         bo, native_flags, make_texture_binder(buffer_import_method, bo, egl_extensions));
@@ -332,7 +316,11 @@ std::shared_ptr<mg::Buffer> mgm::BufferAllocator::alloc_software_buffer(
                 "Trying to create SHM buffer with unsupported pixel format"));
     }
 
-    return std::make_shared<mgc::MemoryBackedShmBuffer>(size, format, egl_delegate);
+    return std::make_shared<mgc::MemoryBackedShmBuffer>(
+        size,
+        format,
+        shm_textures,
+        buffer_pool->create_pixels(mgc::MemoryBackedShmBuffer::storage_size(size, format)));
 }
 
 std::vector<MirPixelFormat> mgm::BufferAllocator::supported_pixel_formats()
@@ -399,6 +387,6 @@ auto mgm::BufferAllocator::buffer_from_shm(
     return mg::wayland::buffer_from_wl_shm(
         buffer,
         std::move(wayland_executor),
-        egl_delegate,
+        shm_textures,
         std::move(on_consumed));
 }
@@ -20,6 +20,7 @@
 #define MIR_GRAPHICS_MESA_BUFFER_ALLOCATOR_H_
 
 #include "platform_common.h"
+#include "buffer_pool.h"
 #include "mir/graphics/graphic_buffer_allocator.h"
 #include "mir/graphics/buffer_id.h"
 #include "mir/graphics/wayland_allocator.h"
@@ -52,6 +53,7 @@ struct EGLExtensions;
 namespace common
 {
 class EGLContextExecutor;
+class ShmTexturePool;
 }
 
 namespace mesa
@@ -72,7 +74,8 @@ public:
         Display const& output,
         gbm_device* device,
         BypassOption bypass_option,
-        BufferImportMethod const buffer_import_method);
+        BufferImportMethod const buffer_import_method,
+        std::size_t buffer_pool_budget = BufferPool::default_budget);
 
     std::shared_ptr<Buffer> alloc_buffer(
         geometry::Size size, uint32_t native_format, uint32_t native_flags) override;
@@ -95,8 +98,10 @@ private:
 
     std::shared_ptr<renderer::gl::Context> const ctx;
     std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
+    std::shared_ptr<common::ShmTexturePool> const shm_textures;
     std::shared_ptr<Executor> wayland_executor;
     gbm_device* const device;
+    std::shared_ptr<BufferPool> const buffer_pool;
     std::shared_ptr<EGLExtensions> const egl_extensions;
 
     BypassOption const bypass_option;
@@ -0,0 +1,229 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "buffer_pool.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace mgm = mir::graphics::mesa;
+namespace geom = mir::geometry;
+
+namespace
+{
+bool clear(gbm_bo* bo)
+{
+    auto const width = gbm_bo_get_width(bo);
+    auto const height = gbm_bo_get_height(bo);
+    uint32_t stride{0};
+    void* map_data{nullptr};
+
+    auto const mapped = gbm_bo_map(bo, 0, 0, width, height, GBM_BO_TRANSFER_WRITE, &stride, &map_data);
+    if (!mapped)
+        return false;
+
+    memset(mapped, 0, stride * height);
+    gbm_bo_unmap(bo, map_data);
+    return true;
+}
+}
+
+std::size_t const mgm::BufferPool::default_budget;
+
+/// Returns a buffer object to its pool when released, unless it was exported
+class mgm::BufferPool::ReleaseBo
+{
+public:
+    ReleaseBo(std::weak_ptr<BufferPool> const& pool, Pooled const& storage)
+        : pool{pool},
+          storage{storage}
+    {
+    }
+
+    ReleaseBo(ReleaseBo const& that)
+        : pool{that.pool},
+          storage{that.storage},
+          exported{that.exported.load()}
+    {
+    }
+
+    void operator()(gbm_bo*) const
+    {
+        auto const self = pool.lock();
+        if (self && !exported)
+            self->release(storage);
+        else
+            free(storage);
+    }
+
+    void mark_exported()
+    {
+        exported = true;
+    }
+
+private:
+    std::weak_ptr<BufferPool> const pool;
+    Pooled const storage;
+    std::atomic<bool> exported{false};
+};
+
+mgm::BufferPool::BufferPool(gbm_device* device, std::size_t budget)
+    : device{device},
+      budget{budget}
+{
+}
+
+mgm::BufferPool::~BufferPool()
+{
+    for (auto const& pooled : pool)
+        free(pooled);
+}
+
+auto mgm::BufferPool::create_bo(geom::Size size, uint32_t format, uint32_t flags) -> std::shared_ptr<gbm_bo>
+{
+    Pooled const wanted{nullptr, nullptr, size.width.as_uint32_t(), size.height.as_uint32_t(), format, flags, 0};
+
+    auto storage = take(
+        [&wanted](Pooled const& pooled)
+        {
+            return pooled.bo &&
+                pooled.width == wanted.width && pooled.height == wanted.height &&
+                pooled.format == wanted.format && pooled.flags == wanted.flags;
+        });
+
+    if (storage.bo && !clear(storage.bo))
+    {
+        free(storage);
+        storage.bo = nullptr;
+    }
+
+    if (!storage.bo)
+    {
+        storage = wanted;
+        storage.bo = gbm_bo_create(device, wanted.width, wanted.height, format, flags);
+        if (!storage.bo)
+        {
+            // The allocation may have failed for want of memory we're holding on to
+            trim();
+            storage.bo = gbm_bo_create(device, wanted.width, wanted.height, format, flags);
+        }
+
+        if (!storage.bo)
+            BOOST_THROW_EXCEPTION(std::runtime_error("Failed to create GBM buffer object"));
+
+        storage.bytes = gbm_bo_get_stride(storage.bo) * wanted.height;
+    }
+
+    return {storage.bo, ReleaseBo{shared_from_this(), storage}};
+}
+
+void mgm::BufferPool::exported(std::shared_ptr<gbm_bo> const& bo)
+{
+    if (auto const release = std::get_deleter<ReleaseBo>(bo))
+        release->mark_exported();
+}
+
+auto mgm::BufferPool::create_pixels(std::size_t bytes) -> std::shared_ptr<unsigned char>
+{
+    auto storage = take(
+        [bytes](Pooled const& pooled)
+        {
+            // Sizes differ from buffer to buffer while a window is resized; a somewhat larger
+            // store will do, so long as it doesn't waste too much
+            return !pooled.bo && pooled.bytes >= bytes && pooled.bytes <= 2 * bytes;
+        });
+
+    if (!storage.pixels)
+        storage = {nullptr, new unsigned char[bytes], 0, 0, 0, 0, bytes};
+
+    std::weak_ptr<BufferPool> const weak_self{shared_from_this()};
+    return {
+        storage.pixels,
+        [weak_self, storage](unsigned char*)
+        {
+            if (auto const self = weak_self.lock())
+                self->release(storage);
+            else
+                free(storage);
+        }};
+}
+
+void mgm::BufferPool::trim()
+{
+    std::list<Pooled> trimmed;
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        trimmed.swap(pool);
+        pool_bytes = 0;
+    }
+
+    for (auto const& pooled : trimmed)
+        free(pooled);
+}
+
+auto mgm::BufferPool::pooled_bytes() const -> std::size_t
+{
+    std::lock_guard<decltype(mutex)> lock{mutex};
+    return pool_bytes;
+}
+
+auto mgm::BufferPool::take(std::function<bool(Pooled const&)> const& matches) -> Pooled
+{
+    std::lock_guard<decltype(mutex)> lock{mutex};
+
+    // Prefer the most recently released: it's the most likely to still be in the caches
+    auto const match = std::find_if(pool.rbegin(), pool.rend(), matches);
+
+    if (match == pool.rend())
+        return {nullptr, nullptr, 0, 0, 0, 0, 0};
+
+    auto const found = *match;
+    pool_bytes -= found.bytes;
+    pool.erase(std::next(match).base());
+    return found;
+}
+
+void mgm::BufferPool::release(Pooled const& released)
+{
+    std::list<Pooled> evicted;
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+
+        pool.push_back(released);
+        pool_bytes += released.bytes;
+
+        while (pool_bytes > budget)
+        {
+            pool_bytes -= pool.front().bytes;
+            evicted.splice(evicted.end(), pool, pool.begin());
+        }
+    }
+
+    for (auto const& pooled : evicted)
+        free(pooled);
+}
+
+void mgm::BufferPool::free(Pooled const& pooled)
+{
+    if (pooled.bo)
+        gbm_bo_destroy(pooled.bo);
+    else
+        delete[] pooled.pixels;
+}
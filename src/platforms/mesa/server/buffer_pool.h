@@ -0,0 +1,132 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MIR_GRAPHICS_MESA_BUFFER_POOL_H_
+#define MIR_GRAPHICS_MESA_BUFFER_POOL_H_
+
+#include "mir/geometry/size.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic warning "-Wall"
+#include <gbm.h>
+#pragma GCC diagnostic pop
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+
+namespace mir
+{
+namespace graphics
+{
+namespace mesa
+{
+
+/**
+ * Recycles the GBM buffer objects and software pixel stores of released buffers
+ *
+ * Clients that resize interactively or churn through swapchains release and
+ * allocate buffers of the same few sizes over and over. Rather than pay for a
+ * new GEM object (and its KMS framebuffer, which is cached on the gbm_bo) each
+ * time, released storage is kept here, bucketed by size, format and usage,
+ * and handed to the next allocation that matches.
+ *
+ * Buffer objects that have been exported (their PRIME fd handed to a client)
+ * are never recycled: the client can go on reading and writing them through
+ * the fd after the server releases them.
+ *
+ * At most budget bytes are kept; beyond that (or on trim()) the least recently
+ * released storage is freed.
+ */
+class BufferPool : public std::enable_shared_from_this<BufferPool>
+{
+public:
+    static std::size_t const default_budget = 64 * 1024 * 1024;
+
+    BufferPool(gbm_device* device, std::size_t budget);
+    ~BufferPool();
+
+    /**
+     * A zero-filled buffer object, recycled from the pool if possible.
+     *
+     * A recycled buffer object may hold what the server last rendered into it,
+     * so it is cleared before reuse; if it can't be mapped to be cleared it is
+     * freed and a new buffer object allocated instead.
+     *
+     * \throws std::runtime_error if no buffer object could be allocated
+     */
+    auto create_bo(geometry::Size size, uint32_t format, uint32_t flags) -> std::shared_ptr<gbm_bo>;
+
+    /**
+     * Note that \a bo has been shared outside the server, so it is destroyed
+     * rather than recycled when released.
+     *
+     * Buffer objects that didn't come from a BufferPool are ignored.
+     */
+    static void exported(std::shared_ptr<gbm_bo> const& bo);
+
+    /**
+     * Storage for a software buffer, recycled from the pool if possible.
+     *
+     * A recycled store may be larger than requested. The contents are
+     * unspecified.
+     */
+    auto create_pixels(std::size_t bytes) -> std::shared_ptr<unsigned char>;
+
+    /**
+     * Free everything held for recycling.
+     */
+    void trim();
+
+    auto pooled_bytes() const -> std::size_t;
+
+private:
+    BufferPool(BufferPool const&) = delete;
+    BufferPool& operator=(BufferPool const&) = delete;
+
+    struct Pooled
+    {
+        gbm_bo* bo;                 ///< nullptr for a pixel store
+        unsigned char* pixels;
+        uint32_t width, height, format, flags;
+        std::size_t bytes;
+    };
+
+    class ReleaseBo;
+
+    /// The most recently released entry that matches (removed from the pool), if any
+    auto take(std::function<bool(Pooled const&)> const& matches) -> Pooled;
+    void release(Pooled const& released);
+    static void free(Pooled const& pooled);
+
+    gbm_device* const device;
+    std::size_t const budget;
+
+    std::mutex mutable mutex;
+    std::list<Pooled> pool;     ///< Least recently released first
+    std::size_t pool_bytes{0};
+};
+
+}
+}
+}
+
+#endif // MIR_GRAPHICS_MESA_BUFFER_POOL_H_
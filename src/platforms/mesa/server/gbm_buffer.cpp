@@ -22,6 +22,7 @@
 #include "buffer_texture_binder.h"
 #include "native_buffer.h"
 #include "gbm_format_conversions.h"
+#include "buffer_pool.h"
 
 #include "mir/graphics/program.h"
 #include "mir/graphics/program_factory.h"
@@ -100,6 +101,9 @@ void mgm::GBMBuffer::gl_bind_to_texture()
 
 std::shared_ptr<mg::NativeBuffer> mgm::GBMBuffer::native_buffer_handle() const
 {
+    // Whoever receives the PRIME fd can use the buffer object for as long as they like
+    BufferPool::exported(gbm_handle);
+
     auto temp = std::make_shared<NativeBuffer>();
 
     temp->fd_items = 1;
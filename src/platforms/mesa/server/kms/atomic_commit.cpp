@@ -0,0 +1,102 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "atomic_commit.h"
+#include "page_flipper.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <stdexcept>
+#include <system_error>
+
+namespace mgm = mir::graphics::mesa;
+
+mgm::AtomicCommit::AtomicCommit(int drm_fd)
+    : drm_fd{drm_fd},
+      request_{drmModeAtomicAlloc(), &drmModeAtomicFree}
+{
+    if (!request_)
+        BOOST_THROW_EXCEPTION(std::runtime_error("Failed to allocate atomic KMS request"));
+}
+
+mgm::AtomicCommit::~AtomicCommit()
+{
+    for (auto const blob : blobs)
+        drmModeDestroyPropertyBlob(drm_fd, blob);
+}
+
+void mgm::AtomicCommit::add_property(uint32_t object_id, uint32_t property_id, uint64_t value)
+{
+    auto const ret = drmModeAtomicAddProperty(request_.get(), object_id, property_id, value);
+    if (ret < 0)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(-ret, std::system_category(), "Failed to add property to atomic KMS request"));
+    }
+}
+
+void mgm::AtomicCommit::add_blob_property(uint32_t object_id, uint32_t property_id, uint32_t blob_id)
+{
+    blobs.push_back(blob_id);
+    add_property(object_id, property_id, blob_id);
+}
+
+void mgm::AtomicCommit::add_flip(
+    std::shared_ptr<PageFlipper> const& flipper,
+    uint32_t crtc_id,
+    uint32_t connector_id)
+{
+    if (this->flipper && this->flipper != flipper)
+        BOOST_THROW_EXCEPTION(std::logic_error("Atomic commit spans more than one page flipper"));
+
+    this->flipper = flipper;
+    flips_.push_back({crtc_id, connector_id});
+}
+
+void mgm::AtomicCommit::on_submitted(std::function<void()> const& submitted)
+{
+    submitted_callbacks.push_back(submitted);
+}
+
+bool mgm::AtomicCommit::submit()
+{
+    /* Every output is powered off; there's nothing to flip */
+    if (flips_.empty())
+        return true;
+
+    if (!flipper->schedule_atomic_flip(*this))
+        return false;
+
+    for (auto const& submitted : submitted_callbacks)
+        submitted();
+
+    return true;
+}
+
+bool mgm::AtomicCommit::test() const
+{
+    return drmModeAtomicCommit(drm_fd, request_.get(), DRM_MODE_ATOMIC_TEST_ONLY, nullptr) == 0;
+}
+
+drmModeAtomicReq* mgm::AtomicCommit::request() const
+{
+    return request_.get();
+}
+
+auto mgm::AtomicCommit::flips() const -> std::vector<Flip> const&
+{
+    return flips_;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_MESA_ATOMIC_COMMIT_H_
+#define MIR_GRAPHICS_MESA_ATOMIC_COMMIT_H_
+
+#include <xf86drmMode.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace mesa
+{
+
+class PageFlipper;
+
+/**
+ * The state for one atomic KMS commit, gathered from every output of a
+ * DisplaySyncGroup.
+ *
+ * Outputs add their plane and CRTC properties along with the page flip they
+ * expect; submit() then hands everything to the PageFlipper as a single
+ * nonblocking commit so that all the CRTCs latch the new frame together.
+ */
+class AtomicCommit
+{
+public:
+    struct Flip
+    {
+        uint32_t crtc_id;
+        uint32_t connector_id;
+    };
+
+    explicit AtomicCommit(int drm_fd);
+    ~AtomicCommit();
+
+    void add_property(uint32_t object_id, uint32_t property_id, uint64_t value);
+
+    /**
+     * Set a blob property, taking ownership of the blob.
+     *
+     * The blob is destroyed along with the AtomicCommit; the kernel keeps its
+     * own reference once the commit has been submitted.
+     */
+    void add_blob_property(uint32_t object_id, uint32_t property_id, uint32_t blob_id);
+
+    /**
+     * Expect a page flip event for crtc_id when the commit completes.
+     *
+     * All the flips in a commit must go through the same PageFlipper.
+     */
+    void add_flip(std::shared_ptr<PageFlipper> const& flipper, uint32_t crtc_id, uint32_t connector_id);
+
+    /**
+     * Call submitted once the kernel has accepted the commit.
+     *
+     * Outputs use this to track what they have on screen: a commit can be
+     * rejected, and then rebuilt differently, after they have added to it.
+     */
+    void on_submitted(std::function<void()> const& submitted);
+
+    /**
+     * Validate and submit the commit.
+     *
+     * \return  false if the kernel rejected the commit, in which case nothing
+     *          has been scheduled.
+     */
+    bool submit();
+
+    /**
+     * Check the commit with DRM_MODE_ATOMIC_TEST_ONLY, without applying it.
+     */
+    bool test() const;
+
+    drmModeAtomicReq* request() const;
+    std::vector<Flip> const& flips() const;
+
+private:
+    AtomicCommit(AtomicCommit const&) = delete;
+    AtomicCommit& operator=(AtomicCommit const&) = delete;
+
+    int const drm_fd;
+    std::unique_ptr<drmModeAtomicReq, void(*)(drmModeAtomicReqPtr)> const request_;
+    std::vector<uint32_t> blobs;
+    std::shared_ptr<PageFlipper> flipper;
+    std::vector<Flip> flips_;
+    std::vector<std::function<void()>> submitted_callbacks;
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_MESA_ATOMIC_COMMIT_H_ */
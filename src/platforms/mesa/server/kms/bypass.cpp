@@ -20,6 +20,8 @@
 #include "mir/graphics/display_buffer.h"
 #include "bypass.h"
 
+#include <algorithm>
+
 using namespace mir;
 namespace mgm = mir::graphics::mesa;
 
@@ -46,3 +48,38 @@ bool mgm::BypassMatch::operator()(std::shared_ptr<graphics::Renderable> const& r
     bypass_is_feasible = (is_opaque && fits && is_orthogonal);
     return bypass_is_feasible;
 }
+
+bool mgm::find_scanout_candidates(
+    graphics::RenderableList const& renderlist,
+    geometry::Rectangle const& view_area,
+    ScanoutCandidates& candidates)
+{
+    glm::mat4 const identity(1);
+    candidates = {};
+
+    for (auto renderable = renderlist.rbegin(); renderable != renderlist.rend(); ++renderable)
+    {
+        auto const& position = (*renderable)->screen_position();
+
+        if (!view_area.overlaps(position))
+            continue;
+
+        auto const is_orthogonal = ((*renderable)->transformation() == identity);
+        auto const is_opaque = ((*renderable)->alpha() == 1.0f) && !(*renderable)->shaped();
+
+        if (is_orthogonal && is_opaque && position == view_area)
+        {
+            candidates.primary = *renderable;
+            std::reverse(candidates.overlays.begin(), candidates.overlays.end());
+            return true;
+        }
+
+        /* Overlay planes blend per-pixel alpha, but not a whole-surface alpha */
+        if (!is_orthogonal || (*renderable)->alpha() != 1.0f || !view_area.contains(position))
+            return false;
+
+        candidates.overlays.push_back(*renderable);
+    }
+
+    return false;
+}
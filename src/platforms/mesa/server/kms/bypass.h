@@ -39,6 +39,29 @@ private:
     glm::mat4 const identity;
 };
 
+/**
+ * Renderables that can be scanned out without compositing: one that fills
+ * the output opaquely, for the primary plane, and those stacked above it,
+ * for overlay planes.
+ */
+struct ScanoutCandidates
+{
+    std::shared_ptr<graphics::Renderable> primary;
+    RenderableList overlays;    ///< Bottom to top
+};
+
+/**
+ * Find the ScanoutCandidates of a renderable list.
+ *
+ * \returns false if nothing fills view_area, or if something above it can't
+ *          go on an overlay plane because it is transformed, translucent or
+ *          not entirely inside view_area.
+ */
+bool find_scanout_candidates(
+    RenderableList const& renderlist,
+    geometry::Rectangle const& view_area,
+    ScanoutCandidates& candidates);
+
 } // namespace mesa
 } // namespace graphics
 } // namespace mir
@@ -28,6 +28,8 @@
 
 #include <boost/exception/errinfo_errno.hpp>
 
+#include <algorithm>
+#include <iterator>
 #include <stdexcept>
 #include <vector>
 
@@ -38,6 +40,7 @@ namespace geom = mir::geometry;
 namespace
 {
 const uint64_t fallback_cursor_size = 64;
+
 char const* const mir_drm_cursor_64x64 = "MIR_DRM_CURSOR_64x64";
 
 // Transforms a relative position within the display bounds described by \a rect which is rotated with \a orientation
@@ -162,7 +165,7 @@ mgm::Cursor::Cursor(
                 [this, &kms_conf](auto const& output)
                 {
                     // I'm not sure why g++ needs the explicit "this->" but it does - alan_g
-                    this->buffer_for_output(*kms_conf.get_output_for(output.id));
+                    this->buffers_for_output(*kms_conf.get_output_for(output.id));
                 });
         });
 
@@ -296,16 +299,9 @@ void mgm::Cursor::show(CursorImage const& cursor_image)
     memcpy(argb8888.data(), cursor_image.as_argb_8888(), argb8888.size());
 
     hotspot = cursor_image.hotspot();
-    {
-        auto locked_buffers = buffers.lock();
-        for (auto& tuple : *locked_buffers)
-        {
-            pad_and_write_image_data_locked(lg, std::get<2>(tuple));
-        }
-    }
+    current_image = image_ids.get(cursor_image, [this] { return ++last_image; });
 
-    // Writing the data could throw an exception so lets
-    // hold off on setting visible until after we have succeeded.
+    // Buffers are written as the cursor is placed on each output
     visible = true;
     place_cursor_at_locked(lg, current_position, ForceState);
 }
@@ -394,14 +390,11 @@ void mgm::Cursor::place_cursor_at_locked(
             // work on radeon and intel. There also seems to be precedent in weston for
             // implementing hotspot in this fashion.
             output.move_cursor(geom::Point{} + dp - hs);
-            auto& buffer = buffer_for_output(output);
-
-            auto const changed_orientation = buffer.change_orientation(orientation);
 
-            if (changed_orientation)
-                pad_and_write_image_data_locked(lg, buffer);
+            bool needs_set{false};
+            auto& buffer = buffer_for_output(lg, output, orientation, needs_set);
 
-            if (force_state || !output.has_cursor() || changed_orientation)
+            if (force_state || !output.has_cursor() || needs_set)
             {
                 if (!output.set_cursor(buffer) || !output.has_cursor())
                     set_on_all_outputs = false;
@@ -419,7 +412,7 @@ void mgm::Cursor::place_cursor_at_locked(
     last_set_failed = !set_on_all_outputs;
 }
 
-mgm::Cursor::GBMBOWrapper& mgm::Cursor::buffer_for_output(KMSOutput const& output)
+auto mgm::Cursor::buffers_for_output(KMSOutput const& output) -> std::list<GBMBOWrapper>&
 {
     auto const drm_fd = output.drm_fd();
     auto const id = output.id();
@@ -432,9 +425,12 @@ mgm::Cursor::GBMBOWrapper& mgm::Cursor::buffer_for_output(KMSOutput const& outpu
             return std::get<2>(bo);
     }
 
-    locked_buffers->push_back(image_buffer{id, drm_fd, GBMBOWrapper{drm_fd, mir_orientation_normal}});
+    locked_buffers->emplace_back(id, drm_fd, std::list<GBMBOWrapper>{});
 
-    GBMBOWrapper& bo = std::get<2>(locked_buffers->back());
+    auto& output_buffers = std::get<2>(locked_buffers->back());
+    output_buffers.emplace_back(drm_fd, mir_orientation_normal);
+
+    GBMBOWrapper& bo = output_buffers.back();
     if (gbm_bo_get_width(bo) < min_buffer_width)
     {
         min_buffer_width = gbm_bo_get_width(bo);
@@ -444,5 +440,46 @@ mgm::Cursor::GBMBOWrapper& mgm::Cursor::buffer_for_output(KMSOutput const& outpu
         min_buffer_height = gbm_bo_get_height(bo);
     }
 
-    return bo;
+    return output_buffers;
+}
+
+mgm::Cursor::GBMBOWrapper& mgm::Cursor::buffer_for_output(
+    std::lock_guard<std::mutex> const& lg,
+    KMSOutput const& output,
+    MirOrientation orientation,
+    bool& needs_set)
+{
+    auto& output_buffers = buffers_for_output(output);
+
+    auto const holding_image = std::find_if(
+        begin(output_buffers),
+        end(output_buffers),
+        [this, orientation](GBMBOWrapper const& bo)
+        {
+            return bo.image == current_image && bo.orientation() == orientation;
+        });
+
+    if (holding_image != end(output_buffers))
+    {
+        needs_set = holding_image != begin(output_buffers);
+        output_buffers.splice(begin(output_buffers), output_buffers, holding_image);
+        return output_buffers.front();
+    }
+
+    // Reuse the least recently used buffer, unless we're still filling the cache
+    if (output_buffers.size() < decltype(image_ids)::default_capacity)
+        output_buffers.emplace_front(output.drm_fd(), orientation);
+    else
+        output_buffers.splice(begin(output_buffers), output_buffers, std::prev(end(output_buffers)));
+
+    auto& buffer = output_buffers.front();
+    buffer.change_orientation(orientation);
+
+    // Forget the old contents first, in case writing the new ones fails
+    buffer.image = 0;
+    pad_and_write_image_data_locked(lg, buffer);
+    buffer.image = current_image;
+
+    needs_set = true;
+    return buffer;
 }
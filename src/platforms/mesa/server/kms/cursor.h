@@ -21,6 +21,7 @@
 #define MIR_GRAPHICS_MESA_CURSOR_H_
 
 #include "mir/graphics/cursor.h"
+#include "mir/graphics/cursor_image_cache.h"
 #include "mir/geometry/point.h"
 #include "mir/geometry/displacement.h"
 
@@ -30,6 +31,7 @@
 #include <gbm.h>
 
 #include <functional>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <vector>
@@ -99,8 +101,18 @@ private:
         GBMBOWrapper& buffer);
     void clear(std::lock_guard<std::mutex> const&);
 
-    GBMBOWrapper& buffer_for_output(KMSOutput const& output);
-    
+    /// The buffers for an output, creating the first if needed
+    std::list<GBMBOWrapper>& buffers_for_output(KMSOutput const& output);
+
+    /// The buffer holding the current image for output, in the given orientation
+    /// Buffers are kept for the most recently shown images, so switching back to one of them only needs the output to
+    /// be pointed at a different buffer. Sets needs_set if that, or rewriting the buffer, was needed.
+    GBMBOWrapper& buffer_for_output(
+        std::lock_guard<std::mutex> const&,
+        KMSOutput const& output,
+        MirOrientation orientation,
+        bool& needs_set);
+
     std::mutex guard;
 
     KMSOutputContainer& output_container;
@@ -109,6 +121,11 @@ private:
     geometry::Size size;
     std::vector<uint8_t> argb8888;
 
+    /// Identifies the image in argb8888, so buffers already holding it can be reused. 0 for no image.
+    uint64_t current_image{0};
+    uint64_t last_image{0};
+    CursorImageCache<uint64_t> image_ids;
+
     bool visible;
     bool last_set_failed;
 
@@ -120,6 +137,9 @@ private:
         auto orientation() const -> MirOrientation { return current_orientation; }
         auto change_orientation(MirOrientation new_orientation) -> bool;
 
+        /// The image written to the buffer, as in Cursor::current_image
+        uint64_t image{0};
+
         ~GBMBOWrapper();
 
         GBMBOWrapper(GBMBOWrapper&& from);
@@ -131,7 +151,8 @@ private:
         GBMBOWrapper& operator=(GBMBOWrapper const&) = delete;
     };
 
-    using image_buffer = std::tuple<uint32_t, int, GBMBOWrapper>;
+    /// The buffers for each output, most recently used first
+    using image_buffer = std::tuple<uint32_t, int, std::list<GBMBOWrapper>>;
     Mutex<std::vector<image_buffer>> buffers;
 
     uint32_t min_buffer_width;
@@ -17,6 +17,7 @@
  */
 
 #include "display_buffer.h"
+#include "atomic_commit.h"
 #include "kms_output.h"
 #include "mir/graphics/display_report.h"
 #include "mir/graphics/transformation.h"
@@ -25,6 +26,7 @@
 #include "mir/fatal.h"
 #include "mir/log.h"
 #include "native_buffer.h"
+#include "shm_scanout.h"
 #include "mir/graphics/egl_error.h"
 
 #include <boost/throw_exception.hpp>
@@ -587,20 +589,27 @@ bool mgm::DisplayBuffer::overlay(RenderableList const& renderable_list)
     if (transform == no_transformation &&
        (bypass_option == mgm::BypassOption::allowed))
     {
-        mgm::BypassMatch bypass_match(area);
-        auto bypass_it = std::find_if(renderable_list.rbegin(), renderable_list.rend(), bypass_match);
-        if (bypass_it != renderable_list.rend())
+        mgm::ScanoutCandidates candidates;
+        if (mgm::find_scanout_candidates(renderable_list, area, candidates))
         {
-            auto bypass_buffer = (*bypass_it)->buffer();
-            auto native = std::dynamic_pointer_cast<mgm::NativeBuffer>(bypass_buffer->native_buffer_handle());
-            if (native && native->flags & mir_buffer_flag_can_scanout &&
-                bypass_buffer->size() == surface.size() &&
-                !needs_bounce_buffer(*outputs.front(), native->bo))
+            auto bypass_buffer = candidates.primary->buffer();
+            if (auto bufobj = scanout_fb_for(*bypass_buffer, surface.size()))
             {
-                if (auto bufobj = outputs.front()->fb_for(native->bo))
+                if (candidates.overlays.empty() || assign_overlays(*bufobj, candidates.overlays))
                 {
                     bypass_buf = bypass_buffer;
                     bypass_bufobj = bufobj;
+                    bypass_is_copy = false;
+                    return true;
+                }
+            }
+            else if (candidates.overlays.empty())
+            {
+                if (auto bufobj = shm_scanout_fb_for(*bypass_buffer))
+                {
+                    bypass_buf = bypass_buffer;
+                    bypass_bufobj = bufobj;
+                    bypass_is_copy = true;
                     return true;
                 }
             }
@@ -609,6 +618,96 @@ bool mgm::DisplayBuffer::overlay(RenderableList const& renderable_list)
 
     bypass_buf = nullptr;
     bypass_bufobj = nullptr;
+    overlay_layers.clear();
+    overlay_bufs.clear();
+    return false;
+}
+
+mgm::FBHandle* mgm::DisplayBuffer::scanout_fb_for(Buffer& buffer, geom::Size const& size) const
+{
+    std::shared_ptr<mgm::NativeBuffer> native;
+    try
+    {
+        native = std::dynamic_pointer_cast<mgm::NativeBuffer>(buffer.native_buffer_handle());
+    }
+    catch (std::exception const&)
+    {
+        // Software buffers, such as those from wl_shm, have no native handle
+        return nullptr;
+    }
+
+    if (native && native->flags & mir_buffer_flag_can_scanout &&
+        buffer.size() == size &&
+        !needs_bounce_buffer(*outputs.front(), native->bo))
+    {
+        return outputs.front()->fb_for(native->bo);
+    }
+    return nullptr;
+}
+
+mgm::FBHandle* mgm::DisplayBuffer::shm_scanout_fb_for(Buffer& buffer)
+{
+    if (!shm_scanout_supported || buffer.size() != surface.size())
+        return nullptr;
+
+    if (!shm_scanout)
+    {
+        try
+        {
+            shm_scanout = std::make_unique<ShmScanout>(outputs.front()->drm_fd(), surface.size());
+        }
+        catch (std::exception const& e)
+        {
+            mir::log_info("Fullscreen software clients will be composited: %s", e.what());
+            shm_scanout_supported = false;
+            return nullptr;
+        }
+    }
+
+    if (auto const bo = shm_scanout->import(buffer))
+        return outputs.front()->fb_for(bo);
+
+    return nullptr;
+}
+
+bool mgm::DisplayBuffer::assign_overlays(FBHandle const& primary, RenderableList const& overlays)
+{
+    /*
+     * Overlay planes belong to a CRTC, and are only reachable through atomic
+     * commits, so stick to compositing for clone groups and legacy drivers.
+     */
+    if (outputs.size() != 1 || !atomic_page_flips || needs_set_crtc)
+        return false;
+
+    /* The frame whose overlays were turned down wasn't shown; let GL composite this one */
+    if (overlays_rejected)
+    {
+        overlays_rejected = false;
+        return false;
+    }
+
+    overlay_layers.clear();
+    overlay_bufs.clear();
+
+    for (auto const& renderable : overlays)
+    {
+        auto const position = renderable->screen_position();
+        auto const buffer = renderable->buffer();
+
+        /* Planes could scale, but drivers disagree on how well; don't ask them to */
+        auto const bufobj = scanout_fb_for(*buffer, position.size);
+        if (!bufobj)
+            break;
+
+        overlay_layers.push_back({bufobj, {as_point(position.top_left - area.top_left), position.size}});
+        overlay_bufs.push_back(buffer);
+    }
+
+    if (overlay_bufs.size() == overlays.size() && outputs.front()->test_overlays(primary, overlay_layers))
+        return true;
+
+    overlay_layers.clear();
+    overlay_bufs.clear();
     return false;
 }
 
@@ -623,6 +722,8 @@ void mgm::DisplayBuffer::swap_buffers()
     surface.swap_buffers();
     bypass_buf = nullptr;
     bypass_bufobj = nullptr;
+    overlay_layers.clear();
+    overlay_bufs.clear();
 }
 
 void mgm::DisplayBuffer::set_crtc(FBHandle const& forced_frame)
@@ -666,21 +767,45 @@ void mgm::DisplayBuffer::post()
             fatal_error("Failed to get front buffer object");
     }
 
-    /*
-     * Try to schedule a page flip as first preference to avoid tearing.
-     * [will complete in a background thread]
-     */
-    if (!needs_set_crtc && !schedule_page_flip(*bufobj))
-        needs_set_crtc = true;
+    if (!overlay_layers.empty())
+    {
+        /*
+         * Nothing else has drawn the renderables on the overlay planes, so if
+         * the kernel turns them down now the frame can't be shown without
+         * them. Keep the last frame on screen instead, and have the next one
+         * composited.
+         */
+        if (!schedule_atomic_page_flip(*bufobj))
+        {
+            mir::log_debug("Overlay planes rejected at commit; compositing the next frame");
+            overlays_rejected = true;
+            bypass_buf = nullptr;
+            bypass_bufobj = nullptr;
+            overlay_layers.clear();
+            overlay_bufs.clear();
+            return;
+        }
 
-    /*
-     * Fallback blitting: Not pretty, since it may tear. VirtualBox seems
-     * to need to do this on every frame. [will complete in this thread]
-     */
-    if (needs_set_crtc)
+        page_flips_pending = true;
+    }
+    else
     {
-        set_crtc(*bufobj);
-        needs_set_crtc = false;
+        /*
+         * Try to schedule a page flip as first preference to avoid tearing.
+         * [will complete in a background thread]
+         */
+        if (!needs_set_crtc && !schedule_page_flip(*bufobj))
+            needs_set_crtc = true;
+
+        /*
+         * Fallback blitting: Not pretty, since it may tear. VirtualBox seems
+         * to need to do this on every frame. [will complete in this thread]
+         */
+        if (needs_set_crtc)
+        {
+            set_crtc(*bufobj);
+            needs_set_crtc = false;
+        }
     }
 
     using namespace std;  // For operator""ms()
@@ -699,7 +824,10 @@ void mgm::DisplayBuffer::post()
          * Also, bypass does not need the deferred page flip because it has
          * no compositing/rendering step for which to save time for.
          */
-        scheduled_bypass_frame = bypass_buf;
+        /* A copied software buffer can go back to the client right away */
+        if (!bypass_is_copy)
+            scheduled_bypass_frame = bypass_buf;
+        scheduled_overlay_frames = std::move(overlay_bufs);
         wait_for_page_flip();
 
         // It's very likely the next frame will be bypassed like this one so
@@ -728,6 +856,8 @@ void mgm::DisplayBuffer::post()
     // Buffer lifetimes are managed exclusively by scheduled*/visible* now
     bypass_buf = nullptr;
     bypass_bufobj = nullptr;
+    overlay_layers.clear();
+    overlay_bufs.clear();
 
     recommend_sleep = 0ms;
     if (outputs.size() == 1)
@@ -750,6 +880,12 @@ bool mgm::DisplayBuffer::schedule_page_flip(FBHandle const& bufobj)
      * Schedule the current front buffer object for display. Note that
      * the page flip is asynchronous and synchronized with vertical refresh.
      */
+    if (atomic_page_flips && schedule_atomic_page_flip(bufobj))
+    {
+        page_flips_pending = true;
+        return page_flips_pending;
+    }
+
     for (auto& output : outputs)
     {
         if (output->schedule_page_flip(bufobj))
@@ -759,6 +895,57 @@ bool mgm::DisplayBuffer::schedule_page_flip(FBHandle const& bufobj)
     return page_flips_pending;
 }
 
+bool mgm::DisplayBuffer::schedule_atomic_page_flip(FBHandle const& bufobj)
+{
+    /*
+     * A single commit flips every output together, so the outputs of a
+     * clone group latch each frame on the same vblank.
+     */
+    auto const add_page_flips =
+        [this, &bufobj](AtomicCommit& commit, std::vector<OverlayLayer> const& overlays)
+        {
+            for (auto& output : outputs)
+            {
+                if (!output->add_page_flip(commit, bufobj, overlays))
+                    return false;
+            }
+            return true;
+        };
+
+    /*
+     * The kernel can still turn down overlays that passed assign_overlays(),
+     * e.g. for bandwidth. Flipping without them would lose their renderables,
+     * so that is left to post().
+     */
+    if (!overlay_layers.empty())
+    {
+        AtomicCommit commit{outputs.front()->drm_fd()};
+        return add_page_flips(commit, overlay_layers) && commit.submit();
+    }
+
+    AtomicCommit commit{outputs.front()->drm_fd()};
+    if (!add_page_flips(commit, {}))
+    {
+        atomic_page_flips = false;
+        return false;
+    }
+
+    if (commit.submit())
+        return true;
+
+    /*
+     * A commit that passes the test can still fail (e.g. EBUSY), which only
+     * costs us this frame; one that doesn't pass means atomic flips won't work.
+     */
+    if (!commit.test())
+    {
+        mir::log_warning("Atomic page flip rejected by the kernel; falling back to legacy page flips");
+        atomic_page_flips = false;
+    }
+
+    return false;
+}
+
 void mgm::DisplayBuffer::wait_for_page_flip()
 {
     if (page_flips_pending)
@@ -777,6 +964,9 @@ void mgm::DisplayBuffer::wait_for_page_flip()
         visible_bypass_frame = scheduled_bypass_frame;
         scheduled_bypass_frame = nullptr;
 
+        visible_overlay_frames = std::move(scheduled_overlay_frames);
+        scheduled_overlay_frames.clear();
+
         visible_composite_frame = std::move(scheduled_composite_frame);
         scheduled_composite_frame = nullptr;
     }
@@ -25,6 +25,7 @@
 #include "display_helpers.h"
 #include "egl_helper.h"
 #include "platform_common.h"
+#include "kms_output.h"
 
 #include <vector>
 #include <memory>
@@ -43,8 +44,8 @@ namespace mesa
 
 class Platform;
 class FBHandle;
-class KMSOutput;
 class NativeBuffer;
+class ShmScanout;
 
 class GBMOutputSurface : public renderer::gl::RenderTarget
 {
@@ -128,11 +129,20 @@ public:
 
 private:
     bool schedule_page_flip(FBHandle const& bufobj);
+    bool schedule_atomic_page_flip(FBHandle const& bufobj);
     void set_crtc(FBHandle const&);
+    FBHandle* scanout_fb_for(Buffer& buffer, geometry::Size const& size) const;
+    FBHandle* shm_scanout_fb_for(Buffer& buffer);
+    bool assign_overlays(FBHandle const& primary, RenderableList const& overlays);
 
     std::shared_ptr<graphics::Buffer> visible_bypass_frame, scheduled_bypass_frame;
     std::shared_ptr<Buffer> bypass_buf{nullptr};
     FBHandle* bypass_bufobj{nullptr};
+    bool bypass_is_copy{false};     ///< bypass_buf was copied into shm_scanout
+    std::vector<OverlayLayer> overlay_layers;
+    std::vector<std::shared_ptr<Buffer>> overlay_bufs;
+    bool overlays_rejected{false};  ///< The kernel turned down the last overlays; composite the next frame
+    std::vector<std::shared_ptr<Buffer>> visible_overlay_frames, scheduled_overlay_frames;
     std::shared_ptr<DisplayReport> const listener;
     BypassOption bypass_option;
 
@@ -150,11 +160,15 @@ private:
     GBMOutputSurface::FrontBuffer visible_composite_frame;
     GBMOutputSurface::FrontBuffer scheduled_composite_frame;
 
+    std::unique_ptr<ShmScanout> shm_scanout;
+    bool shm_scanout_supported{true};
+
     geometry::Rectangle area;
     glm::mat2 transform;
     std::atomic<bool> needs_set_crtc;
     std::chrono::milliseconds recommend_sleep{0};
     bool page_flips_pending;
+    bool atomic_page_flips{true};
 };
 
 }
@@ -22,6 +22,7 @@
 #include "mir/geometry/size.h"
 #include "mir/geometry/point.h"
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/rectangle.h"
 #include "mir/graphics/display_configuration.h"
 #include "mir/graphics/frame.h"
 #include "mir_toolkit/common.h"
@@ -29,6 +30,7 @@
 #include "kms-utils/drm_mode_resources.h"
 
 #include <gbm.h>
+#include <vector>
 
 namespace mir
 {
@@ -39,8 +41,18 @@ class DisplayConfigurationOutput;
 namespace mesa
 {
 
+class AtomicCommit;
 class FBHandle;
 
+/**
+ * A buffer to scan out on an overlay plane
+ */
+struct OverlayLayer
+{
+    FBHandle const* fb;
+    geometry::Rectangle position;   ///< Relative to the top-left of the output
+};
+
 class KMSOutput
 {
 public:
@@ -69,6 +81,31 @@ public:
     virtual bool schedule_page_flip(FBHandle const& fb) = 0;
     virtual void wait_for_page_flip() = 0;
 
+    /**
+     * Add a page flip to fb to an atomic commit shared with other outputs,
+     * instead of scheduling it alone with schedule_page_flip().
+     *
+     * Any gamma change made since the last flip goes in the same commit.
+     * The flip is waited for with wait_for_page_flip() as usual.
+     *
+     * Overlay planes used by the previous flip but not in overlays are
+     * turned off.
+     *
+     * \return  false if this output can't be driven by atomic commits, or
+     *          has too few suitable overlay planes; the caller should use
+     *          schedule_page_flip() instead.
+     */
+    virtual bool add_page_flip(
+        AtomicCommit& commit,
+        FBHandle const& fb,
+        std::vector<OverlayLayer> const& overlays) = 0;
+
+    /**
+     * Check whether the driver accepts fb on the primary plane with overlays
+     * (bottom to top) stacked above it, without changing anything on screen.
+     */
+    virtual bool test_overlays(FBHandle const& fb, std::vector<OverlayLayer> const& overlays) = 0;
+
     virtual bool set_cursor(gbm_bo* buffer) = 0;
     virtual void move_cursor(geometry::Point destination) = 0;
     virtual bool clear_cursor() = 0;
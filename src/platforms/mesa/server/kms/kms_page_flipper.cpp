@@ -17,6 +17,7 @@
  */
 
 #include "kms_page_flipper.h"
+#include "atomic_commit.h"
 #include "mir/graphics/display_report.h"
 
 #include <stdexcept>
@@ -44,6 +45,35 @@ void page_flip_handler(int /*fd*/, unsigned int seq,
                                               seq, ns);
 }
 
+/*
+ * An atomic commit raises one event per CRTC, all with the same user data,
+ * so the CRTC has to come from the event itself. Kernels before 4.12 leave
+ * it as 0, which only happens for legacy flips (see enable_atomic_modesetting())
+ * and their user data does name the CRTC.
+ */
+void page_flip_handler2(int /*fd*/, unsigned int seq,
+                        unsigned int sec, unsigned int usec,
+                        unsigned int crtc_id, void* data)
+{
+    auto page_flip_data = static_cast<mgm::PageFlipEventData*>(data);
+    std::chrono::nanoseconds ns{sec*1000000000LL + usec*1000LL};
+    page_flip_data->flipper->notify_page_flip(
+        crtc_id ? crtc_id : page_flip_data->crtc_id, seq, ns);
+}
+
+/*
+ * Kernels from 4.2 to 4.11 accept atomic commits but don't say which CRTC
+ * an event is for, and an atomic commit has no per-CRTC user data to fall
+ * back on. On those we stick to legacy flips.
+ */
+bool enable_atomic_modesetting(int drm_fd)
+{
+    uint64_t crtc_in_event = 0;
+    if (drmGetCap(drm_fd, DRM_CAP_CRTC_IN_VBLANK_EVENT, &crtc_in_event) || !crtc_in_event)
+        return false;
+
+    return drmSetClientCap(drm_fd, DRM_CLIENT_CAP_ATOMIC, 1) == 0;
+}
 }
 
 mgm::KMSPageFlipper::KMSPageFlipper(
@@ -51,6 +81,8 @@ mgm::KMSPageFlipper::KMSPageFlipper(
     std::shared_ptr<DisplayReport> const& report) :
     drm_fd{drm_fd},
     report{report},
+    atomic_flips{enable_atomic_modesetting(drm_fd)},
+    atomic_flip_data{0, 0, this},
     pending_page_flips(),
     worker_tid()
 {
@@ -88,12 +120,74 @@ bool mgm::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
     return (ret == 0);
 }
 
+bool mgm::KMSPageFlipper::supports_atomic_flips() const
+{
+    return atomic_flips;
+}
+
+bool mgm::KMSPageFlipper::schedule_atomic_flip(AtomicCommit const& commit)
+{
+    std::unique_lock<std::mutex> lock{pf_mutex};
+
+    for (auto const& flip : commit.flips())
+    {
+        if (pending_page_flips.find(flip.crtc_id) != pending_page_flips.end())
+            BOOST_THROW_EXCEPTION(std::logic_error("Page flip for crtc_id is already scheduled"));
+    }
+
+    if (!commit.test())
+        return false;
+
+    for (auto const& flip : commit.flips())
+        pending_page_flips[flip.crtc_id] = PageFlipEventData{flip.crtc_id, flip.connector_id, this};
+
+    auto ret = drmModeAtomicCommit(drm_fd, commit.request(),
+                                   DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT,
+                                   &atomic_flip_data);
+
+    if (ret)
+    {
+        for (auto const& flip : commit.flips())
+            pending_page_flips.erase(flip.crtc_id);
+    }
+
+    return (ret == 0);
+}
+
 mg::Frame mgm::KMSPageFlipper::wait_for_flip(uint32_t crtc_id)
+{
+    wait_for_flip_event(crtc_id);
+
+    Frame frame;
+    uint32_t connector_id;
+    {
+        std::unique_lock<std::mutex> lock{pf_mutex};
+        frame = completed_page_flips[crtc_id];
+
+        auto const unreported = unreported_page_flips.find(crtc_id);
+        if (unreported == unreported_page_flips.end())
+            return frame;
+
+        connector_id = unreported->second;
+        unreported_page_flips.erase(unreported);
+    }
+
+    /*
+     * Report the flip from the thread that waited for it, rather than from
+     * whichever thread happened to handle the event: that is the thread
+     * compositing the output, which presentation feedback relies on.
+     */
+    report->report_vsync(connector_id, frame);
+    return frame;
+}
+
+void mgm::KMSPageFlipper::wait_for_flip_event(uint32_t crtc_id)
 {
     drmEventContext evctx;
     memset(&evctx, 0, sizeof evctx);
-    evctx.version = 2;  // We only support the old v2 page_flip_handler
+    evctx.version = 3;
     evctx.page_flip_handler = &page_flip_handler;
+    evctx.page_flip_handler2 = &page_flip_handler2;
 
     static std::thread::id const invalid_tid;
 
@@ -109,7 +203,7 @@ mg::Frame mgm::KMSPageFlipper::wait_for_flip(uint32_t crtc_id)
 
         /* If the page flip we are waiting for has arrived we are done. */
         if (page_flip_is_done(crtc_id))
-            return completed_page_flips[crtc_id];
+            return;
 
         /* ...otherwise we become the worker */
         worker_tid = std::this_thread::get_id();
@@ -159,7 +253,6 @@ mg::Frame mgm::KMSPageFlipper::wait_for_flip(uint32_t crtc_id)
          */
         pf_cv.notify_all();
     }
-    return completed_page_flips[crtc_id];
 }
 
 std::thread::id mgm::KMSPageFlipper::debug_get_worker_tid()
@@ -184,7 +277,7 @@ void mgm::KMSPageFlipper::notify_page_flip(uint32_t crtc_id, int64_t msc,
         auto& frame = completed_page_flips[crtc_id];
         frame.msc = msc;
         frame.ust = {clock_id, ust};
-        report->report_vsync(pending->second.connector_id, frame);
+        unreported_page_flips[crtc_id] = pending->second.connector_id;
         pending_page_flips.erase(pending);
     }
 }
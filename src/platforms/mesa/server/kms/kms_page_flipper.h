@@ -55,16 +55,25 @@ public:
     bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) override;
     Frame wait_for_flip(uint32_t crtc_id) override;
 
+    bool supports_atomic_flips() const override;
+    bool schedule_atomic_flip(AtomicCommit const& commit) override;
+
     std::thread::id debug_get_worker_tid();
 
     void notify_page_flip(uint32_t crtc_id, int64_t msc, std::chrono::nanoseconds ust);
 private:
+    void wait_for_flip_event(uint32_t crtc_id);
     bool page_flip_is_done(uint32_t crtc_id);
 
     int const drm_fd;
     std::shared_ptr<DisplayReport> const report;
+    bool const atomic_flips;
+    /* Shared by every CRTC of an atomic commit; the event tells us which CRTC flipped */
+    PageFlipEventData atomic_flip_data;
     std::unordered_map<uint32_t,PageFlipEventData> pending_page_flips;
     std::unordered_map<uint32_t,Frame> completed_page_flips;
+    /* The connector of each completed flip that wait_for_flip() has yet to report */
+    std::unordered_map<uint32_t,uint32_t> unreported_page_flips;
     std::mutex pf_mutex;
     std::condition_variable pf_cv;
     std::thread::id worker_tid;
@@ -28,6 +28,7 @@ namespace graphics
 {
 namespace mesa
 {
+class AtomicCommit;
 
 class PageFlipper
 {
@@ -37,6 +38,21 @@ public:
     virtual bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) = 0;
     virtual Frame wait_for_flip(uint32_t crtc_id) = 0;
 
+    /**
+     * Whether the DRM device accepts atomic commits.
+     */
+    virtual bool supports_atomic_flips() const = 0;
+
+    /**
+     * Schedule the flips of every CRTC in commit with a single atomic commit.
+     *
+     * The commit is checked with DRM_MODE_ATOMIC_TEST_ONLY first. The flip of
+     * each CRTC is waited for with wait_for_flip(), as for schedule_flip().
+     *
+     * \return  false if the kernel rejected the commit; no flips are pending.
+     */
+    virtual bool schedule_atomic_flip(AtomicCommit const& commit) = 0;
+
 protected:
     PageFlipper() = default;
     PageFlipper(PageFlipper const&) = delete;
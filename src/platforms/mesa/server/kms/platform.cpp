@@ -54,7 +54,8 @@ namespace mgmh = mgm::helpers;
 mgm::Platform::Platform(std::shared_ptr<DisplayReport> const& listener,
                         std::shared_ptr<ConsoleServices> const& vt,
                         EmergencyCleanupRegistry&,
-                        BypassOption bypass_option)
+                        BypassOption bypass_option,
+                        std::size_t buffer_pool_budget)
     : udev{std::make_shared<mir::udev::Context>()},
       drm{helpers::DRMHelper::open_all_devices(udev, *vt)},
       // We assume the first DRM device is the boot GPU, and arbitrarily pick it as our
@@ -64,7 +65,8 @@ mgm::Platform::Platform(std::shared_ptr<DisplayReport> const& listener,
       gbm{std::make_shared<mgmh::GBMHelper>(drm.front()->fd)},
       listener{listener},
       vt{vt},
-      bypass_option_{bypass_option}
+      bypass_option_{bypass_option},
+      buffer_pool_budget{buffer_pool_budget}
 {
     auth_factory = std::make_unique<DRMNativePlatformAuthFactory>(*drm.front());
 }
@@ -72,7 +74,8 @@ mgm::Platform::Platform(std::shared_ptr<DisplayReport> const& listener,
 mir::UniqueModulePtr<mg::GraphicBufferAllocator> mgm::Platform::create_buffer_allocator(
     mg::Display const& output)
 {
-    return make_module_ptr<mgm::BufferAllocator>(output, gbm->device, bypass_option_, mgm::BufferImportMethod::gbm_native_pixmap);
+    return make_module_ptr<mgm::BufferAllocator>(
+        output, gbm->device, bypass_option_, mgm::BufferImportMethod::gbm_native_pixmap, buffer_pool_budget);
 }
 
 mir::UniqueModulePtr<mg::Display> mgm::Platform::create_display(
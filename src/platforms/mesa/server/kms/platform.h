@@ -25,6 +25,7 @@
 #include "mir/renderer/gl/egl_platform.h"
 #include "platform_common.h"
 #include "display_helpers.h"
+#include "buffer_pool.h"
 
 namespace mir
 {
@@ -44,7 +45,8 @@ public:
     explicit Platform(std::shared_ptr<DisplayReport> const& reporter,
                       std::shared_ptr<ConsoleServices> const& vt,
                       EmergencyCleanupRegistry& emergency_cleanup_registry,
-                      BypassOption bypass_option);
+                      BypassOption bypass_option,
+                      std::size_t buffer_pool_budget = BufferPool::default_budget);
 
     /* From Platform */
     UniqueModulePtr<GraphicBufferAllocator> create_buffer_allocator(
@@ -70,6 +72,7 @@ public:
     BypassOption bypass_option() const;
 private:
     BypassOption const bypass_option_;
+    std::size_t const buffer_pool_budget;
     std::unique_ptr<DRMNativePlatformAuthFactory> auth_factory;
 };
 
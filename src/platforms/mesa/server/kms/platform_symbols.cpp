@@ -49,7 +49,13 @@ namespace
 {
 char const* bypass_option_name{"bypass"};
 char const* host_socket{"host-socket"};
+char const* buffer_pool_option_name{"buffer-pool-size"};
 
+auto buffer_pool_budget(mo::Option const& options) -> std::size_t
+{
+    auto const mebibytes = options.get<int>(buffer_pool_option_name);
+    return mebibytes > 0 ? static_cast<std::size_t>(mebibytes) * 1024 * 1024 : 0;
+}
 }
 
 mir::UniqueModulePtr<mg::Platform> create_host_platform(
@@ -67,7 +73,7 @@ mir::UniqueModulePtr<mg::Platform> create_host_platform(
         bypass_option = mgm::BypassOption::prohibited;
 
     return mir::make_module_ptr<mgm::Platform>(
-        report, console, *emergency_cleanup_registry, bypass_option);
+        report, console, *emergency_cleanup_registry, bypass_option, buffer_pool_budget(*options));
 }
 
 void add_graphics_platform_options(boost::program_options::options_description& config)
@@ -76,7 +82,10 @@ void add_graphics_platform_options(boost::program_options::options_description&
     config.add_options()
         (bypass_option_name,
          boost::program_options::value<bool>()->default_value(true),
-         "[platform-specific] utilize the bypass optimization for fullscreen surfaces.");
+         "[platform-specific] utilize the bypass optimization for fullscreen surfaces.")
+        (buffer_pool_option_name,
+         boost::program_options::value<int>()->default_value(mgm::BufferPool::default_budget / (1024 * 1024)),
+         "[platform-specific] MiB of released buffers to keep for reuse by new buffers of the same size.");
 }
 
 namespace
@@ -301,7 +310,7 @@ mir::UniqueModulePtr<mir::graphics::DisplayPlatform> create_display_platform(
         bypass_option = mgm::BypassOption::prohibited;
 
     return mir::make_module_ptr<mgm::Platform>(
-        report, console, *emergency_cleanup_registry, bypass_option);
+        report, console, *emergency_cleanup_registry, bypass_option, buffer_pool_budget(*options));
 }
 
 mir::UniqueModulePtr<mir::graphics::RenderingPlatform> create_rendering_platform(
@@ -18,6 +18,7 @@
 
 #include "real_kms_output.h"
 #include "mir/graphics/display_configuration.h"
+#include "atomic_commit.h"
 #include "page_flipper.h"
 #include "kms-utils/kms_connector.h"
 #include "mir/fatal.h"
@@ -26,6 +27,7 @@
 #include <sys/stat.h>
 
 #include <boost/throw_exception.hpp>
+#include <algorithm>
 #include <system_error>
 #include <xf86drm.h>
 
@@ -37,8 +39,8 @@ namespace geom = mir::geometry;
 class mgm::FBHandle
 {
 public:
-    FBHandle(gbm_bo* bo, uint32_t drm_fb_id)
-        : bo{bo}, drm_fb_id{drm_fb_id}
+    FBHandle(gbm_bo* bo, uint32_t drm_fb_id, uint32_t format)
+        : bo{bo}, drm_fb_id{drm_fb_id}, format{format}
     {
     }
 
@@ -56,9 +58,15 @@ public:
         return drm_fb_id;
     }
 
+    uint32_t get_format() const
+    {
+        return format;
+    }
+
 private:
     gbm_bo *bo;
     uint32_t drm_fb_id;
+    uint32_t format;
 };
 
 namespace
@@ -69,8 +77,149 @@ void bo_user_data_destroy(gbm_bo* /*bo*/, void *data)
     delete bufobj;
 }
 
+struct CrtcPlanes
+{
+    mgk::DRMModePlaneUPtr primary;
+    std::vector<mgk::DRMModePlaneUPtr> overlays;
+};
+
+CrtcPlanes find_planes(int drm_fd, uint32_t crtc_id)
+{
+    mgk::DRMModeResources resources{drm_fd};
+
+    auto crtc = std::find_if(
+        resources.crtcs().begin(),
+        resources.crtcs().end(),
+        [crtc_id](mgk::DRMModeCrtcUPtr& crtc)
+        {
+            return crtc->crtc_id == crtc_id;
+        });
+    if (crtc == resources.crtcs().end())
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Failed to find index of CRTC"});
+    }
+    uint32_t const crtc_mask = 1 << std::distance(resources.crtcs().begin(), crtc);
+
+    mgk::PlaneResources plane_res{drm_fd};
+    CrtcPlanes planes;
+
+    for (auto& plane : plane_res.planes())
+    {
+        if (!(plane->possible_crtcs & crtc_mask))
+            continue;
+
+        mgk::ObjectProperties plane_props{drm_fd, plane->plane_id, DRM_MODE_OBJECT_PLANE};
+        if (!plane_props.has_property("type"))
+            continue;
+
+        if (plane_props["type"] == DRM_PLANE_TYPE_PRIMARY && !planes.primary)
+        {
+            planes.primary = std::move(plane);
+        }
+        /* Overlays that another CRTC could claim would need sharing out between outputs */
+        else if (plane_props["type"] == DRM_PLANE_TYPE_OVERLAY && plane->possible_crtcs == crtc_mask)
+        {
+            planes.overlays.push_back(std::move(plane));
+        }
+    }
+
+    if (!planes.primary)
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Could not find primary plane for CRTC"});
+
+    return planes;
+}
+
+bool can_scan_out(mgk::ObjectProperties const& plane_props)
+{
+    for (auto const name : {"FB_ID", "CRTC_ID", "SRC_X", "SRC_Y", "SRC_W", "SRC_H",
+                            "CRTC_X", "CRTC_Y", "CRTC_W", "CRTC_H"})
+    {
+        if (!plane_props.has_property(name))
+            return false;
+    }
+    return true;
+}
+
+void add_plane(
+    mgm::AtomicCommit& commit,
+    uint32_t plane_id,
+    mgk::ObjectProperties const& plane_props,
+    uint32_t crtc_id,
+    uint32_t fb_id,
+    geom::Rectangle const& src,
+    geom::Rectangle const& dest)
+{
+    auto const fixed16 = [](int value) { return static_cast<uint64_t>(value) << 16; };
+
+    commit.add_property(plane_id, plane_props.id_for("FB_ID"), fb_id);
+    commit.add_property(plane_id, plane_props.id_for("CRTC_ID"), crtc_id);
+    commit.add_property(plane_id, plane_props.id_for("SRC_X"), fixed16(src.top_left.x.as_int()));
+    commit.add_property(plane_id, plane_props.id_for("SRC_Y"), fixed16(src.top_left.y.as_int()));
+    commit.add_property(plane_id, plane_props.id_for("SRC_W"), fixed16(src.size.width.as_int()));
+    commit.add_property(plane_id, plane_props.id_for("SRC_H"), fixed16(src.size.height.as_int()));
+    commit.add_property(plane_id, plane_props.id_for("CRTC_X"), dest.top_left.x.as_int());
+    commit.add_property(plane_id, plane_props.id_for("CRTC_Y"), dest.top_left.y.as_int());
+    commit.add_property(plane_id, plane_props.id_for("CRTC_W"), dest.size.width.as_int());
+    commit.add_property(plane_id, plane_props.id_for("CRTC_H"), dest.size.height.as_int());
+}
+
+void disable_plane(mgm::AtomicCommit& commit, uint32_t plane_id, mgk::ObjectProperties const& plane_props)
+{
+    commit.add_property(plane_id, plane_props.id_for("FB_ID"), 0);
+    commit.add_property(plane_id, plane_props.id_for("CRTC_ID"), 0);
+}
+
+void set_crtc_gamma(int drm_fd, uint32_t crtc_id, mg::GammaCurves const& gamma)
+{
+    int ret = drmModeCrtcSetGamma(
+        drm_fd,
+        crtc_id,
+        gamma.red.size(),
+        const_cast<uint16_t*>(gamma.red.data()),
+        const_cast<uint16_t*>(gamma.green.data()),
+        const_cast<uint16_t*>(gamma.blue.data()));
+
+    int err = -ret;
+    if (err)
+        mir::log_warning("drmModeCrtcSetGamma failed: %s", strerror(err));
+
+    // TODO: return bool in future? Then do what with it?
+}
+
+uint32_t create_gamma_blob(int drm_fd, mg::GammaCurves const& gamma)
+{
+    std::vector<drm_color_lut> lut(gamma.red.size());
+    for (size_t i = 0; i != lut.size(); ++i)
+        lut[i] = {gamma.red[i], gamma.green[i], gamma.blue[i], 0};
+
+    uint32_t blob_id{0};
+    if (auto const ret = drmModeCreatePropertyBlob(drm_fd, lut.data(), lut.size() * sizeof lut[0], &blob_id))
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(-ret, std::system_category(), "Failed to create GAMMA_LUT blob"));
+    }
+    return blob_id;
+}
 }
 
+struct mgm::RealKMSOutput::AtomicProperties
+{
+    struct OverlayPlane
+    {
+        uint32_t id;
+        std::unique_ptr<kms::ObjectProperties> props;
+        std::vector<uint32_t> formats;
+        uint64_t zpos;
+    };
+
+    uint32_t crtc_id{0};
+    uint32_t plane_id{0};   // 0 if the CRTC can't be driven atomically
+    std::unique_ptr<kms::ObjectProperties> plane;
+    std::vector<OverlayPlane> overlays;     // Bottom to top
+    uint32_t gamma_lut_id{0};
+    uint64_t gamma_lut_size{0};
+};
+
 mgm::RealKMSOutput::RealKMSOutput(
     int drm_fd,
     kms::DRMModeConnectorUPtr&& connector,
@@ -140,6 +289,7 @@ void mgm::RealKMSOutput::reset()
 
     /* Discard previously current crtc */
     current_crtc = nullptr;
+    atomic_properties_ = nullptr;
 }
 
 geom::Size mgm::RealKMSOutput::size() const
@@ -242,6 +392,12 @@ bool mgm::RealKMSOutput::schedule_page_flip(FBHandle const& fb)
                        mgk::connector_name(connector).c_str());
         return false;
     }
+
+    /* A legacy flip only replaces the primary plane */
+    for (auto const plane_id : active_overlays)
+        drmModeSetPlane(drm_fd_, plane_id, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    active_overlays.clear();
+
     return page_flipper->schedule_flip(
         current_crtc->crtc_id,
         fb.get_drm_fb_id(),
@@ -262,6 +418,186 @@ void mgm::RealKMSOutput::wait_for_page_flip()
     last_frame_.store(page_flipper->wait_for_flip(current_crtc->crtc_id));
 }
 
+bool mgm::RealKMSOutput::add_page_flip(
+    AtomicCommit& commit,
+    FBHandle const& fb,
+    std::vector<OverlayLayer> const& overlays)
+{
+    std::unique_lock<std::mutex> lg(power_mutex);
+    if (power_mode != mir_power_mode_on)
+        return true;
+
+    auto const props = atomic_properties();
+    if (!props)
+        return false;
+
+    std::vector<uint32_t> overlay_planes;
+    if (!add_planes(commit, *props, fb, overlays, overlay_planes))
+        return false;
+
+    /* Nothing has changed on screen until the commit goes through */
+    commit.on_submitted(
+        [this, overlay_planes]
+        {
+            std::lock_guard<std::mutex> lg(power_mutex);
+            active_overlays = overlay_planes;
+        });
+
+    commit.add_flip(page_flipper, current_crtc->crtc_id, connector->connector_id);
+    return true;
+}
+
+bool mgm::RealKMSOutput::test_overlays(FBHandle const& fb, std::vector<OverlayLayer> const& overlays)
+{
+    std::unique_lock<std::mutex> lg(power_mutex);
+    if (power_mode != mir_power_mode_on)
+        return false;
+
+    auto const props = atomic_properties();
+    if (!props)
+        return false;
+
+    AtomicCommit commit{drm_fd_};
+    std::vector<uint32_t> overlay_planes;
+    return add_planes(commit, *props, fb, overlays, overlay_planes) && commit.test();
+}
+
+bool mgm::RealKMSOutput::add_planes(
+    AtomicCommit& commit,
+    AtomicProperties const& props,
+    FBHandle const& fb,
+    std::vector<OverlayLayer> const& overlays,
+    std::vector<uint32_t>& overlay_planes)
+{
+    if (overlays.size() > props.overlays.size())
+        return false;
+
+    auto const crtc_id = current_crtc->crtc_id;
+    geom::Rectangle const output_rect{{0, 0}, size()};
+
+    /* In clone mode each output scans out its own region of the shared framebuffer */
+    add_plane(commit, props.plane_id, *props.plane, crtc_id, fb.get_drm_fb_id(),
+              {{fb_offset.dx.as_int(), fb_offset.dy.as_int()}, output_rect.size}, output_rect);
+
+    /* Keep the stacking order by only ever moving up the overlay planes */
+    auto plane = props.overlays.begin();
+    for (auto const& layer : overlays)
+    {
+        plane = std::find_if(plane, props.overlays.end(),
+            [format = layer.fb->get_format()](auto const& candidate)
+            {
+                return std::find(candidate.formats.begin(), candidate.formats.end(), format) !=
+                    candidate.formats.end();
+            });
+
+        if (plane == props.overlays.end())
+            return false;
+
+        add_plane(commit, plane->id, *plane->props, crtc_id, layer.fb->get_drm_fb_id(),
+                  {{0, 0}, layer.position.size}, layer.position);
+        overlay_planes.push_back(plane->id);
+        ++plane;
+    }
+
+    for (auto const& candidate : props.overlays)
+    {
+        auto const contains = [&candidate](std::vector<uint32_t> const& ids)
+            {
+                return std::find(ids.begin(), ids.end(), candidate.id) != ids.end();
+            };
+
+        if (contains(active_overlays) && !contains(overlay_planes))
+            disable_plane(commit, candidate.id, *candidate.props);
+    }
+
+    return true;
+}
+
+auto mgm::RealKMSOutput::atomic_properties() -> AtomicProperties const*
+{
+    if (!current_crtc || !page_flipper->supports_atomic_flips())
+        return nullptr;
+
+    if (!atomic_properties_ || atomic_properties_->crtc_id != current_crtc->crtc_id)
+    {
+        /* Overlays we left on a previous CRTC aren't tracked by the new properties */
+        for (auto const plane_id : active_overlays)
+            drmModeSetPlane(drm_fd_, plane_id, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+        active_overlays.clear();
+
+        atomic_properties_ = std::make_unique<AtomicProperties>();
+        atomic_properties_->crtc_id = current_crtc->crtc_id;
+
+        try
+        {
+            auto const planes = find_planes(drm_fd_, current_crtc->crtc_id);
+            auto plane_props = std::make_unique<kms::ObjectProperties>(
+                drm_fd_, planes.primary->plane_id, DRM_MODE_OBJECT_PLANE);
+
+            if (!can_scan_out(*plane_props))
+                BOOST_THROW_EXCEPTION(std::runtime_error{"Primary plane lacks atomic properties"});
+
+            bool have_zpos{true};
+            for (auto const& overlay : planes.overlays)
+            {
+                auto overlay_props = std::make_unique<kms::ObjectProperties>(
+                    drm_fd_, overlay->plane_id, DRM_MODE_OBJECT_PLANE);
+
+                if (!can_scan_out(*overlay_props))
+                    continue;
+
+                have_zpos = have_zpos && overlay_props->has_property("zpos");
+                auto const zpos = overlay_props->has_property("zpos") ? (*overlay_props)["zpos"] : 0;
+
+                atomic_properties_->overlays.push_back({
+                    overlay->plane_id,
+                    std::move(overlay_props),
+                    {overlay->formats, overlay->formats + overlay->count_formats},
+                    zpos});
+            }
+
+            auto& overlays = atomic_properties_->overlays;
+            if (have_zpos)
+            {
+                /* Some drivers can put overlays beneath the primary plane; those are no use to us */
+                if (plane_props->has_property("zpos"))
+                {
+                    auto const primary_zpos = (*plane_props)["zpos"];
+                    overlays.erase(
+                        std::remove_if(overlays.begin(), overlays.end(),
+                            [primary_zpos](auto const& overlay) { return overlay.zpos <= primary_zpos; }),
+                        overlays.end());
+                }
+
+                std::stable_sort(overlays.begin(), overlays.end(),
+                    [](auto const& a, auto const& b) { return a.zpos < b.zpos; });
+            }
+            else if (overlays.size() > 1)
+            {
+                /* Without zpos we can't tell how the overlays stack, so only use one */
+                overlays.erase(overlays.begin() + 1, overlays.end());
+            }
+
+            kms::ObjectProperties const crtc_props{drm_fd_, current_crtc->crtc_id, DRM_MODE_OBJECT_CRTC};
+            if (crtc_props.has_property("GAMMA_LUT") && crtc_props.has_property("GAMMA_LUT_SIZE"))
+            {
+                atomic_properties_->gamma_lut_id = crtc_props.id_for("GAMMA_LUT");
+                atomic_properties_->gamma_lut_size = crtc_props["GAMMA_LUT_SIZE"];
+            }
+
+            atomic_properties_->plane = std::move(plane_props);
+            atomic_properties_->plane_id = planes.primary->plane_id;
+        }
+        catch (std::exception const& e)
+        {
+            mir::log_info("Output %s will use legacy page flips: %s",
+                          mgk::connector_name(connector).c_str(), e.what());
+        }
+    }
+
+    return atomic_properties_->plane_id ? atomic_properties_.get() : nullptr;
+}
+
 mg::Frame mgm::RealKMSOutput::last_frame() const
 {
     return last_frame_.load();
@@ -383,25 +719,44 @@ void mgm::RealKMSOutput::set_gamma(mg::GammaCurves const& gamma)
             std::invalid_argument("set_gamma: mismatch gamma LUT sizes"));
     }
 
-    int ret = drmModeCrtcSetGamma(
-        drm_fd_,
-        current_crtc->crtc_id,
-        gamma.red.size(),
-        const_cast<uint16_t*>(gamma.red.data()),
-        const_cast<uint16_t*>(gamma.green.data()),
-        const_cast<uint16_t*>(gamma.blue.data()));
-
-    int err = -ret;
-    if (err)
-        mir::log_warning("drmModeCrtcSetGamma failed: %s", strerror(err));
+    /*
+     * Where the CRTC takes a GAMMA_LUT of the right size the curves go out in
+     * an atomic commit of their own, straight away: a gamma-only configuration
+     * change doesn't wake the compositor, so there may be no page flip to
+     * carry them. Being blocking, the commit waits its turn behind any flip
+     * already in flight.
+     */
+    {
+        /* The compositor may be looking up (or rebuilding) the properties too */
+        std::lock_guard<std::mutex> lg(power_mutex);
+        auto const props = atomic_properties();
+        if (props && props->gamma_lut_id && props->gamma_lut_size == gamma.red.size())
+        {
+            AtomicCommit commit{drm_fd_};
+            commit.add_blob_property(current_crtc->crtc_id, props->gamma_lut_id, create_gamma_blob(drm_fd_, gamma));
+            if (auto const ret = drmModeAtomicCommit(drm_fd_, commit.request(), 0, nullptr))
+            {
+                mir::log_warning("Failed to commit GAMMA_LUT on output %s: %s",
+                                 mgk::connector_name(connector).c_str(), strerror(-ret));
+            }
+            else
+            {
+                return;
+            }
+        }
+    }
 
-    // TODO: return bool in future? Then do what with it?
+    set_crtc_gamma(drm_fd_, current_crtc->crtc_id, gamma);
 }
 
 void mgm::RealKMSOutput::refresh_hardware_state()
 {
     connector = kms::get_connector(drm_fd_, connector->connector_id);
     current_crtc = nullptr;
+    {
+        std::lock_guard<std::mutex> lg(power_mutex);
+        atomic_properties_ = nullptr;
+    }
 
     if (connector->encoder_id)
     {
@@ -663,7 +1018,7 @@ mgm::FBHandle* mgm::RealKMSOutput::fb_for(gbm_bo* bo) const
         return nullptr;
 
     /* Create a FBHandle and associate it with the gbm_bo */
-    bufobj = new FBHandle{bo, fb_id};
+    bufobj = new FBHandle{bo, fb_id, format};
     gbm_bo_set_user_data(bo, bufobj, bo_user_data_destroy);
 
     return bufobj;
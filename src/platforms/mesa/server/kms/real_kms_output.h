@@ -55,6 +55,11 @@ public:
     void clear_crtc() override;
     bool schedule_page_flip(FBHandle const& fb) override;
     void wait_for_page_flip() override;
+    bool add_page_flip(
+        AtomicCommit& commit,
+        FBHandle const& fb,
+        std::vector<OverlayLayer> const& overlays) override;
+    bool test_overlays(FBHandle const& fb, std::vector<OverlayLayer> const& overlays) override;
 
     bool set_cursor(gbm_bo* buffer) override;
     void move_cursor(geometry::Point destination) override;
@@ -77,6 +82,16 @@ private:
     bool ensure_crtc();
     void restore_saved_crtc();
 
+    struct AtomicProperties;
+    /* Call with power_mutex held */
+    AtomicProperties const* atomic_properties();
+    bool add_planes(
+        AtomicCommit& commit,
+        AtomicProperties const& props,
+        FBHandle const& fb,
+        std::vector<OverlayLayer> const& overlays,
+        std::vector<uint32_t>& overlay_planes);
+
     int const drm_fd_;
     std::shared_ptr<PageFlipper> const page_flipper;
 
@@ -93,6 +108,14 @@ private:
 
     std::mutex power_mutex;
 
+    /*
+     * Looked up for current_crtc on first use; null if it can't be driven atomically.
+     * Guarded by power_mutex, as set_gamma() and add_page_flip() come from different threads.
+     */
+    std::unique_ptr<AtomicProperties> atomic_properties_;
+    /* Overlay planes showing buffers since our last flip; guarded by power_mutex */
+    std::vector<uint32_t> active_overlays;
+
     AtomicFrame last_frame_;
 };
 
@@ -0,0 +1,143 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shm_scanout.h"
+#include "mir/graphics/buffer.h"
+#include "mir/renderer/sw/pixel_source.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace mg = mir::graphics;
+namespace mgm = mir::graphics::mesa;
+namespace geom = mir::geometry;
+
+namespace
+{
+gbm_device* gbm_create_device_checked(int fd)
+{
+    auto device = gbm_create_device(fd);
+    if (!device)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("Failed to create gbm device"));
+    }
+    return device;
+}
+
+bool can_scan_out(MirPixelFormat format)
+{
+    /* The primary plane ignores alpha, and we only take opaque buffers anyway */
+    return format == mir_pixel_format_xrgb_8888 || format == mir_pixel_format_argb_8888;
+}
+}
+
+mgm::ShmScanout::ShmScanout(int drm_fd, geom::Size const& size)
+    : size{size},
+      device{gbm_create_device_checked(drm_fd)}
+{
+    for (auto& slot : slots)
+    {
+        /* GBM_BO_USE_WRITE gets us a dumb buffer, which is CPU-mappable and linear */
+        slot.bo = gbm_bo_create(
+            device,
+            size.width.as_uint32_t(),
+            size.height.as_uint32_t(),
+            GBM_FORMAT_XRGB8888,
+            GBM_BO_USE_SCANOUT | GBM_BO_USE_WRITE);
+
+        if (!slot.bo)
+        {
+            for (auto& allocated : slots)
+            {
+                if (allocated.bo)
+                    gbm_bo_destroy(allocated.bo);
+            }
+            gbm_device_destroy(device);
+            BOOST_THROW_EXCEPTION(std::runtime_error("Failed to allocate SHM scanout buffer"));
+        }
+    }
+}
+
+mgm::ShmScanout::~ShmScanout()
+{
+    for (auto& slot : slots)
+        gbm_bo_destroy(slot.bo);
+    gbm_device_destroy(device);
+}
+
+gbm_bo* mgm::ShmScanout::import(Buffer& buffer)
+{
+    auto const pixels = dynamic_cast<renderer::software::PixelSource*>(buffer.native_buffer_base());
+    if (!pixels || buffer.size() != size || !can_scan_out(buffer.pixel_format()))
+        return nullptr;
+
+    for (size_t i = 0; i != slots.size(); ++i)
+    {
+        if (slots[i].filled && slots[i].content == buffer.id())
+        {
+            last_used = i;
+            return slots[i].bo;
+        }
+    }
+
+    auto const next = (last_used + 1) % slots.size();
+    auto& slot = slots[next];
+
+    uint32_t dest_stride{0};
+    void* map_data{nullptr};
+    auto const dest = static_cast<unsigned char*>(
+        gbm_bo_map(
+            slot.bo,
+            0, 0,
+            size.width.as_uint32_t(), size.height.as_uint32_t(),
+            GBM_BO_TRANSFER_WRITE,
+            &dest_stride,
+            &map_data));
+
+    if (!dest)
+    {
+        mir::log_warning("Failed to map SHM scanout buffer; falling back to compositing");
+        return nullptr;
+    }
+
+    auto const row_size = size.width.as_uint32_t() * MIR_BYTES_PER_PIXEL(buffer.pixel_format());
+    auto const height = size.height.as_uint32_t();
+    auto const source_stride = pixels->stride().as_uint32_t();
+
+    pixels->read(
+        [&](unsigned char const* source)
+        {
+            if (source_stride == dest_stride)
+            {
+                memcpy(dest, source, dest_stride * (height - 1) + row_size);
+            }
+            else
+            {
+                for (uint32_t row = 0; row != height; ++row)
+                    memcpy(dest + row * dest_stride, source + row * source_stride, row_size);
+            }
+        });
+
+    gbm_bo_unmap(slot.bo, map_data);
+
+    slot.filled = true;
+    slot.content = buffer.id();
+    last_used = next;
+    return slot.bo;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_MESA_SHM_SCANOUT_H_
+#define MIR_GRAPHICS_MESA_SHM_SCANOUT_H_
+
+#include "mir/geometry/size.h"
+#include "mir/graphics/buffer_id.h"
+
+#include <gbm.h>
+
+#include <array>
+#include <memory>
+
+namespace mir
+{
+namespace graphics
+{
+class Buffer;
+
+namespace mesa
+{
+
+/**
+ * A pair of output-sized dumb buffers to scan out software (SHM) buffers from.
+ *
+ * Software clients can't allocate buffers the display can scan out, so
+ * instead of uploading their content to a texture and compositing it, the
+ * content of a fullscreen SHM buffer is copied straight into one of these and
+ * that is flipped to. The two buffers alternate, so the one being written is
+ * never the one on screen.
+ */
+class ShmScanout
+{
+public:
+    ShmScanout(int drm_fd, geometry::Size const& size);
+    ~ShmScanout();
+
+    /**
+     * Copy the content of buffer into a scanout buffer.
+     *
+     * Nothing is copied if the buffer was the last one imported into either
+     * scanout buffer, as is the case when a frame is redrawn without the
+     * client having submitted a new buffer.
+     *
+     * \return  the buffer to scan out, or nullptr if buffer is not a software
+     *          buffer of our size in a format we can scan out.
+     */
+    gbm_bo* import(Buffer& buffer);
+
+private:
+    ShmScanout(ShmScanout const&) = delete;
+    ShmScanout& operator=(ShmScanout const&) = delete;
+
+    struct Slot
+    {
+        gbm_bo* bo{nullptr};
+        bool filled{false};
+        BufferID content{0};    ///< The buffer last copied in, if filled
+    };
+
+    geometry::Size const size;
+    gbm_device* const device;
+    std::array<Slot, 2> slots;
+    size_t last_used{0};
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_MESA_SHM_SCANOUT_H_ */
@@ -84,7 +84,8 @@ mg::rpi::BufferAllocator::BufferAllocator(mir::graphics::Display const& output)
     : egl_extensions{std::make_shared<mg::EGLExtensions>()},
       ctx{context_for_output(output)},
       egl_executor{
-        std::make_shared<mg::common::EGLContextExecutor>(context_for_output(output))}
+        std::make_shared<mg::common::EGLContextExecutor>(context_for_output(output))},
+      shm_textures{std::make_shared<mg::common::ShmTexturePool>(egl_executor)}
 {
 }
 
@@ -123,11 +124,11 @@ auto mg::rpi::BufferAllocator::alloc_software_buffer(
         SimpleShmBuffer(
             geom::Size size,
             MirPixelFormat const& pixelFormat,
-            std::shared_ptr<common::EGLContextExecutor> egl_executor) :
+            std::shared_ptr<common::ShmTexturePool> textures) :
             ShmBuffer(
                 size,
                 pixelFormat,
-                std::move(egl_executor))
+                std::move(textures))
         {
         }
 
@@ -139,7 +140,7 @@ auto mg::rpi::BufferAllocator::alloc_software_buffer(
     private:
     };
 
-    return std::make_shared<SimpleShmBuffer>(size, format, egl_executor);
+    return std::make_shared<SimpleShmBuffer>(size, format, shm_textures);
 }
 
 namespace
@@ -341,7 +342,7 @@ auto mg::rpi::BufferAllocator::buffer_from_shm(
     return mg::wayland::buffer_from_wl_shm(
         buffer,
         std::move(wayland_executor),
-        egl_executor,
+        shm_textures,
         std::move(on_consumed));
 }
 
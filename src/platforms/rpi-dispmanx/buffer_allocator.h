@@ -45,6 +45,7 @@ class Display;
 namespace common
 {
 class EGLContextExecutor;
+class ShmTexturePool;
 }
 
 namespace rpi
@@ -82,6 +83,7 @@ private:
     std::shared_ptr<EGLExtensions> const egl_extensions;
     std::shared_ptr<renderer::gl::Context> const ctx;
     std::shared_ptr<common::EGLContextExecutor> const egl_executor;
+    std::shared_ptr<common::ShmTexturePool> const shm_textures;
     std::shared_ptr<Executor> wayland_executor;
 };
 }
@@ -72,7 +72,8 @@ std::unique_ptr<mir::renderer::gl::Context> context_for_output(mg::Display const
 mgw::BufferAllocator::BufferAllocator(graphics::Display const& output) :
     egl_extensions(std::make_shared<mg::EGLExtensions>()),
     ctx{context_for_output(output)},
-    egl_delegate{std::make_shared<mgc::EGLContextExecutor>(context_for_output(output))}
+    egl_delegate{std::make_shared<mgc::EGLContextExecutor>(context_for_output(output))},
+    shm_textures{std::make_shared<mgc::ShmTexturePool>(egl_delegate)}
 {
 }
 
@@ -93,7 +94,7 @@ std::shared_ptr<mg::Buffer> mgw::BufferAllocator::alloc_software_buffer(geom::Si
                 "Trying to create SHM buffer with unsupported pixel format"));
     }
 
-    return std::make_shared<mgc::MemoryBackedShmBuffer>(size, format, egl_delegate);
+    return std::make_shared<mgc::MemoryBackedShmBuffer>(size, format, shm_textures);
 }
 
 std::vector<MirPixelFormat> mgw::BufferAllocator::supported_pixel_formats()
@@ -144,6 +145,6 @@ auto mgw::BufferAllocator::buffer_from_shm(
     return mg::wayland::buffer_from_wl_shm(
         buffer,
         std::move(wayland_executor),
-        egl_delegate,
+        shm_textures,
         std::move(on_consumed));
 }
@@ -35,6 +35,7 @@ class Display;
 namespace common
 {
 class EGLContextExecutor;
+class ShmTexturePool;
 }
 
 namespace wayland
@@ -69,6 +70,7 @@ private:
     std::shared_ptr<EGLExtensions> const egl_extensions;
     std::shared_ptr<renderer::gl::Context> const ctx;
     std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
+    std::shared_ptr<common::ShmTexturePool> const shm_textures;
 };
 }
 }
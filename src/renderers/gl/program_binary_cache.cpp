@@ -0,0 +1,301 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "GLRenderer"
+
+#include "program_binary_cache.h"
+#include "mir/log.h"
+
+#include <EGL/egl.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mrg = mir::renderer::gl;
+
+namespace
+{
+// GL_OES_get_program_binary and GL_ARB_get_program_binary share these tokens
+// (and entry-point signatures), but the GL and GLES headers don't both define them.
+GLenum const program_binary_length = 0x8741;
+GLenum const num_program_binary_formats = 0x87FE;
+GLenum const program_binary_retrievable_hint = 0x8257;
+
+// Bound the allocations we make on behalf of a (possibly corrupt) cache file
+std::uint32_t const max_entry_size = 64 * 1024 * 1024;
+
+struct EntryHeader
+{
+    char magic[8];
+    std::uint32_t key_size;
+    std::uint32_t format;
+    std::uint32_t binary_size;
+};
+
+char const entry_magic[8] = {'M', 'I', 'R', 'P', 'R', 'O', 'G', '1'};
+
+auto gl_string(GLenum name) -> std::string
+{
+    auto const value = reinterpret_cast<char const*>(glGetString(name));
+    return value ? value : "";
+}
+
+bool has_extension(std::string const& extensions, char const* extension)
+{
+    return (" " + extensions + " ").find(std::string{" "} + extension + " ") != std::string::npos;
+}
+
+bool make_directories(std::string const& path)
+{
+    for (auto slash = path.find('/', 1); ; slash = path.find('/', slash + 1))
+    {
+        auto const dir = path.substr(0, slash);
+        if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST)
+            return false;
+
+        if (slash == std::string::npos)
+            return true;
+    }
+}
+
+void discard(std::string const& path, char const* reason)
+{
+    mir::log_debug("Discarding cached GL program %s: %s", path.c_str(), reason);
+    unlink(path.c_str());
+}
+}
+
+mrg::ProgramBinaryCache::ProgramBinaryCache(std::string const& cache_dir)
+    : dir{cache_dir}
+{
+    if (dir.empty())
+        return;
+
+    auto const extensions = gl_string(GL_EXTENSIONS);
+
+    char const* get_binary_name;
+    char const* binary_name;
+    char const* parameteri_name = nullptr;
+    if (has_extension(extensions, "GL_OES_get_program_binary"))
+    {
+        get_binary_name = "glGetProgramBinaryOES";
+        binary_name = "glProgramBinaryOES";
+    }
+    else if (has_extension(extensions, "GL_ARB_get_program_binary"))
+    {
+        get_binary_name = "glGetProgramBinary";
+        binary_name = "glProgramBinary";
+        // Desktop GL drivers needn't keep a binary we can retrieve unless asked to before linking
+        parameteri_name = "glProgramParameteri";
+    }
+    else
+    {
+        return;
+    }
+
+    // Drivers may advertise the extension without being able to produce any binaries
+    GLint formats = 0;
+    glGetIntegerv(num_program_binary_formats, &formats);
+    if (formats <= 0)
+        return;
+
+    auto const get = reinterpret_cast<GetProgramBinary>(eglGetProcAddress(get_binary_name));
+    auto const set = reinterpret_cast<ProgramBinary>(eglGetProcAddress(binary_name));
+    auto const parameteri = parameteri_name ?
+        reinterpret_cast<ProgramParameteri>(eglGetProcAddress(parameteri_name)) : nullptr;
+    if (!get || !set || (parameteri_name && !parameteri))
+        return;
+
+    get_program_binary = get;
+    program_binary = set;
+    program_parameteri = parameteri;
+    driver = gl_string(GL_VENDOR) + '\n' + gl_string(GL_RENDERER) + '\n' + gl_string(GL_VERSION);
+}
+
+auto mrg::ProgramBinaryCache::default_cache_dir() -> std::string
+{
+    if (auto const cache_home = getenv("XDG_CACHE_HOME"))
+        return std::string{cache_home} + "/mir/shaders";
+
+    if (auto const home = getenv("HOME"))
+        return std::string{home} + "/.cache/mir/shaders";
+
+    return {};
+}
+
+bool mrg::ProgramBinaryCache::enabled() const
+{
+    return program_binary != nullptr;
+}
+
+GLuint mrg::ProgramBinaryCache::load(GLchar const* vertex_src, GLchar const* fragment_src) const
+{
+    if (!enabled())
+        return 0;
+
+    auto const key = key_for(vertex_src, fragment_src);
+    auto const path = path_for(key);
+
+    std::ifstream in{path, std::ios::binary};
+    if (!in)
+        return 0;
+
+    EntryHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof header) ||
+        memcmp(header.magic, entry_magic, sizeof entry_magic) != 0 ||
+        header.key_size > max_entry_size ||
+        header.binary_size > max_entry_size)
+    {
+        discard(path, "not a program binary");
+        return 0;
+    }
+
+    std::string stored_key(header.key_size, '\0');
+    std::vector<char> binary(header.binary_size);
+    if (!in.read(&stored_key[0], stored_key.size()) ||
+        !in.read(binary.data(), binary.size()))
+    {
+        discard(path, "truncated");
+        return 0;
+    }
+
+    // Either a hash collision, or the entry was written for a different driver;
+    // whichever, it'll be replaced when the caller stores the program it compiles.
+    if (stored_key != key)
+        return 0;
+
+    GLuint const program = glCreateProgram();
+    program_binary(program, header.format, binary.data(), binary.size());
+
+    GLint ok = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok)
+    {
+        glDeleteProgram(program);
+        discard(path, "rejected by the driver");
+        return 0;
+    }
+
+    return program;
+}
+
+void mrg::ProgramBinaryCache::prepare_for_link(GLuint program) const
+{
+    if (enabled() && program_parameteri)
+        program_parameteri(program, program_binary_retrievable_hint, GL_TRUE);
+}
+
+void mrg::ProgramBinaryCache::store(GLuint program, GLchar const* vertex_src, GLchar const* fragment_src) const
+{
+    if (!enabled())
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, program_binary_length, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLsizei written = 0;
+    GLenum format = 0;
+    get_program_binary(program, length, &written, &format, binary.data());
+    if (written <= 0)
+        return;
+
+    if (!make_directories(dir))
+    {
+        mir::log_debug("Failed to create GL program cache directory %s: %s", dir.c_str(), strerror(errno));
+        return;
+    }
+
+    auto const key = key_for(vertex_src, fragment_src);
+    auto const path = path_for(key);
+
+    // Write to a temporary file and rename it into place, so that a concurrent
+    // (or crashed) server never sees a partially written entry
+    std::string temp_path{path + ".XXXXXX"};
+    int const temp_fd = mkstemp(&temp_path[0]);
+    if (temp_fd < 0)
+    {
+        mir::log_debug("Failed to create GL program cache entry in %s: %s", dir.c_str(), strerror(errno));
+        return;
+    }
+
+    {
+        EntryHeader header;
+        memcpy(header.magic, entry_magic, sizeof entry_magic);
+        header.key_size = key.size();
+        header.format = format;
+        header.binary_size = written;
+
+        auto const out = fdopen(temp_fd, "wb");
+        if (!out)
+        {
+            close(temp_fd);
+            unlink(temp_path.c_str());
+            return;
+        }
+
+        bool const ok =
+            fwrite(&header, sizeof header, 1, out) == 1 &&
+            fwrite(key.data(), key.size(), 1, out) == 1 &&
+            fwrite(binary.data(), written, 1, out) == 1;
+
+        if (fclose(out) != 0 || !ok)
+        {
+            mir::log_debug("Failed to write GL program cache entry %s", temp_path.c_str());
+            unlink(temp_path.c_str());
+            return;
+        }
+    }
+
+    if (rename(temp_path.c_str(), path.c_str()) != 0)
+        unlink(temp_path.c_str());
+}
+
+auto mrg::ProgramBinaryCache::key_for(GLchar const* vertex_src, GLchar const* fragment_src) const -> std::string
+{
+    std::string key{driver};
+    key += '\0';
+    key += vertex_src;
+    key += '\0';
+    key += fragment_src;
+    return key;
+}
+
+auto mrg::ProgramBinaryCache::path_for(std::string const& key) const -> std::string
+{
+    // 64-bit FNV-1a; it only needs to spread entries over filenames, the full
+    // key is stored (and checked) in the entry itself.
+    std::uint64_t hash = 0xcbf29ce484222325u;
+    for (auto const c : key)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3u;
+    }
+
+    char name[sizeof "0123456789abcdef.bin"];
+    snprintf(name, sizeof name, "%016llx.bin", static_cast<unsigned long long>(hash));
+    return dir + "/" + name;
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_GL_PROGRAM_BINARY_CACHE_H_
+#define MIR_RENDERER_GL_PROGRAM_BINARY_CACHE_H_
+
+#include MIR_SERVER_GL_H
+
+#include <string>
+
+namespace mir
+{
+namespace renderer
+{
+namespace gl
+{
+
+/**
+ * An on-disk cache of linked GL program binaries
+ *
+ * Programs are keyed by the GL vendor, renderer and version strings along with
+ * the source of both shaders, so a driver upgrade or a change of GPU simply
+ * misses the cache. Should the driver reject a cached binary anyway the entry
+ * is discarded and the caller falls back to compiling from source.
+ *
+ * The cache is inert (every load() misses and store() does nothing) when the
+ * GL implementation doesn't support GL_OES_get_program_binary or
+ * GL_ARB_get_program_binary, or when there's no cache directory.
+ */
+class ProgramBinaryCache
+{
+public:
+    /**
+     * \note This must be called with a current GL context
+     *
+     * \param [in] cache_dir  Directory to keep the program binaries in; it is
+     *                        created if necessary. If empty, caching is disabled.
+     */
+    explicit ProgramBinaryCache(std::string const& cache_dir);
+
+    /**
+     * $XDG_CACHE_HOME/mir/shaders, falling back to $HOME/.cache/mir/shaders
+     *
+     * \return  The empty string if neither XDG_CACHE_HOME nor HOME is set
+     */
+    static auto default_cache_dir() -> std::string;
+
+    bool enabled() const;
+
+    /**
+     * Create a program from a previously stored binary
+     *
+     * \return  The linked program, or 0 if there's no usable binary
+     */
+    GLuint load(GLchar const* vertex_src, GLchar const* fragment_src) const;
+
+    /**
+     * Ask the driver to keep the binary of \a program retrievable by store()
+     *
+     * \note This must be called before \a program is linked
+     */
+    void prepare_for_link(GLuint program) const;
+
+    /**
+     * Store the binary of a successfully linked program
+     */
+    void store(GLuint program, GLchar const* vertex_src, GLchar const* fragment_src) const;
+
+private:
+    using GetProgramBinary = void (*)(GLuint program, GLsizei buf_size, GLsizei* length, GLenum* format, void* binary);
+    using ProgramBinary = void (*)(GLuint program, GLenum format, void const* binary, GLint length);
+    using ProgramParameteri = void (*)(GLuint program, GLenum pname, GLint value);
+
+    auto key_for(GLchar const* vertex_src, GLchar const* fragment_src) const -> std::string;
+    auto path_for(std::string const& key) const -> std::string;
+
+    std::string const dir;
+    std::string driver;
+    GetProgramBinary get_program_binary{nullptr};
+    ProgramBinary program_binary{nullptr};
+    /// Only needed (and only available) with GL_ARB_get_program_binary
+    ProgramParameteri program_parameteri{nullptr};
+};
+
+}
+}
+}
+
+#endif // MIR_RENDERER_GL_PROGRAM_BINARY_CACHE_H_
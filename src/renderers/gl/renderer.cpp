@@ -19,6 +19,7 @@
 #define MIR_LOG_COMPONENT "GLRenderer"
 
 #include "renderer.h"
+#include "program_binary_cache.h"
 #include "mir/compositor/buffer_stream.h"
 #include "mir/gl/default_program_factory.h"
 #include "mir/graphics/renderable.h"
@@ -40,8 +41,10 @@
 #include <EGL/egl.h>
 
 #include <boost/throw_exception.hpp>
+#include <algorithm>
 #include <stdexcept>
 #include <cmath>
+#include <cstddef>
 #include <sstream>
 
 namespace mg = mir::graphics;
@@ -159,6 +162,48 @@ private:
     GLuint id;
 };
 
+/**
+ * Append a primitive to vertices as independent triangles, so that it can be
+ * merged with neighbouring primitives into a single draw.
+ *
+ * \return The number of vertices appended, or -1 (appending nothing) if the
+ *         primitive isn't made of triangles.
+ */
+GLsizei append_as_triangles(std::vector<mgl::Vertex>& vertices, mgl::Primitive const& p)
+{
+    auto const* const v = p.vertices;
+    auto const triangle_vertices = 3 * std::max(0, p.nvertices - 2);
+
+    switch (p.type)
+    {
+    case GL_TRIANGLES:
+        vertices.insert(vertices.end(), v, v + p.nvertices);
+        return p.nvertices;
+
+    case GL_TRIANGLE_FAN:
+        for (int i = 1; i + 1 < p.nvertices; ++i)
+        {
+            vertices.insert(vertices.end(), {v[0], v[i], v[i + 1]});
+        }
+        return triangle_vertices;
+
+    case GL_TRIANGLE_STRIP:
+        for (int i = 0; i + 2 < p.nvertices; ++i)
+        {
+            // Every other triangle of a strip has its first two vertices swapped
+            // to keep the winding consistent
+            if (i % 2 == 0)
+                vertices.insert(vertices.end(), {v[i], v[i + 1], v[i + 2]});
+            else
+                vertices.insert(vertices.end(), {v[i + 1], v[i], v[i + 2]});
+        }
+        return triangle_vertices;
+
+    default:
+        return -1;
+    }
+}
+
 using ProgramHandle = GLHandle<&glDeleteProgram>;
 using ShaderHandle = GLHandle<&glDeleteShader>;
 
@@ -199,8 +244,8 @@ class mrg::Renderer::ProgramFactory : public mir::graphics::gl::ProgramFactory
 {
 public:
     // NOTE: This must be called with a current GL context
-    ProgramFactory()
-        : vertex_shader{compile_shader(GL_VERTEX_SHADER, vertex_shader_src)}
+    explicit ProgramFactory(std::string const& cache_dir)
+        : binary_cache{cache_dir}
     {
     }
 
@@ -247,20 +292,37 @@ public:
         // GL shader compilation is *not* threadsafe, and requires external synchronisation
         std::lock_guard<std::mutex> lock{compilation_mutex};
 
-        ShaderHandle const opaque_shader{
-            compile_shader(GL_FRAGMENT_SHADER, opaque_fragment.str().c_str())};
-        ShaderHandle const alpha_shader{
-            compile_shader(GL_FRAGMENT_SHADER, alpha_fragment.str().c_str())};
-
         return std::make_unique<::Program>(
-            link_shader(vertex_shader, opaque_shader),
-            link_shader(vertex_shader, alpha_shader));
-
-        // We delete opaque_shader and alpha_shader here. This is fine; it only marks them
-        // for deletion. GL will only delete them once the GL Program they're linked in is destroyed.
+            load_or_build_program(opaque_fragment.str()),
+            load_or_build_program(alpha_fragment.str()));
     }
 
 private:
+    // NOTE: This must be called with compilation_mutex held
+    ProgramHandle load_or_build_program(std::string const& fragment_src)
+    {
+        if (auto const cached = binary_cache.load(vertex_shader_src, fragment_src.c_str()))
+        {
+            return ProgramHandle{cached};
+        }
+
+        if (!vertex_shader)
+        {
+            // Only compiled once we know we need it; with a warm cache we never do
+            vertex_shader = std::make_unique<ShaderHandle>(compile_shader(GL_VERTEX_SHADER, vertex_shader_src));
+        }
+
+        ShaderHandle const fragment_shader{
+            compile_shader(GL_FRAGMENT_SHADER, fragment_src.c_str())};
+
+        auto program = link_shader(*vertex_shader, fragment_shader, binary_cache);
+        binary_cache.store(program, vertex_shader_src, fragment_src.c_str());
+        return program;
+
+        // We delete fragment_shader here. This is fine; it only marks it for deletion.
+        // GL will only delete it once the GL Program it's linked in is destroyed.
+    }
+
     static GLuint compile_shader(GLenum type, GLchar const* src)
     {
         GLuint id = glCreateShader(type);
@@ -288,11 +350,13 @@ private:
 
     static ProgramHandle link_shader(
         ShaderHandle const& vertex_shader,
-        ShaderHandle const& fragment_shader)
+        ShaderHandle const& fragment_shader,
+        ProgramBinaryCache const& binary_cache)
     {
         ProgramHandle program{glCreateProgram()};
         glAttachShader(program, fragment_shader);
         glAttachShader(program, vertex_shader);
+        binary_cache.prepare_for_link(program);
         glLinkProgram(program);
         GLint ok;
         glGetProgramiv(program, GL_LINK_STATUS, &ok);
@@ -309,7 +373,8 @@ private:
         return program;
     }
 
-    ShaderHandle const vertex_shader;
+    ProgramBinaryCache const binary_cache;
+    std::unique_ptr<ShaderHandle> vertex_shader;
     // GL requires us to synchronise multi-threaded access to the shader APIs.
     std::mutex compilation_mutex;
 };
@@ -335,11 +400,16 @@ mrg::Renderer::Program::Program(GLuint program_id)
 }
 
 mrg::Renderer::Renderer(graphics::DisplayBuffer& display_buffer)
+    : Renderer(display_buffer, ProgramBinaryCache::default_cache_dir())
+{
+}
+
+mrg::Renderer::Renderer(graphics::DisplayBuffer& display_buffer, std::string const& program_cache_dir)
     : render_target(&display_buffer),
       clear_color{0.0f, 0.0f, 0.0f, 0.0f},
       default_program(family.add_program(vshader, default_fshader)),
       alpha_program(family.add_program(vshader, alpha_fshader)),
-      program_factory{std::make_unique<ProgramFactory>()},
+      program_factory{std::make_unique<ProgramFactory>(program_cache_dir)},
       texture_cache(mgl::DefaultProgramFactory().create_texture_cache()),
       display_transform(1)
 {
@@ -398,6 +468,9 @@ mrg::Renderer::Renderer(graphics::DisplayBuffer& display_buffer)
 mrg::Renderer::~Renderer()
 {
     render_target.ensure_current();
+
+    if (vertex_buffer)
+        glDeleteBuffers(1, &vertex_buffer);
 }
 
 void mrg::Renderer::tessellate(std::vector<mgl::Primitive>& primitives,
@@ -420,6 +493,7 @@ void mrg::Renderer::render(mg::RenderableList const& renderables) const
     {
         draw(*r);
     }
+    flush_draws();
 
     render_target.swap_buffers();
 
@@ -433,22 +507,6 @@ void mrg::Renderer::render(mg::RenderableList const& renderables) const
 
 void mrg::Renderer::draw(mg::Renderable const& renderable) const
 {
-    auto const clip_area = renderable.clip_area();
-    if (clip_area)
-    {
-        glEnable(GL_SCISSOR_TEST);
-        glScissor(
-            clip_area.value().top_left.x.as_int() -
-                viewport.top_left.x.as_int(),
-            viewport.top_left.y.as_int() +
-                viewport.size.height.as_int() -
-                clip_area.value().top_left.y.as_int() -
-                clip_area.value().size.height.as_int(),
-            clip_area.value().size.width.as_int(), 
-            clip_area.value().size.height.as_int()
-        );
-    }
-
     auto const texture = std::dynamic_pointer_cast<mg::gl::Texture>(renderable.buffer());
     auto const surface_tex =
         [this, &renderable, need_fallback = !static_cast<bool>(texture)]() -> std::shared_ptr<mir::gl::Texture>
@@ -496,142 +554,288 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
         return;
     }
 
-    auto const& prog = *maybe_prog;
-
-    glUseProgram(prog.id);
-    if (prog.last_used_frameno != frameno)
-    {   // Avoid reloading the screen-global uniforms on every renderable
-        // TODO: We actually only need to bind these *once*, right? Not once per frame?
-        prog.last_used_frameno = frameno;
-        for (auto i = 0u; i < prog.tex_uniforms.size(); ++i)
-        {
-            if (prog.tex_uniforms[i] != -1)
-            {
-                glUniform1i(prog.tex_uniforms[i], i);
-            }
-        }
-        glUniformMatrix4fv(prog.display_transform_uniform, 1, GL_FALSE,
-                           glm::value_ptr(display_transform));
-        glUniformMatrix4fv(prog.screen_to_gl_coords_uniform, 1, GL_FALSE,
-                           glm::value_ptr(screen_to_gl_coords));
-    }
-
-    glActiveTexture(GL_TEXTURE0);
+    Draw draw;
+    draw.program = maybe_prog;
+    draw.texture = texture;
+    draw.fallback_texture = surface_tex;
+    draw.alpha = renderable.alpha();
+    draw.clip = renderable.clip_area();
 
     auto const& rect = renderable.screen_position();
-    GLfloat centrex = rect.top_left.x.as_int() +
-                      rect.size.width.as_int() / 2.0f;
-    GLfloat centrey = rect.top_left.y.as_int() +
-                      rect.size.height.as_int() / 2.0f;
-    glUniform2f(prog.centre_uniform, centrex, centrey);
+    draw.centre = glm::vec2{
+        rect.top_left.x.as_int() + rect.size.width.as_int() / 2.0f,
+        rect.top_left.y.as_int() + rect.size.height.as_int() / 2.0f};
 
-    glm::mat4 transform = renderable.transformation();
+    draw.transform = renderable.transformation();
     if (texture && (texture->layout() == mg::gl::Texture::Layout::TopRowFirst))
     {
         // GL textures have (0,0) at bottom-left rather than top-left
         // We have to invert this texture to get it the way up GL expects.
-        transform *= glm::mat4{
+        draw.transform *= glm::mat4{
             1.0, 0.0, 0.0, 0.0,
             0.0, -1.0, 0.0, 0.0,
             0.0, 0.0, 1.0, 0.0,
             -1.0, 1.0, 0.0, 1.0
         };
     }
+    else if (draw.transform == glm::mat4{1.0f})
+    {
+        // The centre makes no difference to an identity transform; don't let
+        // it prevent merging this with the previous draw.
+        draw.centre = glm::vec2{0.0f, 0.0f};
+    }
 
-    glUniformMatrix4fv(prog.transform_uniform, 1, GL_FALSE,
-                       glm::value_ptr(transform));
-
-    if (prog.alpha_uniform >= 0)
-        glUniform1f(prog.alpha_uniform, renderable.alpha());
-
-    glEnableVertexAttribArray(prog.position_attr);
-    glEnableVertexAttribArray(prog.texcoord_attr);
+    // These renderable method names could be better (see LP: #1236224)
+    if (renderable.shaped())  // Client is RGBA:
+    {
+        draw.blend = {true, GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
+                            GL_ONE, GL_ONE_MINUS_SRC_ALPHA, 1.0f};
+    }
+    else if (renderable.alpha() == 1.0f)  // RGBX and no window translucency:
+    {
+        draw.blend = {false, GL_ONE,  GL_ZERO,
+                             GL_ZERO, GL_ONE, 1.0f};  // Avoid using src_alpha!
+    }
+    else
+    {   // Client is RGBX but we also have window translucency.
+        // The texture alpha channel is possibly uninitialized so we must be
+        // careful and avoid using SRC_ALPHA (LP: #1423462).
+        draw.blend = {true, GL_ONE,  GL_ONE_MINUS_CONSTANT_ALPHA,
+                            GL_ZERO, GL_ONE, renderable.alpha()};
+    }
 
     primitives.clear();
     tessellate(primitives, renderable);
 
-    // if we fail to load the texture, we need to carry on (part of lp:1629275)
-    try
+    for (auto const& p : primitives)
     {
-        typedef struct  // Represents parameters of glBlendFuncSeparate()
+        draw.first = vertices.size();
+        draw.type = GL_TRIANGLES;
+        draw.count = append_as_triangles(vertices, p);
+        if (draw.count < 0)
         {
-            GLenum src_rgb, dst_rgb, src_alpha, dst_alpha;
-        } BlendSeparate;
-
-        BlendSeparate client_blend;
-
-        // These renderable method names could be better (see LP: #1236224)
-        if (renderable.shaped())  // Client is RGBA:
-        {
-            client_blend = {GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
-                            GL_ONE, GL_ONE_MINUS_SRC_ALPHA};
+            // Not made of triangles; draw it as-is
+            vertices.insert(vertices.end(), p.vertices, p.vertices + p.nvertices);
+            draw.type = p.type;
+            draw.count = p.nvertices;
         }
-        else if (renderable.alpha() == 1.0f)  // RGBX and no window translucency:
+
+        if (!draws.empty() &&
+            draws.back().type == GL_TRIANGLES && draw.type == GL_TRIANGLES &&
+            draws.back().has_same_state_as(draw))
         {
-            client_blend = {GL_ONE,  GL_ZERO,
-                            GL_ZERO, GL_ONE};  // Avoid using src_alpha!
+            draws.back().count += draw.count;
         }
         else
-        {   // Client is RGBX but we also have window translucency.
-            // The texture alpha channel is possibly uninitialized so we must be
-            // careful and avoid using SRC_ALPHA (LP: #1423462).
-            client_blend = {GL_ONE,  GL_ONE_MINUS_CONSTANT_ALPHA,
-                            GL_ZERO, GL_ONE};
-            glBlendColor(0.0f, 0.0f, 0.0f, renderable.alpha());
+        {
+            draws.push_back(draw);
         }
+    }
+}
 
-        for (auto const& p : primitives)
-        {
-            BlendSeparate blend;
+void mrg::Renderer::flush_draws() const
+{
+    if (draws.empty())
+        return;
+
+    if (!vertex_buffer)
+        glGenBuffers(1, &vertex_buffer);
+
+    // Respecifying the whole buffer every frame lets the driver orphan the
+    // previous frame's storage (which the GPU may still be reading from)
+    // rather than stall until it's idle.
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    glBufferData(
+        GL_ARRAY_BUFFER,
+        vertices.size() * sizeof(mgl::Vertex),
+        vertices.data(),
+        GL_STREAM_DRAW);
+
+    glActiveTexture(GL_TEXTURE0);
+
+    // Only touch GL state when it differs from what the previous draw left
+    Program const* current_prog{nullptr};
+    std::experimental::optional<Blend> current_blend;
+    std::experimental::optional<geom::Rectangle> current_clip;
+    void const* bound_texture{nullptr};
 
-            blend = client_blend;
-            if (surface_tex)
+    for (auto const& draw : draws)
+    {
+        auto const& prog = *draw.program;
+        bool reload_uniforms{false};
+
+        if (&prog != current_prog)
+        {
+            if (current_prog)
             {
-                surface_tex->bind();
+                glDisableVertexAttribArray(current_prog->texcoord_attr);
+                glDisableVertexAttribArray(current_prog->position_attr);
             }
-            else
-            {
-                texture->bind();
+
+            glUseProgram(prog.id);
+            if (prog.last_used_frameno != frameno)
+            {   // Avoid reloading the screen-global uniforms on every renderable
+                // TODO: We actually only need to bind these *once*, right? Not once per frame?
+                prog.last_used_frameno = frameno;
+                for (auto i = 0u; i < prog.tex_uniforms.size(); ++i)
+                {
+                    if (prog.tex_uniforms[i] != -1)
+                    {
+                        glUniform1i(prog.tex_uniforms[i], i);
+                    }
+                }
+                glUniformMatrix4fv(prog.display_transform_uniform, 1, GL_FALSE,
+                                   glm::value_ptr(display_transform));
+                glUniformMatrix4fv(prog.screen_to_gl_coords_uniform, 1, GL_FALSE,
+                                   glm::value_ptr(screen_to_gl_coords));
+                reload_uniforms = true;
             }
 
+            glEnableVertexAttribArray(prog.position_attr);
+            glEnableVertexAttribArray(prog.texcoord_attr);
             glVertexAttribPointer(prog.position_attr, 3, GL_FLOAT,
                                   GL_FALSE, sizeof(mgl::Vertex),
-                                  &p.vertices[0].position);
+                                  reinterpret_cast<void const*>(offsetof(mgl::Vertex, position)));
             glVertexAttribPointer(prog.texcoord_attr, 2, GL_FLOAT,
                                   GL_FALSE, sizeof(mgl::Vertex),
-                                  &p.vertices[0].texcoord);
+                                  reinterpret_cast<void const*>(offsetof(mgl::Vertex, texcoord)));
 
-            if (blend.dst_rgb == GL_ZERO)
+            current_prog = &prog;
+        }
+
+        if (reload_uniforms || draw.centre != prog.loaded_centre)
+        {
+            glUniform2f(prog.centre_uniform, draw.centre.x, draw.centre.y);
+            prog.loaded_centre = draw.centre;
+        }
+
+        if (reload_uniforms || draw.transform != prog.loaded_transform)
+        {
+            glUniformMatrix4fv(prog.transform_uniform, 1, GL_FALSE,
+                               glm::value_ptr(draw.transform));
+            prog.loaded_transform = draw.transform;
+        }
+
+        if (prog.alpha_uniform >= 0 && (reload_uniforms || draw.alpha != prog.loaded_alpha))
+        {
+            glUniform1f(prog.alpha_uniform, draw.alpha);
+            prog.loaded_alpha = draw.alpha;
+        }
+
+        if (draw.clip != current_clip)
+        {
+            if (draw.clip)
+            {
+                if (!current_clip)
+                    glEnable(GL_SCISSOR_TEST);
+
+                glScissor(
+                    draw.clip.value().top_left.x.as_int() -
+                        viewport.top_left.x.as_int(),
+                    viewport.top_left.y.as_int() +
+                        viewport.size.height.as_int() -
+                        draw.clip.value().top_left.y.as_int() -
+                        draw.clip.value().size.height.as_int(),
+                    draw.clip.value().size.width.as_int(),
+                    draw.clip.value().size.height.as_int()
+                );
+            }
+            else
+            {
+                glDisable(GL_SCISSOR_TEST);
+            }
+            current_clip = draw.clip;
+        }
+
+        if (!current_blend || !(current_blend.value() == draw.blend))
+        {
+            if (!draw.blend.enabled)
             {
                 glDisable(GL_BLEND);
             }
             else
             {
-                glEnable(GL_BLEND);
-                glBlendFuncSeparate(blend.src_rgb,   blend.dst_rgb,
-                                    blend.src_alpha, blend.dst_alpha);
+                if (!current_blend || !current_blend.value().enabled)
+                    glEnable(GL_BLEND);
+
+                glBlendFuncSeparate(draw.blend.src_rgb,   draw.blend.dst_rgb,
+                                    draw.blend.src_alpha, draw.blend.dst_alpha);
+                if (draw.blend.dst_rgb == GL_ONE_MINUS_CONSTANT_ALPHA)
+                    glBlendColor(0.0f, 0.0f, 0.0f, draw.blend.constant_alpha);
             }
+            current_blend = draw.blend;
+        }
 
-            glDrawArrays(p.type, 0, p.nvertices);
+        // if we fail to load the texture, we need to carry on (part of lp:1629275)
+        try
+        {
+            void const* const texture = draw.texture ?
+                static_cast<void const*>(draw.texture.get()) :
+                static_cast<void const*>(draw.fallback_texture.get());
 
-            if (texture)
+            if (texture != bound_texture)
+            {
+                bound_texture = nullptr;
+                if (draw.fallback_texture)
+                {
+                    draw.fallback_texture->bind();
+                }
+                else
+                {
+                    draw.texture->bind();
+                }
+                bound_texture = texture;
+            }
+
+            glDrawArrays(draw.type, draw.first, draw.count);
+
+            if (draw.texture)
             {
                 // We're done with the texture for now
-                texture->add_syncpoint();
+                draw.texture->add_syncpoint();
             }
         }
+        catch (std::exception const& ex)
+        {
+            report_exception();
+        }
     }
-    catch (std::exception const& ex)
+
+    if (current_prog)
     {
-        report_exception();
+        glDisableVertexAttribArray(current_prog->texcoord_attr);
+        glDisableVertexAttribArray(current_prog->position_attr);
     }
-
-    glDisableVertexAttribArray(prog.texcoord_attr);
-    glDisableVertexAttribArray(prog.position_attr);
-    if (renderable.clip_area())
+    if (current_clip)
     {
         glDisable(GL_SCISSOR_TEST);
     }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    draws.clear();
+    vertices.clear();
+}
+
+bool mrg::Renderer::Blend::operator==(Blend const& other) const
+{
+    if (!enabled || !other.enabled)
+        return enabled == other.enabled;
+
+    return src_rgb == other.src_rgb && dst_rgb == other.dst_rgb &&
+           src_alpha == other.src_alpha && dst_alpha == other.dst_alpha &&
+           (dst_rgb != GL_ONE_MINUS_CONSTANT_ALPHA || constant_alpha == other.constant_alpha);
+}
+
+bool mrg::Renderer::Draw::has_same_state_as(Draw const& other) const
+{
+    return program == other.program &&
+           texture == other.texture &&
+           fallback_texture == other.fallback_texture &&
+           transform == other.transform &&
+           centre == other.centre &&
+           alpha == other.alpha &&
+           blend == other.blend &&
+           clip == other.clip;
 }
 
 void mrg::Renderer::set_viewport(geometry::Rectangle const& rect)
@@ -29,14 +29,21 @@
 #include "mir/renderer/gl/render_target.h"
 
 #include MIR_SERVER_GL_H
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 namespace mir
 {
-namespace gl { class TextureCache; }
-namespace graphics { class DisplayBuffer; }
+namespace gl { class TextureCache; class Texture; }
+namespace graphics
+{
+class DisplayBuffer;
+namespace gl { class Texture; }
+}
 namespace renderer
 {
 namespace gl
@@ -60,6 +67,8 @@ class Renderer : public renderer::Renderer
 {
 public:
     Renderer(graphics::DisplayBuffer& display_buffer);
+    /// \param [in] program_cache_dir  where to cache linked shader programs; empty to disable
+    Renderer(graphics::DisplayBuffer& display_buffer, std::string const& program_cache_dir);
     virtual ~Renderer();
 
     // These are called with a valid GL context:
@@ -87,6 +96,11 @@ public:
         GLint alpha_uniform = -1;
         mutable long long last_used_frameno = 0;
 
+        // The per-draw uniform values last loaded into this program this frame
+        mutable glm::mat4 loaded_transform;
+        mutable glm::vec2 loaded_centre;
+        mutable GLfloat loaded_alpha = -1.0f;
+
         Program(GLuint program_id);
     };
 private:
@@ -123,9 +137,48 @@ protected:
     static const GLchar* const default_fshader;
     static const GLchar* const alpha_fshader;
 
+    /**
+     * Add a renderable to the frame's batch of draws.
+     *
+     * Nothing is drawn until the batch is flushed at the end of render().
+     */
     virtual void draw(graphics::Renderable const& renderable) const;
 
 private:
+    struct Blend
+    {
+        bool enabled;
+        GLenum src_rgb, dst_rgb, src_alpha, dst_alpha;
+        GLfloat constant_alpha;
+
+        bool operator==(Blend const& other) const;
+    };
+
+    /**
+     * A single glDrawArrays() from the frame's vertex buffer, along with the
+     * GL state it needs.
+     *
+     * Consecutive renderables (or primitives of a renderable) needing the
+     * same state are merged into one Draw.
+     */
+    struct Draw
+    {
+        Program const* program;
+        std::shared_ptr<graphics::gl::Texture> texture;
+        std::shared_ptr<mir::gl::Texture> fallback_texture;
+        glm::mat4 transform;
+        glm::vec2 centre;
+        GLfloat alpha;
+        Blend blend;
+        std::experimental::optional<geometry::Rectangle> clip;
+        GLenum type;
+        GLint first;
+        GLsizei count;
+
+        bool has_same_state_as(Draw const& other) const;
+    };
+
+    void flush_draws() const;
     void update_gl_viewport();
 
     class ProgramFactory;
@@ -135,6 +188,12 @@ private:
     glm::mat4 screen_to_gl_coords;
     glm::mat4 display_transform;
     std::vector<mir::gl::Primitive> mutable primitives;
+
+    // The current frame: every vertex is uploaded to vertex_buffer in one go,
+    // and then drawn by a sequence of (merged) draws.
+    std::vector<mir::gl::Vertex> mutable vertices;
+    std::vector<Draw> mutable draws;
+    GLuint mutable vertex_buffer = 0;
 };
 
 }
@@ -18,13 +18,24 @@
 
 #include "renderer_factory.h"
 #include "renderer.h"
+#include "program_binary_cache.h"
 #include "mir/graphics/display_buffer.h"
 
 namespace mrg = mir::renderer::gl;
 
+mrg::RendererFactory::RendererFactory()
+    : RendererFactory{ProgramBinaryCache::default_cache_dir()}
+{
+}
+
+mrg::RendererFactory::RendererFactory(std::string const& program_cache_dir)
+    : program_cache_dir{program_cache_dir}
+{
+}
+
 std::unique_ptr<mir::renderer::Renderer>
 mrg::RendererFactory::create_renderer_for(
     graphics::DisplayBuffer& display_buffer)
 {
-    return std::make_unique<Renderer>(display_buffer);
+    return std::make_unique<Renderer>(display_buffer, program_cache_dir);
 }
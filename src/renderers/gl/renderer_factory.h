@@ -21,6 +21,8 @@
 
 #include "mir/renderer/renderer_factory.h"
 
+#include <string>
+
 namespace mir
 {
 namespace renderer
@@ -31,8 +33,16 @@ namespace gl
 class RendererFactory : public renderer::RendererFactory
 {
 public:
+    /// Renderers cache their linked programs in ProgramBinaryCache::default_cache_dir()
+    RendererFactory();
+    /// \param [in] program_cache_dir  where renderers cache their linked programs; empty to disable
+    explicit RendererFactory(std::string const& program_cache_dir);
+
     std::unique_ptr<renderer::Renderer> create_renderer_for(
         graphics::DisplayBuffer& display_buffer) override;
+
+private:
+    std::string const program_cache_dir;
 };
 
 }
@@ -0,0 +1,196 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pixel_ops.h"
+
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace msw = mir::renderer::software;
+
+namespace
+{
+uint32_t const alpha_channel{0xff000000};
+
+/// a*b/255, correctly rounded for a, b in [0, 255]
+inline uint32_t mul_div_255(uint32_t a, uint32_t b)
+{
+    auto const t = a*b + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+inline uint32_t blend_pixel(uint32_t dst, uint32_t src, uint32_t alpha)
+{
+    auto const inverse = 255 - mul_div_255(src >> 24, alpha);
+
+    uint32_t result{0};
+    for (auto shift = 0; shift != 32; shift += 8)
+    {
+        auto const channel =
+            mul_div_255((src >> shift) & 0xff, alpha) +
+            mul_div_255((dst >> shift) & 0xff, inverse);
+        result |= std::min(channel, 255u) << shift;
+    }
+    return result;
+}
+
+#ifdef __SSE2__
+inline __m128i load(uint32_t const* pixels)
+{
+    return _mm_loadu_si128(reinterpret_cast<__m128i const*>(pixels));
+}
+
+inline void store(uint32_t* pixels, __m128i value)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), value);
+}
+
+inline __m128i splat(uint32_t value)
+{
+    return _mm_set1_epi32(static_cast<int32_t>(value));
+}
+
+/// mul_div_255() on each 16-bit lane
+inline __m128i mul_div_255(__m128i a, __m128i b)
+{
+    auto const t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+/// Copies the alpha lane of each of two unpacked pixels to all four lanes
+inline __m128i broadcast_alpha(__m128i pixels)
+{
+    return _mm_shufflehi_epi16(
+        _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)),
+        _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+/// blend_pixel() on four pixels at once
+inline __m128i blend_pixels(__m128i dst, __m128i src, __m128i alpha, bool apply_alpha)
+{
+    auto const zero = _mm_setzero_si128();
+    auto const max = _mm_set1_epi16(255);
+
+    auto src_lo = _mm_unpacklo_epi8(src, zero);
+    auto src_hi = _mm_unpackhi_epi8(src, zero);
+    if (apply_alpha)
+    {
+        src_lo = mul_div_255(src_lo, alpha);
+        src_hi = mul_div_255(src_hi, alpha);
+    }
+
+    auto const dst_lo = mul_div_255(_mm_unpacklo_epi8(dst, zero), _mm_sub_epi16(max, broadcast_alpha(src_lo)));
+    auto const dst_hi = mul_div_255(_mm_unpackhi_epi8(dst, zero), _mm_sub_epi16(max, broadcast_alpha(src_hi)));
+
+    return _mm_packus_epi16(_mm_add_epi16(src_lo, dst_lo), _mm_add_epi16(src_hi, dst_hi));
+}
+#endif
+}
+
+void msw::fill_row(uint32_t* dst, int count, uint32_t value)
+{
+    std::fill_n(dst, count, value);
+}
+
+void msw::copy_opaque_row(uint32_t* dst, uint32_t const* src, int count)
+{
+    int i{0};
+#ifdef __SSE2__
+    auto const opaque = splat(alpha_channel);
+    for (; i + 4 <= count; i += 4)
+        store(dst + i, _mm_or_si128(load(src + i), opaque));
+#endif
+    for (; i < count; ++i)
+        dst[i] = src[i] | alpha_channel;
+}
+
+void msw::blend_row(uint32_t* dst, uint32_t const* src, int count, uint8_t alpha, bool src_has_alpha)
+{
+    uint32_t const force_opaque{src_has_alpha ? 0u : alpha_channel};
+
+    int i{0};
+#ifdef __SSE2__
+    auto const zero = _mm_setzero_si128();
+    auto const opaque = splat(alpha_channel);
+    auto const extra_alpha = splat(force_opaque);
+    auto const alpha16 = _mm_set1_epi16(alpha);
+    bool const apply_alpha{alpha != 255};
+
+    for (; i + 4 <= count; i += 4)
+    {
+        auto const s = _mm_or_si128(load(src + i), extra_alpha);
+
+        if (!apply_alpha)
+        {
+            // Most client pixels are either fully opaque or fully transparent
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, opaque), opaque)) == 0xffff)
+            {
+                store(dst + i, s);
+                continue;
+            }
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xffff)
+                continue;
+        }
+
+        store(dst + i, blend_pixels(load(dst + i), s, alpha16, apply_alpha));
+    }
+#endif
+    for (; i < count; ++i)
+        dst[i] = blend_pixel(dst[i], src[i] | force_opaque, alpha);
+}
+
+void msw::scale_row(uint32_t* dst, uint32_t const* src, int count, uint32_t x, uint32_t step)
+{
+    int i{0};
+    for (; i + 4 <= count; i += 4)
+    {
+        dst[i]     = src[x >> 16]; x += step;
+        dst[i + 1] = src[x >> 16]; x += step;
+        dst[i + 2] = src[x >> 16]; x += step;
+        dst[i + 3] = src[x >> 16]; x += step;
+    }
+    for (; i < count; ++i, x += step)
+        dst[i] = src[x >> 16];
+}
+
+void msw::swap_red_blue_row(uint32_t* pixels, int count)
+{
+    uint32_t const alpha_green{0xff00ff00};
+    uint32_t const red_blue{0x00ff00ff};
+
+    int i{0};
+#ifdef __SSE2__
+    auto const keep = splat(alpha_green);
+    auto const swap = splat(red_blue);
+    for (; i + 4 <= count; i += 4)
+    {
+        auto const p = load(pixels + i);
+        auto const rb = _mm_and_si128(p, swap);
+        store(pixels + i,
+            _mm_or_si128(
+                _mm_and_si128(p, keep),
+                _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16))));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        auto const rb = pixels[i] & red_blue;
+        pixels[i] = (pixels[i] & alpha_green) | (rb << 16) | (rb >> 16);
+    }
+}
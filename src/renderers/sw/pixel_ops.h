@@ -0,0 +1,66 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_SW_PIXEL_OPS_H_
+#define MIR_RENDERER_SW_PIXEL_OPS_H_
+
+#include <cstdint>
+
+namespace mir
+{
+namespace renderer
+{
+namespace software
+{
+/*
+ * Row kernels used by the software renderer. All pixels are 32-bit ARGB in
+ * native byte order with premultiplied alpha, matching what Wayland clients
+ * put in wl_shm buffers.
+ */
+
+/// Fills count pixels of dst with value
+void fill_row(uint32_t* dst, int count, uint32_t value);
+
+/// Copies count pixels from src to dst, forcing them fully opaque
+void copy_opaque_row(uint32_t* dst, uint32_t const* src, int count);
+
+/**
+ * Composites count pixels of src over dst (Porter-Duff "over").
+ *
+ * \param [in] alpha          Extra opacity applied to every source pixel
+ * \param [in] src_has_alpha  Whether to honour the source alpha channel. If
+ *                            false the source is treated as opaque (before
+ *                            alpha is applied), as the channel may be garbage
+ *                            in XRGB buffers.
+ */
+void blend_row(uint32_t* dst, uint32_t const* src, int count, uint8_t alpha, bool src_has_alpha);
+
+/**
+ * Nearest-neighbour resample of a row.
+ *
+ * dst[i] = src[(x + i*step) >> 16], i.e. x and step are 16.16 fixed point
+ * coordinates into src.
+ */
+void scale_row(uint32_t* dst, uint32_t const* src, int count, uint32_t x, uint32_t step);
+
+/// Converts count pixels between ABGR and ARGB in place
+void swap_red_blue_row(uint32_t* pixels, int count);
+
+}
+}
+}
+
+#endif /* MIR_RENDERER_SW_PIXEL_OPS_H_ */
@@ -0,0 +1,387 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "SoftwareRenderer"
+
+#include "renderer.h"
+#include "pixel_ops.h"
+#include "mir/renderer/sw/render_target.h"
+#include "mir/renderer/sw/pixel_source.h"
+#include "mir/graphics/buffer.h"
+#include "mir/graphics/display_buffer.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace mg = mir::graphics;
+namespace msw = mir::renderer::software;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// Matches the GL renderer's clear colour
+uint32_t const background{0x00000000};
+
+/// Beyond this many separate regions damage is tracked as a single rectangle
+size_t const max_damage_regions{8};
+
+msw::RenderTarget* render_target_of(mg::DisplayBuffer& display_buffer)
+{
+    auto const render_target =
+        dynamic_cast<msw::RenderTarget*>(display_buffer.native_display_buffer());
+
+    if (!render_target)
+        BOOST_THROW_EXCEPTION(std::logic_error("DisplayBuffer does not support software rendering"));
+
+    return render_target;
+}
+
+bool empty(geom::Rectangle const& rect)
+{
+    return rect.size.width.as_int() <= 0 || rect.size.height.as_int() <= 0;
+}
+
+geom::Rectangle bounding_rectangle(geom::Rectangle const& a, geom::Rectangle const& b)
+{
+    auto const left = std::min(a.left(), b.left());
+    auto const top = std::min(a.top(), b.top());
+    auto const right = std::max(a.right(), b.right());
+    auto const bottom = std::max(a.bottom(), b.bottom());
+
+    return {{left, top}, {(right - left).as_int(), (bottom - top).as_int()}};
+}
+
+/// Adds rect to damage, keeping the regions in damage disjoint
+void add_damage(std::vector<geom::Rectangle>& damage, geom::Rectangle rect)
+{
+    if (empty(rect))
+        return;
+
+    for (auto merged = true; merged;)
+    {
+        merged = false;
+        for (auto i = damage.begin(); i != damage.end(); ++i)
+        {
+            if (i->overlaps(rect))
+            {
+                rect = bounding_rectangle(rect, *i);
+                damage.erase(i);
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    if (damage.size() == max_damage_regions)
+    {
+        for (auto const& region : damage)
+            rect = bounding_rectangle(rect, region);
+        damage.clear();
+    }
+
+    damage.push_back(rect);
+}
+
+uint8_t alpha_to_byte(float alpha)
+{
+    return static_cast<uint8_t>(std::lround(std::min(std::max(alpha, 0.0f), 1.0f) * 255));
+}
+}
+
+bool msw::Renderer::Layer::operator==(Layer const& other) const
+{
+    return id == other.id &&
+           buffer_id == other.buffer_id &&
+           destination == other.destination &&
+           visible == other.visible &&
+           alpha == other.alpha &&
+           shaped == other.shaped;
+}
+
+msw::Renderer::Renderer(mg::DisplayBuffer& display_buffer)
+    : render_target{render_target_of(display_buffer)}
+{
+}
+
+msw::Renderer::~Renderer() = default;
+
+void msw::Renderer::set_viewport(geom::Rectangle const& rect)
+{
+    if (rect == viewport)
+        return;
+
+    viewport = rect;
+    full_redraw = true;
+}
+
+void msw::Renderer::set_output_transform(glm::mat2 const& transform)
+{
+    if (transform != glm::mat2{1} && !transform_reported)
+    {
+        mir::log_warning("Output transformations are not supported; the output will not be rotated");
+        transform_reported = true;
+    }
+}
+
+void msw::Renderer::suspend()
+{
+    // Something else has been drawing on the output
+    full_redraw = true;
+    previous_layers.clear();
+}
+
+void msw::Renderer::render(mg::RenderableList const& renderables) const
+{
+    std::vector<Layer> layers;
+    layers.reserve(renderables.size());
+    for (auto const& renderable : renderables)
+        layers.push_back(layer_for(*renderable));
+
+    auto const damage = damage_between(layers);
+
+    /*
+     * Within each damaged region nothing below the topmost layer that
+     * completely covers it with opaque pixels can be seen, so start there.
+     */
+    std::vector<size_t> first_visible(damage.size(), 0);
+    for (size_t region = 0; region != damage.size(); ++region)
+    {
+        auto covered = false;
+        for (auto i = layers.size(); i-- != 0 && !covered;)
+        {
+            if (layers[i].opaque() && layers[i].visible.contains(damage[region]))
+            {
+                first_visible[region] = i;
+                covered = true;
+            }
+        }
+
+        if (!covered)
+        {
+            auto const& rect = damage[region];
+            auto const stride = render_target->stride().as_int();
+            auto const pixels = render_target->pixels() + rect.left().as_int() * sizeof(uint32_t);
+
+            for (auto y = rect.top().as_int(); y != rect.bottom().as_int(); ++y)
+            {
+                fill_row(
+                    reinterpret_cast<uint32_t*>(pixels + y * stride),
+                    rect.size.width.as_int(),
+                    background);
+            }
+        }
+    }
+
+    std::vector<geom::Rectangle> regions;
+    for (size_t i = 0; i != layers.size(); ++i)
+    {
+        regions.clear();
+        for (size_t region = 0; region != damage.size(); ++region)
+        {
+            if (first_visible[region] <= i)
+            {
+                auto const area = layers[i].visible.intersection_with(damage[region]);
+                if (!empty(area))
+                    regions.push_back(area);
+            }
+        }
+
+        if (!regions.empty())
+            draw(*renderables[i], layers[i], regions);
+    }
+
+    render_target->commit(damage);
+
+    previous_layers = std::move(layers);
+    full_redraw = false;
+}
+
+msw::Renderer::Layer msw::Renderer::layer_for(mg::Renderable const& renderable) const
+{
+    geom::Rectangle const framebuffer{{0, 0}, render_target->size()};
+
+    // Maps from screen coordinates to framebuffer coordinates
+    auto const to_framebuffer =
+        [&](geom::Rectangle const& rect) -> geom::Rectangle
+        {
+            if (empty(viewport))
+                return {};
+
+            double const x_scale = double(framebuffer.size.width.as_int()) / viewport.size.width.as_int();
+            double const y_scale = double(framebuffer.size.height.as_int()) / viewport.size.height.as_int();
+
+            auto const left = std::floor((rect.left() - viewport.left()).as_int() * x_scale);
+            auto const top = std::floor((rect.top() - viewport.top()).as_int() * y_scale);
+            auto const right = std::floor((rect.right() - viewport.left()).as_int() * x_scale);
+            auto const bottom = std::floor((rect.bottom() - viewport.top()).as_int() * y_scale);
+
+            return {
+                {static_cast<int>(left), static_cast<int>(top)},
+                {static_cast<int>(right - left), static_cast<int>(bottom - top)}};
+        };
+
+    auto const buffer = renderable.buffer();
+
+    Layer layer{
+        renderable.id(),
+        buffer ? buffer->id() : mg::BufferID{},
+        to_framebuffer(renderable.screen_position()),
+        {},
+        alpha_to_byte(renderable.alpha()),
+        renderable.shaped()};
+
+    layer.visible = layer.destination.intersection_with(framebuffer);
+    if (auto const clip_area = renderable.clip_area())
+        layer.visible = layer.visible.intersection_with(to_framebuffer(clip_area.value()));
+
+    return layer;
+}
+
+std::vector<geom::Rectangle> msw::Renderer::damage_between(std::vector<Layer> const& layers) const
+{
+    std::vector<geom::Rectangle> damage;
+
+    if (full_redraw)
+    {
+        add_damage(damage, {{0, 0}, render_target->size()});
+        return damage;
+    }
+
+    auto const previous_layer_for =
+        [this](mg::Renderable::ID id)
+        {
+            return std::find_if(
+                previous_layers.begin(), previous_layers.end(),
+                [id](Layer const& layer) { return layer.id == id; });
+        };
+
+    for (size_t i = 0; i != layers.size(); ++i)
+    {
+        auto const& layer = layers[i];
+        if (i < previous_layers.size() && previous_layers[i] == layer)
+            continue;
+
+        add_damage(damage, layer.visible);
+
+        auto const previous = previous_layer_for(layer.id);
+        if (previous != previous_layers.end())
+            add_damage(damage, previous->visible);
+    }
+
+    for (auto const& previous : previous_layers)
+    {
+        auto const gone = std::none_of(
+            layers.begin(), layers.end(),
+            [&previous](Layer const& layer) { return layer.id == previous.id; });
+
+        if (gone)
+            add_damage(damage, previous.visible);
+    }
+
+    return damage;
+}
+
+void msw::Renderer::draw(
+    mg::Renderable const& renderable,
+    Layer const& layer,
+    std::vector<geom::Rectangle> const& regions) const
+{
+    auto const buffer = renderable.buffer();
+    auto const pixel_source = buffer ? dynamic_cast<PixelSource*>(buffer->native_buffer_base()) : nullptr;
+
+    if (!pixel_source)
+    {
+        mir::log_error("Buffer does not support software rendering!");
+        return;
+    }
+
+    bool swap_red_blue;
+    switch (auto const format = buffer->pixel_format())
+    {
+    case mir_pixel_format_argb_8888:
+    case mir_pixel_format_xrgb_8888:
+        swap_red_blue = false;
+        break;
+
+    case mir_pixel_format_abgr_8888:
+    case mir_pixel_format_xbgr_8888:
+        swap_red_blue = true;
+        break;
+
+    default:
+        if (reported_formats.insert(format).second)
+            mir::log_error("Pixel format %d is not supported by the software renderer", format);
+        return;
+    }
+
+    auto const& destination = layer.destination;
+    auto const source_size = buffer->size();
+    auto const source_stride = pixel_source->stride().as_int();
+    auto const target_stride = render_target->stride().as_int();
+    auto const target_pixels = render_target->pixels();
+
+    // 16.16 fixed point steps through the source per destination pixel
+    uint32_t const x_step = (uint64_t(source_size.width.as_int()) << 16) / destination.size.width.as_int();
+    uint32_t const y_step = (uint64_t(source_size.height.as_int()) << 16) / destination.size.height.as_int();
+    bool const unscaled{x_step == (1u << 16)};
+
+    pixel_source->read(
+        [&](unsigned char const* source_pixels)
+        {
+            for (auto const& region : regions)
+            {
+                auto const width = region.size.width.as_int();
+                // Sample from the centre of each destination pixel
+                uint32_t const x = (region.left() - destination.left()).as_int() * x_step + x_step / 2;
+
+                if (scratch_row.size() < static_cast<size_t>(width))
+                    scratch_row.resize(width);
+
+                for (auto y = region.top().as_int(); y != region.bottom().as_int(); ++y)
+                {
+                    auto const source_y =
+                        ((uint64_t((y - destination.top().as_int())) * y_step) + y_step / 2) >> 16;
+                    auto const source_row =
+                        reinterpret_cast<uint32_t const*>(source_pixels + source_y * source_stride);
+                    auto const target_row =
+                        reinterpret_cast<uint32_t*>(target_pixels + y * target_stride) + region.left().as_int();
+
+                    uint32_t const* row = source_row + (x >> 16);
+                    if (!unscaled || swap_red_blue)
+                    {
+                        if (unscaled)
+                            std::copy_n(row, width, scratch_row.data());
+                        else
+                            scale_row(scratch_row.data(), source_row, width, x, x_step);
+
+                        if (swap_red_blue)
+                            swap_red_blue_row(scratch_row.data(), width);
+
+                        row = scratch_row.data();
+                    }
+
+                    if (layer.opaque())
+                        copy_opaque_row(target_row, row, width);
+                    else
+                        blend_row(target_row, row, width, layer.alpha, layer.shaped);
+                }
+            }
+        });
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_SW_RENDERER_H_
+#define MIR_RENDERER_SW_RENDERER_H_
+
+#include <mir/renderer/renderer.h>
+#include <mir/geometry/rectangle.h>
+#include <mir/graphics/buffer_id.h>
+#include <mir/graphics/renderable.h>
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace mir
+{
+namespace graphics { class DisplayBuffer; }
+namespace renderer
+{
+namespace software
+{
+class RenderTarget;
+
+/**
+ * Composites renderables on the CPU into a software::RenderTarget.
+ *
+ * Only the parts of the output that changed since the previous frame are
+ * redrawn, and within those regions anything below the topmost opaque
+ * renderable is skipped. Renderables are scaled to their screen position
+ * with nearest-neighbour sampling; other transformations are not supported.
+ */
+class Renderer : public renderer::Renderer
+{
+public:
+    Renderer(graphics::DisplayBuffer& display_buffer);
+    ~Renderer();
+
+    void set_viewport(geometry::Rectangle const& rect) override;
+    void set_output_transform(glm::mat2 const&) override;
+    void render(graphics::RenderableList const&) const override;
+    void suspend() override;
+
+private:
+    /// What was drawn for a renderable, in framebuffer coordinates
+    struct Layer
+    {
+        graphics::Renderable::ID id;
+        graphics::BufferID buffer_id;
+        geometry::Rectangle destination;
+        geometry::Rectangle visible;
+        uint8_t alpha;
+        bool shaped;
+
+        bool opaque() const { return alpha == 255 && !shaped; }
+        bool operator==(Layer const& other) const;
+    };
+
+    Layer layer_for(graphics::Renderable const& renderable) const;
+    std::vector<geometry::Rectangle> damage_between(std::vector<Layer> const& layers) const;
+    void draw(
+        graphics::Renderable const& renderable,
+        Layer const& layer,
+        std::vector<geometry::Rectangle> const& regions) const;
+
+    RenderTarget* const render_target;
+    geometry::Rectangle viewport;
+    bool transform_reported{false};
+    mutable bool full_redraw{true};
+    mutable std::vector<Layer> previous_layers;
+    mutable std::vector<uint32_t> scratch_row;
+    mutable std::unordered_set<int> reported_formats;
+};
+
+}
+}
+}
+
+#endif // MIR_RENDERER_SW_RENDERER_H_
@@ -23,6 +23,7 @@
 #include "default_display_buffer_compositor_factory.h"
 #include "multi_threaded_compositor.h"
 #include "gl/renderer_factory.h"
+#include "sw/renderer_factory.h"
 #include "compositing_screencast.h"
 #include "mir/main_loop.h"
 
@@ -30,6 +31,7 @@
 #include "mir/options/configuration.h"
 
 #include <boost/throw_exception.hpp>
+#include <stdexcept>
 
 namespace mc = mir::compositor;
 namespace ms = mir::scene;
@@ -86,8 +88,25 @@ mir::DefaultServerConfiguration::the_compositor()
 std::shared_ptr<mir::renderer::RendererFactory> mir::DefaultServerConfiguration::the_renderer_factory()
 {
     return renderer_factory(
-        []()
+        [this]() -> std::shared_ptr<mir::renderer::RendererFactory>
         {
+            auto const renderer = the_options()->get<std::string>(options::renderer_opt);
+
+            if (renderer == options::software_renderer_opt_value)
+                return std::make_shared<mir::renderer::software::RendererFactory>();
+
+            if (renderer != options::gl_renderer_opt_value)
+                BOOST_THROW_EXCEPTION(std::runtime_error("Unknown renderer: " + renderer));
+
+            if (the_options()->is_set(options::gl_program_cache_opt))
+            {
+                auto const program_cache = the_options()->get<std::string>(options::gl_program_cache_opt);
+
+                // An empty cache directory disables the cache
+                return std::make_shared<mir::renderer::gl::RendererFactory>(
+                    program_cache == options::off_opt_value ? std::string{} : program_cache);
+            }
+
             return std::make_shared<mir::renderer::gl::RendererFactory>();
         });
 }
@@ -38,6 +38,7 @@
 #include "mir/input/vt_filter.h"
 #include "mir/input/input_manager.h"
 #include "mir/time/steady_clock.h"
+#include "mir/time/timer_wheel.h"
 #include "mir/geometry/rectangles.h"
 #include "mir/default_configuration.h"
 #include "mir/scene/null_prompt_session_listener.h"
@@ -164,6 +165,15 @@ std::shared_ptr<mir::time::Clock> mir::DefaultServerConfiguration::the_clock()
         });
 }
 
+std::shared_ptr<mir::time::AlarmFactory> mir::DefaultServerConfiguration::the_alarm_factory()
+{
+    return alarm_factory(
+        [this]()
+        {
+            return std::make_shared<mir::time::TimerWheel>(the_main_loop(), the_clock());
+        });
+}
+
 std::shared_ptr<mir::MainLoop> mir::DefaultServerConfiguration::the_main_loop()
 {
     return main_loop(
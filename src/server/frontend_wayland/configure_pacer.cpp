@@ -0,0 +1,48 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "configure_pacer.h"
+
+namespace mf = mir::frontend;
+
+void mf::ConfigurePacer::configure_sent(uint32_t serial)
+{
+    unacked_serial = serial;
+    resize_deferred = false;
+}
+
+void mf::ConfigurePacer::configure_acked(uint32_t serial)
+{
+    // Clients only have to ack the latest of several configures; an older one leaves the latest outstanding
+    if (unacked_serial && serial == unacked_serial.value())
+        unacked_serial = std::experimental::nullopt;
+}
+
+auto mf::ConfigurePacer::resize_requested() -> bool
+{
+    if (unacked_serial)
+    {
+        resize_deferred = true;
+        return false;
+    }
+
+    return true;
+}
+
+auto mf::ConfigurePacer::committed() -> bool
+{
+    return resize_deferred && !unacked_serial;
+}
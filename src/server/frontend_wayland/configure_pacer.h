@@ -0,0 +1,59 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_CONFIGURE_PACER_H_
+#define MIR_FRONTEND_CONFIGURE_PACER_H_
+
+#include <cstdint>
+#include <experimental/optional>
+
+namespace mir
+{
+namespace frontend
+{
+/**
+ * Paces the resizes sent to an xdg_toplevel by the client's progress through them
+ *
+ * An interactive resize changes the size at the rate of pointer motion. Rather than have the client reallocate and
+ * redraw for every intermediate size, a resize that arrives while the client has yet to ack the previous configure is
+ * deferred. It is sent (with whatever size is latest by then) on the first commit after the ack, that is once the
+ * client has drawn at the size it acked. Until then the previous buffer is drawn at its own size.
+ *
+ * Any other configure (a state or focus change, say) carries the latest size too, so it supersedes a deferred resize.
+ */
+class ConfigurePacer
+{
+public:
+    /// A configure has been sent with \a serial
+    void configure_sent(uint32_t serial);
+
+    /// The client has acked the configure with \a serial
+    void configure_acked(uint32_t serial);
+
+    /// \return Whether to send a resize now; if not, it is deferred
+    auto resize_requested() -> bool;
+
+    /// \return Whether to send a deferred resize now that the client has committed
+    auto committed() -> bool;
+
+private:
+    std::experimental::optional<uint32_t> unacked_serial;
+    bool resize_deferred{false};
+};
+}
+}
+
+#endif // MIR_FRONTEND_CONFIGURE_PACER_H_
@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "presentation_time.h"
+
+#include "wl_surface.h"
+#include "deleted_for_resource.h"
+
+#include <time.h>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace mw = mir::wayland;
+
+namespace mir
+{
+namespace frontend
+{
+class WpPresentation::Instance : public wayland::Presentation
+{
+public:
+    Instance(wl_resource* new_resource)
+        : wayland::Presentation{new_resource, Version<1>()}
+    {
+        send_clock_id_event(CLOCK_MONOTONIC);
+    }
+
+private:
+    void destroy() override
+    {
+        destroy_wayland_object();
+    }
+
+    void feedback(wl_resource* surface, wl_resource* callback) override
+    {
+        WlSurface::from(surface)->add_presentation_feedback(std::make_shared<PresentationFeedback>(callback));
+    }
+};
+}
+}
+
+mf::WpPresentation::WpPresentation(wl_display* display)
+    : Global{display, Version<1>()}
+{
+}
+
+void mf::WpPresentation::bind(wl_resource* new_wp_presentation)
+{
+    new Instance{new_wp_presentation};
+}
+
+mf::PresentationFeedback::PresentationFeedback(wl_resource* new_resource)
+    : mw::PresentationFeedback{new_resource, Version<1>()},
+      destroyed{deleted_flag_for_resource(resource)}
+{
+}
+
+void mf::PresentationFeedback::presented(mg::PresentationClock::Presentation const& presentation)
+{
+    if (*destroyed)
+        return;
+
+    auto const ust = std::chrono::duration_cast<std::chrono::nanoseconds>(presentation.frame.ust.nanoseconds).count();
+    uint64_t const tv_sec = ust / 1000000000;
+    uint32_t const tv_nsec = ust % 1000000000;
+    uint64_t const msc = presentation.frame.msc;
+
+    uint32_t flags = 0;
+    if (presentation.vsync)
+        flags |= Kind::vsync | Kind::hw_clock | Kind::hw_completion;
+
+    send_presented_event(
+        tv_sec >> 32, tv_sec & 0xffffffff, tv_nsec,
+        presentation.refresh.count(),
+        msc >> 32, msc & 0xffffffff,
+        flags);
+    destroy_wayland_object();
+}
+
+void mf::PresentationFeedback::discarded()
+{
+    if (*destroyed)
+        return;
+
+    send_discarded_event();
+    destroy_wayland_object();
+}
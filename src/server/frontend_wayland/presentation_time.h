@@ -0,0 +1,56 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_PRESENTATION_TIME_H_
+#define MIR_FRONTEND_PRESENTATION_TIME_H_
+
+#include "presentation-time_wrapper.h"
+
+#include "mir/graphics/presentation_clock.h"
+
+#include <memory>
+
+namespace mir
+{
+namespace frontend
+{
+class WpPresentation : public wayland::Presentation::Global
+{
+public:
+    WpPresentation(wl_display* display);
+
+private:
+    class Instance;
+
+    void bind(wl_resource* new_wp_presentation) override;
+};
+
+/// Delivers exactly one presented or discarded event, then destroys itself
+class PresentationFeedback : public wayland::PresentationFeedback
+{
+public:
+    PresentationFeedback(wl_resource* new_resource);
+
+    void presented(graphics::PresentationClock::Presentation const& presentation);
+    void discarded();
+
+private:
+    std::shared_ptr<bool> const destroyed;
+};
+}
+}
+
+#endif // MIR_FRONTEND_PRESENTATION_TIME_H_
@@ -0,0 +1,91 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "surface_presentation.h"
+
+#include "mir/executor.h"
+
+#include <atomic>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+
+/// Feedback for one buffer commit, claimed by whichever of consumption or replacement happens first
+struct mf::SurfacePresentation::Commit
+{
+    Commit(std::function<void(Presentation const&)> const& presented, std::function<void()> const& discarded)
+        : presented{presented},
+          discarded{discarded}
+    {
+    }
+
+    std::atomic<bool> claimed{false};
+    std::function<void(Presentation const&)> const presented;
+    std::function<void()> const discarded;
+};
+
+mf::SurfacePresentation::SurfacePresentation(
+    std::shared_ptr<Executor> const& wayland_executor,
+    std::shared_ptr<graphics::PresentationClock> const& clock,
+    std::function<void(std::chrono::nanoseconds timestamp)> const& send_frame_callbacks)
+    : wayland_executor{wayland_executor},
+      clock{clock},
+      send_frame_callbacks{send_frame_callbacks},
+      destroyed{std::make_shared<bool>(false)}
+{
+}
+
+mf::SurfacePresentation::~SurfacePresentation()
+{
+    *destroyed = true;
+    discard_unconsumed();
+}
+
+auto mf::SurfacePresentation::buffer_committed(
+    std::function<void(Presentation const&)> const& presented,
+    std::function<void()> const& discarded) -> std::function<void()>
+{
+    auto const commit = std::make_shared<Commit>(presented, discarded);
+    unconsumed = commit;
+
+    // Register for the flip from the compositor thread that consumed the buffer (so we can't miss it, and so the
+    // flip is that of the output the buffer is shown on), then deliver the events on the Wayland thread.
+    return [this, executor = wayland_executor, clock = clock, destroyed = destroyed, commit]()
+        {
+            auto const present = !commit->claimed.exchange(true);
+            clock->on_next_presentation(
+                [this, executor, destroyed, commit, present](Presentation const& presentation)
+                {
+                    executor->spawn(
+                        [this, destroyed, commit, present, presentation]()
+                        {
+                            if (present)
+                                commit->presented(presentation);
+
+                            if (!*destroyed)
+                                send_frame_callbacks(presentation.frame.ust.nanoseconds);
+                        });
+                });
+        };
+}
+
+void mf::SurfacePresentation::discard_unconsumed()
+{
+    if (unconsumed && !unconsumed->claimed.exchange(true))
+        unconsumed->discarded();
+
+    unconsumed.reset();
+}
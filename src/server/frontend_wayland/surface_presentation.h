@@ -0,0 +1,83 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_SURFACE_PRESENTATION_H_
+#define MIR_FRONTEND_SURFACE_PRESENTATION_H_
+
+#include "mir/graphics/presentation_clock.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+
+namespace mir
+{
+class Executor;
+
+namespace frontend
+{
+/**
+ * Times the frame callbacks and presentation feedback of a surface's commits
+ *
+ * Once the compositor consumes a committed buffer, its feedback is presented and the surface's frame callbacks are
+ * sent at the next page flip, so clients start drawing at the beginning of a refresh period. Feedback for a buffer
+ * that is superseded before it is consumed is discarded.
+ *
+ * Everything other than the consumption callback is called on, and reports back on, the Wayland thread.
+ */
+class SurfacePresentation
+{
+public:
+    using Presentation = graphics::PresentationClock::Presentation;
+
+    SurfacePresentation(
+        std::shared_ptr<Executor> const& wayland_executor,
+        std::shared_ptr<graphics::PresentationClock> const& clock,
+        std::function<void(std::chrono::nanoseconds timestamp)> const& send_frame_callbacks);
+
+    /// Discards the feedback of an unconsumed buffer, and sends no more frame callbacks
+    ~SurfacePresentation();
+
+    /**
+     * A buffer has been committed
+     *
+     * \param presented Called once the buffer has reached the screen, unless the buffer is superseded first
+     * \param discarded Called if the buffer is superseded (or the surface destroyed) before it is consumed
+     * \return          The callback for the compositor to call as it consumes the buffer
+     */
+    auto buffer_committed(
+        std::function<void(Presentation const&)> const& presented,
+        std::function<void()> const& discarded) -> std::function<void()>;
+
+    /// The buffer committed last, if not yet consumed, has been superseded
+    void discard_unconsumed();
+
+private:
+    SurfacePresentation(SurfacePresentation const&) = delete;
+    SurfacePresentation& operator=(SurfacePresentation const&) = delete;
+
+    struct Commit;
+
+    std::shared_ptr<Executor> const wayland_executor;
+    std::shared_ptr<graphics::PresentationClock> const clock;
+    std::function<void(std::chrono::nanoseconds timestamp)> const send_frame_callbacks;
+    std::shared_ptr<bool> const destroyed;
+    std::shared_ptr<Commit> unconsumed;
+};
+}
+}
+
+#endif /* MIR_FRONTEND_SURFACE_PRESENTATION_H_ */
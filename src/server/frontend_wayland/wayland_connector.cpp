@@ -26,6 +26,7 @@
 #include "wl_surface.h"
 #include "wl_seat.h"
 #include "wl_region.h"
+#include "presentation_time.h"
 
 #include "null_event_sink.h"
 #include "output_manager.h"
@@ -88,6 +89,10 @@
 #define MIR_NO_WAYLAND_FILTER
 #endif
 
+#if (WAYLAND_VERSION_MAJOR == 1) && (WAYLAND_VERSION_MINOR < 23)
+#define MIR_NO_WAYLAND_MAX_BUFFER_SIZE
+#endif
+
 namespace mf = mir::frontend;
 namespace mg = mir::graphics;
 namespace mc = mir::compositor;
@@ -239,16 +244,19 @@ public:
     WlCompositor(
         struct wl_display* display,
         std::shared_ptr<mir::Executor> const& executor,
-        std::shared_ptr<mg::WaylandAllocator> const& allocator)
+        std::shared_ptr<mg::WaylandAllocator> const& allocator,
+        std::shared_ptr<mg::PresentationClock> const& presentation_clock)
         : Global(display, Version<4>()),
           allocator{allocator},
-          executor{executor}
+          executor{executor},
+          presentation_clock{presentation_clock}
     {
     }
 
 private:
     std::shared_ptr<mg::WaylandAllocator> const allocator;
     std::shared_ptr<mir::Executor> const executor;
+    std::shared_ptr<mg::PresentationClock> const presentation_clock;
 
     class Instance : wayland::Compositor
     {
@@ -273,7 +281,7 @@ private:
 
 void WlCompositor::Instance::create_surface(wl_resource* new_surface)
 {
-    new WlSurface{new_surface, compositor->executor, compositor->allocator};
+    new WlSurface{new_surface, compositor->executor, compositor->allocator, compositor->presentation_clock};
 }
 
 void WlCompositor::Instance::create_region(wl_resource* new_region)
@@ -631,6 +639,7 @@ mf::WaylandConnector::WaylandConnector(
     std::shared_ptr<mi::Seat> const& seat,
     std::shared_ptr<mg::GraphicBufferAllocator> const& allocator,
     std::shared_ptr<mf::SessionAuthorizer> const& session_authorizer,
+    std::shared_ptr<mg::PresentationClock> const& presentation_clock,
     bool arw_socket,
     std::unique_ptr<WaylandExtensions> extensions_,
     WaylandProtocolExtensionFilter const& extension_filter)
@@ -655,6 +664,12 @@ mf::WaylandConnector::WaylandConnector(
         BOOST_THROW_EXCEPTION(std::runtime_error{"Failed to create wl_display"});
     }
 
+#ifndef MIR_NO_WAYLAND_MAX_BUFFER_SIZE
+    // A client that is slow to read (for example while it is busy rendering) would otherwise be
+    // disconnected as soon as libwayland's default 4KiB of queued events overflows
+    wl_display_set_default_max_buffer_size(display.get(), 1024 * 1024);
+#endif
+
 #ifndef MIR_NO_WAYLAND_FILTER
     wl_display_set_global_filter(display.get(), &wl_display_global_filter_func_thunk, this);
 #else
@@ -680,7 +695,8 @@ mf::WaylandConnector::WaylandConnector(
     compositor_global = std::make_unique<mf::WlCompositor>(
         display.get(),
         executor,
-        this->allocator);
+        this->allocator,
+        presentation_clock);
     subcompositor_global = std::make_unique<mf::WlSubcompositor>(display.get());
     seat_global = std::make_unique<mf::WlSeat>(display.get(), input_hub, seat, executor);
     output_manager = std::make_unique<mf::OutputManager>(
@@ -689,6 +705,7 @@ mf::WaylandConnector::WaylandConnector(
         executor);
 
     data_device_manager_global = mf::create_data_device_manager(display.get());
+    presentation_global = std::make_unique<mf::WpPresentation>(display.get());
 
     extensions->init(display.get(), shell, seat_global.get(), output_manager.get());
 
@@ -42,6 +42,7 @@ namespace graphics
 {
 class GraphicBufferAllocator;
 class WaylandAllocator;
+class PresentationClock;
 }
 namespace geometry
 {
@@ -65,6 +66,7 @@ class OutputManager;
 class MirDisplay;
 class SessionAuthorizer;
 class DataDeviceManager;
+class WpPresentation;
 
 class WaylandExtensions
 {
@@ -101,6 +103,7 @@ public:
         std::shared_ptr<input::Seat> const& seat,
         std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator,
         std::shared_ptr<SessionAuthorizer> const& session_authorizer,
+        std::shared_ptr<graphics::PresentationClock> const& presentation_clock,
         bool arw_socket,
         std::unique_ptr<WaylandExtensions> extensions,
         WaylandProtocolExtensionFilter const& extension_filter);
@@ -132,6 +135,7 @@ private:
     std::unique_ptr<WlSeat> seat_global;
     std::unique_ptr<OutputManager> output_manager;
     std::unique_ptr<DataDeviceManager> data_device_manager_global;
+    std::unique_ptr<WpPresentation> presentation_global;
     std::shared_ptr<Executor> const executor;
     std::shared_ptr<graphics::WaylandAllocator> const allocator;
     std::shared_ptr<shell::Shell> const shell;
@@ -30,6 +30,7 @@
 #include "xdg-output-unstable-v1_wrapper.h"
 
 #include "mir/graphics/platform.h"
+#include "mir/graphics/vsync_presentation_clock.h"
 #include "mir/options/default_configuration.h"
 #include "mir/scene/session.h"
 
@@ -158,6 +159,7 @@ std::shared_ptr<mf::Connector>
                 the_seat(),
                 the_buffer_allocator(),
                 the_session_authorizer(),
+                the_presentation_clock(),
                 arw_socket,
                 configure_wayland_extensions(wayland_extensions, options->is_set(mo::x11_display_opt), wayland_extension_hooks),
                 wayland_extension_filter);
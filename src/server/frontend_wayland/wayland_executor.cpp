@@ -25,8 +25,8 @@
 
 #include <boost/throw_exception.hpp>
 
+#include <atomic>
 #include <cstring>
-#include <deque>
 #include <functional>
 #include <mutex>
 #include <system_error>
@@ -44,6 +44,12 @@ namespace mf = mir::frontend;
  * wl_event_source and the WaylandExecutor. WaylandExecutor can then always
  * enqueue new work, even if no more work is going to be processed, and the work
  * processing function always has a reference to the workqueue state.
+ *
+ * Work is spawned from many threads (most notably once per input event) and only
+ * ever consumed by the Wayland thread, so the workqueue is a lock-free intrusive
+ * multi-producer single-consumer queue. The eventfd is only written by the spawn
+ * that finds no wakeup outstanding, and the Wayland thread then runs everything
+ * that has been queued in one go.
  */
 
 class mf::WaylandExecutor::State
@@ -55,67 +61,111 @@ private:
         TerminationRequested,
         Stopped
     };
+
+    struct Node
+    {
+        std::atomic<Node*> next{nullptr};
+        std::function<void()> work;
+    };
+
 public:
     explicit State(wl_event_loop* loop)
         : loop{loop}
     {
-        enqueue(
-            []()
-            {
-                on_wayland_thread = true;
-            });
+        // Runs ahead of the first spawned work, which is what wakes the loop
+        auto const node = new Node;
+        node->work = []() { on_wayland_thread = true; };
+        push(node);
     }
 
-    void enqueue(std::function<void()>&& work)
+    ~State()
     {
-        if (on_wayland_thread)
+        // Anything left over was spawned after the event loop stopped; drop it on the floor
+        while (auto const node = pop())
         {
-            work();
-            return;
+            delete node;
         }
+    }
 
-        std::lock_guard<std::mutex> lock{mutex};
-        if (state == ExecutionState::Running)
+    /// \return true if the caller needs to wake the event loop
+    bool enqueue(std::function<void()>&& work)
+    {
+        if (on_wayland_thread)
         {
-            workqueue.emplace_back(std::move(work));
+            work();
+            return false;
         }
+
         // If we've been terminated then drop the work on the floor, letting the
         // std::function destructor clean up any necessary state.
+        if (state.load(std::memory_order_acquire) != ExecutionState::Running)
+        {
+            return false;
+        }
+
+        auto const node = new Node;
+        node->work = std::move(work);
+        push(node);
+
+        return !wakeup_pending.exchange(true, std::memory_order_acq_rel);
     }
 
     void enqueue_termination(std::function<void()>&& terminator)
     {
-        std::lock_guard<std::mutex> lock{mutex};
-        if (state == ExecutionState::Running)
+        std::lock_guard<std::mutex> lock{termination_mutex};
+        if (state.load(std::memory_order_relaxed) == ExecutionState::Running)
         {
-            workqueue.emplace_front(std::move(terminator));
+            this->terminator = std::move(terminator);
             on_wayland_thread = false;
-            state = ExecutionState::TerminationRequested;
+            state.store(ExecutionState::TerminationRequested, std::memory_order_release);
         }
     }
 
-    std::function<void()> get_work()
+    std::function<void()> take_terminator()
+    {
+        std::lock_guard<std::mutex> lock{termination_mutex};
+        return std::move(terminator);
+    }
+
+    /**
+     * Run all the work currently queued.
+     *
+     * Any spawn that happens after this has started either gets run here or
+     * sees no wakeup pending, and so writes the eventfd itself.
+     */
+    void run_work()
     {
-        std::lock_guard<std::mutex> lock{mutex};
-        if (!workqueue.empty())
+        wakeup_pending.store(false, std::memory_order_seq_cst);
+
+        // A null pop means either the queue is empty or a producer is part way through
+        // push(); in the latter case that producer will wake us again once it's done.
+        while (auto const node = pop())
         {
-            auto const work = std::move(workqueue.front());
-            workqueue.pop_front();
-            return work;
+            std::unique_ptr<Node> const owner{node};
+            try
+            {
+                node->work();
+            }
+            catch (...)
+            {
+                mir::log(
+                    mir::logging::Severity::critical,
+                    MIR_LOG_COMPONENT,
+                    std::current_exception(),
+                    "Exception processing Wayland event loop work item");
+            }
         }
-        return {};
     }
 
     std::unique_lock<std::mutex> drain()
     {
-        std::unique_lock<std::mutex> lock{mutex};
+        std::unique_lock<std::mutex> lock{termination_mutex};
 
-        if (state == ExecutionState::TerminationRequested)
+        if (state.load(std::memory_order_relaxed) == ExecutionState::TerminationRequested && terminator)
         {
-            // If we've been asked to terminate then the front of the workqueue
-            // will contain the termination request.
+            // If we've been asked to terminate then run the termination request.
             {
-                std::function<void()> const work = std::move(workqueue.front());
+                std::function<void()> const work = std::move(terminator);
                 lock.unlock();
 
                 work();
@@ -124,19 +174,68 @@ public:
         }
 
         on_wayland_thread = false;
-        state = ExecutionState::Stopped;
-        workqueue.empty();
+        state.store(ExecutionState::Stopped, std::memory_order_release);
 
         return lock;
     }
 
     static int on_notify(int fd, uint32_t, void* data);
 private:
+    // Vyukov's intrusive MPSC queue: producers only touch head, the consumer only touches tail.
+    void push(Node* node)
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        auto const prev = head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    Node* pop()
+    {
+        auto current = tail;
+        auto next = current->next.load(std::memory_order_acquire);
+
+        if (current == &stub)
+        {
+            if (!next)
+                return nullptr;
+
+            tail = next;
+            current = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (next)
+        {
+            tail = next;
+            return current;
+        }
+
+        if (current != head.load(std::memory_order_acquire))
+            return nullptr;
+
+        push(&stub);
+
+        next = current->next.load(std::memory_order_acquire);
+        if (next)
+        {
+            tail = next;
+            return current;
+        }
+
+        return nullptr;
+    }
+
     static thread_local bool on_wayland_thread;
-    std::mutex mutex;
-    ExecutionState state{ExecutionState::Running};
+    std::atomic<ExecutionState> state{ExecutionState::Running};
     wl_event_loop* const loop;
-    std::deque<std::function<void()>> workqueue;
+
+    Node stub;
+    std::atomic<Node*> head{&stub};
+    Node* tail{&stub};
+    std::atomic<bool> wakeup_pending{false};
+
+    std::mutex termination_mutex;
+    std::function<void()> terminator;
 };
 
 thread_local bool mf::WaylandExecutor::State::on_wayland_thread{false};
@@ -233,34 +332,20 @@ int mf::WaylandExecutor::State::on_notify(int fd, uint32_t, void* data)
             err);
     }
 
-    while (auto work = state->get_work())
-    {
-        try
-        {
-            work();
-        }
-        catch (...)
-        {
-            mir::log(
-                mir::logging::Severity::critical,
-                MIR_LOG_COMPONENT,
-                std::current_exception(),
-                "Exception processing Wayland event loop work item");
-        }
-    }
-    if (state->state != ExecutionState::Running)
+    state->run_work();
+
+    if (auto const terminator = state->take_terminator())
     {
+        terminator();
         EventLoopDestroyedHandler::remove_destruction_handler_for_loop(state->loop);
     }
 
     return 0;
 }
 
-
-
 mf::WaylandExecutor::WaylandExecutor(wl_event_loop* loop)
     : state{std::make_shared<State>(loop)},
-      notify_fd{eventfd(0, EFD_CLOEXEC | EFD_SEMAPHORE | EFD_NONBLOCK)},
+      notify_fd{eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)},
       source{wl_event_loop_add_fd(
           loop,
           notify_fd,
@@ -319,7 +404,8 @@ mf::WaylandExecutor::~WaylandExecutor()
 
 void mf::WaylandExecutor::spawn (std::function<void()>&& work)
 {
-    state->enqueue(std::move(work));
+    if (!state->enqueue(std::move(work)))
+        return;
 
     if (auto err = eventfd_write(notify_fd, 1))
     {
@@ -26,7 +26,7 @@
 
 #include <mutex>
 #include <memory>
-#include <deque>
+#include <functional>
 
 namespace mir
 {
@@ -27,6 +27,7 @@
 #include <mir/input/keymap.h>
 #include <mir/log.h>
 
+#include <wayland-server-core.h>
 #include <linux/input-event-codes.h>
 #include <boost/throw_exception.hpp>
 
@@ -70,6 +71,54 @@ void mf::WaylandInputDispatcher::set_focus(bool has_focus)
         });
 }
 
+mf::WaylandInputDispatcher::Record::Record(MirInputEvent const* event)
+    : type{mir_input_event_get_type(event)},
+      time{mir_input_event_get_event_time(event)},
+      has_cookie{mir_input_event_has_cookie(event)}
+{
+    switch (type)
+    {
+    case mir_input_event_type_key:
+    {
+        auto const key_event = mir_input_event_get_keyboard_event(event);
+        key_action = mir_keyboard_event_action(key_event);
+        scancode = mir_keyboard_event_scan_code(key_event);
+        break;
+    }
+    case mir_input_event_type_pointer:
+    {
+        auto const pointer_event = mir_input_event_get_pointer_event(event);
+        pointer_action = mir_pointer_event_action(pointer_event);
+        pointer_buttons = mir_pointer_event_buttons(pointer_event);
+        position = geom::Point{
+            mir_pointer_event_axis_value(pointer_event, mir_pointer_axis_x),
+            mir_pointer_event_axis_value(pointer_event, mir_pointer_axis_y)};
+        axis_motion = geom::Displacement{
+            mir_pointer_event_axis_value(pointer_event, mir_pointer_axis_hscroll) * 10,
+            mir_pointer_event_axis_value(pointer_event, mir_pointer_axis_vscroll) * 10};
+        break;
+    }
+    case mir_input_event_type_touch:
+    {
+        auto const touch_event = mir_input_event_get_touch_event(event);
+        auto const count = mir_touch_event_point_count(touch_event);
+        touch_points.reserve(count);
+        for (auto i = 0u; i < count; ++i)
+        {
+            touch_points.push_back(TouchPoint{
+                mir_touch_event_id(touch_event, i),
+                mir_touch_event_action(touch_event, i),
+                geom::Point{
+                    mir_touch_event_axis_value(touch_event, i, mir_touch_axis_x),
+                    mir_touch_event_axis_value(touch_event, i, mir_touch_axis_y)}});
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
 void mf::WaylandInputDispatcher::handle_event(MirEvent const* event)
 {
     if (*wl_surface_destroyed)
@@ -83,69 +132,92 @@ void mf::WaylandInputDispatcher::handle_event(MirEvent const* event)
         return;
     }
 
-    auto const input_ev = mir_event_get_input_event(event);
-    handle_input_event(input_ev);
+    handle_records({Record{mir_event_get_input_event(event)}});
 }
 
-void mf::WaylandInputDispatcher::handle_input_event(MirInputEvent const* event)
+void mf::WaylandInputDispatcher::handle_records(std::vector<Record> const& records)
 {
-    auto const ns = std::chrono::nanoseconds{mir_input_event_get_event_time(event)};
-    auto const ms = std::chrono::duration_cast<std::chrono::milliseconds>(ns);
-
-    // Remember the timestamp of any events "signed" with a cookie
-    if (mir_input_event_has_cookie(event))
-        timestamp = ns;
+    if (*wl_surface_destroyed)
+        return;
 
-    switch (mir_input_event_get_type(event))
+    auto const last = records.end();
+    for (auto current = records.begin(); current != last;)
     {
-    case mir_input_event_type_key:
-        handle_keyboard_event(ms, mir_input_event_get_keyboard_event(event));
-        break;
-    case mir_input_event_type_pointer:
-        handle_pointer_event(ms, mir_input_event_get_pointer_event(event));
-        break;
-    case mir_input_event_type_touch:
-        handle_touch_event(ms, mir_input_event_get_touch_event(event));
-        break;
-    default:
-        break;
+        // Remember the timestamp of any events "signed" with a cookie
+        if (current->has_cookie)
+            timestamp = current->time;
+
+        switch (current->type)
+        {
+        case mir_input_event_type_key:
+            current = handle_keyboard_records(current, last);
+            break;
+
+        case mir_input_event_type_pointer:
+            if (current->pointer_action == mir_pointer_action_motion)
+            {
+                current = handle_pointer_motion_records(current, last);
+            }
+            else
+            {
+                handle_pointer_record(*current++);
+            }
+            break;
+
+        case mir_input_event_type_touch:
+            handle_touch_record(*current++);
+            break;
+
+        default:
+            ++current;
+            break;
+        }
     }
+
+    // Input is latency critical, so don't leave it waiting for the rest of this event loop iteration
+    wl_client_flush(client);
 }
 
-void mf::WaylandInputDispatcher::handle_keyboard_event(std::chrono::milliseconds const& ms, MirKeyboardEvent const* event)
+auto mf::WaylandInputDispatcher::handle_keyboard_records(Iterator first, Iterator last) -> Iterator
 {
-    MirKeyboardAction const action = mir_keyboard_event_action(event);
-    if (action == mir_keyboard_action_down || action == mir_keyboard_action_up)
+    auto end = first;
+    while (end != last && end->type == mir_input_event_type_key)
     {
-        int const scancode = mir_keyboard_event_scan_code(event);
-        bool const down = action == mir_keyboard_action_down;
-        seat->for_each_listener(client, [&ms, scancode, down](WlKeyboard* keyboard)
-            {
-                keyboard->key(ms, scancode, down);
-            });
+        if (end->has_cookie)
+            timestamp = end->time;
+        ++end;
     }
+
+    seat->for_each_listener(client, [first, end](WlKeyboard* keyboard)
+        {
+            for (auto record = first; record != end; ++record)
+            {
+                if (record->key_action == mir_keyboard_action_down || record->key_action == mir_keyboard_action_up)
+                {
+                    auto const ms = std::chrono::duration_cast<std::chrono::milliseconds>(record->time);
+                    keyboard->key(ms, record->scancode, record->key_action == mir_keyboard_action_down);
+                }
+            }
+        });
+
+    return end;
 }
 
-void mf::WaylandInputDispatcher::handle_pointer_event(std::chrono::milliseconds const& ms, MirPointerEvent const* event)
+void mf::WaylandInputDispatcher::handle_pointer_record(Record const& record)
 {
-    switch(mir_pointer_event_action(event))
+    switch(record.pointer_action)
     {
         case mir_pointer_action_button_down:
         case mir_pointer_action_button_up:
-            handle_pointer_button_event(ms, event);
+            handle_pointer_button_record(record);
             break;
         case mir_pointer_action_enter:
-        {
-            geom::Point const position{
-                mir_pointer_event_axis_value(event, mir_pointer_axis_x),
-                mir_pointer_event_axis_value(event, mir_pointer_axis_y)};
-            seat->for_each_listener(client, [wl_surface = wl_surface, &position](WlPointer* pointer)
+            seat->for_each_listener(client, [wl_surface = wl_surface, &record](WlPointer* pointer)
                 {
-                    pointer->enter(wl_surface, position);
+                    pointer->enter(wl_surface, record.position);
                     pointer->frame();
                 });
             break;
-        }
         case mir_pointer_action_leave:
             seat->for_each_listener(client, [](WlPointer* pointer)
                 {
@@ -154,18 +226,15 @@ void mf::WaylandInputDispatcher::handle_pointer_event(std::chrono::milliseconds
                 });
             break;
         case mir_pointer_action_motion:
-            handle_pointer_motion_event(ms, event);
-            break;
         case mir_pointer_actions:
             break;
     }
 }
 
-void mf::WaylandInputDispatcher::handle_pointer_button_event(
-    std::chrono::milliseconds const& ms,
-    MirPointerEvent const* event)
+void mf::WaylandInputDispatcher::handle_pointer_button_record(Record const& record)
 {
-    MirPointerButtons const event_buttons = mir_pointer_event_buttons(event);
+    auto const ms = std::chrono::duration_cast<std::chrono::milliseconds>(record.time);
+    MirPointerButtons const event_buttons = record.pointer_buttons;
     std::vector<std::pair<uint32_t, bool>> buttons;
 
     for (auto const& mapping :
@@ -202,19 +271,28 @@ void mf::WaylandInputDispatcher::handle_pointer_button_event(
     last_pointer_buttons = event_buttons;
 }
 
-void mf::WaylandInputDispatcher::handle_pointer_motion_event(
-    std::chrono::milliseconds const& ms,
-    MirPointerEvent const* event)
+auto mf::WaylandInputDispatcher::handle_pointer_motion_records(Iterator first, Iterator last) -> Iterator
 {
     // TODO: send axis_source, axis_stop and axis_discrete events where appropriate
     // (may require significant eworking of the input system)
 
-    geom::Point const position{
-        mir_pointer_event_axis_value(event, mir_pointer_axis_x),
-        mir_pointer_event_axis_value(event, mir_pointer_axis_y)};
-    geom::Displacement const axis_motion{
-        mir_pointer_event_axis_value(event, mir_pointer_axis_hscroll) * 10,
-        mir_pointer_event_axis_value(event, mir_pointer_axis_vscroll) * 10};
+    // Motion that has queued up since the last batch is only of interest to the client where it ended
+    // up, so send it as a single motion (and the summed scrolling) in a single frame.
+    auto end = first;
+    geom::Displacement axis_motion;
+    while (end != last &&
+           end->type == mir_input_event_type_pointer &&
+           end->pointer_action == mir_pointer_action_motion)
+    {
+        if (end->has_cookie)
+            timestamp = end->time;
+        axis_motion = axis_motion + end->axis_motion;
+        ++end;
+    }
+
+    auto const& latest = *(end - 1);
+    auto const ms = std::chrono::duration_cast<std::chrono::milliseconds>(latest.time);
+    auto const& position = latest.position;
     bool const send_motion = (!last_pointer_position || position != last_pointer_position.value());
     bool const send_axis = (axis_motion != geom::Displacement{});
 
@@ -233,21 +311,20 @@ void mf::WaylandInputDispatcher::handle_pointer_motion_event(
                 pointer->frame();
             });
     }
+
+    return end;
 }
 
-void mf::WaylandInputDispatcher::handle_touch_event(
-    std::chrono::milliseconds const& ms,
-    MirTouchEvent const* event)
+void mf::WaylandInputDispatcher::handle_touch_record(Record const& record)
 {
-    for (auto i = 0u; i < mir_touch_event_point_count(event); ++i)
+    auto const ms = std::chrono::duration_cast<std::chrono::milliseconds>(record.time);
+
+    for (auto const& point : record.touch_points)
     {
-        geometry::Point const position{
-            mir_touch_event_axis_value(event, i, mir_touch_axis_x),
-            mir_touch_event_axis_value(event, i, mir_touch_axis_y)};
-        int const touch_id = mir_touch_event_id(event, i);
-        MirTouchAction const action = mir_touch_event_action(event, i);
+        auto const touch_id = point.id;
+        auto const& position = point.position;
 
-        switch (action)
+        switch (point.action)
         {
         case mir_touch_action_down:
             seat->for_each_listener(client, [&ms, touch_id, wl_surface = wl_surface, &position](WlTouch* touch)
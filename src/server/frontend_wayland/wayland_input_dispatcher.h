@@ -22,9 +22,11 @@
 #include "mir_toolkit/common.h"
 #include "mir_toolkit/events/event.h"
 #include "mir/geometry/point.h"
+#include "mir/geometry/displacement.h"
 
 #include <memory>
 #include <chrono>
+#include <vector>
 #include <experimental/optional>
 
 struct wl_client;
@@ -45,6 +47,34 @@ class WlSurface;
 class WaylandInputDispatcher
 {
 public:
+    /// The parts of an input event that reach a Wayland client
+    /// Copying these out can be done from any thread and is much cheaper than cloning the MirEvent
+    struct Record
+    {
+        explicit Record(MirInputEvent const* event);
+
+        struct TouchPoint
+        {
+            int id;
+            MirTouchAction action;
+            geometry::Point position;
+        };
+
+        MirInputEventType type;
+        std::chrono::nanoseconds time;
+        bool has_cookie;
+
+        MirKeyboardAction key_action{mir_keyboard_actions};
+        int scancode{0};
+
+        MirPointerAction pointer_action{mir_pointer_actions};
+        MirPointerButtons pointer_buttons{0};
+        geometry::Point position;
+        geometry::Displacement axis_motion;
+
+        std::vector<TouchPoint> touch_points;
+    };
+
     WaylandInputDispatcher(
         WlSeat* seat,
         WlSurface* wl_surface);
@@ -54,6 +84,9 @@ public:
     void set_focus(bool has_focus);
     void handle_event(MirEvent const* event);
 
+    /// Sends a batch of input in order, coalescing consecutive pointer motion into a single wl_pointer.frame
+    void handle_records(std::vector<Record> const& records);
+
     auto latest_timestamp() const -> std::chrono::nanoseconds { return timestamp; }
 
 private:
@@ -69,14 +102,16 @@ private:
     MirPointerButtons last_pointer_buttons{0};
     std::experimental::optional<geometry::Point> last_pointer_position;
 
+    using Iterator = std::vector<Record>::const_iterator;
+
     /// Handle user input events
+    /// Those taking a range consume a run of similar records, and return the end of that run
     ///@{
-    void handle_input_event(MirInputEvent const* event);
-    void handle_keyboard_event(std::chrono::milliseconds const& ms, MirKeyboardEvent const* event);
-    void handle_pointer_event(std::chrono::milliseconds const& ms, MirPointerEvent const* event);
-    void handle_pointer_button_event(std::chrono::milliseconds const& ms, MirPointerEvent const* event);
-    void handle_pointer_motion_event(std::chrono::milliseconds const& ms, MirPointerEvent const* event);
-    void handle_touch_event(std::chrono::milliseconds const& ms, MirTouchEvent const* event);
+    auto handle_keyboard_records(Iterator first, Iterator last) -> Iterator;
+    auto handle_pointer_motion_records(Iterator first, Iterator last) -> Iterator;
+    void handle_pointer_record(Record const& record);
+    void handle_pointer_button_record(Record const& record);
+    void handle_touch_record(Record const& record);
     ///@}
 };
 }
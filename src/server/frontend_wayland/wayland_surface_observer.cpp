@@ -23,15 +23,12 @@
 #include "window_wl_surface_role.h"
 #include "wayland_input_dispatcher.h"
 
-#include <mir/events/event_builders.h>
-
 #include <mir/input/keymap.h>
 #include <mir/log.h>
 
 namespace mf = mir::frontend;
 namespace ms = mir::scene;
 namespace geom = mir::geometry;
-namespace mev = mir::events;
 namespace mi = mir::input;
 
 mf::WaylandSurfaceObserver::WaylandSurfaceObserver(
@@ -128,13 +125,41 @@ void mf::WaylandSurfaceObserver::placed_relative(ms::Surface const*, geometry::R
 
 void mf::WaylandSurfaceObserver::input_consumed(ms::Surface const*, MirEvent const* event)
 {
-    std::shared_ptr<MirEvent> owned_event = mev::clone_event(*event);
+    if (mir_event_get_type(event) != mir_event_type_input)
+    {
+        log_warning(
+            "WaylandSurfaceObserver::input_consumed() got non-input event type %d",
+            mir_event_get_type(event));
+        return;
+    }
 
-    run_on_wayland_thread_unless_destroyed(
-        [this, owned_event]()
+    WaylandInputDispatcher::Record record{mir_event_get_input_event(event)};
+
+    std::shared_ptr<std::vector<WaylandInputDispatcher::Record>> new_batch;
+    {
+        std::lock_guard<std::mutex> lock{input_mutex};
+        if (!open_input_batch)
         {
-            input_dispatcher->handle_event(owned_event.get());
-        });
+            new_batch = std::make_shared<std::vector<WaylandInputDispatcher::Record>>();
+            open_input_batch = new_batch;
+        }
+        open_input_batch->push_back(std::move(record));
+    }
+
+    // Spawning may run the work immediately (if we're on the Wayland thread), so don't hold the lock
+    if (new_batch)
+    {
+        spawn_unless_destroyed(
+            [this, batch = std::move(new_batch)]()
+            {
+                {
+                    std::lock_guard<std::mutex> lock{input_mutex};
+                    if (open_input_batch == batch)
+                        open_input_batch.reset();
+                }
+                input_dispatcher->handle_records(*batch);
+            });
+    }
 }
 
 auto mf::WaylandSurfaceObserver::latest_timestamp() const -> std::chrono::nanoseconds
@@ -143,6 +168,16 @@ auto mf::WaylandSurfaceObserver::latest_timestamp() const -> std::chrono::nanose
 }
 
 void mf::WaylandSurfaceObserver::run_on_wayland_thread_unless_destroyed(std::function<void()>&& work)
+{
+    {
+        // Input arriving after this must not overtake it, so it needs to start a new batch
+        std::lock_guard<std::mutex> lock{input_mutex};
+        open_input_batch.reset();
+    }
+    spawn_unless_destroyed(std::move(work));
+}
+
+void mf::WaylandSurfaceObserver::spawn_unless_destroyed(std::function<void()>&& work)
 {
     seat->spawn(run_unless(destroyed, work));
 }
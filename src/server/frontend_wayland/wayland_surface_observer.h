@@ -21,8 +21,11 @@
 #define MIR_FRONTEND_WAYLAND_SURFACE_OBSERVER_H_
 
 #include "mir/scene/null_surface_observer.h"
+#include "wayland_input_dispatcher.h"
 
 #include <memory>
+#include <mutex>
+#include <vector>
 #include <experimental/optional>
 #include <chrono>
 #include <functional>
@@ -36,7 +39,6 @@ namespace frontend
 class WlSurface;
 class WlSeat;
 class WindowWlSurfaceRole;
-class WaylandInputDispatcher;
 
 class WaylandSurfaceObserver
     : public scene::NullSurfaceObserver
@@ -81,7 +83,7 @@ public:
     void disconnect() { *destroyed = true; }
 
 private:
-    WlSeat* const seat; // only used by run_on_wayland_thread_unless_destroyed()
+    WlSeat* const seat; // only used by spawn_unless_destroyed()
     WindowWlSurfaceRole* const window;
     std::unique_ptr<WaylandInputDispatcher> const input_dispatcher;
 
@@ -90,7 +92,15 @@ private:
     MirWindowState current_state{mir_window_state_unknown};
     std::shared_ptr<bool> const destroyed;
 
+    /// Input waiting for the Wayland thread. Only the first event of a batch spawns work; later
+    /// events are appended until the batch is taken, or closed by other work being spawned.
+    ///@{
+    std::mutex input_mutex;
+    std::shared_ptr<std::vector<WaylandInputDispatcher::Record>> open_input_batch;
+    ///@}
+
     void run_on_wayland_thread_unless_destroyed(std::function<void()>&& work);
+    void spawn_unless_destroyed(std::function<void()>&& work);
 };
 }
 }
@@ -24,6 +24,7 @@
 #include "wl_region.h"
 #include "wlshmbuffer.h"
 #include "deleted_for_resource.h"
+#include "presentation_time.h"
 
 #include "wayland_wrapper.h"
 
@@ -35,6 +36,7 @@
 #include "mir/compositor/buffer_stream.h"
 #include "mir/executor.h"
 #include "mir/graphics/wayland_allocator.h"
+#include "mir/graphics/presentation_clock.h"
 #include "mir/shell/surface_specification.h"
 #include "mir/log.h"
 
@@ -45,6 +47,15 @@ namespace mf = mir::frontend;
 namespace geom = mir::geometry;
 namespace mw = mir::wayland;
 namespace msh = mir::shell;
+namespace mg = mir::graphics;
+
+namespace
+{
+auto now() -> std::chrono::nanoseconds
+{
+    return mir::time::PosixTimestamp::now(CLOCK_MONOTONIC).nanoseconds;
+}
+}
 
 mf::WlSurfaceState::Callback::Callback(wl_resource* new_resource)
     : mw::Callback{new_resource, Version<1>()},
@@ -67,6 +78,10 @@ void mf::WlSurfaceState::update_from(WlSurfaceState const& source)
                            begin(source.frame_callbacks),
                            end(source.frame_callbacks));
 
+    presentation_feedbacks.insert(end(presentation_feedbacks),
+                                  begin(source.presentation_feedbacks),
+                                  end(source.presentation_feedbacks));
+
     if (source.surface_data_invalidated)
         surface_data_invalidated = true;
 }
@@ -81,7 +96,8 @@ bool mf::WlSurfaceState::surface_data_needs_refresh() const
 mf::WlSurface::WlSurface(
     wl_resource* new_resource,
     std::shared_ptr<Executor> const& executor,
-    std::shared_ptr<graphics::WaylandAllocator> const& allocator)
+    std::shared_ptr<graphics::WaylandAllocator> const& allocator,
+    std::shared_ptr<graphics::PresentationClock> const& presentation_clock)
     : Surface(new_resource, Version<4>()),
         session{get_session(client)},
         stream{session->create_buffer_stream({{}, mir_pixel_format_invalid, graphics::BufferUsage::undefined})},
@@ -89,6 +105,7 @@ mf::WlSurface::WlSurface(
         executor{executor},
         null_role{this},
         role{&null_role},
+        presentation{executor, presentation_clock, [this](auto timestamp) { send_frame_callbacks(timestamp); }},
         destroyed{std::make_shared<bool>(false)}
 {
     // wl_surface is specified to act in mailbox mode
@@ -108,6 +125,9 @@ mf::WlSurface::~WlSurface()
     }
 
     role->destroy();
+    presentation.discard_unconsumed();
+    for (auto const& feedback : pending.presentation_feedbacks)
+        feedback->discarded();
     session->destroy_buffer_stream(stream);
 }
 
@@ -224,20 +244,25 @@ mf::WlSurface* mf::WlSurface::from(wl_resource* resource)
     return static_cast<WlSurface*>(static_cast<wayland::Surface*>(raw_surface));
 }
 
-void mf::WlSurface::send_frame_callbacks()
+void mf::WlSurface::send_frame_callbacks(std::chrono::nanoseconds timestamp)
 {
+    auto const timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(timestamp).count();
     for (auto const& frame : frame_callbacks)
     {
         if (!*frame->destroyed)
         {
-            // TODO: argument should be a timestamp
-            frame->send_done_event(0);
+            frame->send_done_event(timestamp_ms);
             frame->destroy_wayland_object();
         }
     }
     frame_callbacks.clear();
 }
 
+void mf::WlSurface::add_presentation_feedback(std::shared_ptr<PresentationFeedback> const& feedback)
+{
+    pending.presentation_feedbacks.push_back(feedback);
+}
+
 void mf::WlSurface::destroy()
 {
     *destroyed = true;
@@ -317,23 +342,30 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     {
         wl_resource * buffer = *state.buffer;
 
+        // Whatever was waiting to be consumed has been superseded
+        presentation.discard_unconsumed();
+
         if (buffer == nullptr)
         {
             // TODO: unmap surface, and unmap all subsurfaces
             buffer_size_ = std::experimental::nullopt;
-            send_frame_callbacks();
+            for (auto const& feedback : state.presentation_feedbacks)
+                feedback->discarded();
+            send_frame_callbacks(now());
         }
         else
         {
-            auto const executor_send_frame_callbacks = [this, executor = executor, destroyed = destroyed]()
+            auto const executor_send_frame_callbacks = presentation.buffer_committed(
+                [feedbacks = state.presentation_feedbacks](mg::PresentationClock::Presentation const& presented)
+                {
+                    for (auto const& feedback : feedbacks)
+                        feedback->presented(presented);
+                },
+                [feedbacks = state.presentation_feedbacks]()
                 {
-                    executor->spawn(run_unless(
-                        destroyed,
-                        [this]()
-                        {
-                            send_frame_callbacks();
-                        }));
-                };
+                    for (auto const& feedback : feedbacks)
+                        feedback->discarded();
+                });
 
             std::shared_ptr<graphics::Buffer> mir_buffer;
 
@@ -381,7 +413,10 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     }
     else
     {
-        send_frame_callbacks();
+        // Without new content there is nothing for the feedback to track
+        for (auto const& feedback : state.presentation_feedbacks)
+            feedback->discarded();
+        send_frame_callbacks(now());
     }
 
     for (WlSubsurface* child: children)
@@ -22,11 +22,14 @@
 #include "wayland_wrapper.h"
 
 #include "wl_surface_role.h"
+#include "surface_presentation.h"
 
 #include "mir/geometry/displacement.h"
 #include "mir/geometry/size.h"
 #include "mir/geometry/point.h"
 
+#include <atomic>
+#include <chrono>
 #include <vector>
 #include <map>
 
@@ -37,6 +40,7 @@ class Executor;
 namespace graphics
 {
 class WaylandAllocator;
+class PresentationClock;
 }
 namespace scene
 {
@@ -58,6 +62,7 @@ namespace frontend
 {
 class WlSurface;
 class WlSubsurface;
+class PresentationFeedback;
 
 struct WlSurfaceState
 {
@@ -83,6 +88,7 @@ struct WlSurfaceState
     std::experimental::optional<geometry::Displacement> offset;
     std::experimental::optional<std::experimental::optional<std::vector<geometry::Rectangle>>> input_shape;
     std::vector<std::shared_ptr<Callback>> frame_callbacks;
+    std::vector<std::shared_ptr<PresentationFeedback>> presentation_feedbacks;
 
 private:
     // only set to true if invalidate_surface_data() is called
@@ -118,7 +124,8 @@ public:
 
     WlSurface(wl_resource* new_resource,
               std::shared_ptr<mir::Executor> const& executor,
-              std::shared_ptr<mir::graphics::WaylandAllocator> const& allocator);
+              std::shared_ptr<mir::graphics::WaylandAllocator> const& allocator,
+              std::shared_ptr<mir::graphics::PresentationClock> const& presentation_clock);
 
     ~WlSurface();
 
@@ -141,6 +148,7 @@ public:
                                std::vector<mir::geometry::Rectangle>& input_shape_accumulator,
                                geometry::Displacement const& parent_offset) const;
     void commit(WlSurfaceState const& state);
+    void add_presentation_feedback(std::shared_ptr<PresentationFeedback> const& feedback);
     void add_destroy_listener(void const* key, std::function<void()> listener);
     void remove_destroy_listener(void const* key);
 
@@ -161,11 +169,12 @@ private:
     geometry::Displacement offset_;
     std::experimental::optional<geometry::Size> buffer_size_;
     std::vector<std::shared_ptr<WlSurfaceState::Callback>> frame_callbacks;
+    SurfacePresentation presentation;
     std::experimental::optional<std::vector<mir::geometry::Rectangle>> input_shape;
     std::map<void const*, std::function<void()>> destroy_listeners;
     std::shared_ptr<bool> const destroyed;
 
-    void send_frame_callbacks();
+    void send_frame_callbacks(std::chrono::nanoseconds timestamp);
 
     void destroy() override;
     void attach(std::experimental::optional<wl_resource*> const& buffer, int32_t x, int32_t y) override;
@@ -18,6 +18,7 @@
 
 #include "xdg_shell_stable.h"
 
+#include "configure_pacer.h"
 #include "wl_surface.h"
 #include "wayland_utils.h"
 
@@ -58,6 +59,8 @@ public:
 
     void send_configure();
 
+    ConfigurePacer& configure_pacer() { return pacer; }
+
     std::experimental::optional<WindowWlSurfaceRole*> const& window_role();
 
     using wayland::XdgSurface::client;
@@ -69,6 +72,7 @@ private:
     std::experimental::optional<WindowWlSurfaceRole*> window_role_;
     std::shared_ptr<bool> window_role_destroyed;
     WlSurface* const surface;
+    ConfigurePacer pacer;
 
 public:
     XdgShellStable const& xdg_shell;
@@ -97,7 +101,7 @@ public:
     void unset_fullscreen() override;
     void set_minimized() override;
 
-    void handle_commit() override {};
+    void handle_commit() override;
     void handle_state_change(MirWindowState /*new_state*/) override;
     void handle_active_change(bool /*is_now_active*/) override;
     void handle_resize(std::experimental::optional<geometry::Point> const& new_top_left,
@@ -248,14 +252,14 @@ void mf::XdgSurfaceStable::set_window_geometry(int32_t x, int32_t y, int32_t wid
 
 void mf::XdgSurfaceStable::ack_configure(uint32_t serial)
 {
-    (void)serial;
-    // TODO
+    pacer.configure_acked(serial);
 }
 
 void mf::XdgSurfaceStable::send_configure()
 {
     auto const serial = wl_display_next_serial(wl_client_get_display(wayland::XdgSurface::client));
     send_configure_event(serial);
+    pacer.configure_sent(serial);
 }
 
 std::experimental::optional<mf::WindowWlSurfaceRole*> const& mf::XdgSurfaceStable::window_role()
@@ -511,7 +515,14 @@ void mf::XdgToplevelStable::handle_active_change(bool /*is_now_active*/)
 void mf::XdgToplevelStable::handle_resize(std::experimental::optional<geometry::Point> const& /*new_top_left*/,
                                           geometry::Size const& /*new_size*/)
 {
-    send_toplevel_configure();
+    if (xdg_surface->configure_pacer().resize_requested())
+        send_toplevel_configure();
+}
+
+void mf::XdgToplevelStable::handle_commit()
+{
+    if (xdg_surface->configure_pacer().committed())
+        send_toplevel_configure();
 }
 
 void mf::XdgToplevelStable::handle_close_request()
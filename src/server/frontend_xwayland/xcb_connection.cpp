@@ -63,6 +63,7 @@ mf::XCBConnection::Atom::operator xcb_atom_t() const
             BOOST_THROW_EXCEPTION(std::runtime_error("Failed to look up atom " + name_));
         atom = reply->atom;
         free(reply);
+        connection->cache_atom_name(atom.value(), name_);
     }
     return atom.value();
 }
@@ -141,30 +142,40 @@ auto mf::XCBConnection::root_window() const -> xcb_window_t
 
 auto mf::XCBConnection::query_name(xcb_atom_t atom) const -> std::string
 {
-    // TODO: cache, for cheaper lookup
-
     if (atom == XCB_ATOM_NONE)
         return "None";
 
+    {
+        std::lock_guard<std::mutex> lock{atom_name_cache_mutex};
+        auto const cached = atom_name_cache.find(atom);
+        if (cached != atom_name_cache.end())
+            return cached->second;
+    }
+
     xcb_get_atom_name_cookie_t const cookie = xcb_get_atom_name(xcb_connection, atom);
     xcb_get_atom_name_reply_t* const reply = xcb_get_atom_name_reply(xcb_connection, cookie, nullptr);
 
-    std::string name;
-
-    if (reply)
+    if (!reply)
     {
-        name = std::string{xcb_get_atom_name_name(reply), static_cast<size_t>(xcb_get_atom_name_name_length(reply))};
-    }
-    else
-    {
-        name = "Atom " + std::to_string(atom);
+        // Not cached, the atom may simply not exist (yet)
+        return "Atom " + std::to_string(atom);
     }
 
+    std::string const name{
+        xcb_get_atom_name_name(reply),
+        static_cast<size_t>(xcb_get_atom_name_name_length(reply))};
     free(reply);
 
+    cache_atom_name(atom, name);
     return name;
 }
 
+void mf::XCBConnection::cache_atom_name(xcb_atom_t atom, std::string const& name) const
+{
+    std::lock_guard<std::mutex> lock{atom_name_cache_mutex};
+    atom_name_cache.emplace(atom, name);
+}
+
 auto mf::XCBConnection::reply_contains_string_data(xcb_get_property_reply_t const* reply) const -> bool
 {
     return reply->type == XCB_ATOM_STRING || reply->type == utf8_string;
@@ -27,6 +27,8 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <mutex>
+#include <unordered_map>
 #include <experimental/optional>
 
 namespace mir
@@ -88,7 +90,8 @@ public:
     auto root_window() const -> xcb_window_t;
 
 
-    /// Does a round-trip to the X server and does not cache. Should be improved if needed on normal code paths
+    /// Atom names never change for the lifetime of the X server, so they are cached. Only the first lookup of an atom
+    /// not already known to us does a round-trip to the X server
     auto query_name(xcb_atom_t atom) const -> std::string;
     auto reply_contains_string_data(xcb_get_property_reply_t const* reply) const -> bool;
     auto string_from(xcb_get_property_reply_t const* reply) const -> std::string;
@@ -238,6 +241,11 @@ private:
 
     auto xcb_type_atom(XCBType type) const -> xcb_atom_t;
 
+    void cache_atom_name(xcb_atom_t atom, std::string const& name) const;
+
+    std::mutex mutable atom_name_cache_mutex;
+    std::unordered_map<xcb_atom_t, std::string> mutable atom_name_cache;
+
     template<XCBType type>
     static inline constexpr uint8_t xcb_type_format()
     {
@@ -432,30 +432,43 @@ void mf::XWaylandSurface::wm_change_state_client_message(uint32_t const (&data)[
     request_scene_surface_state(new_window_state.mir_window_state());
 }
 
-void mf::XWaylandSurface::property_notify(xcb_atom_t property)
+auto mf::XWaylandSurface::property_notify(xcb_atom_t property) -> std::function<void()>
 {
     auto const handler = property_handlers.find(property);
-    if (handler != property_handlers.end())
+    if (handler == property_handlers.end())
     {
-        std::shared_ptr<scene::Surface> scene_surface;
-        std::experimental::optional<std::unique_ptr<shell::SurfaceSpecification>> spec;
+        return [](){};
+    }
 
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (!weak_scene_surface.lock())
         {
-            std::lock_guard<std::mutex> lock{mutex};
-            scene_surface = weak_scene_surface.lock();
-            spec = consume_pending_spec(lock);
+            // The property will be read when the scene surface is created
+            return [](){};
         }
+    }
 
-        if (scene_surface)
+    auto const completion = handler->second();
+
+    return [this, completion]()
         {
-            auto completion = handler->second();
             completion();
-            if (spec)
+
+            std::shared_ptr<scene::Surface> scene_surface;
+            std::experimental::optional<std::unique_ptr<shell::SurfaceSpecification>> spec;
+
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                scene_surface = weak_scene_surface.lock();
+                spec = consume_pending_spec(lock);
+            }
+
+            if (scene_surface && spec)
             {
                 shell->modify_surface(scene_surface->session().lock(), scene_surface, *spec.value());
             }
-        }
-    }
+        };
 }
 
 void mf::XWaylandSurface::attach_wl_surface(WlSurface* wl_surface)
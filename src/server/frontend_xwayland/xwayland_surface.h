@@ -149,7 +149,11 @@ public:
     void configure_notify(xcb_configure_notify_event_t* event);
     void net_wm_state_client_message(uint32_t const (&data)[5]);
     void wm_change_state_client_message(uint32_t const (&data)[5]);
-    void property_notify(xcb_atom_t property);
+
+    /// Requests the new value of the property, without waiting for it
+    /// Returns a function that will wait on the reply and apply it. Replies for several properties can be awaited
+    /// together, so that a burst of PropertyNotify events costs a single round-trip to the X server
+    auto property_notify(xcb_atom_t property) -> std::function<void()>;
     void attach_wl_surface(WlSurface* wl_surface); ///< Should only be called on the Wayland thread
     void move_resize(uint32_t detail);
 
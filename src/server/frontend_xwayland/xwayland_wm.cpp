@@ -290,10 +290,56 @@ void mf::XWaylandWM::handle_events()
     bool got_events = false;
 
     while (xcb_generic_event_t* const event = xcb_poll_for_event(*connection))
+    {
+        process_event(event);
+        got_events = true;
+    }
+
+    while (!deferred_replies.empty())
+    {
+        wait_for_deferred_replies();
+
+        // Events that arrived while we were waiting have already been read off the socket, so won't wake us up again
+        while (xcb_generic_event_t* const event = xcb_poll_for_queued_event(*connection))
+        {
+            process_event(event);
+            got_events = true;
+        }
+    }
+
+    if (got_events)
+    {
+        connection->flush();
+    }
+}
+
+void mf::XWaylandWM::process_event(xcb_generic_event_t* event)
+{
+    try
+    {
+        handle_event(event);
+    }
+    catch (...)
+    {
+        log(
+            logging::Severity::warning,
+            MIR_LOG_COMPONENT,
+            std::current_exception(),
+            "Failed to handle xcb event.");
+    }
+    free(event);
+}
+
+void mf::XWaylandWM::wait_for_deferred_replies()
+{
+    std::vector<std::function<void()>> replies;
+    swap(replies, deferred_replies);
+
+    for (auto const& reply : replies)
     {
         try
         {
-            handle_event(event);
+            reply();
         }
         catch (...)
         {
@@ -301,15 +347,8 @@ void mf::XWaylandWM::handle_events()
                 logging::Severity::warning,
                 MIR_LOG_COMPONENT,
                 std::current_exception(),
-                "Failed to handle xcb event.");
+                "Failed to handle xcb reply.");
         }
-        free(event);
-        got_events = true;
-    }
-
-    if (got_events)
-    {
-        connection->flush();
     }
 }
 
@@ -398,17 +437,18 @@ void mf::XWaylandWM::handle_property_notify(xcb_property_notify_event_t *event)
         }
         else
         {
-            auto const log_prop = [this, event](std::string const& value)
+            // The event is freed before the reply is processed
+            auto const log_prop = [this, window = event->window, atom = event->atom](std::string const& value)
                 {
-                    auto const prop_name = connection->query_name(event->atom);
+                    auto const prop_name = connection->query_name(atom);
                     log_debug(
                         "XCB_PROPERTY_NOTIFY (%s).%s: %s",
-                        connection->window_debug_string(event->window).c_str(),
+                        connection->window_debug_string(window).c_str(),
                         prop_name.c_str(),
                         value.c_str());
                 };
 
-            auto const reply_function = connection->read_property(
+            deferred_replies.push_back(connection->read_property(
                 event->window,
                 event->atom,
                 [this, log_prop](xcb_get_property_reply_t* reply)
@@ -419,15 +459,16 @@ void mf::XWaylandWM::handle_property_notify(xcb_property_notify_event_t *event)
                 [log_prop]()
                 {
                     log_prop("Error getting value");
-                });
-
-            reply_function();
+                }));
         }
     }
 
     if (auto const surface = get_wm_surface(event->window))
     {
-        surface.value()->property_notify(event->atom);
+        auto const reply = surface.value()->property_notify(event->atom);
+
+        // Keep the surface alive until its reply is processed, even if the window is destroyed in the meantime
+        deferred_replies.push_back([surface = surface.value(), reply]() { reply(); });
     }
 }
 
@@ -96,6 +96,8 @@ private:
     // Event handeling
     void handle_events();
     void handle_event(xcb_generic_event_t* event);
+    void process_event(xcb_generic_event_t* event);
+    void wait_for_deferred_replies();
 
     // Events
     void handle_create_notify(xcb_create_notify_event_t *event);
@@ -112,6 +114,11 @@ private:
 
     std::mutex mutex;
 
+    /// Waits on and processes the replies to requests made while handling events
+    /// Only accessed from the event thread. Replies are waited for once all the pending events have been handled, so
+    /// that the requests for a whole batch of events are in flight together
+    std::vector<std::function<void()>> deferred_replies;
+
     // Cursor
     xcb_cursor_t xcb_cursor_image_load_cursor(const XcursorImage *img);
     xcb_cursor_t xcb_cursor_images_load_cursor(const XcursorImages *images);
@@ -25,8 +25,10 @@
 #include "mir/renderer/gl/egl_platform.h"
 #include "null_cursor.h"
 #include "offscreen/display.h"
+#include "offscreen/software_display.h"
 #include "software_cursor.h"
 #include "platform_probe.h"
+#include "mir/graphics/vsync_presentation_clock.h"
 
 #include "mir/graphics/gl_config.h"
 #include "mir/graphics/platform.h"
@@ -153,7 +155,7 @@ std::shared_ptr<mg::Platform> mir::DefaultServerConfiguration::the_graphics_plat
                     the_options(),
                     the_emergency_cleanup(),
                     the_console_services(),
-                    the_display_report(),
+                    the_presentation_clock(),
                     the_logger());
             }
             catch(...)
@@ -182,6 +184,26 @@ mir::DefaultServerConfiguration::the_display()
     return display(
         [this]() -> std::shared_ptr<mg::Display>
         {
+            auto const software_rendering =
+                the_options()->get<std::string>(options::renderer_opt) == options::software_renderer_opt_value;
+
+            if (software_rendering)
+            {
+                if (!the_options()->is_set(options::offscreen_opt))
+                {
+                    BOOST_THROW_EXCEPTION(std::runtime_error(
+                        "The software renderer is only supported with --offscreen"));
+                }
+
+                auto const frame_export_socket = the_options()->is_set(options::offscreen_frame_export_opt) ?
+                    the_options()->get<std::string>(options::offscreen_frame_export_opt) : std::string{};
+
+                return std::make_shared<mg::offscreen::SoftwareDisplay>(
+                    the_display_configuration_policy(),
+                    the_presentation_clock(),
+                    frame_export_socket);
+            }
+
             if (the_options()->is_set(options::offscreen_opt))
             {
                 if (auto egl_access = dynamic_cast<mir::renderer::gl::EGLPlatform*>(
@@ -190,7 +212,7 @@ mir::DefaultServerConfiguration::the_display()
                     return std::make_shared<mg::offscreen::Display>(
                         egl_access->egl_native_display(),
                         the_display_configuration_policy(),
-                        the_display_report());
+                        the_presentation_clock());
                 }
                 else
                 {
@@ -206,6 +228,16 @@ mir::DefaultServerConfiguration::the_display()
         });
 }
 
+std::shared_ptr<mg::VsyncPresentationClock>
+mir::DefaultServerConfiguration::the_presentation_clock()
+{
+    return presentation_clock(
+        [this]
+        {
+            return std::make_shared<mg::VsyncPresentationClock>(the_display_report(), the_alarm_factory());
+        });
+}
+
 std::shared_ptr<mg::Cursor>
 mir::DefaultServerConfiguration::the_cursor()
 {
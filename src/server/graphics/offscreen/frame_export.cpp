@@ -0,0 +1,231 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame_export.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <string>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <linux/memfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace mg = mir::graphics;
+namespace mgo = mg::offscreen;
+namespace geom = mir::geometry;
+namespace fe = mgo::frame_export;
+
+namespace
+{
+size_t round_up_to_page(size_t size)
+{
+    size_t const page_size = sysconf(_SC_PAGESIZE);
+    return (size + page_size - 1) / page_size * page_size;
+}
+
+mir::Fd create_sealed_memfd(size_t size)
+{
+    mir::Fd fd{static_cast<int>(syscall(SYS_memfd_create, "mir-frame-export", MFD_CLOEXEC | MFD_ALLOW_SEALING))};
+    if (fd < 0)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to create memfd for frame export"));
+    }
+
+    if (ftruncate(fd, size) == -1)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to resize memfd for frame export"));
+    }
+
+    // Consumers can rely on the size never changing under their mapping
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == -1)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to seal memfd for frame export"));
+    }
+
+    return fd;
+}
+
+void* map(mir::Fd const& fd, size_t size)
+{
+    auto const mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to map memfd for frame export"));
+    }
+    return mapping;
+}
+
+geom::Rectangle bounding_rectangle(std::vector<geom::Rectangle> const& rectangles)
+{
+    auto left = rectangles.front().left();
+    auto top = rectangles.front().top();
+    auto right = rectangles.front().right();
+    auto bottom = rectangles.front().bottom();
+
+    for (auto const& rect : rectangles)
+    {
+        left = std::min(left, rect.left());
+        top = std::min(top, rect.top());
+        right = std::max(right, rect.right());
+        bottom = std::max(bottom, rect.bottom());
+    }
+
+    return {{left, top}, {(right - left).as_int(), (bottom - top).as_int()}};
+}
+
+unsigned checked(unsigned slot_count)
+{
+    if (slot_count < 2 || slot_count > fe::max_slots)
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument(
+            "Frame export needs between 2 and " + std::to_string(fe::max_slots) + " slots"));
+    }
+    return slot_count;
+}
+
+size_t slot_size_for(geom::Size size, geom::Stride stride)
+{
+    return round_up_to_page(stride.as_int() * size.height.as_int());
+}
+
+int64_t monotonic_now_ns()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+}
+
+mgo::FrameExport::FrameExport(
+    DisplayConfigurationOutputId output_id,
+    geom::Rectangle const& area,
+    unsigned slot_count)
+    : size{area.size},
+      stride{size.width.as_int() * sizeof(uint32_t)},
+      mapping_size{round_up_to_page(sizeof(fe::Header)) + checked(slot_count) * slot_size_for(size, stride)},
+      fd{create_sealed_memfd(mapping_size)},
+      mapping{map(fd, mapping_size)},
+      header{new (mapping) fe::Header()},
+      stale(slot_count, {{{0, 0}, size}})
+{
+    header->magic = fe::magic;
+    header->version = fe::version;
+    header->output_id = output_id.as_value();
+    header->x = area.top_left.x.as_int();
+    header->y = area.top_left.y.as_int();
+    header->width = size.width.as_int();
+    header->height = size.height.as_int();
+    header->stride = stride.as_int();
+    header->format = mir_pixel_format_xrgb_8888;
+    header->slot_count = slot_count;
+    header->slot_offset = round_up_to_page(sizeof(fe::Header));
+    header->slot_size = slot_size_for(size, stride);
+}
+
+mgo::FrameExport::~FrameExport() noexcept
+{
+    header->closed.store(1, std::memory_order_release);
+    munmap(mapping, mapping_size);
+}
+
+void mgo::FrameExport::publish(
+    unsigned char const* pixels,
+    geom::Stride pixels_stride,
+    std::vector<geom::Rectangle> const& damage)
+{
+    if (damage.empty())
+        return;
+
+    ++frame;
+
+    for (auto& regions : stale)
+    {
+        regions.insert(regions.end(), damage.begin(), damage.end());
+        if (regions.size() > fe::max_damage)
+            regions = {bounding_rectangle(regions)};
+    }
+
+    auto const index = frame % header->slot_count;
+    auto& slot = header->slots[index];
+    auto const slot_pixels =
+        static_cast<unsigned char*>(mapping) + header->slot_offset + index * header->slot_size;
+
+    slot.sequence.store(2 * frame - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    geom::Rectangle const bounds{{0, 0}, size};
+    for (auto const& region : stale[index])
+    {
+        auto const area = region.intersection_with(bounds);
+        auto const row_offset = area.left().as_int() * sizeof(uint32_t);
+        auto const row_bytes = area.size.width.as_int() * sizeof(uint32_t);
+
+        for (auto y = area.top().as_int(); y < area.bottom().as_int(); ++y)
+        {
+            std::memcpy(
+                slot_pixels + y * stride.as_int() + row_offset,
+                pixels + y * pixels_stride.as_int() + row_offset,
+                row_bytes);
+        }
+    }
+    stale[index].clear();
+
+    auto const published =
+        damage.size() > fe::max_damage ? std::vector<geom::Rectangle>{bounding_rectangle(damage)} : damage;
+
+    slot.frame = frame;
+    slot.timestamp_ns = monotonic_now_ns();
+    slot.damage_count = published.size();
+    for (size_t i = 0; i != published.size(); ++i)
+    {
+        slot.damage[i] = fe::Rectangle{
+            published[i].left().as_int(),
+            published[i].top().as_int(),
+            published[i].size.width.as_int(),
+            published[i].size.height.as_int()};
+    }
+
+    slot.sequence.store(2 * frame, std::memory_order_release);
+    header->latest_frame.store(frame, std::memory_order_release);
+}
+
+mir::Fd mgo::FrameExport::consumer_fd() const
+{
+    // Reopening through /proc gives an independent, read-only description of the same file
+    auto const path = "/proc/self/fd/" + std::to_string(static_cast<int>(fd));
+    mir::Fd read_only{open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+
+    if (read_only < 0)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to open read-only frame export"));
+    }
+
+    return read_only;
+}
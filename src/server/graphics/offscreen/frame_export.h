@@ -0,0 +1,152 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_OFFSCREEN_FRAME_EXPORT_H_
+#define MIR_GRAPHICS_OFFSCREEN_FRAME_EXPORT_H_
+
+#include "mir/graphics/display_configuration.h"
+#include "mir/geometry/rectangle.h"
+#include "mir/geometry/dimensions.h"
+#include "mir/fd.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace offscreen
+{
+/**
+ * Shared memory layout of an exported output.
+ *
+ * The memfd starts with a Header. slot_count frames of pixels follow, the
+ * first at slot_offset bytes and each slot_size bytes after the previous.
+ * All fields are in native byte order and the file is sealed against
+ * resizing, so it can be mapped in full for as long as it is open.
+ *
+ * To read the latest frame a consumer:
+ *  1. loads latest_frame (acquire); 0 means nothing has been published yet
+ *  2. loads the sequence of slot latest_frame % slot_count (acquire); if it
+ *     is not 2 * latest_frame that slot is being rewritten, so start again
+ *  3. reads the pixels it needs
+ *  4. issues an acquire fence and reloads sequence; if it changed the pixels
+ *     may be torn and must be read again
+ *
+ * Each slot records the regions that changed since the previous frame. A
+ * consumer that has fallen more than slot_count - 1 frames behind should
+ * treat the whole output as damaged.
+ */
+namespace frame_export
+{
+uint32_t const magic{0x4652494d};  // "MIRF"
+uint32_t const version{1};
+unsigned const max_slots{4};
+unsigned const max_damage{16};
+
+struct Rectangle
+{
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+};
+
+struct Slot
+{
+    std::atomic<uint64_t> sequence;     ///< 2 * frame once written, odd while being written
+    uint64_t frame;
+    int64_t timestamp_ns;               ///< CLOCK_MONOTONIC
+    uint32_t damage_count;
+    uint32_t reserved;
+    Rectangle damage[max_damage];
+};
+
+struct Header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t output_id;
+    int32_t x;                          ///< Position of the output in the layout
+    int32_t y;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    uint32_t format;                    ///< A MirPixelFormat
+    uint32_t slot_count;
+    uint64_t slot_offset;
+    uint64_t slot_size;
+    std::atomic<uint64_t> latest_frame;
+    std::atomic<uint32_t> closed;       ///< The output is gone; no more frames will follow
+    uint32_t reserved;
+    Slot slots[max_slots];
+};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Shared memory needs address-free atomics");
+}
+
+/**
+ * Publishes the frames of an output to other processes as a ring of slots
+ * in a sealed memfd (see frame_export::Header)
+ */
+class FrameExport
+{
+public:
+    FrameExport(
+        DisplayConfigurationOutputId output_id,
+        geometry::Rectangle const& area,
+        unsigned slot_count = 3);
+    ~FrameExport() noexcept;
+
+    /**
+     * Publishes a new frame.
+     * Only the regions that changed since the slot was last written are
+     * copied from pixels.
+     * \param [in] pixels  The complete XRGB frame
+     * \param [in] stride  The stride of pixels
+     * \param [in] damage  The regions that changed since the previous frame
+     */
+    void publish(
+        unsigned char const* pixels,
+        geometry::Stride stride,
+        std::vector<geometry::Rectangle> const& damage);
+
+    /// A new read-only file descriptor for the shared memory
+    Fd consumer_fd() const;
+
+private:
+    FrameExport(FrameExport const&) = delete;
+    FrameExport& operator=(FrameExport const&) = delete;
+
+    geometry::Size const size;
+    geometry::Stride const stride;
+    size_t const mapping_size;
+    Fd const fd;
+    void* const mapping;
+    frame_export::Header* const header;
+
+    uint64_t frame{0};
+    /// For each slot, the regions that have changed since it was last written
+    std::vector<std::vector<geometry::Rectangle>> stale;
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_OFFSCREEN_FRAME_EXPORT_H_ */
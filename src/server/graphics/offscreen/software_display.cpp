@@ -0,0 +1,198 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "offscreen"
+
+#include "software_display.h"
+#include "software_display_buffer.h"
+#include "frame_export.h"
+#include "display.h"
+#include "mir/graphics/display_configuration_policy.h"
+#include "mir/graphics/event_handler_register.h"
+#include "mir/graphics/virtual_output.h"
+#include "mir/geometry/size.h"
+#include "mir/fd_socket_transmission.h"
+#include "mir/local_socket.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace mg = mir::graphics;
+namespace mgo = mg::offscreen;
+namespace geom = mir::geometry;
+
+namespace
+{
+mir::Fd listen_on(std::string const& path)
+{
+    if (path.empty())
+        return {};
+
+    return mir::listen_on_local_socket(path, "frame export");
+}
+}
+
+mgo::SoftwareDisplay::SoftwareDisplay(
+    std::shared_ptr<DisplayConfigurationPolicy> const& initial_conf_policy,
+    std::shared_ptr<DisplayReport> const&,
+    std::string const& frame_export_socket)
+    : frame_export_socket_path{frame_export_socket},
+      frame_export_socket{listen_on(frame_export_socket)},
+      current_display_configuration{geom::Size{1024,768}}
+{
+    initial_conf_policy->apply_to(current_display_configuration);
+
+    configure(current_display_configuration);
+}
+
+mgo::SoftwareDisplay::~SoftwareDisplay() noexcept
+{
+    if (frame_export_socket >= 0)
+        unlink(frame_export_socket_path.c_str());
+}
+
+void mgo::SoftwareDisplay::for_each_display_sync_group(
+    std::function<void(mg::DisplaySyncGroup&)> const& f)
+{
+    std::lock_guard<std::mutex> lock{configuration_mutex};
+
+    for (auto& dg_ptr : display_sync_groups)
+        f(*dg_ptr);
+}
+
+std::unique_ptr<mg::DisplayConfiguration> mgo::SoftwareDisplay::configuration() const
+{
+    std::lock_guard<std::mutex> lock{configuration_mutex};
+    return std::make_unique<mgo::DisplayConfiguration>(
+        current_display_configuration);
+}
+
+void mgo::SoftwareDisplay::configure(mg::DisplayConfiguration const& conf)
+{
+    if (!conf.valid())
+    {
+        BOOST_THROW_EXCEPTION(
+            std::logic_error("Invalid or inconsistent display configuration"));
+    }
+
+    std::lock_guard<std::mutex> lock{configuration_mutex};
+
+    display_buffers.clear();
+    display_sync_groups.clear();
+
+    conf.for_each_output(
+        [this] (DisplayConfigurationOutput const& output)
+        {
+            if (output.connected && output.preferred_mode_index < output.modes.size())
+            {
+                std::unique_ptr<FrameExport> frame_export;
+                if (frame_export_socket >= 0)
+                    frame_export = std::make_unique<FrameExport>(output.id, output.extents());
+
+                auto raw_db = new mgo::SoftwareDisplayBuffer{output.extents(), std::move(frame_export)};
+                display_buffers.push_back(raw_db);
+
+                display_sync_groups.emplace_back(
+                    new mgo::detail::DisplaySyncGroup(std::unique_ptr<mg::DisplayBuffer>(raw_db)));
+            }
+        });
+}
+
+void mgo::SoftwareDisplay::register_configuration_change_handler(
+    EventHandlerRegister& handlers,
+    DisplayConfigurationChangeHandler const&)
+{
+    if (frame_export_socket >= 0)
+    {
+        handlers.register_fd_handler(
+            {frame_export_socket},
+            this,
+            [this](int) { send_frame_exports(); });
+    }
+}
+
+void mgo::SoftwareDisplay::send_frame_exports()
+{
+    mir::Fd const client{accept4(frame_export_socket, nullptr, nullptr, SOCK_CLOEXEC)};
+    if (client < 0)
+        return;
+
+    try
+    {
+        std::vector<mir::Fd> exports;
+        {
+            std::lock_guard<std::mutex> lock{configuration_mutex};
+            for (auto const db : display_buffers)
+                exports.push_back(db->frame_export()->consumer_fd());
+        }
+
+        uint32_t const count = exports.size();
+        // The consumer may already have gone, and a SIGPIPE would take the server down with it
+        if (send(client, &count, sizeof(count), MSG_NOSIGNAL) != sizeof(count))
+            BOOST_THROW_EXCEPTION(std::system_error(errno, std::system_category(), "Failed to send output count"));
+
+        mir::send_fds(client, exports);
+    }
+    catch (std::exception const& error)
+    {
+        mir::log_warning("Failed to send frame exports: %s", error.what());
+    }
+}
+
+void mgo::SoftwareDisplay::register_pause_resume_handlers(
+    EventHandlerRegister&,
+    DisplayPauseHandler const&,
+    DisplayResumeHandler const&)
+{
+}
+
+void mgo::SoftwareDisplay::pause()
+{
+}
+
+void mgo::SoftwareDisplay::resume()
+{
+}
+
+std::shared_ptr<mg::Cursor> mgo::SoftwareDisplay::create_hardware_cursor()
+{
+    return {};
+}
+
+mg::NativeDisplay* mgo::SoftwareDisplay::native_display()
+{
+    return this;
+}
+
+mg::Frame mgo::SoftwareDisplay::last_frame_on(unsigned) const
+{
+    return {};
+}
+
+std::unique_ptr<mg::VirtualOutput> mgo::SoftwareDisplay::create_virtual_output(int /*width*/, int /*height*/)
+{
+    return nullptr;
+}
+
+bool mgo::SoftwareDisplay::apply_if_configuration_preserves_display_buffers(mg::DisplayConfiguration const&)
+{
+    return false;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_OFFSCREEN_SOFTWARE_DISPLAY_H_
+#define MIR_GRAPHICS_OFFSCREEN_SOFTWARE_DISPLAY_H_
+
+#include "mir/graphics/display.h"
+#include "display_configuration.h"
+#include "mir/fd.h"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+
+class DisplayConfigurationPolicy;
+class DisplayReport;
+
+namespace offscreen
+{
+class SoftwareDisplayBuffer;
+
+/**
+ * An offscreen display that needs no GL or EGL: outputs are plain memory
+ * for the software renderer to draw into.
+ *
+ * Given a frame_export_socket path, each output's frames are exported
+ * through a FrameExport. A process connecting to the socket receives a
+ * uint32_t count followed by that many read-only FrameExport descriptors
+ * (see mir::send_fds()), one per output in the current configuration.
+ */
+class SoftwareDisplay : public graphics::Display,
+                        public graphics::NativeDisplay
+{
+public:
+    SoftwareDisplay(std::shared_ptr<DisplayConfigurationPolicy> const& initial_conf_policy,
+                    std::shared_ptr<DisplayReport> const& listener,
+                    std::string const& frame_export_socket = {});
+    ~SoftwareDisplay() noexcept;
+
+    void for_each_display_sync_group(std::function<void(DisplaySyncGroup&)> const& f) override;
+
+    std::unique_ptr<graphics::DisplayConfiguration> configuration() const override;
+    void configure(graphics::DisplayConfiguration const& conf) override;
+
+    void register_configuration_change_handler(
+        EventHandlerRegister& handlers,
+        DisplayConfigurationChangeHandler const& conf_change_handler) override;
+
+    void register_pause_resume_handlers(
+        EventHandlerRegister& handlers,
+        DisplayPauseHandler const& pause_handler,
+        DisplayResumeHandler const& resume_handler) override;
+
+    void pause() override;
+    void resume() override;
+
+    std::shared_ptr<Cursor> create_hardware_cursor() override;
+    std::unique_ptr<VirtualOutput> create_virtual_output(int width, int height) override;
+
+    NativeDisplay* native_display() override;
+    Frame last_frame_on(unsigned output_id) const override;
+
+    bool apply_if_configuration_preserves_display_buffers(graphics::DisplayConfiguration const& conf) override;
+private:
+    void send_frame_exports();
+
+    std::string const frame_export_socket_path;
+    Fd const frame_export_socket;
+    mutable std::mutex configuration_mutex;
+    DisplayConfiguration current_display_configuration;
+    std::vector<std::unique_ptr<DisplaySyncGroup>> display_sync_groups;
+    std::vector<SoftwareDisplayBuffer*> display_buffers;
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_OFFSCREEN_SOFTWARE_DISPLAY_H_ */
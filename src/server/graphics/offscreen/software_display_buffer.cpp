@@ -0,0 +1,90 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "software_display_buffer.h"
+#include "frame_export.h"
+
+#include <cstdint>
+
+namespace mg = mir::graphics;
+namespace mgo = mg::offscreen;
+namespace geom = mir::geometry;
+
+namespace
+{
+geom::Stride stride_for(geom::Size const& size)
+{
+    return geom::Stride{size.width.as_int() * sizeof(uint32_t)};
+}
+}
+
+mgo::SoftwareDisplayBuffer::SoftwareDisplayBuffer(
+    geom::Rectangle const& area,
+    std::unique_ptr<FrameExport> frame_export)
+    : area{area},
+      stride_{stride_for(area.size)},
+      framebuffer{static_cast<size_t>(stride_.as_int()) * area.size.height.as_int()},
+      frame_export_{std::move(frame_export)}
+{
+}
+
+mgo::SoftwareDisplayBuffer::~SoftwareDisplayBuffer() = default;
+
+geom::Rectangle mgo::SoftwareDisplayBuffer::view_area() const
+{
+    return area;
+}
+
+bool mgo::SoftwareDisplayBuffer::overlay(RenderableList const&)
+{
+    return false;
+}
+
+glm::mat2 mgo::SoftwareDisplayBuffer::transformation() const
+{
+    return glm::mat2{1};
+}
+
+mg::NativeDisplayBuffer* mgo::SoftwareDisplayBuffer::native_display_buffer()
+{
+    return this;
+}
+
+geom::Size mgo::SoftwareDisplayBuffer::size() const
+{
+    return area.size;
+}
+
+geom::Stride mgo::SoftwareDisplayBuffer::stride() const
+{
+    return stride_;
+}
+
+unsigned char* mgo::SoftwareDisplayBuffer::pixels()
+{
+    return static_cast<unsigned char*>(framebuffer.base_ptr());
+}
+
+void mgo::SoftwareDisplayBuffer::commit(std::vector<geom::Rectangle> const& damage)
+{
+    if (frame_export_)
+        frame_export_->publish(pixels(), stride_, damage);
+}
+
+mgo::FrameExport* mgo::SoftwareDisplayBuffer::frame_export() const
+{
+    return frame_export_.get();
+}
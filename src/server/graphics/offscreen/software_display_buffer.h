@@ -0,0 +1,73 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_OFFSCREEN_SOFTWARE_DISPLAY_BUFFER_H_
+#define MIR_GRAPHICS_OFFSCREEN_SOFTWARE_DISPLAY_BUFFER_H_
+
+#include "mir/graphics/display_buffer.h"
+#include "mir/geometry/rectangle.h"
+#include "mir/renderer/sw/render_target.h"
+#include "mir/anonymous_shm_file.h"
+
+#include <memory>
+
+namespace mir
+{
+namespace graphics
+{
+namespace offscreen
+{
+class FrameExport;
+
+/**
+ * An offscreen output backed by a memfd in system memory, for use with
+ * the software renderer on hosts without a GPU.
+ *
+ * If given a FrameExport, every committed frame is published through it.
+ */
+class SoftwareDisplayBuffer : public graphics::DisplayBuffer,
+                              public graphics::NativeDisplayBuffer,
+                              public renderer::software::RenderTarget
+{
+public:
+    SoftwareDisplayBuffer(geometry::Rectangle const& area, std::unique_ptr<FrameExport> frame_export);
+    ~SoftwareDisplayBuffer();
+
+    geometry::Rectangle view_area() const override;
+    bool overlay(RenderableList const& renderlist) override;
+    glm::mat2 transformation() const override;
+    NativeDisplayBuffer* native_display_buffer() override;
+
+    geometry::Size size() const override;
+    geometry::Stride stride() const override;
+    unsigned char* pixels() override;
+    void commit(std::vector<geometry::Rectangle> const& damage) override;
+
+    /// The export of this output, or null if it is not exported
+    FrameExport* frame_export() const;
+
+private:
+    geometry::Rectangle const area;
+    geometry::Stride const stride_;
+    AnonymousShmFile const framebuffer;
+    std::unique_ptr<FrameExport> const frame_export_;
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_OFFSCREEN_SOFTWARE_DISPLAY_BUFFER_H_ */
@@ -36,7 +36,6 @@ namespace mrs = mir::renderer::software;
 
 namespace
 {
-
 MirPixelFormat get_8888_format(std::vector<MirPixelFormat> const& formats)
 {
     for (auto format : formats)
@@ -190,19 +189,24 @@ mg::SoftwareCursor::create_renderable_for(CursorImage const& cursor_image, geom:
     if (pixels_size == 0)
         BOOST_THROW_EXCEPTION(std::logic_error("zero sized software cursor image is invalid"));
 
-    auto new_renderable = std::make_shared<detail::CursorRenderable>(
-        allocator->alloc_software_buffer(cursor_image.size(), format),
+    auto const& buffer = buffers.get(cursor_image, [&]
+        {
+            auto const buffer = allocator->alloc_software_buffer(cursor_image.size(), format);
+
+            // TODO: The buffer pixel format may not be argb_8888, leading to
+            // incorrect cursor colors. We need to transform the data to match
+            // the buffer pixel format.
+            auto pixel_source = dynamic_cast<mrs::PixelSource*>(buffer->native_buffer_base());
+            if (pixel_source)
+                pixel_source->write(static_cast<unsigned char const*>(cursor_image.as_argb_8888()), pixels_size);
+            else
+                BOOST_THROW_EXCEPTION(std::logic_error("could not write to buffer for software cursor"));
+            return buffer;
+        });
+
+    return std::make_shared<detail::CursorRenderable>(
+        buffer,
         position + hotspot - cursor_image.hotspot());
-
-    // TODO: The buffer pixel format may not be argb_8888, leading to
-    // incorrect cursor colors. We need to transform the data to match
-    // the buffer pixel format.
-    auto pixel_source = dynamic_cast<mrs::PixelSource*>(new_renderable->buffer()->native_buffer_base());
-    if (pixel_source)
-        pixel_source->write(static_cast<unsigned char const*>(cursor_image.as_argb_8888()), pixels_size);
-    else
-        BOOST_THROW_EXCEPTION(std::logic_error("could not write to buffer for software cursor"));
-    return new_renderable;
 }
 
 void mg::SoftwareCursor::hide()
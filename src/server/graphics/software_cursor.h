@@ -20,6 +20,7 @@
 #define MIR_GRAPHICS_SOFTWARE_CURSOR_H_
 
 #include "mir/graphics/cursor.h"
+#include "mir/graphics/cursor_image_cache.h"
 #include "mir_toolkit/client_types.h"
 #include "mir/geometry/displacement.h"
 #include <mutex>
@@ -29,6 +30,7 @@ namespace mir
 namespace input { class Scene; }
 namespace graphics
 {
+class Buffer;
 class GraphicBufferAllocator;
 class Renderable;
 
@@ -61,6 +63,9 @@ private:
     std::shared_ptr<detail::CursorRenderable> renderable;
     bool visible;
     geometry::Displacement hotspot;
+
+    /// Buffers are never written once shown, so a recent image's buffer (and any texture made from it) can be reused
+    CursorImageCache<std::shared_ptr<Buffer>> buffers;
 };
 
 }
@@ -0,0 +1,229 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/vsync_presentation_clock.h"
+#include "mir/time/alarm.h"
+#include "mir/time/alarm_factory.h"
+
+#include <atomic>
+#include <limits>
+
+namespace mg = mir::graphics;
+namespace mt = mir::time;
+
+namespace
+{
+auto in_monotonic_time(mg::Frame frame) -> mg::Frame
+{
+    if (frame.ust.clock_id != CLOCK_MONOTONIC)
+    {
+        auto const age = mt::PosixTimestamp::now(frame.ust.clock_id) - frame.ust;
+        frame.ust = mt::PosixTimestamp::now(CLOCK_MONOTONIC) - age;
+    }
+    return frame;
+}
+
+auto presentation_now() -> mg::PresentationClock::Presentation
+{
+    return {mg::Frame{0, mt::PosixTimestamp::now(CLOCK_MONOTONIC)}, std::chrono::nanoseconds::zero(), false};
+}
+
+/// Where handlers wait when the thread registering them has not reported a flip
+unsigned int const any_output{std::numeric_limits<unsigned int>::max()};
+
+std::atomic<uint64_t> next_clock_id{1};
+
+/*
+ * The clock this thread reports flips to, and the first output it reported:
+ * handlers registered from the thread wait under that output for a flip of
+ * any output the thread composites. Being thread local it goes with the
+ * thread; compositor threads are replaced on every display reconfiguration,
+ * and a new thread (even one reusing an old thread's id) has yet to report.
+ */
+struct CompositingThread
+{
+    uint64_t clock_id;
+    unsigned int output_id;
+};
+thread_local CompositingThread this_thread{0, any_output};
+}
+
+mg::VsyncPresentationClock::VsyncPresentationClock(
+    std::shared_ptr<DisplayReport> const& wrapped,
+    std::shared_ptr<time::AlarmFactory> const& alarm_factory,
+    std::chrono::milliseconds flip_timeout) :
+    id{next_clock_id.fetch_add(1)},
+    wrapped{wrapped},
+    alarm_factory{alarm_factory},
+    flip_timeout{flip_timeout}
+{
+}
+
+mg::VsyncPresentationClock::~VsyncPresentationClock() = default;
+
+void mg::VsyncPresentationClock::report_successful_setup_of_native_resources()
+{
+    wrapped->report_successful_setup_of_native_resources();
+}
+
+void mg::VsyncPresentationClock::report_successful_egl_make_current_on_construction()
+{
+    wrapped->report_successful_egl_make_current_on_construction();
+}
+
+void mg::VsyncPresentationClock::report_successful_egl_buffer_swap_on_construction()
+{
+    wrapped->report_successful_egl_buffer_swap_on_construction();
+}
+
+void mg::VsyncPresentationClock::report_successful_display_construction()
+{
+    wrapped->report_successful_display_construction();
+}
+
+void mg::VsyncPresentationClock::report_egl_configuration(EGLDisplay disp, EGLConfig cfg)
+{
+    wrapped->report_egl_configuration(disp, cfg);
+}
+
+void mg::VsyncPresentationClock::report_vsync(unsigned int output_id, Frame const& frame)
+{
+    wrapped->report_vsync(output_id, frame);
+
+    if (this_thread.clock_id != id)
+        this_thread = {id, output_id};
+
+    Presentation presentation{in_monotonic_time(frame), std::chrono::nanoseconds::zero(), true};
+    std::vector<Handler> handlers;
+    // Destroyed without holding mutex: a timeout that is firing waits for it
+    std::vector<std::unique_ptr<time::Alarm>> timeouts;
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        flips_reported = true;
+
+        auto& last = last_frame[output_id];
+        if (last.msc != 0 && frame.msc > last.msc && frame.ust.clock_id == last.ust.clock_id)
+        {
+            presentation.refresh = (frame.ust - last.ust) / (frame.msc - last.msc);
+        }
+        last = frame;
+
+        for (auto const key : {this_thread.output_id, any_output})
+        {
+            auto const waiting = pending.find(key);
+            if (waiting == pending.end() || waiting->second.handlers.empty())
+                continue;
+
+            ++waiting->second.generation;
+            handlers.insert(end(handlers), begin(waiting->second.handlers), end(waiting->second.handlers));
+            waiting->second.handlers.clear();
+            timeouts.push_back(std::move(waiting->second.timeout));
+        }
+    }
+
+    for (auto const& handler : handlers)
+        handler(presentation);
+}
+
+void mg::VsyncPresentationClock::report_successful_drm_mode_set_crtc_on_construction()
+{
+    wrapped->report_successful_drm_mode_set_crtc_on_construction();
+}
+
+void mg::VsyncPresentationClock::report_drm_master_failure(int error)
+{
+    wrapped->report_drm_master_failure(error);
+}
+
+void mg::VsyncPresentationClock::report_vt_switch_away_failure()
+{
+    wrapped->report_vt_switch_away_failure();
+}
+
+void mg::VsyncPresentationClock::report_vt_switch_back_failure()
+{
+    wrapped->report_vt_switch_back_failure();
+}
+
+void mg::VsyncPresentationClock::on_next_presentation(std::function<void(Presentation const&)> const& handler)
+{
+    bool waiting_for_flip{false};
+    auto const output_id = this_thread.clock_id == id ? this_thread.output_id : any_output;
+    uint64_t generation{0};
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        if (flips_reported)
+        {
+            auto& waiting = pending[output_id];
+            waiting.handlers.push_back(handler);
+
+            // Only the first handler of a generation needs a timeout
+            if (waiting.handlers.size() > 1)
+                return;
+
+            waiting_for_flip = true;
+            generation = waiting.generation;
+        }
+    }
+
+    if (waiting_for_flip)
+    {
+        // Alarms are not touched while holding mutex: a firing alarm holds its own lock while it waits for mutex
+        start_timeout(output_id, generation);
+    }
+    else
+    {
+        handler(presentation_now());
+    }
+}
+
+void mg::VsyncPresentationClock::start_timeout(unsigned int output_id, uint64_t generation)
+{
+    auto timeout = alarm_factory->create_alarm(
+        [this, output_id, generation]
+        {
+            present_without_flip(output_id, generation);
+        });
+    timeout->reschedule_in(flip_timeout);
+
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        auto& waiting = pending[output_id];
+
+        // Unless a flip has already called the handlers this timeout was for
+        if (waiting.generation == generation)
+            std::swap(waiting.timeout, timeout);
+    }
+}
+
+void mg::VsyncPresentationClock::present_without_flip(unsigned int output_id, uint64_t generation)
+{
+    std::vector<Handler> handlers;
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        auto& waiting = pending[output_id];
+        if (waiting.generation != generation)
+            return;
+
+        // The alarm that called us stays in place until the next generation's replaces it
+        ++waiting.generation;
+        handlers.swap(waiting.handlers);
+    }
+
+    auto const presentation = presentation_now();
+    for (auto const& handler : handlers)
+        handler(presentation);
+}
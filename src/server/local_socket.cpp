@@ -0,0 +1,55 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/local_socket.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+auto mir::listen_on_local_socket(std::string const& path, std::string const& description) -> Fd
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+        BOOST_THROW_EXCEPTION(std::invalid_argument(description + " socket path is too long: " + path));
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    Fd socket_fd{socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)};
+    if (socket_fd < 0)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to create " + description + " socket"));
+    }
+
+    unlink(path.c_str());
+    if (bind(socket_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1 ||
+        chmod(path.c_str(), S_IRUSR | S_IWUSR) == -1 ||
+        listen(socket_fd, SOMAXCONN) == -1)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to listen on " + description + " socket " + path));
+    }
+
+    return socket_fd;
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compositor_report.h"
+#include "registry.h"
+#include "metrics.h"
+
+#include "mir/time/clock.h"
+
+#include <chrono>
+
+namespace mrm = mir::report::metrics;
+
+namespace
+{
+double const nanoseconds = 1e-9;
+
+/// A compositor thread composites one frame at a time, from began_frame() to finished_frame()
+struct FrameState
+{
+    std::int64_t began_ns;
+    bool rendered;
+};
+
+thread_local FrameState frame_state{0, false};
+}
+
+mrm::CompositorReport::CompositorReport(std::shared_ptr<Registry> const& registry, std::shared_ptr<time::Clock> const& clock)
+    : registry{registry},
+      clock{clock},
+      frames{registry->counter(
+          "mir_compositor_frames_total",
+          "Frames composited, across all displays")},
+      bypassed_frames{registry->counter(
+          "mir_compositor_bypassed_frames_total",
+          "Frames scanned out directly from a client buffer without rendering")},
+      schedules{registry->counter(
+          "mir_compositor_scheduled_total",
+          "Requests to composite a new frame")},
+      displays{registry->gauge(
+          "mir_compositor_displays",
+          "Display buffers being composited")},
+      renderables{registry->gauge(
+          "mir_compositor_renderables",
+          "Renderables in the most recently composited frame")},
+      composition_time{registry->histogram(
+          "mir_compositor_frame_seconds",
+          "Time from starting to finishing the composition of a frame",
+          nanoseconds)},
+      render_time{registry->histogram(
+          "mir_compositor_render_seconds",
+          "Time spent rendering frames that were not bypassed",
+          nanoseconds)},
+      schedule_latency{registry->histogram(
+          "mir_compositor_schedule_latency_seconds",
+          "Time from compositing being scheduled to a frame being started",
+          nanoseconds)}
+{
+}
+
+std::int64_t mrm::CompositorReport::now_ns() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(clock->now().time_since_epoch()).count();
+}
+
+void mrm::CompositorReport::added_display(int, int, int, int, SubCompositorId)
+{
+    displays.add(1);
+}
+
+void mrm::CompositorReport::began_frame(SubCompositorId)
+{
+    auto const now = now_ns();
+    frame_state = {now, false};
+
+    auto const scheduled = last_scheduled_ns.load(std::memory_order_relaxed);
+    if (scheduled && now >= scheduled)
+        schedule_latency.record(now - scheduled);
+}
+
+void mrm::CompositorReport::renderables_in_frame(SubCompositorId, graphics::RenderableList const& list)
+{
+    renderables.set(list.size());
+}
+
+void mrm::CompositorReport::rendered_frame(SubCompositorId)
+{
+    frame_state.rendered = true;
+    render_time.record(now_ns() - frame_state.began_ns);
+}
+
+void mrm::CompositorReport::finished_frame(SubCompositorId)
+{
+    frames.increment();
+    if (!frame_state.rendered)
+        bypassed_frames.increment();
+
+    composition_time.record(now_ns() - frame_state.began_ns);
+}
+
+void mrm::CompositorReport::started()
+{
+}
+
+void mrm::CompositorReport::stopped()
+{
+    displays.set(0);
+}
+
+void mrm::CompositorReport::scheduled()
+{
+    schedules.increment();
+    last_scheduled_ns.store(now_ns(), std::memory_order_relaxed);
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_METRICS_COMPOSITOR_REPORT_H_
+#define MIR_REPORT_METRICS_COMPOSITOR_REPORT_H_
+
+#include "mir/compositor/compositor_report.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace mir
+{
+namespace time
+{
+class Clock;
+}
+namespace report
+{
+namespace metrics
+{
+class Registry;
+class Counter;
+class Gauge;
+class Histogram;
+
+class CompositorReport : public compositor::CompositorReport
+{
+public:
+    CompositorReport(std::shared_ptr<Registry> const& registry, std::shared_ptr<time::Clock> const& clock);
+
+    void added_display(int width, int height, int x, int y, SubCompositorId id) override;
+    void began_frame(SubCompositorId id) override;
+    void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
+    void rendered_frame(SubCompositorId id) override;
+    void finished_frame(SubCompositorId id) override;
+    void started() override;
+    void stopped() override;
+    void scheduled() override;
+
+private:
+    std::int64_t now_ns() const;
+
+    std::shared_ptr<Registry> const registry;
+    std::shared_ptr<time::Clock> const clock;
+
+    Counter& frames;
+    Counter& bypassed_frames;
+    Counter& schedules;
+    Gauge& displays;
+    Gauge& renderables;
+    Histogram& composition_time;
+    Histogram& render_time;
+    Histogram& schedule_latency;
+
+    std::atomic<std::int64_t> last_scheduled_ns{0};
+};
+}
+}
+}
+
+#endif /* MIR_REPORT_METRICS_COMPOSITOR_REPORT_H_ */
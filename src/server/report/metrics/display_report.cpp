@@ -0,0 +1,79 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "display_report.h"
+#include "registry.h"
+#include "metrics.h"
+
+namespace mrm = mir::report::metrics;
+
+mrm::DisplayReport::DisplayReport(std::shared_ptr<Registry> const& registry)
+    : registry{registry},
+      vsyncs{registry->counter(
+          "mir_display_vsyncs_total",
+          "Page flips completed, across all outputs")},
+      drm_master_failures{registry->counter(
+          "mir_display_drm_master_failures_total",
+          "Failures to acquire or drop DRM master")},
+      vt_switch_failures{registry->counter(
+          "mir_display_vt_switch_failures_total",
+          "Failures to switch VT away from or back to the server")}
+{
+}
+
+void mrm::DisplayReport::report_successful_setup_of_native_resources()
+{
+}
+
+void mrm::DisplayReport::report_successful_egl_make_current_on_construction()
+{
+}
+
+void mrm::DisplayReport::report_successful_egl_buffer_swap_on_construction()
+{
+}
+
+void mrm::DisplayReport::report_successful_drm_mode_set_crtc_on_construction()
+{
+}
+
+void mrm::DisplayReport::report_successful_display_construction()
+{
+}
+
+void mrm::DisplayReport::report_drm_master_failure(int)
+{
+    drm_master_failures.increment();
+}
+
+void mrm::DisplayReport::report_vt_switch_away_failure()
+{
+    vt_switch_failures.increment();
+}
+
+void mrm::DisplayReport::report_vt_switch_back_failure()
+{
+    vt_switch_failures.increment();
+}
+
+void mrm::DisplayReport::report_egl_configuration(EGLDisplay, EGLConfig)
+{
+}
+
+void mrm::DisplayReport::report_vsync(unsigned int, graphics::Frame const&)
+{
+    vsyncs.increment();
+}
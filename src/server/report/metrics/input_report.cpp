@@ -0,0 +1,94 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "input_report.h"
+#include "registry.h"
+#include "metrics.h"
+
+#include "mir/time/clock.h"
+
+#include <chrono>
+
+namespace mrm = mir::report::metrics;
+
+namespace
+{
+double const nanoseconds = 1e-9;
+}
+
+mrm::InputReport::InputReport(std::shared_ptr<Registry> const& registry, std::shared_ptr<time::Clock> const& clock)
+    : registry{registry},
+      clock{clock},
+      kernel_events{registry->counter(
+          "mir_input_kernel_events_total",
+          "Input events read from the kernel")},
+      published_events{registry->counter(
+          "mir_input_published_events_total",
+          "Key and motion events published to clients")},
+      opened_devices{registry->counter(
+          "mir_input_devices_opened_total",
+          "Input devices opened")},
+      failed_devices{registry->counter(
+          "mir_input_device_open_failures_total",
+          "Input devices that failed to open")},
+      kernel_latency{registry->histogram(
+          "mir_input_kernel_latency_seconds",
+          "Time from the kernel timestamping an input event to the server processing it",
+          nanoseconds)},
+      publish_latency{registry->histogram(
+          "mir_input_publish_latency_seconds",
+          "Time from an input event occurring to it being published to a client",
+          nanoseconds)}
+{
+}
+
+void mrm::InputReport::record_latency(Histogram& histogram, int64_t event_time)
+{
+    auto const now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        clock->now().time_since_epoch()).count();
+
+    // Events from devices with a different time base would give nonsense
+    if (event_time > 0 && now >= event_time)
+        histogram.record(now - event_time);
+}
+
+void mrm::InputReport::received_event_from_kernel(int64_t when, int, int, int)
+{
+    kernel_events.increment();
+    record_latency(kernel_latency, when);
+}
+
+void mrm::InputReport::published_key_event(int, uint32_t, int64_t event_time)
+{
+    published_events.increment();
+    record_latency(publish_latency, event_time);
+}
+
+void mrm::InputReport::published_motion_event(int, uint32_t, int64_t event_time)
+{
+    published_events.increment();
+    record_latency(publish_latency, event_time);
+}
+
+void mrm::InputReport::opened_input_device(char const*, char const*)
+{
+    opened_devices.increment();
+}
+
+void mrm::InputReport::failed_to_open_input_device(char const*, char const*)
+{
+    failed_devices.increment();
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metrics.h"
+
+namespace mrm = mir::report::metrics;
+
+mrm::Counter::Counter()
+{
+    for (auto& cell : cells)
+        cell.value.store(0, std::memory_order_relaxed);
+}
+
+std::uint64_t mrm::Counter::value() const noexcept
+{
+    std::uint64_t total{0};
+    for (auto const& cell : cells)
+        total += cell.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+mrm::Histogram::Histogram()
+{
+    for (auto& shard : shards)
+    {
+        for (auto& bucket : shard.buckets)
+            bucket.store(0, std::memory_order_relaxed);
+        shard.sum.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::vector<std::uint64_t> mrm::Histogram::bucket_counts() const
+{
+    std::vector<std::uint64_t> counts(bucket_count, 0);
+
+    for (auto const& shard : shards)
+    {
+        for (std::size_t i = 0; i != bucket_count; ++i)
+            counts[i] += shard.buckets[i].load(std::memory_order_relaxed);
+    }
+
+    return counts;
+}
+
+std::uint64_t mrm::Histogram::sum() const noexcept
+{
+    std::uint64_t total{0};
+    for (auto const& shard : shards)
+        total += shard.sum.load(std::memory_order_relaxed);
+    return total;
+}
+
+std::uint64_t mrm::Histogram::bucket_lower_bound(std::size_t index) noexcept
+{
+    auto const sub_buckets = std::size_t{1} << sub_bucket_bits;
+
+    if (index < sub_buckets)
+        return index;
+
+    auto const magnitude = (index >> sub_bucket_bits) - 1;
+    return std::uint64_t{sub_buckets + index % sub_buckets} << magnitude;
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_METRICS_METRICS_H_
+#define MIR_REPORT_METRICS_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mir
+{
+namespace report
+{
+namespace metrics
+{
+namespace detail
+{
+/// Number of independent cells each metric spreads its updates over
+std::size_t constexpr shard_count = 8;
+
+/// The shard the calling thread updates; fixed for the lifetime of the thread
+inline std::size_t this_thread_shard() noexcept
+{
+    static std::atomic<std::size_t> next_shard{0};
+    thread_local std::size_t const shard = next_shard.fetch_add(1, std::memory_order_relaxed) % shard_count;
+    return shard;
+}
+
+/// A counter on a cache line of its own, so threads on different shards never contend
+struct Cell
+{
+    std::atomic<std::uint64_t> value;
+    char padding[64 - sizeof(std::atomic<std::uint64_t>)];
+};
+}
+
+/**
+ * A monotonically increasing count.
+ *
+ * Increments are a single relaxed atomic add on a per-thread shard, so
+ * concurrent updaters don't bounce a cache line between them; reading the
+ * value sums the shards.
+ */
+class Counter
+{
+public:
+    Counter();
+
+    void increment(std::uint64_t n = 1) noexcept
+    {
+        cells[detail::this_thread_shard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    std::uint64_t value() const noexcept;
+
+private:
+    Counter(Counter const&) = delete;
+    Counter& operator=(Counter const&) = delete;
+
+    std::array<detail::Cell, detail::shard_count> cells;
+};
+
+/**
+ * A value that can go up and down, such as the number of surfaces.
+ */
+class Gauge
+{
+public:
+    void set(std::int64_t v) noexcept
+    {
+        current.store(v, std::memory_order_relaxed);
+    }
+
+    void add(std::int64_t delta) noexcept
+    {
+        current.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    std::int64_t value() const noexcept
+    {
+        return current.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<std::int64_t> current{0};
+};
+
+/**
+ * A log-linear ("HDR") histogram of non-negative integer samples.
+ *
+ * Values below 16 get a bucket each; above that every power-of-two range is
+ * split into 16 equal buckets, so any recorded value is known to within
+ * 1/16th (~6%) regardless of magnitude. Samples of 2^40 and above are
+ * clamped into the last bucket.
+ *
+ * Like Counter, bucket counts are sharded per thread and updated with
+ * relaxed atomics; record() never locks or allocates.
+ */
+class Histogram
+{
+public:
+    static unsigned constexpr sub_bucket_bits = 4;
+    static unsigned constexpr max_value_bits = 40;
+    static std::size_t constexpr bucket_count =
+        (max_value_bits - sub_bucket_bits + 1) << sub_bucket_bits;
+
+    Histogram();
+
+    void record(std::uint64_t value) noexcept
+    {
+        auto& shard = shards[detail::this_thread_shard()];
+        shard.buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    /// The per-bucket sample counts, summed over all threads
+    std::vector<std::uint64_t> bucket_counts() const;
+    std::uint64_t sum() const noexcept;
+
+    static std::size_t bucket_index(std::uint64_t value) noexcept
+    {
+        auto const sub_buckets = std::uint64_t{1} << sub_bucket_bits;
+
+        if (value >= (std::uint64_t{1} << max_value_bits))
+            return bucket_count - 1;
+        if (value < sub_buckets)
+            return value;
+
+        unsigned const magnitude = (63 - __builtin_clzll(value)) - sub_bucket_bits;
+        return ((magnitude + 1) << sub_bucket_bits) + ((value >> magnitude) - sub_buckets);
+    }
+
+    /// The smallest value that lands in bucket \a index
+    static std::uint64_t bucket_lower_bound(std::size_t index) noexcept;
+
+private:
+    Histogram(Histogram const&) = delete;
+    Histogram& operator=(Histogram const&) = delete;
+
+    struct Shard
+    {
+        std::array<std::atomic<std::uint64_t>, bucket_count> buckets;
+        std::atomic<std::uint64_t> sum;
+        char padding[64];
+    };
+
+    std::array<Shard, detail::shard_count> shards;
+};
+}
+}
+}
+
+#endif /* MIR_REPORT_METRICS_METRICS_H_ */
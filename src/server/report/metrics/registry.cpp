@@ -0,0 +1,151 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "registry.h"
+#include "metrics.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <ostream>
+#include <stdexcept>
+
+namespace mrm = mir::report::metrics;
+
+struct mrm::Registry::Metric
+{
+    std::string help;
+    std::string type;
+    std::unique_ptr<Counter> counter;
+    std::unique_ptr<Gauge> gauge;
+    std::unique_ptr<Histogram> histogram;
+    double unit{1};
+};
+
+namespace
+{
+void write_histogram(std::ostream& out, std::string const& name, mrm::Histogram const& histogram, double unit)
+{
+    auto const counts = histogram.bucket_counts();
+    auto const sub_buckets = std::size_t{1} << mrm::Histogram::sub_bucket_bits;
+
+    // Exporting all of the buckets would swamp a scrape, so only emit the
+    // power-of-two boundaries (the first bucket of each magnitude). The
+    // boundary itself is counted in the next bucket, which is within the
+    // resolution of the histogram.
+    std::uint64_t cumulative{0};
+    std::size_t last_used{0};
+    for (std::size_t i = 0; i != counts.size(); ++i)
+    {
+        if (counts[i])
+            last_used = i;
+    }
+
+    for (std::size_t i = 0; i != counts.size(); ++i)
+    {
+        if (i >= sub_buckets && i % sub_buckets == 0)
+        {
+            out << name << "_bucket{le=\"" << mrm::Histogram::bucket_lower_bound(i) * unit << "\"} "
+                << cumulative << '\n';
+
+            if (i > last_used)
+                break;
+        }
+        cumulative += counts[i];
+    }
+
+    out << name << "_bucket{le=\"+Inf\"} " << cumulative << '\n'
+        << name << "_sum " << histogram.sum() * unit << '\n'
+        << name << "_count " << cumulative << '\n';
+}
+}
+
+mrm::Registry::Registry() = default;
+mrm::Registry::~Registry() = default;
+
+auto mrm::Registry::find_or_insert(std::string const& name, std::string const& help, char const* type) -> Metric&
+{
+    auto& metric = metrics[name];
+
+    if (!metric)
+    {
+        metric = std::make_unique<Metric>();
+        metric->help = help;
+        metric->type = type;
+    }
+    else if (metric->type != type)
+    {
+        BOOST_THROW_EXCEPTION(std::logic_error("Metric \"" + name + "\" already registered as a " + metric->type));
+    }
+
+    return *metric;
+}
+
+auto mrm::Registry::counter(std::string const& name, std::string const& help) -> Counter&
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto& metric = find_or_insert(name, help, "counter");
+    if (!metric.counter)
+        metric.counter = std::make_unique<Counter>();
+
+    return *metric.counter;
+}
+
+auto mrm::Registry::gauge(std::string const& name, std::string const& help) -> Gauge&
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto& metric = find_or_insert(name, help, "gauge");
+    if (!metric.gauge)
+        metric.gauge = std::make_unique<Gauge>();
+
+    return *metric.gauge;
+}
+
+auto mrm::Registry::histogram(std::string const& name, std::string const& help, double unit) -> Histogram&
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto& metric = find_or_insert(name, help, "histogram");
+    if (!metric.histogram)
+    {
+        metric.histogram = std::make_unique<Histogram>();
+        metric.unit = unit;
+    }
+
+    return *metric.histogram;
+}
+
+void mrm::Registry::write_prometheus(std::ostream& out) const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    for (auto const& entry : metrics)
+    {
+        auto const& name = entry.first;
+        auto const& metric = *entry.second;
+
+        out << "# HELP " << name << ' ' << metric.help << '\n'
+            << "# TYPE " << name << ' ' << metric.type << '\n';
+
+        if (metric.counter)
+            out << name << ' ' << metric.counter->value() << '\n';
+        else if (metric.gauge)
+            out << name << ' ' << metric.gauge->value() << '\n';
+        else if (metric.histogram)
+            write_histogram(out, name, *metric.histogram, metric.unit);
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_METRICS_REGISTRY_H_
+#define MIR_REPORT_METRICS_REGISTRY_H_
+
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace mir
+{
+namespace report
+{
+namespace metrics
+{
+class Counter;
+class Gauge;
+class Histogram;
+
+/**
+ * The named metrics of a server, exported in the Prometheus text format.
+ *
+ * Looking a metric up takes a lock, so reports do it once on construction
+ * and keep the returned reference; the metrics live as long as the Registry.
+ * Asking for an existing name returns the same metric, so that several
+ * reports of one kind share their metrics.
+ */
+class Registry
+{
+public:
+    Registry();
+    ~Registry();
+
+    Counter& counter(std::string const& name, std::string const& help);
+    Gauge& gauge(std::string const& name, std::string const& help);
+
+    /**
+     * \param [in] unit   the size of one recorded integer step in the exported
+     *                    unit, e.g. 1e-9 for nanosecond samples of a metric
+     *                    exported in seconds
+     */
+    Histogram& histogram(std::string const& name, std::string const& help, double unit);
+
+    void write_prometheus(std::ostream& out) const;
+
+private:
+    Registry(Registry const&) = delete;
+    Registry& operator=(Registry const&) = delete;
+
+    struct Metric;
+
+    Metric& find_or_insert(std::string const& name, std::string const& help, char const* type);
+
+    std::mutex mutable mutex;
+    std::map<std::string, std::unique_ptr<Metric>> metrics;
+};
+}
+}
+}
+
+#endif /* MIR_REPORT_METRICS_REGISTRY_H_ */
@@ -0,0 +1,96 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scrape_endpoint.h"
+#include "registry.h"
+
+#include "mir/graphics/event_handler_register.h"
+#include "mir/local_socket.h"
+
+#include <sstream>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace mrm = mir::report::metrics;
+
+namespace
+{
+void discard_request(int fd)
+{
+    // We answer every request the same way, but closing a unix socket with
+    // unread data resets the connection under the client's feet. Only what
+    // has already arrived is read: the main loop doesn't wait on clients.
+    char buffer[1024];
+    while (recv(fd, buffer, sizeof buffer, MSG_DONTWAIT) > 0)
+        ;
+}
+}
+
+mrm::ScrapeEndpoint::ScrapeEndpoint(
+    std::string const& socket_path,
+    std::shared_ptr<Registry> const& registry,
+    std::shared_ptr<graphics::EventHandlerRegister> const& event_register)
+    : socket_path{socket_path},
+      registry{registry},
+      event_register{event_register},
+      socket_fd{listen_on_local_socket(socket_path, "metrics")}
+{
+    event_register->register_fd_handler(
+        {socket_fd},
+        this,
+        [this](int) { serve_scrape(); });
+}
+
+mrm::ScrapeEndpoint::~ScrapeEndpoint()
+{
+    event_register->unregister_fd_handler(this);
+    unlink(socket_path.c_str());
+}
+
+void mrm::ScrapeEndpoint::serve_scrape()
+{
+    Fd const client{accept4(socket_fd, nullptr, nullptr, SOCK_CLOEXEC)};
+    if (client < 0)
+        return;
+
+    discard_request(client);
+
+    std::ostringstream response;
+    response << "HTTP/1.0 200 OK\r\n"
+                "Content-Type: text/plain; version=0.0.4\r\n"
+                "Connection: close\r\n"
+                "\r\n";
+    registry->write_prometheus(response);
+
+    auto const text = response.str();
+    auto data = text.data();
+    auto remaining = text.size();
+
+    // The exposition fits comfortably in a socket buffer; a client that
+    // doesn't read it isn't worth blocking the main loop for.
+    while (remaining)
+    {
+        auto const sent = send(client, data, remaining, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent <= 0)
+            break;
+
+        data += sent;
+        remaining -= sent;
+    }
+
+    shutdown(client, SHUT_RDWR);
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_METRICS_SCRAPE_ENDPOINT_H_
+#define MIR_REPORT_METRICS_SCRAPE_ENDPOINT_H_
+
+#include "mir/fd.h"
+
+#include <memory>
+#include <string>
+
+namespace mir
+{
+namespace graphics
+{
+class EventHandlerRegister;
+}
+namespace report
+{
+namespace metrics
+{
+class Registry;
+
+/**
+ * Serves the contents of a Registry on a local socket.
+ *
+ * Each connection gets a minimal HTTP/1.0 response carrying the Prometheus
+ * text exposition, then the connection is closed; this is enough for
+ * Prometheus (via a unix socket proxy), "curl --unix-socket" or plain "nc -U".
+ * Connections are handled on the thread servicing the EventHandlerRegister.
+ */
+class ScrapeEndpoint
+{
+public:
+    ScrapeEndpoint(
+        std::string const& socket_path,
+        std::shared_ptr<Registry> const& registry,
+        std::shared_ptr<graphics::EventHandlerRegister> const& event_register);
+    ~ScrapeEndpoint();
+
+private:
+    ScrapeEndpoint(ScrapeEndpoint const&) = delete;
+    ScrapeEndpoint& operator=(ScrapeEndpoint const&) = delete;
+
+    void serve_scrape();
+
+    std::string const socket_path;
+    std::shared_ptr<Registry> const registry;
+    std::shared_ptr<graphics::EventHandlerRegister> const event_register;
+    Fd const socket_fd;
+};
+}
+}
+}
+
+#endif /* MIR_REPORT_METRICS_SCRAPE_ENDPOINT_H_ */
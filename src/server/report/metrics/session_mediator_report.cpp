@@ -0,0 +1,146 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "session_mediator_report.h"
+#include "registry.h"
+#include "metrics.h"
+
+namespace mrm = mir::report::metrics;
+
+namespace
+{
+mrm::Counter& calls_of(mrm::Registry& registry, char const* method)
+{
+    return registry.counter(
+        std::string{"mir_session_mediator_"} + method + "_calls_total",
+        std::string{"Calls to "} + method + " from clients");
+}
+}
+
+mrm::SessionMediatorReport::SessionMediatorReport(std::shared_ptr<Registry> const& registry)
+    : registry{registry},
+      connect_calls{calls_of(*registry, "connect")},
+      create_surface_calls{calls_of(*registry, "create_surface")},
+      submit_buffer_calls{calls_of(*registry, "submit_buffer")},
+      allocate_buffers_calls{calls_of(*registry, "allocate_buffers")},
+      release_buffers_calls{calls_of(*registry, "release_buffers")},
+      release_surface_calls{calls_of(*registry, "release_surface")},
+      disconnect_calls{calls_of(*registry, "disconnect")},
+      configure_surface_calls{calls_of(*registry, "configure_surface")},
+      configure_surface_cursor_calls{calls_of(*registry, "configure_surface_cursor")},
+      configure_display_calls{calls_of(*registry, "configure_display")},
+      set_base_display_configuration_calls{calls_of(*registry, "set_base_display_configuration")},
+      preview_base_display_configuration_calls{calls_of(*registry, "preview_base_display_configuration")},
+      confirm_base_display_configuration_calls{calls_of(*registry, "confirm_base_display_configuration")},
+      start_prompt_session_calls{calls_of(*registry, "start_prompt_session")},
+      stop_prompt_session_calls{calls_of(*registry, "stop_prompt_session")},
+      create_buffer_stream_calls{calls_of(*registry, "create_buffer_stream")},
+      release_buffer_stream_calls{calls_of(*registry, "release_buffer_stream")},
+      errors{registry->counter(
+          "mir_session_mediator_errors_total",
+          "Session mediator calls that failed")}
+{
+}
+
+void mrm::SessionMediatorReport::session_connect_called(std::string const&)
+{
+    connect_calls.increment();
+}
+
+void mrm::SessionMediatorReport::session_create_surface_called(std::string const&)
+{
+    create_surface_calls.increment();
+}
+
+void mrm::SessionMediatorReport::session_submit_buffer_called(std::string const&)
+{
+    submit_buffer_calls.increment();
+}
+
+void mrm::SessionMediatorReport::session_allocate_buffers_called(std::string const&)
+{
+    allocate_buffers_calls.increment();
+}
+
+void mrm::SessionMediatorReport::session_release_buffers_called(std::string const&)
+{
+    release_buffers_calls.increment();
+}
+
+void mrm::SessionMediatorReport::session_release_surface_called(std::string const&)
+{
+    release_surface_calls.increment();
+}
+
+void mrm::SessionMediatorReport::session_disconnect_called(std::string const&)
+{
+    disconnect_calls.increment();
+}
+
+void mrm::SessionMediatorReport::session_configure_surface_called(std::string const&)
+{
+    configure_surface_calls.increment();
+}
+
+void mrm::SessionMediatorReport::session_configure_surface_cursor_called(std::string const&)
+{
+    configure_surface_cursor_calls.increment();
+}
+
+void mrm::SessionMediatorReport::session_configure_display_called(std::string const&)
+{
+    configure_display_calls.increment();
+}
+
+void mrm::SessionMediatorReport::session_set_base_display_configuration_called(std::string const&)
+{
+    set_base_display_configuration_calls.increment();
+}
+
+void mrm::SessionMediatorReport::session_preview_base_display_configuration_called(std::string const&)
+{
+    preview_base_display_configuration_calls.increment();
+}
+
+void mrm::SessionMediatorReport::session_confirm_base_display_configuration_called(std::string const&)
+{
+    confirm_base_display_configuration_calls.increment();
+}
+
+void mrm::SessionMediatorReport::session_start_prompt_session_called(std::string const&, pid_t)
+{
+    start_prompt_session_calls.increment();
+}
+
+void mrm::SessionMediatorReport::session_stop_prompt_session_called(std::string const&)
+{
+    stop_prompt_session_calls.increment();
+}
+
+void mrm::SessionMediatorReport::session_create_buffer_stream_called(std::string const&)
+{
+    create_buffer_stream_calls.increment();
+}
+
+void mrm::SessionMediatorReport::session_release_buffer_stream_called(std::string const&)
+{
+    release_buffer_stream_calls.increment();
+}
+
+void mrm::SessionMediatorReport::session_error(std::string const&, char const*, std::string const&)
+{
+    errors.increment();
+}
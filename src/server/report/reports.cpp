@@ -28,10 +28,20 @@
 #include "report_factory.h"
 #include "lttng_report_factory.h"
 #include "logging_report_factory.h"
+#include "metrics_report_factory.h"
+#include "trace_report_factory.h"
 #include "null_report_factory.h"
+#include "metrics/registry.h"
+#include "metrics/scrape_endpoint.h"
+#include "trace/trace_control.h"
+#include "mir/main_loop.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <string>
 
+#include <unistd.h>
+
 namespace mo = mir::options;
 namespace mr = mir::report;
 
@@ -41,7 +51,9 @@ enum class ReportOutput
 {
     Discarded,
     Log,
-    LTTNG
+    LTTNG,
+    Metrics,
+    Trace
 };
 
 std::unique_ptr<mr::ReportFactory> factory_for_type(
@@ -56,6 +68,10 @@ std::unique_ptr<mr::ReportFactory> factory_for_type(
         return std::make_unique<mr::LoggingReportFactory>(config.the_logger(), config.the_clock());
     case ReportOutput::LTTNG:
         return std::make_unique<mr::LttngReportFactory>();
+    case ReportOutput::Metrics:
+        return std::make_unique<mr::MetricsReportFactory>(config.the_metrics_registry(), config.the_clock());
+    case ReportOutput::Trace:
+        return std::make_unique<mr::TraceReportFactory>(config.the_tracer());
     }
 #ifndef __clang__
     /*
@@ -80,6 +96,14 @@ ReportOutput parse_report_option(std::string const& opt)
     {
         return ReportOutput::LTTNG;
     }
+    else if (opt == mo::metrics_opt_value)
+    {
+        return ReportOutput::Metrics;
+    }
+    else if (opt == mo::trace_opt_value)
+    {
+        return ReportOutput::Trace;
+    }
     else if (opt == mo::off_opt_value)
     {
         return ReportOutput::Discarded;
@@ -89,7 +113,8 @@ ReportOutput parse_report_option(std::string const& opt)
         throw mir::AbnormalExit(
             std::string("Invalid report option: ") + opt + " (valid options are: \"" +
             mo::off_opt_value + "\" and \"" + mo::log_opt_value +
-            "\" and \"" + mo::lttng_opt_value + "\")");
+            "\" and \"" + mo::lttng_opt_value + "\" and \"" + mo::metrics_opt_value +
+            "\" and \"" + mo::trace_opt_value + "\")");
     }
 }
 
@@ -122,6 +147,51 @@ std::shared_ptr<mir::frontend::SessionMediatorObserver> create_session_mediator_
         std::throw_with_nested(mir::AbnormalExit("Failed to create report for "s + mo::session_mediator_report_opt));
     }
 }
+
+std::shared_ptr<mr::metrics::ScrapeEndpoint> create_metrics_endpoint(
+    mir::DefaultServerConfiguration& config,
+    mo::Option const& options)
+{
+    if (!options.is_set(mo::metrics_socket_opt))
+        return {};
+
+    return std::make_shared<mr::metrics::ScrapeEndpoint>(
+        options.get<std::string>(mo::metrics_socket_opt),
+        config.the_metrics_registry(),
+        config.the_main_loop());
+}
+
+std::string default_trace_file()
+{
+    auto const runtime_dir = getenv("XDG_RUNTIME_DIR");
+    auto const file = "mir-trace-" + std::to_string(getpid()) + ".json";
+
+    return runtime_dir ? std::string{runtime_dir} + "/" + file : file;
+}
+
+std::shared_ptr<mr::trace::TraceControl> create_trace_control(
+    mir::DefaultServerConfiguration& config,
+    mo::Option const& options)
+{
+    auto const report_opts = {
+        mo::compositor_report_opt,
+        mo::display_report_opt,
+        mo::input_report_opt,
+        mo::scene_report_opt,
+        mo::session_mediator_report_opt};
+
+    auto const tracing = std::any_of(
+        report_opts.begin(), report_opts.end(),
+        [&options](char const* opt) { return options.get<std::string>(opt) == mo::trace_opt_value; });
+
+    if (!tracing)
+        return {};
+
+    auto const trace_file = options.is_set(mo::trace_file_opt) ?
+        options.get<std::string>(mo::trace_file_opt) : default_trace_file();
+
+    return std::make_shared<mr::trace::TraceControl>(config.the_tracer(), trace_file, *config.the_main_loop());
+}
 }
 
 mir::report::Reports::Reports(
@@ -135,7 +205,9 @@ mir::report::Reports::Reports(
           create_session_mediator_reports(
               server,
               options.get<std::string>(mo::session_mediator_report_opt))},
-      session_mediator_observer_multiplexer{server.the_session_mediator_observer_registrar()}
+      session_mediator_observer_multiplexer{server.the_session_mediator_observer_registrar()},
+      metrics_endpoint{create_metrics_endpoint(server, options)},
+      trace_control{create_trace_control(server, options)}
 {
     display_configuration_multiplexer->register_interest(display_configuration_report);
     seat_observer_multiplexer->register_interest(seat_report);
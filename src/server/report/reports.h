@@ -55,6 +55,15 @@ class DisplayConfigurationReport;
 
 class ReportFactory;
 
+namespace metrics
+{
+class ScrapeEndpoint;
+}
+namespace trace
+{
+class TraceControl;
+}
+
 class Reports
 {
 public:
@@ -68,6 +77,8 @@ private:
     std::shared_ptr<frontend::SessionMediatorObserver> const session_mediator_report;
     std::shared_ptr<ObserverRegistrar<frontend::SessionMediatorObserver>> const
         session_mediator_observer_multiplexer;
+    std::shared_ptr<metrics::ScrapeEndpoint> const metrics_endpoint;
+    std::shared_ptr<trace::TraceControl> const trace_control;
 };
 }
 }
@@ -0,0 +1,75 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compositor_report.h"
+#include "tracer.h"
+
+namespace mrt = mir::report::trace;
+
+namespace
+{
+char const* const category = "compositor";
+
+std::int64_t display_arg(mir::compositor::CompositorReport::SubCompositorId id)
+{
+    return reinterpret_cast<std::intptr_t>(id);
+}
+}
+
+mrt::CompositorReport::CompositorReport(std::shared_ptr<Tracer> const& tracer)
+    : tracer{tracer}
+{
+}
+
+void mrt::CompositorReport::added_display(int width, int height, int, int, SubCompositorId id)
+{
+    tracer->instant(category, "added display", {"display", display_arg(id)}, {"pixels", std::int64_t{width} * height});
+}
+
+void mrt::CompositorReport::began_frame(SubCompositorId id)
+{
+    tracer->begin(category, "frame", {"display", display_arg(id)});
+}
+
+void mrt::CompositorReport::renderables_in_frame(SubCompositorId, graphics::RenderableList const& renderables)
+{
+    tracer->instant(category, "renderables", {"count", static_cast<std::int64_t>(renderables.size())});
+}
+
+void mrt::CompositorReport::rendered_frame(SubCompositorId)
+{
+    tracer->instant(category, "rendered");
+}
+
+void mrt::CompositorReport::finished_frame(SubCompositorId)
+{
+    tracer->end(category, "frame");
+}
+
+void mrt::CompositorReport::started()
+{
+    tracer->instant(category, "started");
+}
+
+void mrt::CompositorReport::stopped()
+{
+    tracer->instant(category, "stopped");
+}
+
+void mrt::CompositorReport::scheduled()
+{
+    tracer->instant(category, "scheduled");
+}
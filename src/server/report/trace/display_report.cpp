@@ -0,0 +1,86 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "display_report.h"
+#include "tracer.h"
+
+#include "mir/graphics/frame.h"
+
+namespace mrt = mir::report::trace;
+
+namespace
+{
+char const* const category = "display";
+}
+
+mrt::DisplayReport::DisplayReport(std::shared_ptr<Tracer> const& tracer)
+    : tracer{tracer}
+{
+}
+
+void mrt::DisplayReport::report_successful_setup_of_native_resources()
+{
+}
+
+void mrt::DisplayReport::report_successful_egl_make_current_on_construction()
+{
+}
+
+void mrt::DisplayReport::report_successful_egl_buffer_swap_on_construction()
+{
+}
+
+void mrt::DisplayReport::report_successful_drm_mode_set_crtc_on_construction()
+{
+}
+
+void mrt::DisplayReport::report_successful_display_construction()
+{
+}
+
+void mrt::DisplayReport::report_drm_master_failure(int error)
+{
+    tracer->instant(category, "DRM master failure", {"errno", error});
+}
+
+void mrt::DisplayReport::report_vt_switch_away_failure()
+{
+    tracer->instant(category, "VT switch away failure");
+}
+
+void mrt::DisplayReport::report_vt_switch_back_failure()
+{
+    tracer->instant(category, "VT switch back failure");
+}
+
+void mrt::DisplayReport::report_egl_configuration(EGLDisplay, EGLConfig)
+{
+}
+
+void mrt::DisplayReport::report_vsync(unsigned int output_id, graphics::Frame const& frame)
+{
+    // Place the flip at the time the hardware reported, when it's on our timeline
+    if (frame.ust.clock_id == CLOCK_MONOTONIC && frame.ust.nanoseconds.count())
+    {
+        tracer->instant_at(
+            frame.ust.nanoseconds.count(), category, "page flip",
+            {"output", output_id}, {"msc", frame.msc});
+    }
+    else
+    {
+        tracer->instant(category, "page flip", {"output", output_id}, {"msc", frame.msc});
+    }
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "input_report.h"
+#include "tracer.h"
+
+namespace mrt = mir::report::trace;
+
+namespace
+{
+char const* const category = "input";
+}
+
+mrt::InputReport::InputReport(std::shared_ptr<Tracer> const& tracer)
+    : tracer{tracer}
+{
+}
+
+void mrt::InputReport::received_event_from_kernel(int64_t when, int type, int code, int)
+{
+    // Mark both when the kernel saw the event and when we got to it
+    tracer->instant_at(when, category, "kernel event", {"type", type}, {"code", code});
+    tracer->instant(category, "dispatch", {"type", type}, {"code", code});
+}
+
+void mrt::InputReport::published_key_event(int dest_fd, uint32_t seq_id, int64_t)
+{
+    tracer->instant(category, "published key event", {"fd", dest_fd}, {"seq", seq_id});
+}
+
+void mrt::InputReport::published_motion_event(int dest_fd, uint32_t seq_id, int64_t)
+{
+    tracer->instant(category, "published motion event", {"fd", dest_fd}, {"seq", seq_id});
+}
+
+void mrt::InputReport::opened_input_device(char const*, char const*)
+{
+    tracer->instant(category, "opened device");
+}
+
+void mrt::InputReport::failed_to_open_input_device(char const*, char const*)
+{
+    tracer->instant(category, "failed to open device");
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scene_report.h"
+#include "tracer.h"
+
+namespace mrt = mir::report::trace;
+
+namespace
+{
+char const* const category = "scene";
+
+mir::report::trace::Tracer::Arg surface_arg(mir::scene::SceneReport::BasicSurfaceId id)
+{
+    return {"surface", reinterpret_cast<std::intptr_t>(id)};
+}
+}
+
+mrt::SceneReport::SceneReport(std::shared_ptr<Tracer> const& tracer)
+    : tracer{tracer}
+{
+}
+
+void mrt::SceneReport::surface_created(BasicSurfaceId id, std::string const&)
+{
+    tracer->instant(category, "surface created", surface_arg(id));
+}
+
+void mrt::SceneReport::surface_added(BasicSurfaceId id, std::string const&)
+{
+    tracer->instant(category, "surface added", surface_arg(id));
+}
+
+void mrt::SceneReport::surface_removed(BasicSurfaceId id, std::string const&)
+{
+    tracer->instant(category, "surface removed", surface_arg(id));
+}
+
+void mrt::SceneReport::surface_deleted(BasicSurfaceId id, std::string const&)
+{
+    tracer->instant(category, "surface deleted", surface_arg(id));
+}
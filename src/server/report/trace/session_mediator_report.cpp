@@ -0,0 +1,120 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "session_mediator_report.h"
+#include "tracer.h"
+
+namespace mrt = mir::report::trace;
+
+namespace
+{
+char const* const category = "session mediator";
+}
+
+mrt::SessionMediatorReport::SessionMediatorReport(std::shared_ptr<Tracer> const& tracer)
+    : tracer{tracer}
+{
+}
+
+void mrt::SessionMediatorReport::session_connect_called(std::string const&)
+{
+    tracer->instant(category, "connect");
+}
+
+void mrt::SessionMediatorReport::session_create_surface_called(std::string const&)
+{
+    tracer->instant(category, "create_surface");
+}
+
+void mrt::SessionMediatorReport::session_submit_buffer_called(std::string const&)
+{
+    tracer->instant(category, "submit_buffer");
+}
+
+void mrt::SessionMediatorReport::session_allocate_buffers_called(std::string const&)
+{
+    tracer->instant(category, "allocate_buffers");
+}
+
+void mrt::SessionMediatorReport::session_release_buffers_called(std::string const&)
+{
+    tracer->instant(category, "release_buffers");
+}
+
+void mrt::SessionMediatorReport::session_release_surface_called(std::string const&)
+{
+    tracer->instant(category, "release_surface");
+}
+
+void mrt::SessionMediatorReport::session_disconnect_called(std::string const&)
+{
+    tracer->instant(category, "disconnect");
+}
+
+void mrt::SessionMediatorReport::session_configure_surface_called(std::string const&)
+{
+    tracer->instant(category, "configure_surface");
+}
+
+void mrt::SessionMediatorReport::session_configure_surface_cursor_called(std::string const&)
+{
+    tracer->instant(category, "configure_surface_cursor");
+}
+
+void mrt::SessionMediatorReport::session_configure_display_called(std::string const&)
+{
+    tracer->instant(category, "configure_display");
+}
+
+void mrt::SessionMediatorReport::session_set_base_display_configuration_called(std::string const&)
+{
+    tracer->instant(category, "set_base_display_configuration");
+}
+
+void mrt::SessionMediatorReport::session_preview_base_display_configuration_called(std::string const&)
+{
+    tracer->instant(category, "preview_base_display_configuration");
+}
+
+void mrt::SessionMediatorReport::session_confirm_base_display_configuration_called(std::string const&)
+{
+    tracer->instant(category, "confirm_base_display_configuration");
+}
+
+void mrt::SessionMediatorReport::session_start_prompt_session_called(std::string const&, pid_t application_process)
+{
+    tracer->instant(category, "start_prompt_session", {"pid", application_process});
+}
+
+void mrt::SessionMediatorReport::session_stop_prompt_session_called(std::string const&)
+{
+    tracer->instant(category, "stop_prompt_session");
+}
+
+void mrt::SessionMediatorReport::session_create_buffer_stream_called(std::string const&)
+{
+    tracer->instant(category, "create_buffer_stream");
+}
+
+void mrt::SessionMediatorReport::session_release_buffer_stream_called(std::string const&)
+{
+    tracer->instant(category, "release_buffer_stream");
+}
+
+void mrt::SessionMediatorReport::session_error(std::string const&, char const*, std::string const&)
+{
+    tracer->instant(category, "error");
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "trace"
+
+#include "trace_control.h"
+#include "tracer.h"
+
+#include "mir/graphics/event_handler_register.h"
+#include "mir/log.h"
+
+#include <fstream>
+#include <mutex>
+
+#include <signal.h>
+
+namespace mrt = mir::report::trace;
+
+struct mrt::TraceControl::State
+{
+    State(std::shared_ptr<Tracer> const& tracer, std::string const& trace_file)
+        : tracer{tracer},
+          trace_file{trace_file}
+    {
+    }
+
+    void start()
+    {
+        tracer->start();
+        mir::log_info("Tracing started; send SIGUSR2 to stop and write %s", trace_file.c_str());
+    }
+
+    void stop()
+    {
+        tracer->stop();
+
+        std::ofstream out{trace_file, std::ios::out | std::ios::trunc};
+        tracer->write_json(out);
+        out.close();
+
+        if (out)
+            mir::log_info("Tracing stopped; trace written to %s", trace_file.c_str());
+        else
+            mir::log_warning("Tracing stopped, but failed to write trace to %s", trace_file.c_str());
+    }
+
+    void toggle()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        if (tracer->recording())
+            stop();
+        else
+            start();
+    }
+
+    std::shared_ptr<Tracer> const tracer;
+    std::string const trace_file;
+    std::mutex mutex;
+};
+
+mrt::TraceControl::TraceControl(
+    std::shared_ptr<Tracer> const& tracer,
+    std::string const& trace_file,
+    graphics::EventHandlerRegister& event_register)
+    : state{std::make_shared<State>(tracer, trace_file)}
+{
+    // Signal handlers can't be unregistered, so don't let one keep us alive
+    std::weak_ptr<State> const weak_state{state};
+    event_register.register_signal_handler(
+        {SIGUSR2},
+        [weak_state](int)
+        {
+            if (auto const state = weak_state.lock())
+                state->toggle();
+        });
+
+    state->start();
+}
+
+mrt::TraceControl::~TraceControl()
+{
+    std::lock_guard<std::mutex> lock{state->mutex};
+
+    if (state->tracer->recording())
+        state->stop();
+}
+
+void mrt::TraceControl::toggle()
+{
+    state->toggle();
+}
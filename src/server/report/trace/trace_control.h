@@ -0,0 +1,65 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_TRACE_TRACE_CONTROL_H_
+#define MIR_REPORT_TRACE_TRACE_CONTROL_H_
+
+#include <memory>
+#include <string>
+
+namespace mir
+{
+namespace graphics
+{
+class EventHandlerRegister;
+}
+namespace report
+{
+namespace trace
+{
+class Tracer;
+
+/**
+ * Starts and stops a Tracer at runtime.
+ *
+ * Recording starts straight away. Each SIGUSR2 then alternately stops
+ * recording, writing the trace to \a trace_file, and starts a new recording.
+ * A recording still in progress is written when the TraceControl is
+ * destroyed.
+ */
+class TraceControl
+{
+public:
+    TraceControl(
+        std::shared_ptr<Tracer> const& tracer,
+        std::string const& trace_file,
+        graphics::EventHandlerRegister& event_register);
+    ~TraceControl();
+
+    void toggle();
+
+private:
+    TraceControl(TraceControl const&) = delete;
+    TraceControl& operator=(TraceControl const&) = delete;
+
+    struct State;
+    std::shared_ptr<State> const state;
+};
+}
+}
+}
+
+#endif /* MIR_REPORT_TRACE_TRACE_CONTROL_H_ */
@@ -0,0 +1,262 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tracer.h"
+
+#include "mir/time/clock.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace mrt = mir::report::trace;
+
+struct mrt::Tracer::ThreadBuffer
+{
+    ThreadBuffer(std::size_t capacity)
+        : capacity{capacity},
+          events{new Event[capacity]}
+    {
+        claim();
+    }
+
+    /// Hand the buffer to the calling thread, discarding any events of its previous owner
+    void claim()
+    {
+        tid = static_cast<pid_t>(syscall(SYS_gettid));
+
+        char name[16] = "";
+        pthread_getname_np(pthread_self(), name, sizeof name);
+        thread_name = name;
+
+        // Keep the name safe to embed in a JSON string
+        std::replace_if(thread_name.begin(), thread_name.end(),
+                        [](char c) { return c == '"' || c == '\\' || c < ' '; }, '_');
+
+        head.store(0, std::memory_order_relaxed);
+    }
+
+    pid_t tid;
+    std::string thread_name;
+    std::size_t const capacity;
+    std::unique_ptr<Event[]> const events;
+
+    /// Written only by the owning thread; the count of events ever recorded
+    std::atomic<std::uint64_t> head{0};
+};
+
+struct mrt::Tracer::ThreadBuffers
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> all;
+    /// Buffers of threads that have exited, ready for reuse
+    std::vector<ThreadBuffer*> released;
+};
+
+/// A thread's claim on one of a Tracer's buffers, released when the thread exits
+struct mrt::Tracer::BufferClaim
+{
+    BufferClaim(std::uint64_t tracer_id, std::weak_ptr<ThreadBuffers> const& buffers, ThreadBuffer* buffer)
+        : tracer_id{tracer_id},
+          buffers{buffers},
+          buffer{buffer}
+    {
+    }
+
+    BufferClaim(BufferClaim&& that) noexcept
+        : tracer_id{that.tracer_id},
+          buffers{std::move(that.buffers)},
+          buffer{std::exchange(that.buffer, nullptr)}
+    {
+    }
+
+    BufferClaim& operator=(BufferClaim&& that) noexcept
+    {
+        std::swap(tracer_id, that.tracer_id);
+        std::swap(buffers, that.buffers);
+        std::swap(buffer, that.buffer);
+        return *this;
+    }
+
+    ~BufferClaim()
+    {
+        // The Tracer (and with it the buffer) may already have gone
+        auto const live = buffers.lock();
+        if (live && buffer)
+        {
+            std::lock_guard<std::mutex> lock{live->mutex};
+            live->released.push_back(buffer);
+        }
+    }
+
+    std::uint64_t tracer_id;
+    std::weak_ptr<ThreadBuffers> buffers;
+    ThreadBuffer* buffer;
+};
+
+namespace
+{
+std::atomic<std::uint64_t> next_tracer_id{1};
+
+void write_timestamp(std::ostream& out, std::int64_t ns)
+{
+    // Trace event timestamps are in microseconds
+    auto const fraction = ns % 1000;
+    out << ns / 1000 << '.'
+        << static_cast<char>('0' + fraction / 100)
+        << static_cast<char>('0' + fraction / 10 % 10)
+        << static_cast<char>('0' + fraction % 10);
+}
+}
+
+mrt::Tracer::Tracer(std::shared_ptr<time::Clock> const& clock, std::size_t events_per_thread)
+    : clock{clock},
+      events_per_thread{events_per_thread},
+      id{next_tracer_id.fetch_add(1)},
+      buffers{std::make_shared<ThreadBuffers>()}
+{
+}
+
+mrt::Tracer::~Tracer() = default;
+
+std::int64_t mrt::Tracer::now_ns() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(clock->now().time_since_epoch()).count();
+}
+
+void mrt::Tracer::start()
+{
+    started_at_ns.store(now_ns(), std::memory_order_relaxed);
+    recording_.store(true, std::memory_order_relaxed);
+}
+
+void mrt::Tracer::stop()
+{
+    recording_.store(false, std::memory_order_relaxed);
+}
+
+auto mrt::Tracer::this_thread_buffer() -> ThreadBuffer&
+{
+    // A thread normally records to a single Tracer, so this is usually one entry
+    thread_local std::vector<BufferClaim> claims;
+
+    for (auto const& claim : claims)
+    {
+        if (claim.tracer_id == id)
+            return *claim.buffer;
+    }
+
+    // Don't let claims on Tracers that have gone accumulate
+    claims.erase(
+        std::remove_if(claims.begin(), claims.end(), [](auto const& claim) { return claim.buffers.expired(); }),
+        claims.end());
+
+    std::lock_guard<std::mutex> lock{buffers->mutex};
+
+    ThreadBuffer* buffer;
+    if (buffers->released.empty())
+    {
+        buffers->all.push_back(std::make_unique<ThreadBuffer>(events_per_thread));
+        buffer = buffers->all.back().get();
+    }
+    else
+    {
+        buffer = buffers->released.back();
+        buffers->released.pop_back();
+        buffer->claim();
+    }
+
+    claims.emplace_back(id, buffers, buffer);
+    return *buffer;
+}
+
+void mrt::Tracer::record(
+    Phase phase,
+    char const* category,
+    char const* name,
+    std::int64_t timestamp_ns,
+    Arg arg0,
+    Arg arg1)
+{
+    auto& buffer = this_thread_buffer();
+    auto const head = buffer.head.load(std::memory_order_relaxed);
+
+    auto& event = buffer.events[head % buffer.capacity];
+    event.timestamp_ns = timestamp_ns;
+    event.category = category;
+    event.name = name;
+    event.args[0] = arg0;
+    event.args[1] = arg1;
+    event.phase = phase;
+
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void mrt::Tracer::write_json(std::ostream& out) const
+{
+    auto const pid = getpid();
+    auto const started_at = started_at_ns.load(std::memory_order_relaxed);
+    char const* separator = "\n";
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    std::lock_guard<std::mutex> lock{buffers->mutex};
+    for (auto const& buffer : buffers->all)
+    {
+        out << separator
+            << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid << ",\"tid\":" << buffer->tid
+            << ",\"args\":{\"name\":\"" << buffer->thread_name << "\"}}";
+        separator = ",\n";
+
+        auto const head = buffer->head.load(std::memory_order_acquire);
+        auto const count = std::min<std::uint64_t>(head, buffer->capacity);
+
+        for (auto i = head - count; i != head; ++i)
+        {
+            auto const& event = buffer->events[i % buffer->capacity];
+            if (event.timestamp_ns < started_at)
+                continue;
+
+            out << separator
+                << "{\"ph\":\"" << static_cast<char>(event.phase)
+                << "\",\"cat\":\"" << event.category
+                << "\",\"name\":\"" << event.name
+                << "\",\"pid\":" << pid << ",\"tid\":" << buffer->tid << ",\"ts\":";
+            write_timestamp(out, event.timestamp_ns);
+
+            if (event.phase == Phase::instant)
+                out << ",\"s\":\"t\"";
+
+            if (event.args[0].name)
+            {
+                out << ",\"args\":{\"" << event.args[0].name << "\":" << event.args[0].value;
+                if (event.args[1].name)
+                    out << ",\"" << event.args[1].name << "\":" << event.args[1].value;
+                out << '}';
+            }
+            out << '}';
+        }
+    }
+
+    out << "\n]}\n";
+}
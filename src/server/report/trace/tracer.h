@@ -0,0 +1,152 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_TRACE_TRACER_H_
+#define MIR_REPORT_TRACE_TRACER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+namespace mir
+{
+namespace time
+{
+class Clock;
+}
+namespace report
+{
+namespace trace
+{
+/**
+ * Records events from any thread for export as a Chrome trace-event file
+ * (viewable in chrome://tracing or https://ui.perfetto.dev).
+ *
+ * Each thread appends to a ring buffer of its own, so recording is a few
+ * plain stores and one release store with no locking; only the first event
+ * from a thread takes a lock to register its buffer. When a buffer fills up
+ * the oldest events are overwritten, so a trace holds the most recent
+ * activity of each thread.
+ *
+ * When a thread exits its buffer is kept for export until another thread
+ * takes it over, so short-lived threads don't grow the Tracer without bound.
+ *
+ * Event names, categories and argument names must be string literals (or
+ * otherwise outlive the Tracer); only the pointers are recorded.
+ */
+class Tracer
+{
+public:
+    enum class Phase : char
+    {
+        begin = 'B',
+        end = 'E',
+        instant = 'i'
+    };
+
+    struct Arg
+    {
+        char const* name;
+        std::int64_t value;
+    };
+
+    /// \param [in] events_per_thread  capacity of each thread's ring buffer
+    Tracer(std::shared_ptr<time::Clock> const& clock, std::size_t events_per_thread = 1 << 12);
+    ~Tracer();
+
+    void begin(char const* category, char const* name, Arg arg0 = {}, Arg arg1 = {})
+    {
+        if (recording())
+            record(Phase::begin, category, name, now_ns(), arg0, arg1);
+    }
+
+    void end(char const* category, char const* name)
+    {
+        if (recording())
+            record(Phase::end, category, name, now_ns(), {}, {});
+    }
+
+    void instant(char const* category, char const* name, Arg arg0 = {}, Arg arg1 = {})
+    {
+        if (recording())
+            record(Phase::instant, category, name, now_ns(), arg0, arg1);
+    }
+
+    /// Record an instant that happened at \a timestamp_ns on the clock's timeline
+    void instant_at(std::int64_t timestamp_ns, char const* category, char const* name, Arg arg0 = {}, Arg arg1 = {})
+    {
+        if (recording())
+            record(Phase::instant, category, name, timestamp_ns, arg0, arg1);
+    }
+
+    /**
+     * Start recording; events recorded before the last start() are not exported.
+     */
+    void start();
+    void stop();
+    bool recording() const
+    {
+        return recording_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Write the events recorded since start() in the Chrome trace-event JSON
+     * format.
+     *
+     * This is meant to be called once recording has stopped; events recorded
+     * while writing may be torn.
+     */
+    void write_json(std::ostream& out) const;
+
+private:
+    Tracer(Tracer const&) = delete;
+    Tracer& operator=(Tracer const&) = delete;
+
+    struct Event
+    {
+        std::int64_t timestamp_ns;
+        char const* category;
+        char const* name;
+        Arg args[2];
+        Phase phase;
+    };
+
+    struct ThreadBuffer;
+    /// Shared with the threads recording, so they can hand their buffers back when they exit
+    struct ThreadBuffers;
+    struct BufferClaim;
+
+    void record(Phase phase, char const* category, char const* name, std::int64_t timestamp_ns, Arg arg0, Arg arg1);
+    ThreadBuffer& this_thread_buffer();
+    std::int64_t now_ns() const;
+
+    std::shared_ptr<time::Clock> const clock;
+    std::size_t const events_per_thread;
+    /// Distinguishes this Tracer from others (possibly at the same address) in thread-local caches
+    std::uint64_t const id;
+
+    std::atomic<bool> recording_{false};
+    std::atomic<std::int64_t> started_at_ns{0};
+
+    std::shared_ptr<ThreadBuffers> const buffers;
+};
+}
+}
+}
+
+#endif /* MIR_REPORT_TRACE_TRACER_H_ */
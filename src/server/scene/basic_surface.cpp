@@ -327,6 +327,7 @@ void ms::BasicSurface::move_to(geometry::Point const& top_left)
     {
         std::lock_guard<std::mutex> lock(guard);
         surface_rect.top_left = top_left;
+        render_state_.reset();
     }
     observers->moved_to(this, top_left);
 }
@@ -380,6 +381,7 @@ void ms::BasicSurface::resize(geom::Size const& desired_size)
     if (new_size != surface_rect.size)
     {
         surface_rect.size = new_size;
+        render_state_.reset();
         auto const content_size_ = content_size(lock);
 
         lock.unlock();
@@ -437,6 +439,7 @@ void ms::BasicSurface::set_alpha(float alpha)
     {
         std::lock_guard<std::mutex> lock(guard);
         surface_alpha = alpha;
+        render_state_.reset();
     }
     observers->alpha_set_to(this, alpha);
 }
@@ -451,6 +454,7 @@ void ms::BasicSurface::set_transformation(glm::mat4 const& t)
     {
         std::lock_guard<std::mutex> lock(guard);
         transformation_matrix = t;
+        render_state_.reset();
     }
     observers->transformation_set_to(this, t);
 }
@@ -808,31 +812,36 @@ std::shared_ptr<ms::Surface> ms::BasicSurface::parent() const
     return parent_.lock();
 }
 
-namespace
+/// The parts of a surface that feed its renderables; rebuilt only when one of them changes
+struct ms::BasicSurface::RenderState
 {
-//This class avoids locking for long periods of time by copying (or lazy-copying)
-class SurfaceSnapshot : public mg::Renderable
+    struct Layer
+    {
+        std::shared_ptr<mc::BufferStream> stream;
+        geom::Point top_left;
+        mir::optional_value<geom::Size> size;
+    };
+
+    std::vector<Layer> layers;
+    std::experimental::optional<geom::Rectangle> clip_area;
+    glm::mat4 transformation;
+    float alpha;
+};
+
+//This class avoids locking for long periods of time by sharing the immutable
+//RenderState and lazily locking the compositor buffer
+class ms::BasicSurface::SurfaceSnapshot : public mg::Renderable
 {
 public:
     SurfaceSnapshot(
-        std::shared_ptr<mc::BufferStream> const& stream,
+        std::shared_ptr<RenderState const> const& state,
+        RenderState::Layer const& layer,
         void const* compositor_id,
-        geom::Rectangle const& position,
-        std::experimental::optional<geom::Rectangle> const& clip_area,
-        glm::mat4 const& transform,
-        float alpha,
-        mg::Renderable::ID id)
-    : underlying_buffer_stream{stream},
+        geom::Rectangle const& position)
+    : state{state},
+      underlying_buffer_stream{layer.stream.get()},
       compositor_id{compositor_id},
-      alpha_{alpha},
-      screen_position_(position),
-      clip_area_(clip_area),
-      transformation_(transform),
-      id_(id)
-    {
-    }
-
-    ~SurfaceSnapshot()
+      screen_position_(position)
     {
     }
 
@@ -852,30 +861,27 @@ public:
     { return screen_position_; }
 
     std::experimental::optional<geom::Rectangle> clip_area() const override
-    { return clip_area_; }
+    { return state->clip_area; }
 
     float alpha() const override
-    { return alpha_; }
+    { return state->alpha; }
 
     glm::mat4 transformation() const override
-    { return transformation_; }
+    { return state->transformation; }
 
     bool shaped() const override
     { return mg::contains_alpha(underlying_buffer_stream->pixel_format()); }
 
     mg::Renderable::ID id() const override
-    { return id_; }
+    { return underlying_buffer_stream; }
 private:
-    std::shared_ptr<mc::BufferStream> const underlying_buffer_stream;
+    // Keeps underlying_buffer_stream alive
+    std::shared_ptr<RenderState const> const state;
+    mc::BufferStream* const underlying_buffer_stream;
     std::shared_ptr<mg::Buffer> mutable compositor_buffer;
     void const*const compositor_id;
-    float const alpha_;
     geom::Rectangle const screen_position_;
-    std::experimental::optional<geom::Rectangle> const clip_area_;
-    glm::mat4 const transformation_;
-    mg::Renderable::ID const id_;
 };
-}
 
 int ms::BasicSurface::buffers_ready_for_compositor(void const* id) const
 {
@@ -918,6 +924,7 @@ void ms::BasicSurface::set_streams(std::list<scene::StreamInfo> const& s)
             layer.stream->set_frame_posted_callback([](auto){});
 
         layers = s;
+        render_state_.reset();
 
         for(auto& layer : layers)
             layer.stream->set_frame_posted_callback(
@@ -935,37 +942,56 @@ void ms::BasicSurface::set_streams(std::list<scene::StreamInfo> const& s)
 
 mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) const
 {
-    std::lock_guard<std::mutex> lock(guard);
-    mg::RenderableList list;
-    
-    if (clip_area_)
+    std::shared_ptr<RenderState const> state;
     {
-        if (!surface_rect.overlaps(clip_area_.value()))
-            return list;
+        std::lock_guard<std::mutex> lock(guard);
+
+        if (clip_area_)
+        {
+            if (!surface_rect.overlaps(clip_area_.value()))
+                return {};
+        }
+
+        state = render_state(lock);
     }
 
-    auto const content_top_left_ = content_top_left(lock);
+    mg::RenderableList list;
+    list.reserve(state->layers.size());
 
-    for (auto const& info : layers)
+    for (auto const& layer : state->layers)
     {
-        if (info.stream->has_submitted_buffer())
+        if (layer.stream->has_submitted_buffer())
         {
-            geom::Size size;
-            if (info.size.is_set())
-                size = info.size.value();
-            else
-                size = info.stream->stream_size();
+            geom::Size const size = layer.size.is_set() ? layer.size.value() : layer.stream->stream_size();
 
             list.emplace_back(std::make_shared<SurfaceSnapshot>(
-                info.stream, id,
-                geom::Rectangle{content_top_left_ + info.displacement, std::move(size)},
-                clip_area_,
-                transformation_matrix, surface_alpha, info.stream.get()));
+                state, layer, id, geom::Rectangle{layer.top_left, size}));
         }
     }
     return list;
 }
 
+auto ms::BasicSurface::render_state(ProofOfMutexLock const& lock) const -> std::shared_ptr<RenderState const>
+{
+    if (!render_state_)
+    {
+        auto const state = std::make_shared<RenderState>();
+        auto const content_top_left_ = content_top_left(lock);
+
+        state->layers.reserve(layers.size());
+        for (auto const& info : layers)
+            state->layers.push_back({info.stream, content_top_left_ + info.displacement, info.size});
+
+        state->clip_area = clip_area_;
+        state->transformation = transformation_matrix;
+        state->alpha = surface_alpha;
+
+        render_state_ = state;
+    }
+
+    return render_state_;
+}
+
 void ms::BasicSurface::set_confine_pointer_state(MirPointerConfinementState state)
 {
     std::lock_guard<std::mutex> lock(guard);
@@ -1013,6 +1039,7 @@ void mir::scene::BasicSurface::set_clip_area(std::experimental::optional<geom::R
 {
     std::lock_guard<std::mutex> lock(guard);
     clip_area_ = area;
+    render_state_.reset();
 }
 
 auto mir::scene::BasicSurface::focus_state() const -> MirWindowFocusState
@@ -1084,6 +1111,7 @@ void mir::scene::BasicSurface::set_window_margins(
         margins.left   = left;
         margins.bottom = bottom;
         margins.right  = right;
+        render_state_.reset();
 
         auto const size = content_size(lock);
         lock.unlock();
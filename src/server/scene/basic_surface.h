@@ -186,6 +186,10 @@ private:
     auto content_size(ProofOfMutexLock const&) const -> geometry::Size;
     auto content_top_left(ProofOfMutexLock const&) const -> geometry::Point;
 
+    struct RenderState;
+    class SurfaceSnapshot;
+    auto render_state(ProofOfMutexLock const&) const -> std::shared_ptr<RenderState const>;
+
     std::shared_ptr<SurfaceObservers> observers = std::make_shared<SurfaceObservers>();
     std::mutex mutable guard;
     std::string surface_name;
@@ -226,6 +230,9 @@ private:
         geometry::DeltaY bottom;
         geometry::DeltaX right;
     } margins;
+
+    /// Shared by the renderables of every frame until something that affects them changes
+    std::shared_ptr<RenderState const> mutable render_state_;
 };
 
 }
@@ -251,7 +251,7 @@ auto mir::DefaultServerConfiguration::the_application_not_responding_detector()
             using namespace std::literals::chrono_literals;
             return wrap_application_not_responding_detector(
                 std::make_shared<ms::TimeoutApplicationNotRespondingDetector>(
-                    *the_main_loop(), 1s));
+                    *the_alarm_factory(), 1s));
         });
 }
 
@@ -19,92 +19,100 @@
 #include "rendering_tracker.h"
 #include "mir/scene/surface.h"
 
-#include <algorithm>
-
 #include <stdexcept>
 #include <boost/throw_exception.hpp>
 
 namespace ms = mir::scene;
-namespace mc = mir::compositor;
+
+namespace
+{
+// Not a MirWindowVisibility, so the first visibility worked out is always published
+int const nothing_published{-1};
+}
 
 ms::RenderingTracker::RenderingTracker(
     std::weak_ptr<ms::Surface> const& weak_surface)
-    : weak_surface{weak_surface}
+    : weak_surface{weak_surface},
+      published{nothing_published}
 {
 }
 
-void ms::RenderingTracker::rendered_in(mc::CompositorID cid)
+bool ms::RenderingTracker::rendered_in(CompositorMask compositor)
 {
-    std::lock_guard<std::mutex> lock{guard};
-
-    ensure_is_active_compositor(cid);
+    ensure_is_active_compositor(compositor);
 
-    occlusions.erase(cid);
+    occlusions.fetch_and(~compositor);
+    exposures.fetch_or(compositor);
 
-    configure_visibility(mir_window_visibility_exposed);
+    return needs_publishing();
 }
 
-void ms::RenderingTracker::occluded_in(mc::CompositorID cid)
+bool ms::RenderingTracker::occluded_in(CompositorMask compositor)
 {
-    std::lock_guard<std::mutex> lock{guard};
+    ensure_is_active_compositor(compositor);
 
-    ensure_is_active_compositor(cid);
+    occlusions.fetch_or(compositor);
+    exposures.fetch_and(~compositor);
 
-    occlusions.insert(cid);
-
-    if (occluded_in_all_active_compositors())
-        configure_visibility(mir_window_visibility_occluded);
+    return needs_publishing();
 }
 
-void ms::RenderingTracker::active_compositors(std::set<mc::CompositorID> const& cids)
+void ms::RenderingTracker::active_compositors(CompositorMask compositors)
 {
-    std::lock_guard<std::mutex> lock{guard};
-
-    active_compositors_ = cids;
+    active_compositors_ = compositors;
 
-    remove_occlusions_for_inactive_compositors();
+    // Forget about compositors that are no longer active
+    occlusions.fetch_and(compositors);
+    exposures.fetch_and(compositors);
 
-    if (occluded_in_all_active_compositors())
-        configure_visibility(mir_window_visibility_occluded);
+    if (visibility() == mir_window_visibility_occluded)
+        publish_visibility();
 }
 
-bool ms::RenderingTracker::is_exposed_in(mc::CompositorID cid) const
+bool ms::RenderingTracker::is_exposed_in(CompositorMask compositor) const
 {
-    std::lock_guard<std::mutex> lock{guard};
-
-    ensure_is_active_compositor(cid);
-
-    if (occlusions.size() == 0)
-        return true;
+    ensure_is_active_compositor(compositor);
 
-    return occlusions.find(cid) == occlusions.end();
+    return (occlusions & compositor) == 0;
 }
 
-bool ms::RenderingTracker::occluded_in_all_active_compositors()
+void ms::RenderingTracker::publish_visibility()
 {
-    return occlusions == active_compositors_;
-}
+    std::lock_guard<std::mutex> lock{publish_guard};
+
+    // Clear this first: anything that changes after we've looked at the masks
+    // will need publishing again
+    publish_pending = false;
+
+    auto const current = visibility();
+    if (current == published)
+        return;
+
+    published = current;
 
-void ms::RenderingTracker::configure_visibility(MirWindowVisibility visibility)
-{
     if (auto const surface = weak_surface.lock())
-        surface->configure(mir_window_attrib_visibility, visibility);
+        surface->configure(mir_window_attrib_visibility, static_cast<MirWindowVisibility>(current));
 }
 
-void ms::RenderingTracker::remove_occlusions_for_inactive_compositors()
+int ms::RenderingTracker::visibility() const
 {
-    std::set<mc::CompositorID> new_occlusions;
+    if (occlusions == active_compositors_)
+        return mir_window_visibility_occluded;
+
+    if (exposures)
+        return mir_window_visibility_exposed;
 
-    std::set_intersection(
-        active_compositors_.begin(), active_compositors_.end(),
-        occlusions.begin(), occlusions.end(),
-        std::inserter(new_occlusions, new_occlusions.begin()));
+    // Occluded in some compositors but not yet drawn in any: nothing new to say
+    return published;
+}
 
-    occlusions = std::move(new_occlusions);
+bool ms::RenderingTracker::needs_publishing()
+{
+    return visibility() != published && !publish_pending.exchange(true);
 }
 
-void ms::RenderingTracker::ensure_is_active_compositor(compositor::CompositorID cid) const
+void ms::RenderingTracker::ensure_is_active_compositor(CompositorMask compositor) const
 {
-    if (active_compositors_.find(cid) == active_compositors_.end())
+    if (!compositor || (active_compositors_ & compositor) != compositor)
         BOOST_THROW_EXCEPTION(std::logic_error("No active compositor with supplied id"));
 }
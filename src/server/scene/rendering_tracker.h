@@ -19,10 +19,9 @@
 #ifndef MIR_SCENE_RENDERING_TRACKER_H_
 #define MIR_SCENE_RENDERING_TRACKER_H_
 
-#include "mir/compositor/compositor_id.h"
-
+#include <atomic>
+#include <cstdint>
 #include <memory>
-#include <set>
 #include <mutex>
 
 #include "mir_toolkit/common.h"
@@ -34,26 +33,45 @@ namespace scene
 
 class Surface;
 
+/**
+ * Works out a surface's visibility from what the compositors drew
+ *
+ * Each active compositor is identified by one bit of a CompositorMask, so
+ * rendered_in() and occluded_in() are a single atomic update that is cheap
+ * enough to call for every renderable on every frame. They don't tell the
+ * surface: when they return true the caller should arrange for
+ * publish_visibility() to be called once it is out of its compositing loop.
+ */
 class RenderingTracker
 {
 public:
+    using CompositorMask = std::uint64_t;
+
     RenderingTracker(std::weak_ptr<Surface> const& weak_surface);
 
-    void rendered_in(compositor::CompositorID cid);
-    void occluded_in(compositor::CompositorID cid);
-    void active_compositors(std::set<compositor::CompositorID> const& cids);
-    bool is_exposed_in(compositor::CompositorID cid) const;
+    /// \return true if publish_visibility() needs calling
+    bool rendered_in(CompositorMask compositor);
+    /// \return true if publish_visibility() needs calling
+    bool occluded_in(CompositorMask compositor);
+    void active_compositors(CompositorMask compositors);
+    bool is_exposed_in(CompositorMask compositor) const;
+
+    /// Configures the surface's visibility, if that has changed since it was last published
+    void publish_visibility();
 
 private:
-    bool occluded_in_all_active_compositors();
-    void configure_visibility(MirWindowVisibility visibility);
-    void remove_occlusions_for_inactive_compositors();
-    void ensure_is_active_compositor(compositor::CompositorID cid) const;
+    int visibility() const;
+    bool needs_publishing();
+    void ensure_is_active_compositor(CompositorMask compositor) const;
 
     std::weak_ptr<Surface> const weak_surface;
-    std::set<compositor::CompositorID> occlusions;
-    std::set<compositor::CompositorID> active_compositors_;
-    std::mutex mutable guard;
+    std::atomic<CompositorMask> occlusions{0};
+    std::atomic<CompositorMask> exposures{0};
+    std::atomic<CompositorMask> active_compositors_{0};
+
+    std::mutex publish_guard;
+    std::atomic<int> published;
+    std::atomic<bool> publish_pending{false};
 };
 
 }
@@ -20,7 +20,7 @@
 
 #include <boost/throw_exception.hpp>
 
-#include <algorithm>
+#include <iterator>
 #include <stdexcept>
 
 namespace ms = mir::scene;
@@ -32,17 +32,19 @@ void ms::SessionContainer::insert_session(std::shared_ptr<Session> const& sessio
 {
     std::unique_lock<std::mutex> lk(guard);
 
-    apps.push_back(session);
+    if (index.find(session.get()) == index.end())
+        index[session.get()] = apps.insert(apps.end(), session);
 }
 
 void ms::SessionContainer::remove_session(std::shared_ptr<Session> const& session)
 {
     std::unique_lock<std::mutex> lk(guard);
 
-    auto it = std::find(apps.begin(), apps.end(), session);
-    if (it != apps.end())
+    auto it = index.find(session.get());
+    if (it != index.end())
     {
-        apps.erase(it);
+        apps.erase(it->second);
+        index.erase(it);
     }
     else
     {
@@ -54,7 +56,7 @@ void ms::SessionContainer::for_each(std::function<void(std::shared_ptr<Session>
 {
     std::unique_lock<std::mutex> lk(guard);
 
-    for (auto const ptr : apps)
+    for (auto const& ptr : apps)
     {
         f(ptr);
     }
@@ -63,47 +65,30 @@ void ms::SessionContainer::for_each(std::function<void(std::shared_ptr<Session>
 auto ms::SessionContainer::successor_of(std::shared_ptr<Session> const& session) const
     -> std::shared_ptr<ms::Session>
 {
-    std::shared_ptr<Session> result, first;
-
     if (!session && apps.size())
         return apps.back();
     else if(!session)
         return std::shared_ptr<Session>();
 
-    for (auto it = apps.begin(); it != apps.end(); it++)
-    {
-        if (*it == session)
-        {
-            auto successor = ++it;
-            if (successor == apps.end())
-                return *apps.begin();
-            else return *successor;
-        }
-    }
+    auto const found = index.find(session.get());
+    if (found == index.end())
+        BOOST_THROW_EXCEPTION(std::logic_error("Invalid session"));
 
-    BOOST_THROW_EXCEPTION(std::logic_error("Invalid session"));
+    auto const successor = std::next(found->second);
+    return successor == apps.end() ? apps.front() : *successor;
 }
 
 auto mir::scene::SessionContainer::predecessor_of(std::shared_ptr<Session> const& session) const
     -> std::shared_ptr<Session>
 {
-    std::shared_ptr<Session> result, first;
-
     if (!session && apps.size())
         return apps.front();
     else if(!session)
         return std::shared_ptr<Session>();
 
-    for (auto it = apps.rbegin(); it != apps.rend(); it++)
-    {
-        if (*it == session)
-        {
-            auto successor = ++it;
-            if (successor == apps.rend())
-                return *apps.rbegin();
-            else return *successor;
-        }
-    }
+    auto const found = index.find(session.get());
+    if (found == index.end())
+        BOOST_THROW_EXCEPTION(std::logic_error("Invalid session"));
 
-    BOOST_THROW_EXCEPTION(std::logic_error("Invalid session"));
+    return found->second == apps.begin() ? apps.back() : *std::prev(found->second);
 }
@@ -44,18 +44,43 @@ namespace geom = mir::geometry;
 namespace
 {
 
+/**
+ * The visibility changes found while compositing one SceneElementSequence
+ *
+ * They are published when the compositor releases the sequence, after it has
+ * finished drawing, rather than from inside its loop over the elements. Like
+ * the sequence itself, this is only used by one compositor thread.
+ */
+class VisibilityUpdates
+{
+public:
+    ~VisibilityUpdates()
+    {
+        for (auto const& tracker : pending)
+            tracker->publish_visibility();
+    }
+
+    void add(std::shared_ptr<ms::RenderingTracker> const& tracker)
+    {
+        pending.push_back(tracker);
+    }
+
+private:
+    std::vector<std::shared_ptr<ms::RenderingTracker>> pending;
+};
+
 class SurfaceSceneElement : public mc::SceneElement
 {
 public:
     SurfaceSceneElement(
-        std::string name,
         std::shared_ptr<mg::Renderable> const& renderable,
         std::shared_ptr<ms::RenderingTracker> const& tracker,
-        mc::CompositorID id)
+        ms::RenderingTracker::CompositorMask compositor,
+        std::shared_ptr<VisibilityUpdates> const& updates)
         : renderable_{renderable},
           tracker{tracker},
-          cid{id},
-          surface_name(name)
+          compositor{compositor},
+          updates{updates}
     {
     }
 
@@ -66,21 +91,31 @@ public:
 
     void rendered() override
     {
-        tracker->rendered_in(cid);
+        if (tracker->rendered_in(compositor))
+            updates->add(tracker);
     }
 
     void occluded() override
     {
-        tracker->occluded_in(cid);
+        if (tracker->occluded_in(compositor))
+            updates->add(tracker);
     }
 
 private:
     std::shared_ptr<mg::Renderable> const renderable_;
     std::shared_ptr<ms::RenderingTracker> const tracker;
-    mc::CompositorID cid;
-    std::string const surface_name;
+    ms::RenderingTracker::CompositorMask const compositor;
+    std::shared_ptr<VisibilityUpdates> const updates;
 };
 
+auto compositor_mask(
+    std::map<mc::CompositorID, ms::RenderingTracker::CompositorMask> const& compositors,
+    mc::CompositorID id) -> ms::RenderingTracker::CompositorMask
+{
+    auto const i = compositors.find(id);
+    return i != compositors.end() ? i->second : 0;
+}
+
 //note: something different than a 2D/HWC overlay
 class OverlaySceneElement : public mc::SceneElement
 {
@@ -133,6 +168,7 @@ private:
 ms::SurfaceStack::SurfaceStack(
     std::shared_ptr<SceneReport> const& report) :
     report{report},
+    snapshot{std::make_shared<Snapshot>()},
     scene_changed{false},
     surface_observer{std::make_shared<SurfaceDepthLayerObserver>(this)}
 {
@@ -140,7 +176,7 @@ ms::SurfaceStack::SurfaceStack(
 
 ms::SurfaceStack::~SurfaceStack() noexcept(true)
 {
-    RecursiveWriteLock lg(guard);
+    std::lock_guard<std::mutex> lg(guard);
     for (auto const& layer : surface_layers)
     {
         for (auto const& surface : layer)
@@ -150,31 +186,36 @@ ms::SurfaceStack::~SurfaceStack() noexcept(true)
     }
 }
 
+auto ms::SurfaceStack::current_snapshot() const -> std::shared_ptr<Snapshot const>
+{
+    return std::atomic_load(&snapshot);
+}
+
 mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID id)
 {
-    RecursiveReadLock lg(guard);
+    auto const current = current_snapshot();
+    auto const compositor = compositor_mask(current->compositors, id);
+    auto const updates = std::make_shared<VisibilityUpdates>();
 
     scene_changed = false;
     mc::SceneElementSequence elements;
-    for (auto const& layer : surface_layers)
+    elements.reserve(current->render_list.size() + current->overlays.size());
+    for (auto const& entry : current->render_list)
     {
-        for (auto const& surface : layer)
+        if (entry.surface->visible())
         {
-            if (surface->visible())
+            for (auto& renderable : entry.surface->generate_renderables(id))
             {
-                for (auto& renderable : surface->generate_renderables(id))
-                {
-                    elements.emplace_back(
-                        std::make_shared<SurfaceSceneElement>(
-                            surface->name(),
-                            renderable,
-                            rendering_trackers[surface.get()],
-                            id));
-                }
+                elements.emplace_back(
+                    std::make_shared<SurfaceSceneElement>(
+                        renderable,
+                        entry.tracker,
+                        compositor,
+                        updates));
             }
         }
     }
-    for (auto const& renderable : overlays)
+    for (auto const& renderable : current->overlays)
     {
         elements.emplace_back(std::make_shared<OverlaySceneElement>(renderable));
     }
@@ -183,26 +224,20 @@ mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID i
 
 int ms::SurfaceStack::frames_pending(mc::CompositorID id) const
 {
-    RecursiveReadLock lg(guard);
+    auto const current = current_snapshot();
+    auto const compositor = compositor_mask(current->compositors, id);
 
     int result = scene_changed ? 1 : 0;
-    for (auto const& layer : surface_layers)
+    for (auto const& entry : current->render_list)
     {
-        for (auto const& surface : layer)
+        if (entry.surface->visible() && entry.tracker->is_exposed_in(compositor))
         {
-            if (surface->visible())
-            {
-                auto const tracker = rendering_trackers.find(surface.get());
-                if (tracker != rendering_trackers.end() && tracker->second->is_exposed_in(id))
-                {
-                    // Note that we ask the surface and not a Renderable.
-                    // This is because we don't want to waste time and resources
-                    // on a snapshot till we're sure we need it...
-                    int ready = surface->buffers_ready_for_compositor(id);
-                    if (ready > result)
-                        result = ready;
-                }
-            }
+            // Note that we ask the surface and not a Renderable.
+            // This is because we don't want to waste time and resources
+            // on a snapshot till we're sure we need it...
+            int ready = entry.surface->buffers_ready_for_compositor(id);
+            if (ready > result)
+                result = ready;
         }
     }
     return result;
@@ -210,28 +245,39 @@ int ms::SurfaceStack::frames_pending(mc::CompositorID id) const
 
 void ms::SurfaceStack::register_compositor(mc::CompositorID cid)
 {
-    RecursiveWriteLock lg(guard);
+    std::lock_guard<std::mutex> lg(guard);
+
+    if (registered_compositors.count(cid))
+        return;
+
+    auto const active = active_compositors();
+    if (!~active)
+        BOOST_THROW_EXCEPTION(std::runtime_error("Too many compositors registered with the scene"));
 
-    registered_compositors.insert(cid);
+    // The lowest bit not yet used by another compositor
+    registered_compositors[cid] = ~active & (active + 1);
 
     update_rendering_tracker_compositors();
+    publish_snapshot();
 }
 
 void ms::SurfaceStack::unregister_compositor(mc::CompositorID cid)
 {
-    RecursiveWriteLock lg(guard);
+    std::lock_guard<std::mutex> lg(guard);
 
     registered_compositors.erase(cid);
 
     update_rendering_tracker_compositors();
+    publish_snapshot();
 }
 
 void ms::SurfaceStack::add_input_visualization(
     std::shared_ptr<mg::Renderable> const& overlay)
 {
     {
-        RecursiveWriteLock lg(guard);
+        std::lock_guard<std::mutex> lg(guard);
         overlays.push_back(overlay);
+        publish_snapshot();
     }
     emit_scene_changed();
 }
@@ -241,13 +287,14 @@ void ms::SurfaceStack::remove_input_visualization(
 {
     auto overlay = weak_overlay.lock();
     {
-        RecursiveWriteLock lg(guard);
+        std::lock_guard<std::mutex> lg(guard);
         auto const p = std::find(overlays.begin(), overlays.end(), overlay);
         if (p == overlays.end())
         {
             BOOST_THROW_EXCEPTION(std::runtime_error("Attempt to remove an overlay which was never added or which has been previously removed"));
         }
         overlays.erase(p);
+        publish_snapshot();
     }
     
     emit_scene_changed();
@@ -255,10 +302,7 @@ void ms::SurfaceStack::remove_input_visualization(
 
 void ms::SurfaceStack::emit_scene_changed()
 {
-    {
-        RecursiveWriteLock lg(guard);
-        scene_changed = true;
-    }
+    scene_changed = true;
     observers.scene_changed();
 }
 
@@ -267,10 +311,11 @@ void ms::SurfaceStack::add_surface(
     mi::InputReceptionMode input_mode)
 {
     {
-        RecursiveWriteLock lg(guard);
+        std::lock_guard<std::mutex> lg(guard);
         insert_surface_at_top_of_depth_layer(surface);
         create_rendering_tracker_for(surface);
         surface->add_observer(surface_observer);
+        publish_snapshot();
     }
     surface->set_reception_mode(input_mode);
     observers.surface_added(surface);
@@ -284,7 +329,7 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
 
     bool found_surface = false;
     {
-        RecursiveWriteLock lg(guard);
+        std::lock_guard<std::mutex> lg(guard);
 
         for (auto& layer : surface_layers)
         {
@@ -295,6 +340,7 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
                 layer.erase(surface);
                 rendering_trackers.erase(keep_alive.get());
                 keep_alive->remove_observer(surface_observer);
+                publish_snapshot();
                 found_surface = true;
                 break;
             }
@@ -325,18 +371,15 @@ InReverse<Container> in_reverse(Container& container) { return InReverse<Contain
 auto ms::SurfaceStack::surface_at(geometry::Point cursor) const
 -> std::shared_ptr<Surface>
 {
-    RecursiveReadLock lg(guard);
-    for (auto const& layer : in_reverse(surface_layers))
+    auto const current = current_snapshot();
+    for (auto const& entry : in_reverse(current->render_list))
     {
-        for (auto const& surface : in_reverse(layer))
-        {
-            // TODO There's a lack of clarity about how the input area will
-            // TODO be maintained and whether this test will detect clicks on
-            // TODO decorations (it should) as these may be outside the area
-            // TODO known to the client.  But it works for now.
-            if (surface->input_area_contains(cursor))
-                    return surface;
-        }
+        // TODO There's a lack of clarity about how the input area will
+        // TODO be maintained and whether this test will detect clicks on
+        // TODO decorations (it should) as these may be outside the area
+        // TODO known to the client.  But it works for now.
+        if (entry.surface->input_area_contains(cursor))
+                return entry.surface;
     }
 
     return {};
@@ -344,13 +387,10 @@ auto ms::SurfaceStack::surface_at(geometry::Point cursor) const
 
 void ms::SurfaceStack::for_each(std::function<void(std::shared_ptr<mi::Surface> const&)> const& callback)
 {
-    RecursiveReadLock lg(guard);
-    for (auto const& layer : surface_layers)
+    auto const current = current_snapshot();
+    for (auto const& entry : current->render_list)
     {
-        for (auto const& surface : layer)
-        {
-            callback(surface);
-        }
+        callback(entry.surface);
     }
 }
 
@@ -359,7 +399,7 @@ void ms::SurfaceStack::raise(Surface const* surface)
     bool surfaces_reordered{false};
 
     {
-        RecursiveWriteLock ul(guard);
+        std::lock_guard<std::mutex> ul(guard);
         for (auto& layer : surface_layers)
         {
             auto const p = std::find_if(
@@ -375,6 +415,7 @@ void ms::SurfaceStack::raise(Surface const* surface)
                 std::shared_ptr<Surface> surface_shared = *p;
                 layer.erase(p);
                 insert_surface_at_top_of_depth_layer(surface_shared);
+                publish_snapshot();
                 surfaces_reordered = true;
                 break;
             }
@@ -396,7 +437,7 @@ void ms::SurfaceStack::raise(SurfaceSet const& ss)
 {
     bool surfaces_reordered{false};
     {
-        RecursiveWriteLock ul(guard);
+        std::lock_guard<std::mutex> ul(guard);
         for (auto& layer : surface_layers)
         {
             auto const old_layer = layer;
@@ -421,6 +462,9 @@ void ms::SurfaceStack::raise(SurfaceSet const& ss)
             if (old_layer != layer)
                 surfaces_reordered = true;
         }
+
+        if (surfaces_reordered)
+            publish_snapshot();
     }
 
     if (surfaces_reordered)
@@ -431,17 +475,26 @@ void ms::SurfaceStack::create_rendering_tracker_for(std::shared_ptr<Surface> con
 {
     auto const tracker = std::make_shared<RenderingTracker>(surface);
 
-    RecursiveWriteLock ul(guard);
-    tracker->active_compositors(registered_compositors);
+    tracker->active_compositors(active_compositors());
     rendering_trackers[surface.get()] = tracker;
 }
 
 void ms::SurfaceStack::update_rendering_tracker_compositors()
 {
-    RecursiveReadLock ul(guard);
+    auto const active = active_compositors();
 
     for (auto const& pair : rendering_trackers)
-        pair.second->active_compositors(registered_compositors);
+        pair.second->active_compositors(active);
+}
+
+auto ms::SurfaceStack::active_compositors() const -> RenderingTracker::CompositorMask
+{
+    RenderingTracker::CompositorMask active{0};
+
+    for (auto const& compositor : registered_compositors)
+        active |= compositor.second;
+
+    return active;
 }
 
 void ms::SurfaceStack::insert_surface_at_top_of_depth_layer(std::shared_ptr<Surface> const& surface)
@@ -452,18 +505,30 @@ void ms::SurfaceStack::insert_surface_at_top_of_depth_layer(std::shared_ptr<Surf
     surface_layers[depth_index].push_back(surface);
 }
 
+void ms::SurfaceStack::publish_snapshot()
+{
+    auto const next = std::make_shared<Snapshot>();
+
+    for (auto const& layer : surface_layers)
+    {
+        for (auto const& surface : layer)
+            next->render_list.push_back({surface, rendering_trackers.at(surface.get())});
+    }
+    next->overlays = overlays;
+    next->compositors = registered_compositors;
+
+    std::atomic_store(&snapshot, std::shared_ptr<Snapshot const>{next});
+}
+
 void ms::SurfaceStack::add_observer(std::shared_ptr<ms::Observer> const& observer)
 {
     observers.add(observer);
 
     // Notify observer of existing surfaces
-    RecursiveReadLock lk(guard);
-    for (auto const& layer : surface_layers)
+    auto const current = current_snapshot();
+    for (auto const& entry : current->render_list)
     {
-        for (auto const& surface : layer)
-        {
-            observer->surface_exists(surface);
-        }
+        observer->surface_exists(entry.surface);
     }
 }
 
@@ -25,16 +25,15 @@
 #include "mir/compositor/scene.h"
 #include "mir/scene/observer.h"
 #include "mir/input/scene.h"
-#include "mir/recursive_read_write_mutex.h"
 
 #include "mir/basic_observers.h"
 #include "mir/scene/surface_observer.h"
+#include "rendering_tracker.h"
 
 #include <atomic>
 #include <map>
 #include <memory>
 #include <mutex>
-#include <set>
 #include <vector>
 
 namespace mir
@@ -49,7 +48,6 @@ namespace scene
 {
 class BasicSurface;
 class SceneReport;
-class RenderingTracker;
 
 class Observers : public Observer, BasicObservers<Observer>
 {
@@ -112,9 +110,12 @@ private:
     SurfaceStack& operator=(const SurfaceStack&) = delete;
     void create_rendering_tracker_for(std::shared_ptr<Surface> const&);
     void update_rendering_tracker_compositors();
+    auto active_compositors() const -> RenderingTracker::CompositorMask;
     void insert_surface_at_top_of_depth_layer(std::shared_ptr<Surface> const& surface);
+    void publish_snapshot();
 
-    RecursiveReadWriteMutex mutable guard;
+    /// Serialises changes to the stack; readers use the published snapshot instead
+    std::mutex mutable guard;
 
     std::shared_ptr<SceneReport> const report;
 
@@ -127,10 +128,36 @@ private:
      */
     std::vector<std::vector<std::shared_ptr<Surface>>> surface_layers;
     std::map<Surface*,std::shared_ptr<RenderingTracker>> rendering_trackers;
-    std::set<compositor::CompositorID> registered_compositors;
-    
+    /// Each registered compositor's bit in the RenderingTracker masks
+    std::map<compositor::CompositorID, RenderingTracker::CompositorMask> registered_compositors;
+
     std::vector<std::shared_ptr<graphics::Renderable>> overlays;
 
+    struct RenderListEntry
+    {
+        std::shared_ptr<Surface> surface;
+        std::shared_ptr<RenderingTracker> tracker;
+    };
+
+    /**
+     * An immutable copy of what the compositor and input need from the stack
+     *
+     * A new Snapshot is published whenever the stack changes, so readers
+     * neither take the guard nor wait for writers: they just keep hold of
+     * whichever snapshot was current when they started.
+     */
+    struct Snapshot
+    {
+        /// surface_layers flattened bottom to top, with each surface's tracker
+        std::vector<RenderListEntry> render_list;
+        std::vector<std::shared_ptr<graphics::Renderable>> overlays;
+        std::map<compositor::CompositorID, RenderingTracker::CompositorMask> compositors;
+    };
+
+    /// Only accessed through std::atomic_load() and std::atomic_store()
+    std::shared_ptr<Snapshot const> snapshot;
+    auto current_snapshot() const -> std::shared_ptr<Snapshot const>;
+
     Observers observers;
     std::atomic<bool> scene_changed;
     std::shared_ptr<SurfaceObserver> surface_observer;
@@ -20,22 +20,68 @@
 #include "mir/scene/session.h"
 
 #include "mir/time/alarm_factory.h"
+#include "mir/lockable_callback.h"
 
 namespace ms = mir::scene;
 namespace mt = mir::time;
 
 struct ms::TimeoutApplicationNotRespondingDetector::ANRContext
 {
-    ANRContext(std::function<void()> const& pinger)
+    ANRContext(std::function<void()> const& pinger, std::unique_ptr<mt::Alarm> alarm)
         : pinger{pinger},
           replied_since_last_ping{true},
-          flagged_as_unresponsive{false}
+          flagged_as_unresponsive{false},
+          alarm{std::move(alarm)}
     {
     }
 
     std::function<void()> const pinger;
     bool replied_since_last_ping;
     bool flagged_as_unresponsive;
+    std::unique_ptr<mt::Alarm> const alarm;
+};
+
+/*
+ * Each session runs its ping cycle on its own alarm, so pings are spread across
+ * the period according to when sessions connected rather than sent in one burst.
+ *
+ * The alarm holds session_mutex while dispatching so that destroying a session's
+ * alarm under that lock cannot deadlock against a ping in flight; observers are
+ * notified once the lock has been released.
+ */
+class ms::TimeoutApplicationNotRespondingDetector::PingCallback : public LockableCallback
+{
+public:
+    PingCallback(TimeoutApplicationNotRespondingDetector* detector, Session const* session)
+        : detector{detector},
+          session{session}
+    {
+    }
+
+    void operator()() override
+    {
+        became_unresponsive = detector->handle_ping_cycle(session);
+    }
+
+    void lock() override
+    {
+        detector->session_mutex.lock();
+    }
+
+    void unlock() override
+    {
+        bool const needs_unresponsive_notification{became_unresponsive};
+        became_unresponsive = false;
+        detector->session_mutex.unlock();
+
+        if (needs_unresponsive_notification)
+            detector->observers.session_unresponsive(session);
+    }
+
+private:
+    TimeoutApplicationNotRespondingDetector* const detector;
+    Session const* const session;
+    bool became_unresponsive{false};
 };
 
 void ms::TimeoutApplicationNotRespondingDetector::ANRObservers::session_unresponsive(
@@ -53,8 +99,8 @@ void ms::TimeoutApplicationNotRespondingDetector::ANRObservers::session_now_resp
 ms::TimeoutApplicationNotRespondingDetector::TimeoutApplicationNotRespondingDetector(
     mt::AlarmFactory& alarms,
     std::chrono::milliseconds period)
-    : period{period},
-      alarm{alarms.create_alarm(std::bind(&TimeoutApplicationNotRespondingDetector::handle_ping_cycle, this))}
+    : alarms{alarms},
+      period{period}
 {
 }
 
@@ -65,34 +111,30 @@ ms::TimeoutApplicationNotRespondingDetector::~TimeoutApplicationNotRespondingDet
 void ms::TimeoutApplicationNotRespondingDetector::register_session(
     scene::Session const* session, std::function<void()> const& pinger)
 {
-    bool alarm_needs_schedule;
-    {
-        std::lock_guard<std::mutex> lock{session_mutex};
-        sessions[dynamic_cast<Session const*>(session)] = std::make_unique<ANRContext>(pinger);
-        alarm_needs_schedule = alarm->state() != mt::Alarm::State::pending;
-    }
-    if (alarm_needs_schedule)
-    {
-        alarm->reschedule_in(period);
-    }
+    std::lock_guard<std::mutex> lock{session_mutex};
+
+    auto& session_ctx = sessions[session];
+    session_ctx = std::make_unique<ANRContext>(
+        pinger,
+        alarms.create_alarm(std::make_unique<PingCallback>(this, session)));
+    session_ctx->alarm->reschedule_in(period);
 }
 
 void ms::TimeoutApplicationNotRespondingDetector::unregister_session(
     scene::Session const* session)
 {
     std::lock_guard<std::mutex> lock{session_mutex};
-    sessions.erase(dynamic_cast<Session const*>(session));
+    sessions.erase(session);
 }
 
 void ms::TimeoutApplicationNotRespondingDetector::pong_received(
    scene::Session const* received_for)
 {
     bool needs_now_responsive_notification{false};
-    bool alarm_needs_rescheduling;
     {
         std::lock_guard<std::mutex> lock{session_mutex};
 
-        auto& session_ctx = sessions.at(dynamic_cast<Session const*>(received_for));
+        auto& session_ctx = sessions.at(received_for);
         if (session_ctx->flagged_as_unresponsive)
         {
             session_ctx->flagged_as_unresponsive = false;
@@ -100,15 +142,14 @@ void ms::TimeoutApplicationNotRespondingDetector::pong_received(
         }
         session_ctx->replied_since_last_ping = true;
 
-        alarm_needs_rescheduling = alarm->state() != mt::Alarm::State::pending;
+        if (session_ctx->alarm->state() != mt::Alarm::State::pending)
+        {
+            session_ctx->alarm->reschedule_in(period);
+        }
     }
     if (needs_now_responsive_notification)
     {
-        observers.session_now_responsive(dynamic_cast<Session const*>(received_for));
-    }
-    if (alarm_needs_rescheduling)
-    {
-        alarm->reschedule_in(period);
+        observers.session_now_responsive(received_for);
     }
 }
 
@@ -141,43 +182,25 @@ void ms::TimeoutApplicationNotRespondingDetector::unregister_observer(
     observers.remove(observer);
 }
 
-void ms::TimeoutApplicationNotRespondingDetector::handle_ping_cycle()
+// Called with session_mutex held; returns true if the session has just become unresponsive
+bool ms::TimeoutApplicationNotRespondingDetector::handle_ping_cycle(Session const* session)
 {
-    bool needs_rearm{false};
-    {
-        std::lock_guard<std::mutex> lock{session_mutex};
-        for (auto const& session_pair : sessions)
-        {
-            bool const newly_unresponsive =
-                !session_pair.second->replied_since_last_ping &&
-                !session_pair.second->flagged_as_unresponsive;
-            bool const needs_ping =
-                session_pair.second->replied_since_last_ping;
+    auto const found = sessions.find(session);
+    if (found == sessions.end())
+        return false;
 
-            if (newly_unresponsive)
-            {
-                session_pair.second->flagged_as_unresponsive = true;
-                unresponsive_sessions_temporary.push_back(session_pair.first);
-            }
-            else if (needs_ping)
-            {
-                session_pair.second->pinger();
-                session_pair.second->replied_since_last_ping = false;
-                needs_rearm = true;
-            }
-        }
-    }
+    auto& session_ctx = *found->second;
 
-    // Dispatch notifications outside the lock.
-    for (auto const& unresponsive_session : unresponsive_sessions_temporary)
+    if (!session_ctx.replied_since_last_ping)
     {
-        observers.session_unresponsive(unresponsive_session);
+        // Once flagged we stop pinging until the session pongs, which rearms the alarm
+        bool const newly_unresponsive{!session_ctx.flagged_as_unresponsive};
+        session_ctx.flagged_as_unresponsive = true;
+        return newly_unresponsive;
     }
 
-    unresponsive_sessions_temporary.clear();
-
-    if (needs_rearm)
-    {
-        this->alarm->reschedule_in(this->period);
-    }
+    session_ctx.pinger();
+    session_ctx.replied_since_last_ping = false;
+    session_ctx.alarm->reschedule_in(period);
+    return false;
 }
@@ -64,9 +64,10 @@ public:
     void register_observer(std::shared_ptr<Observer> const& observer) override;
     void unregister_observer(std::shared_ptr<Observer> const& observer) override;
 private:
-    void handle_ping_cycle();
+    bool handle_ping_cycle(Session const* session);
 
     struct ANRContext;
+    class PingCallback;
 
     class ANRObservers : public Observer, private BasicObservers<Observer>
     {
@@ -80,10 +81,9 @@ private:
 
     std::mutex session_mutex;
     std::unordered_map<Session const*, std::unique_ptr<ANRContext>> sessions;
-    std::vector<Session const*> unresponsive_sessions_temporary;
 
+    time::AlarmFactory& alarms;
     std::chrono::milliseconds const period;
-    std::unique_ptr<time::Alarm> const alarm;
 };
 }
 }
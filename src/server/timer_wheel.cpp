@@ -0,0 +1,449 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/time/timer_wheel.h"
+#include "mir/time/alarm.h"
+#include "mir/time/clock.h"
+#include "mir/graphics/event_handler_register.h"
+#include "mir/basic_callback.h"
+#include "mir/lockable_callback.h"
+#include "mir/fd.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <system_error>
+#include <vector>
+
+namespace mt = mir::time;
+
+namespace
+{
+// Four levels of 64 slots; at the default 1ms tick the wheel spans ~4.6 hours
+// before far-future alarms need to be re-cascaded from the top level.
+unsigned const bits_per_level{6};
+unsigned const levels{4};
+uint64_t const slots_per_level{uint64_t{1} << bits_per_level};
+uint64_t const slot_mask{slots_per_level - 1};
+uint64_t const wheel_span{uint64_t{1} << (bits_per_level * levels)};
+uint64_t const never{std::numeric_limits<uint64_t>::max()};
+
+struct Timer : std::enable_shared_from_this<Timer>
+{
+    explicit Timer(std::unique_ptr<mir::LockableCallback> callback)
+        : callback{std::move(callback)}
+    {
+    }
+
+    void fire(uint64_t scheduled_generation)
+    {
+        // Attempt to preserve locking order during callback dispatching
+        // so we acquire the caller's lock before our own.
+        auto& handler = *callback;
+        std::lock_guard<mir::LockableCallback> handler_lock{handler};
+        std::lock_guard<decltype(dispatch_mutex)> dispatch_lock{dispatch_mutex};
+        {
+            std::lock_guard<decltype(state_mutex)> lock{state_mutex};
+            if (state != mt::Alarm::pending || generation != scheduled_generation)
+                return;
+            state = mt::Alarm::triggered;
+        }
+        handler();
+    }
+
+    std::unique_ptr<mir::LockableCallback> const callback;
+
+    // Held across dispatch so cancellation and destruction can guarantee the
+    // callback is not (and will not subsequently be) running on another thread.
+    std::recursive_mutex dispatch_mutex;
+
+    std::mutex mutable state_mutex;
+    mt::Alarm::State state{mt::Alarm::cancelled};
+    uint64_t generation{0};
+
+    // Wheel bookkeeping; protected by the wheel's mutex
+    Timer* prev{nullptr};
+    Timer* next{nullptr};
+    uint64_t expiry{0};
+    uint64_t linked_generation{0};
+    unsigned level{0};
+    unsigned slot{0};
+    bool linked{false};
+};
+
+using Expired = std::vector<std::pair<std::shared_ptr<Timer>, uint64_t>>;
+
+auto rotate_right(uint64_t bits, unsigned shift) -> uint64_t
+{
+    shift &= 63;
+    return shift ? (bits >> shift) | (bits << (64 - shift)) : bits;
+}
+}
+
+class mt::TimerWheel::Wheel
+{
+public:
+    Wheel(
+        std::shared_ptr<graphics::EventHandlerRegister> const& event_register,
+        std::shared_ptr<Clock> const& clock,
+        std::chrono::milliseconds tick)
+        : event_register{event_register},
+          clock{clock},
+          tick{std::chrono::duration_cast<Duration>(tick)},
+          origin{clock->now()},
+          timer_fd{timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)}
+    {
+        if (timer_fd < 0)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{
+                errno, std::system_category(), "Failed to create timerfd for alarms"}));
+        }
+        if (this->tick <= Duration::zero())
+            BOOST_THROW_EXCEPTION((std::invalid_argument{"Timer wheel tick must be positive"}));
+    }
+
+    ~Wheel()
+    {
+        event_register->unregister_fd_handler(this);
+    }
+
+    // Outstanding alarms keep the wheel alive, so the timerfd stays registered
+    // until both the factory and every alarm it created have gone.
+    static void register_with(std::shared_ptr<Wheel> const& wheel)
+    {
+        std::weak_ptr<Wheel> const weak_wheel{wheel};
+
+        wheel->event_register->register_fd_handler(
+            {wheel->timer_fd},
+            wheel.get(),
+            [weak_wheel](int)
+            {
+                if (auto const wheel = weak_wheel.lock())
+                    wheel->dispatch_expired();
+            });
+    }
+
+    void schedule(Timer& timer, uint64_t generation, Timestamp deadline)
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+
+        if (timer.linked)
+            unlink(timer);
+
+        timer.expiry = std::max(tick_for(deadline), current_tick + 1);
+        timer.linked_generation = generation;
+        link(timer);
+
+        if (timer.expiry < armed_tick)
+            arm_timerfd();
+    }
+
+    void cancel(Timer& timer)
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+
+        // We leave the timerfd armed; a spurious wakeup is cheaper than
+        // recalculating the next deadline on every cancellation.
+        if (timer.linked)
+            unlink(timer);
+    }
+
+    void dispatch_expired()
+    {
+        uint64_t expirations;
+        if (read(timer_fd, &expirations, sizeof expirations) < 0 && errno != EAGAIN)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{
+                errno, std::system_category(), "Failed to read alarm timerfd"}));
+        }
+
+        Expired expired;
+        {
+            std::lock_guard<decltype(mutex)> lock{mutex};
+            advance_to(ticks_elapsed(clock->now()), expired);
+            armed_tick = never;
+            arm_timerfd();
+        }
+
+        std::exception_ptr error;
+        for (auto const& timer : expired)
+        {
+            try
+            {
+                timer.first->fire(timer.second);
+            }
+            catch (...)
+            {
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+private:
+    auto tick_for(Timestamp deadline) const -> uint64_t
+    {
+        if (deadline <= origin)
+            return 0;
+        return (deadline - origin + tick - Duration{1}) / tick;
+    }
+
+    auto ticks_elapsed(Timestamp now) const -> uint64_t
+    {
+        if (now <= origin)
+            return 0;
+        return (now - origin) / tick;
+    }
+
+    void link(Timer& timer)
+    {
+        auto const delta = timer.expiry - current_tick;
+
+        unsigned level = 0;
+        while (level + 1 < levels && delta >= (uint64_t{1} << (bits_per_level * (level + 1))))
+            ++level;
+
+        // Deadlines beyond the span of the wheel are parked in the furthest
+        // top-level slot and placed again when that slot is cascaded.
+        auto const placement = delta < wheel_span ? timer.expiry : current_tick + wheel_span - 1;
+
+        timer.level = level;
+        timer.slot = (placement >> (bits_per_level * level)) & slot_mask;
+
+        auto& head = slots[timer.level][timer.slot];
+        timer.prev = nullptr;
+        timer.next = head;
+        if (head)
+            head->prev = &timer;
+        head = &timer;
+        timer.linked = true;
+
+        occupied[timer.level] |= uint64_t{1} << timer.slot;
+    }
+
+    void unlink(Timer& timer)
+    {
+        auto& head = slots[timer.level][timer.slot];
+        if (timer.prev)
+            timer.prev->next = timer.next;
+        else
+            head = timer.next;
+        if (timer.next)
+            timer.next->prev = timer.prev;
+
+        if (!head)
+            occupied[timer.level] &= ~(uint64_t{1} << timer.slot);
+
+        timer.prev = timer.next = nullptr;
+        timer.linked = false;
+    }
+
+    /// The next tick at which a level-0 slot comes due or an occupied slot needs cascading
+    auto next_event_tick() const -> uint64_t
+    {
+        auto next = never;
+        for (unsigned level = 0; level != levels; ++level)
+        {
+            if (!occupied[level])
+                continue;
+
+            auto const shift = bits_per_level * level;
+            auto const first = (current_tick >> shift) + 1;
+            auto const offset = __builtin_ctzll(rotate_right(occupied[level], first & slot_mask));
+            next = std::min(next, (first + offset) << shift);
+        }
+
+        return next;
+    }
+
+    void cascade()
+    {
+        for (unsigned level = 1; level != levels; ++level)
+        {
+            auto const index = (current_tick >> (bits_per_level * level)) & slot_mask;
+
+            while (auto const timer = slots[level][index])
+            {
+                unlink(*timer);
+                link(*timer);
+            }
+
+            if (index != 0)
+                break;
+        }
+    }
+
+    void advance_to(uint64_t now_tick, Expired& expired)
+    {
+        for (auto next = next_event_tick(); next <= now_tick; next = next_event_tick())
+        {
+            current_tick = next;
+
+            if ((current_tick & slot_mask) == 0)
+                cascade();
+
+            while (auto const timer = slots[0][current_tick & slot_mask])
+            {
+                unlink(*timer);
+                expired.emplace_back(timer->shared_from_this(), timer->linked_generation);
+            }
+        }
+
+        current_tick = std::max(current_tick, now_tick);
+    }
+
+    void arm_timerfd()
+    {
+        auto const next = next_event_tick();
+        if (next == armed_tick)
+            return;
+
+        itimerspec spec{{0, 0}, {0, 0}};
+        if (next != never)
+        {
+            auto const deadline = origin + static_cast<Duration::rep>(next) * tick;
+            auto const ns = std::max<std::chrono::nanoseconds::rep>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(clock->min_wait_until(deadline)).count(),
+                1);
+
+            spec.it_value.tv_sec = ns / 1000000000;
+            spec.it_value.tv_nsec = ns % 1000000000;
+        }
+
+        if (timerfd_settime(timer_fd, 0, &spec, nullptr) < 0)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{
+                errno, std::system_category(), "Failed to arm alarm timerfd"}));
+        }
+        armed_tick = next;
+    }
+
+    std::shared_ptr<graphics::EventHandlerRegister> const event_register;
+    std::shared_ptr<Clock> const clock;
+    Duration const tick;
+    Timestamp const origin;
+    mir::Fd const timer_fd;
+
+    std::mutex mutex;
+    uint64_t current_tick{0};
+    uint64_t armed_tick{never};
+    std::array<std::array<Timer*, slots_per_level>, levels> slots{};
+    std::array<uint64_t, levels> occupied{};
+};
+
+class mt::TimerWheel::AlarmImpl : public mt::Alarm
+{
+public:
+    AlarmImpl(
+        std::shared_ptr<Wheel> const& wheel,
+        std::shared_ptr<Clock> const& clock,
+        std::unique_ptr<LockableCallback> callback)
+        : wheel{wheel},
+          clock{clock},
+          timer{std::make_shared<Timer>(std::move(callback))}
+    {
+    }
+
+    ~AlarmImpl() override
+    {
+        std::lock_guard<decltype(timer->dispatch_mutex)> dispatch_lock{timer->dispatch_mutex};
+        {
+            std::lock_guard<decltype(timer->state_mutex)> lock{timer->state_mutex};
+            timer->state = State::cancelled;
+            ++timer->generation;
+        }
+        wheel->cancel(*timer);
+    }
+
+    bool cancel() override
+    {
+        std::lock_guard<decltype(timer->dispatch_mutex)> dispatch_lock{timer->dispatch_mutex};
+        {
+            std::lock_guard<decltype(timer->state_mutex)> lock{timer->state_mutex};
+            if (timer->state != State::pending)
+                return timer->state == State::cancelled;
+
+            timer->state = State::cancelled;
+            ++timer->generation;
+        }
+        wheel->cancel(*timer);
+        return true;
+    }
+
+    State state() const override
+    {
+        std::lock_guard<decltype(timer->state_mutex)> lock{timer->state_mutex};
+        return timer->state;
+    }
+
+    bool reschedule_in(std::chrono::milliseconds delay) override
+    {
+        return reschedule_for(clock->now() + delay);
+    }
+
+    bool reschedule_for(Timestamp timeout) override
+    {
+        std::lock_guard<decltype(timer->dispatch_mutex)> dispatch_lock{timer->dispatch_mutex};
+
+        State old_state;
+        uint64_t generation;
+        {
+            std::lock_guard<decltype(timer->state_mutex)> lock{timer->state_mutex};
+            old_state = timer->state;
+            timer->state = State::pending;
+            generation = ++timer->generation;
+        }
+        wheel->schedule(*timer, generation, timeout);
+
+        return old_state == State::pending;
+    }
+
+private:
+    std::shared_ptr<Wheel> const wheel;
+    std::shared_ptr<Clock> const clock;
+    std::shared_ptr<Timer> const timer;
+};
+
+mt::TimerWheel::TimerWheel(
+    std::shared_ptr<graphics::EventHandlerRegister> const& event_register,
+    std::shared_ptr<Clock> const& clock,
+    std::chrono::milliseconds tick)
+    : clock{clock},
+      wheel{std::make_shared<Wheel>(event_register, clock, tick)}
+{
+    Wheel::register_with(wheel);
+}
+
+mt::TimerWheel::~TimerWheel() = default;
+
+std::unique_ptr<mt::Alarm> mt::TimerWheel::create_alarm(std::function<void()> const& callback)
+{
+    return create_alarm(std::make_unique<BasicCallback>(callback));
+}
+
+std::unique_ptr<mt::Alarm> mt::TimerWheel::create_alarm(std::unique_ptr<LockableCallback> callback)
+{
+    return std::make_unique<AlarmImpl>(wheel, clock, std::move(callback));
+}
@@ -78,6 +78,10 @@ public:
                                             void (*destroy_user_data)(struct gbm_bo *, void *)));
     MOCK_METHOD1(gbm_bo_get_user_data, void*(struct gbm_bo *bo));
     MOCK_METHOD3(gbm_bo_write, bool(struct gbm_bo *bo, const void *buf, size_t count));
+    MOCK_METHOD8(gbm_bo_map, void*(struct gbm_bo *bo,
+                                   uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                                   uint32_t flags, uint32_t *stride, void **map_data));
+    MOCK_METHOD2(gbm_bo_unmap, void(struct gbm_bo *bo, void *map_data));
     MOCK_METHOD1(gbm_bo_destroy, void(struct gbm_bo *bo));
     MOCK_METHOD4(gbm_bo_import, struct gbm_bo*(struct gbm_device*, uint32_t, void*, uint32_t));
     MOCK_METHOD1(gbm_bo_get_fd, int(gbm_bo*));
@@ -355,6 +355,9 @@ mtd::MockDRM::MockDRM()
     ON_CALL(*this, drmGetVersion(_))
         .WillByDefault(Return(const_cast<drmVersionPtr>(&version)));
 
+    ON_CALL(*this, drmModeAtomicAlloc())
+        .WillByDefault(Return(reinterpret_cast<drmModeAtomicReqPtr>(0xa70)));
+
     ON_CALL(*this, drmCheckModesettingSupported(NotNull()))
         .WillByDefault(Return(0));
     ON_CALL(*this, drmCheckModesettingSupported(IsNull()))
@@ -595,6 +598,36 @@ int drmModeConnectorSetProperty(int fd, uint32_t connector_id, uint32_t property
     return global_mock->drmModeConnectorSetProperty(fd, connector_id, property_id, value);
 }
 
+drmModeAtomicReqPtr drmModeAtomicAlloc()
+{
+    return global_mock->drmModeAtomicAlloc();
+}
+
+void drmModeAtomicFree(drmModeAtomicReqPtr req)
+{
+    global_mock->drmModeAtomicFree(req);
+}
+
+int drmModeAtomicAddProperty(drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_id, uint64_t value)
+{
+    return global_mock->drmModeAtomicAddProperty(req, object_id, property_id, value);
+}
+
+int drmModeAtomicCommit(int fd, drmModeAtomicReqPtr req, uint32_t flags, void* user_data)
+{
+    return global_mock->drmModeAtomicCommit(fd, req, flags, user_data);
+}
+
+int drmModeCreatePropertyBlob(int fd, void const* data, size_t size, uint32_t* id)
+{
+    return global_mock->drmModeCreatePropertyBlob(fd, data, size, id);
+}
+
+int drmModeDestroyPropertyBlob(int fd, uint32_t id)
+{
+    return global_mock->drmModeDestroyPropertyBlob(fd, id);
+}
+
 void drmModeFreeConnector(drmModeConnectorPtr ptr)
 {
     global_mock->drmModeFreeConnector(ptr);
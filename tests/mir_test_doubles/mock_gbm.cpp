@@ -173,6 +173,18 @@ int gbm_bo_write(struct gbm_bo *bo, const void *buf, size_t count)
     return global_mock->gbm_bo_write(bo, buf, count);
 }
 
+void *gbm_bo_map(struct gbm_bo *bo,
+                 uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                 uint32_t flags, uint32_t *stride, void **map_data)
+{
+    return global_mock->gbm_bo_map(bo, x, y, width, height, flags, stride, map_data);
+}
+
+void gbm_bo_unmap(struct gbm_bo *bo, void *map_data)
+{
+    global_mock->gbm_bo_unmap(bo, map_data);
+}
+
 void gbm_bo_destroy(struct gbm_bo *bo)
 {
     return global_mock->gbm_bo_destroy(bo);
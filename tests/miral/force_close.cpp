@@ -0,0 +1,89 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_window_manager_tools.h"
+
+using namespace miral;
+using namespace testing;
+namespace mt = mir::test;
+
+namespace
+{
+X const display_left{0};
+Y const display_top{0};
+Width const display_width{640};
+Height const display_height{480};
+
+Rectangle const display_area{{display_left,  display_top},
+                             {display_width, display_height}};
+
+struct ForceClose : mt::TestWindowManagerTools
+{
+    void SetUp() override
+    {
+        notify_configuration_applied(create_fake_display_configuration({display_area}));
+        basic_window_manager.add_session(session);
+    }
+
+    // Only the session holds the surface, so it goes as soon as the session destroys it
+    auto create_window() -> Window
+    {
+        mir::scene::SurfaceCreationParameters creation_parameters;
+        creation_parameters.type = mir_window_type_normal;
+        creation_parameters.size = Size{100, 100};
+
+        auto const window = basic_window_manager.info_for(
+            basic_window_manager.add_surface(session, creation_parameters, &create_surface)).window();
+        basic_window_manager.select_active_window(window);
+
+        return window;
+    }
+};
+}
+
+TEST_F(ForceClose, the_surface_is_destroyed)
+{
+    auto const window = create_window();
+
+    basic_window_manager.force_close(window);
+
+    EXPECT_THAT(std::shared_ptr<mir::scene::Surface>(window), IsNull());
+}
+
+TEST_F(ForceClose, the_window_info_is_released)
+{
+    auto const window = create_window();
+    std::weak_ptr<void> userdata;
+    {
+        auto const data = std::make_shared<int>();
+        basic_window_manager.info_for(window).userdata(data);
+        userdata = data;
+    }
+
+    basic_window_manager.force_close(window);
+
+    EXPECT_TRUE(userdata.expired());
+}
+
+TEST_F(ForceClose, another_window_becomes_active)
+{
+    auto const other = create_window();
+    auto const window = create_window();
+
+    basic_window_manager.force_close(window);
+
+    EXPECT_THAT(basic_window_manager.active_window(), Eq(other));
+}
@@ -59,6 +59,7 @@ struct MRUWindowList : testing::Test
 {
     static auto const window_a_id = 0;
     static auto const window_b_id = 1;
+    static auto const window_c_id = 2;
 
     miral::MRUWindowList mru_list;
 
@@ -77,6 +78,11 @@ struct MRUWindowList : testing::Test
     {
         stub_session->surfaces[window_id]->visible_ = true;
     }
+
+    void destroy_surface(int window_id)
+    {
+        stub_session->surfaces[window_id].reset();
+    }
 };
 
 TEST_F(MRUWindowList, when_created_is_empty)
@@ -189,3 +195,32 @@ TEST_F(MRUWindowList, hiding_then_showing_windows_retains_order)
     EXPECT_THAT(as_enumerated, ElementsAre(window_c, window_b, window_a));
 }
 
+
+TEST_F(MRUWindowList, a_window_whose_surface_has_gone_is_not_pushed)
+{
+    mru_list.push(window_a);
+    mru_list.push(window_b);
+
+    destroy_surface(window_c_id);
+    mru_list.push(window_c);
+
+    std::vector<miral::Window> as_enumerated;
+
+    mru_list.enumerate([&](miral::Window& window)
+       { as_enumerated.push_back(window); return true; });
+
+    EXPECT_THAT(mru_list.top(), Eq(window_b));
+    EXPECT_THAT(as_enumerated, ElementsAre(window_b, window_a));
+}
+
+TEST_F(MRUWindowList, a_window_whose_surface_has_gone_can_be_erased)
+{
+    mru_list.push(window_a);
+    mru_list.push(window_b);
+    mru_list.push(window_c);
+
+    destroy_surface(window_c_id);
+    mru_list.erase(window_c);
+
+    EXPECT_THAT(mru_list.top(), Eq(window_b));
+}
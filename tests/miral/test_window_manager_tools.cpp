@@ -165,6 +165,18 @@ struct StubStubSession : mir::test::doubles::StubSession
         return surface;
     }
 
+    void destroy_surface(std::shared_ptr<mir::scene::Surface> const& surface) override
+    {
+        for (auto i = begin(surfaces); i != end(surfaces); ++i)
+        {
+            if (i->second == surface)
+            {
+                surfaces.erase(i);
+                break;
+            }
+        }
+    }
+
 private:
     std::atomic<int> next_surface_id;
     std::map<mir::frontend::SurfaceId, std::shared_ptr<mir::scene::Surface>> surfaces;
@@ -297,6 +309,11 @@ mt::TestWindowManagerTools::TestWindowManagerTools()
 
 mt::TestWindowManagerTools::~TestWindowManagerTools() = default;
 
+auto mt::TestWindowManagerTools::create_session() -> std::shared_ptr<mir::scene::Session>
+{
+    return std::make_shared<StubStubSession>();
+}
+
 auto mt::TestWindowManagerTools::create_surface(
     std::shared_ptr<mir::scene::Session> const& session,
     mir::scene::SurfaceCreationParameters const& params) -> std::shared_ptr<mir::scene::Surface>
@@ -85,6 +85,9 @@ public:
     miral::WindowManagerTools window_manager_tools;
     miral::BasicWindowManager basic_window_manager;
 
+    /// A session of the same kind as session, for tests that need more than one
+    static auto create_session() -> std::shared_ptr<mir::scene::Session>;
+
     static auto create_surface(
         std::shared_ptr<mir::scene::Session> const& session,
         mir::scene::SurfaceCreationParameters const& params) -> std::shared_ptr<mir::scene::Surface>;
@@ -0,0 +1,132 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_window_manager_tools.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+using namespace miral;
+using namespace testing;
+namespace mt = mir::test;
+
+namespace
+{
+X const display_left{0};
+Y const display_top{0};
+Width const display_width{3840};
+Height const display_height{2160};
+
+Rectangle const display_area{{display_left,  display_top},
+                             {display_width, display_height}};
+
+// Enough to show up anything that grows with the number of clients, not so many as to slow the test suite
+int const session_count{500};
+int const windows_per_session{4};
+int const focus_changes{10000};
+
+using Clock = std::chrono::steady_clock;
+
+struct WindowManagementScalability : mt::TestWindowManagerTools
+{
+    void SetUp() override
+    {
+        notify_configuration_applied(create_fake_display_configuration({display_area}));
+    }
+
+    struct Client
+    {
+        std::shared_ptr<mir::scene::Session> session;
+        std::vector<std::shared_ptr<mir::scene::Surface>> surfaces;
+    };
+
+    auto create_window(Client& client, int index) -> Window
+    {
+        mir::scene::SurfaceCreationParameters creation_parameters;
+        creation_parameters.name = "window " + std::to_string(index);
+        creation_parameters.type = mir_window_type_normal;
+        creation_parameters.size = Size{100, 100};
+
+        auto const surface = basic_window_manager.add_surface(client.session, creation_parameters, &create_surface);
+        client.surfaces.push_back(surface);
+
+        return basic_window_manager.info_for(surface).window();
+    }
+
+    static void report(char const* operation, Clock::duration elapsed, int count)
+    {
+        auto const per_operation = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed) / count;
+        std::cout << "[ BENCHMARK] " << operation << ": " << count << " in "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << "ms ("
+                  << per_operation.count() << "ns each)" << std::endl;
+    }
+
+    std::vector<Client> clients{session_count};
+    std::vector<Window> windows;
+};
+}
+
+TEST_F(WindowManagementScalability, thousands_of_windows_and_sessions)
+{
+    auto start = Clock::now();
+    for (auto& client : clients)
+    {
+        client.session = create_session();
+        basic_window_manager.add_session(client.session);
+    }
+    report("add_session", Clock::now() - start, session_count);
+
+    start = Clock::now();
+    for (auto& client : clients)
+    {
+        for (int i = 0; i != windows_per_session; ++i)
+            windows.push_back(create_window(client, windows.size()));
+    }
+    report("add_surface", Clock::now() - start, windows.size());
+
+    ASSERT_THAT(basic_window_manager.count_applications(), Eq(unsigned(session_count)));
+
+    std::mt19937 random{0};
+    std::uniform_int_distribution<std::size_t> pick{0, windows.size() - 1};
+
+    Window expected_active;
+    start = Clock::now();
+    for (int i = 0; i != focus_changes; ++i)
+    {
+        expected_active = windows[pick(random)];
+        basic_window_manager.select_active_window(expected_active);
+    }
+    report("select_active_window", Clock::now() - start, focus_changes);
+
+    EXPECT_THAT(basic_window_manager.active_window(), Eq(expected_active));
+
+    start = Clock::now();
+    for (auto& client : clients)
+    {
+        for (auto const& surface : client.surfaces)
+            basic_window_manager.remove_surface(client.session, surface);
+    }
+    report("remove_surface", Clock::now() - start, windows.size());
+
+    start = Clock::now();
+    for (auto& client : clients)
+        basic_window_manager.remove_session(client.session);
+    report("remove_session", Clock::now() - start, session_count);
+
+    EXPECT_THAT(basic_window_manager.count_applications(), Eq(0u));
+    EXPECT_THAT(basic_window_manager.active_window(), Eq(Window{}));
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/graphics/offscreen/frame_export.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+
+namespace mg = mir::graphics;
+namespace mgo = mir::graphics::offscreen;
+namespace fe = mir::graphics::offscreen::frame_export;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+struct FrameExport : Test
+{
+    FrameExport()
+    {
+        frame_export = std::make_unique<mgo::FrameExport>(mg::DisplayConfigurationOutputId{3}, area);
+        consumer_fd = frame_export->consumer_fd();
+
+        struct stat info;
+        fstat(consumer_fd, &info);
+        mapping_size = info.st_size;
+        mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, consumer_fd, 0);
+    }
+
+    ~FrameExport()
+    {
+        munmap(mapping, mapping_size);
+    }
+
+    fe::Header const& header() const
+    {
+        return *static_cast<fe::Header const*>(mapping);
+    }
+
+    uint32_t exported_pixel(uint64_t frame, int x, int y) const
+    {
+        auto const slot = static_cast<unsigned char const*>(mapping) +
+            header().slot_offset + (frame % header().slot_count) * header().slot_size;
+        return reinterpret_cast<uint32_t const*>(slot + y * header().stride)[x];
+    }
+
+    void publish(std::vector<geom::Rectangle> const& damage)
+    {
+        frame_export->publish(
+            reinterpret_cast<unsigned char const*>(framebuffer.data()),
+            geom::Stride{width * sizeof(uint32_t)},
+            damage);
+    }
+
+    void fill(geom::Rectangle const& rect, uint32_t value)
+    {
+        for (auto y = rect.top().as_int(); y != rect.bottom().as_int(); ++y)
+            for (auto x = rect.left().as_int(); x != rect.right().as_int(); ++x)
+                framebuffer[y * width + x] = value;
+    }
+
+    int const width{16};
+    int const height{8};
+    geom::Rectangle const area{{100, 200}, {width, height}};
+    std::vector<uint32_t> framebuffer = std::vector<uint32_t>(width * height, 0);
+    std::unique_ptr<mgo::FrameExport> frame_export;
+    mir::Fd consumer_fd;
+    size_t mapping_size;
+    void* mapping;
+};
+}
+
+TEST_F(FrameExport, header_describes_output)
+{
+    ASSERT_THAT(mapping, Ne(MAP_FAILED));
+
+    EXPECT_THAT(header().magic, Eq(fe::magic));
+    EXPECT_THAT(header().version, Eq(fe::version));
+    EXPECT_THAT(header().output_id, Eq(3u));
+    EXPECT_THAT(header().x, Eq(100));
+    EXPECT_THAT(header().y, Eq(200));
+    EXPECT_THAT(header().width, Eq(16u));
+    EXPECT_THAT(header().height, Eq(8u));
+    EXPECT_THAT(header().stride, Eq(16u * 4));
+    EXPECT_THAT(header().format, Eq(static_cast<uint32_t>(mir_pixel_format_xrgb_8888)));
+    EXPECT_THAT(header().slot_count, Eq(3u));
+    EXPECT_THAT(header().latest_frame.load(), Eq(0u));
+    EXPECT_THAT(mapping_size, Ge(header().slot_offset + header().slot_count * header().slot_size));
+}
+
+TEST_F(FrameExport, consumer_fd_is_sealed_and_read_only)
+{
+    auto const seals = fcntl(consumer_fd, F_GET_SEALS);
+    EXPECT_THAT(seals & F_SEAL_SHRINK, Ne(0));
+    EXPECT_THAT(seals & F_SEAL_GROW, Ne(0));
+    EXPECT_THAT(seals & F_SEAL_SEAL, Ne(0));
+
+    EXPECT_THAT(mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, consumer_fd, 0), Eq(MAP_FAILED));
+}
+
+TEST_F(FrameExport, publishes_frame_with_damage_and_timestamp)
+{
+    geom::Rectangle const damage{{2, 3}, {4, 2}};
+    fill({{0, 0}, {width, height}}, 0xff123456);
+
+    publish({damage});
+
+    ASSERT_THAT(header().latest_frame.load(), Eq(1u));
+    auto const& slot = header().slots[1];
+    EXPECT_THAT(slot.sequence.load(), Eq(2u));
+    EXPECT_THAT(slot.frame, Eq(1u));
+    EXPECT_THAT(slot.timestamp_ns, Gt(0));
+    ASSERT_THAT(slot.damage_count, Eq(1u));
+    EXPECT_THAT(slot.damage[0].x, Eq(2));
+    EXPECT_THAT(slot.damage[0].y, Eq(3));
+    EXPECT_THAT(slot.damage[0].width, Eq(4));
+    EXPECT_THAT(slot.damage[0].height, Eq(2));
+    EXPECT_THAT(exported_pixel(1, 3, 4), Eq(0xff123456));
+}
+
+TEST_F(FrameExport, frame_without_damage_is_not_published)
+{
+    publish({});
+
+    EXPECT_THAT(header().latest_frame.load(), Eq(0u));
+}
+
+TEST_F(FrameExport, every_published_slot_holds_the_complete_frame)
+{
+    // Each slot misses the damage of the frames written to the other slots
+    for (auto frame = 1; frame != 10; ++frame)
+    {
+        geom::Rectangle const damage{{frame, frame % height}, {3, 1}};
+        fill(damage, 0xff000000 | frame);
+        publish({damage});
+
+        ASSERT_THAT(header().latest_frame.load(), Eq(uint64_t(frame)));
+        for (auto y = 0; y != height; ++y)
+        {
+            for (auto x = 0; x != width; ++x)
+            {
+                ASSERT_THAT(exported_pixel(frame, x, y), Eq(framebuffer[y * width + x]))
+                    << "frame " << frame << " at (" << x << ", " << y << ")";
+            }
+        }
+    }
+}
+
+TEST_F(FrameExport, excess_damage_is_reported_as_bounding_rectangle)
+{
+    std::vector<geom::Rectangle> damage;
+    for (auto i = 0u; i != fe::max_damage + 1; ++i)
+        damage.push_back({{int(i % width), int(i % height)}, {1, 1}});
+
+    publish(damage);
+
+    auto const& slot = header().slots[1];
+    ASSERT_THAT(slot.damage_count, Eq(1u));
+    EXPECT_THAT(slot.damage[0].x, Eq(0));
+    EXPECT_THAT(slot.damage[0].y, Eq(0));
+    EXPECT_THAT(slot.damage[0].width, Eq(width));
+    EXPECT_THAT(slot.damage[0].height, Eq(height));
+}
+
+TEST_F(FrameExport, marks_export_closed_when_destroyed)
+{
+    frame_export.reset();
+
+    EXPECT_THAT(header().closed.load(), Eq(1u));
+}
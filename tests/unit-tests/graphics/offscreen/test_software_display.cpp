@@ -0,0 +1,171 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/graphics/offscreen/software_display.h"
+#include "src/server/graphics/offscreen/frame_export.h"
+#include "mir/graphics/default_display_configuration_policy.h"
+#include "mir/graphics/display_buffer.h"
+#include "mir/renderer/sw/render_target.h"
+#include "mir/fd_socket_transmission.h"
+#include "src/server/report/null_report_factory.h"
+
+#include "mir/test/doubles/mock_event_handler_register.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace mg = mir::graphics;
+namespace mgo = mir::graphics::offscreen;
+namespace fe = mir::graphics::offscreen::frame_export;
+namespace msw = mir::renderer::software;
+namespace mtd = mir::test::doubles;
+namespace mr = mir::report;
+
+using namespace testing;
+
+namespace
+{
+std::string temporary_socket_path()
+{
+    char dir_template[] = "/tmp/mir-frame-export-XXXXXX";
+    return std::string{mkdtemp(dir_template)} + "/socket";
+}
+
+mir::Fd connect_to(std::string const& path)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    mir::Fd fd{socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+        return {};
+    return fd;
+}
+
+struct SoftwareDisplay : Test
+{
+    ~SoftwareDisplay()
+    {
+        rmdir(socket_path.substr(0, socket_path.rfind('/')).c_str());
+    }
+
+    std::string const socket_path{temporary_socket_path()};
+};
+}
+
+TEST_F(SoftwareDisplay, outputs_are_software_render_targets)
+{
+    mgo::SoftwareDisplay display{
+        std::make_shared<mg::CloneDisplayConfigurationPolicy>(),
+        mr::null_display_report()};
+
+    int count{0};
+    display.for_each_display_sync_group([&](mg::DisplaySyncGroup& group)
+        {
+            group.for_each_display_buffer([&](mg::DisplayBuffer& db)
+                {
+                    ++count;
+                    auto const target = dynamic_cast<msw::RenderTarget*>(db.native_display_buffer());
+                    ASSERT_THAT(target, NotNull());
+                    EXPECT_THAT(target->size(), Eq(db.view_area().size));
+                    EXPECT_THAT(target->pixels(), NotNull());
+                });
+        });
+
+    EXPECT_THAT(count, Gt(0));
+}
+
+TEST_F(SoftwareDisplay, sends_frame_exports_to_connecting_clients)
+{
+    NiceMock<mtd::MockEventHandlerRegister> handlers;
+    std::function<void(int)> handler;
+    EXPECT_CALL(handlers, register_fd_handler(_, _, _)).WillOnce(SaveArg<2>(&handler));
+
+    mgo::SoftwareDisplay display{
+        std::make_shared<mg::CloneDisplayConfigurationPolicy>(),
+        mr::null_display_report(),
+        socket_path};
+    display.register_configuration_change_handler(handlers, []{});
+    ASSERT_TRUE(handler);
+
+    auto const client = connect_to(socket_path);
+    ASSERT_THAT(client, Ge(0));
+    handler(-1);
+
+    uint32_t count{0};
+    ASSERT_THAT(read(client, &count, sizeof(count)), Eq(ssize_t(sizeof(count))));
+    ASSERT_THAT(count, Eq(1u));
+
+    char dummy;
+    std::vector<mir::Fd> fds(count);
+    mir::receive_data(client, &dummy, sizeof(dummy), fds);
+
+    auto const mapping = mmap(nullptr, sizeof(fe::Header), PROT_READ, MAP_SHARED, fds[0], 0);
+    ASSERT_THAT(mapping, Ne(MAP_FAILED));
+    EXPECT_THAT(static_cast<fe::Header const*>(mapping)->magic, Eq(fe::magic));
+    munmap(mapping, sizeof(fe::Header));
+}
+
+TEST_F(SoftwareDisplay, survives_clients_that_disconnect_before_being_served)
+{
+    NiceMock<mtd::MockEventHandlerRegister> handlers;
+    std::function<void(int)> handler;
+    EXPECT_CALL(handlers, register_fd_handler(_, _, _)).WillOnce(SaveArg<2>(&handler));
+
+    mgo::SoftwareDisplay display{
+        std::make_shared<mg::CloneDisplayConfigurationPolicy>(),
+        mr::null_display_report(),
+        socket_path};
+    display.register_configuration_change_handler(handlers, []{});
+    ASSERT_TRUE(handler);
+
+    {
+        auto const client = connect_to(socket_path);
+        ASSERT_THAT(client, Ge(0));
+    }
+
+    // Writing to the closed connection must not raise SIGPIPE (which would kill the test)
+    handler(-1);
+
+    auto const client = connect_to(socket_path);
+    ASSERT_THAT(client, Ge(0));
+    handler(-1);
+
+    uint32_t count{0};
+    EXPECT_THAT(read(client, &count, sizeof(count)), Eq(ssize_t(sizeof(count))));
+}
+
+TEST_F(SoftwareDisplay, removes_socket_when_destroyed)
+{
+    {
+        mgo::SoftwareDisplay display{
+            std::make_shared<mg::CloneDisplayConfigurationPolicy>(),
+            mr::null_display_report(),
+            socket_path};
+
+        EXPECT_THAT(access(socket_path.c_str(), F_OK), Eq(0));
+    }
+
+    EXPECT_THAT(access(socket_path.c_str(), F_OK), Ne(0));
+}
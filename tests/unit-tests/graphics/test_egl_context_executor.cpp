@@ -0,0 +1,168 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/common/server/egl_context_executor.h"
+#include "mir/renderer/gl/context.h"
+
+#include "mir/test/doubles/mock_gl.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <future>
+
+namespace mgc = mir::graphics::common;
+namespace mtd = mir::test::doubles;
+using namespace testing;
+using namespace std::literals::chrono_literals;
+
+namespace
+{
+class NullGLContext : public mir::renderer::gl::Context
+{
+public:
+    void make_current() const override
+    {
+    }
+
+    void release_current() const override
+    {
+    }
+};
+
+struct EGLContextExecutorTest : Test
+{
+    /// Occupy the EGL thread until unblock_egl_thread() is called
+    void block_egl_thread()
+    {
+        auto const started = std::make_shared<std::promise<void>>();
+        auto const egl_thread_started = started->get_future();
+        executor.spawn(
+            [this, started]()
+            {
+                started->set_value();
+                unblocked.wait();
+            });
+        ASSERT_THAT(egl_thread_started.wait_for(10s), Eq(std::future_status::ready));
+    }
+
+    void unblock_egl_thread()
+    {
+        release.set_value();
+    }
+
+    void wait_for_egl_thread()
+    {
+        auto const done = std::make_shared<std::promise<void>>();
+        auto const egl_thread_done = done->get_future();
+        executor.spawn([done]() { done->set_value(); });
+        ASSERT_THAT(egl_thread_done.wait_for(10s), Eq(std::future_status::ready));
+    }
+
+    NiceMock<mtd::MockGL> mock_gl;
+    std::promise<void> release;
+    std::shared_future<void> const unblocked{release.get_future().share()};
+    mgc::EGLContextExecutor executor{std::make_unique<NullGLContext>()};
+};
+}
+
+TEST_F(EGLContextExecutorTest, spawn_does_not_wait_for_running_work)
+{
+    block_egl_thread();
+
+    auto const spawned = std::async(
+        std::launch::async,
+        [this]()
+        {
+            executor.spawn([]{});
+            executor.delete_texture(7);
+        });
+
+    EXPECT_THAT(spawned.wait_for(10s), Eq(std::future_status::ready));
+
+    unblock_egl_thread();
+}
+
+TEST_F(EGLContextExecutorTest, consecutive_texture_deletions_are_coalesced)
+{
+    std::vector<GLuint> deleted;
+    EXPECT_CALL(mock_gl, glDeleteTextures(3, _))
+        .WillOnce(Invoke([&deleted](GLsizei n, GLuint const* textures) { deleted.assign(textures, textures + n); }));
+
+    block_egl_thread();
+    executor.delete_texture(1);
+    executor.delete_texture(2);
+    executor.delete_texture(3);
+    unblock_egl_thread();
+
+    wait_for_egl_thread();
+
+    EXPECT_THAT(deleted, ElementsAre(1, 2, 3));
+}
+
+TEST_F(EGLContextExecutorTest, texture_deletions_are_ordered_with_spawned_work)
+{
+    MockFunction<void()> work;
+
+    {
+        InSequence seq;
+        EXPECT_CALL(mock_gl, glDeleteTextures(1, Pointee(Eq(1u))));
+        EXPECT_CALL(work, Call());
+        EXPECT_CALL(mock_gl, glDeleteTextures(1, Pointee(Eq(2u))));
+    }
+
+    block_egl_thread();
+    executor.delete_texture(1);
+    executor.spawn([&work]{ work.Call(); });
+    executor.delete_texture(2);
+    unblock_egl_thread();
+
+    wait_for_egl_thread();
+}
+
+TEST_F(EGLContextExecutorTest, metrics_report_queued_work)
+{
+    block_egl_thread();
+    executor.spawn([]{});
+    executor.spawn([]{});
+    executor.delete_texture(1);
+
+    auto const queued = executor.metrics();
+    EXPECT_THAT(queued.queue_depth, Eq(3u));
+    EXPECT_THAT(queued.peak_queue_depth, Ge(3u));
+
+    unblock_egl_thread();
+    wait_for_egl_thread();
+
+    auto const drained = executor.metrics();
+    EXPECT_THAT(drained.queue_depth, Eq(0u));
+    EXPECT_THAT(drained.textures_deleted, Eq(1u));
+    EXPECT_THAT(drained.functors_run, Ge(4u));
+}
+
+TEST_F(EGLContextExecutorTest, work_queued_before_destruction_is_run)
+{
+    EXPECT_CALL(mock_gl, glDeleteTextures(1, Pointee(Eq(5u))));
+    bool ran{false};
+
+    {
+        mgc::EGLContextExecutor local{std::make_unique<NullGLContext>()};
+        local.spawn([&ran]{ ran = true; });
+        local.delete_texture(5);
+    }
+
+    EXPECT_TRUE(ran);
+}
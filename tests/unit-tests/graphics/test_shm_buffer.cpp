@@ -31,6 +31,7 @@
 #include <EGL/egl.h>
 #include <endian.h>
 #include <boost/throw_exception.hpp>
+#include <vector>
 
 namespace mg = mir::graphics;
 namespace mgc = mir::graphics::common;
@@ -69,11 +70,11 @@ struct PlatformlessShmBuffer : mgc::MemoryBackedShmBuffer
     PlatformlessShmBuffer(
         geom::Size const& size,
         MirPixelFormat const& pixel_format,
-        std::shared_ptr<mgc::EGLContextExecutor> egl_delegate)
+        std::shared_ptr<mgc::ShmTexturePool> textures)
         : MemoryBackedShmBuffer(
             size,
             pixel_format,
-            std::move(egl_delegate))
+            std::move(textures))
     {
     }
 
@@ -102,11 +103,13 @@ struct ShmBufferTest : public testing::Test
           egl_delegate{
             std::make_shared<mgc::EGLContextExecutor>(
                 std::make_unique<DumbGLContext>(dummy))},
+          textures{std::make_shared<mgc::ShmTexturePool>(egl_delegate)},
           shm_buffer{
             size,
             pixel_format,
-            std::make_shared<mgc::EGLContextExecutor>(
-                std::make_unique<DumbGLContext>(dummy))}
+            std::make_shared<mgc::ShmTexturePool>(
+                std::make_shared<mgc::EGLContextExecutor>(
+                    std::make_unique<DumbGLContext>(dummy)))}
     {
     }
 
@@ -117,6 +120,7 @@ struct ShmBufferTest : public testing::Test
     MirPixelFormat const pixel_format;
     EGLContext const dummy{reinterpret_cast<void*>(0x0011223344)};
     std::shared_ptr<mgc::EGLContextExecutor> const egl_delegate;
+    std::shared_ptr<mgc::ShmTexturePool> const textures;
 
     PlatformlessShmBuffer shm_buffer;
 };
@@ -135,7 +139,7 @@ TEST_F(ShmBufferTest, has_correct_properties)
 
 TEST_F(ShmBufferTest, cant_upload_bgr_888)
 {
-    PlatformlessShmBuffer buf(size, mir_pixel_format_bgr_888, egl_delegate);
+    PlatformlessShmBuffer buf(size, mir_pixel_format_bgr_888, textures);
     EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _,
                                       size.width.as_int(), size.height.as_int(),
                                       0, _, _,
@@ -166,7 +170,7 @@ TEST_P(UploadTest, uploads_correctly)
     auto const desc = GetParam();
 
     PlatformlessShmBuffer buf(
-        desc.size, desc.format, egl_delegate);
+        desc.size, desc.format, textures);
 
     ExpectationSet gl_setup;
     gl_setup +=
@@ -354,7 +358,7 @@ TEST_F(ShmBufferTest, texture_is_destroyed_on_thread_with_current_context)
         // Ensure we have a “context” current for creation and bind
         eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, dummy_ctx);
 
-        PlatformlessShmBuffer buffer{size, pixel_format, egl_delegate};
+        PlatformlessShmBuffer buffer{size, pixel_format, std::make_shared<mgc::ShmTexturePool>(egl_delegate)};
 
         buffer.bind();
 
@@ -362,3 +366,142 @@ TEST_F(ShmBufferTest, texture_is_destroyed_on_thread_with_current_context)
         eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
     }
 }
+
+TEST_F(ShmBufferTest, texture_of_released_buffer_is_reused_by_buffer_of_same_size_and_format)
+{
+    GLuint const tex_id{0x8086};
+    EXPECT_CALL(mock_gl, glGenTextures(1,_))
+        .WillOnce(SetArgPointee<1>(tex_id));
+
+    {
+        PlatformlessShmBuffer buffer{size, mir_pixel_format_argb_8888, textures};
+        buffer.bind();
+    }
+
+    PlatformlessShmBuffer buffer{size, mir_pixel_format_argb_8888, textures};
+
+    EXPECT_CALL(mock_gl, glBindTexture(GL_TEXTURE_2D, tex_id));
+    EXPECT_CALL(mock_gl, glTexParameteri(_,_,_)).Times(0);
+    EXPECT_CALL(mock_gl, glTexImage2D(_,_,_,_,_,_,_,_,_)).Times(0);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(
+        GL_TEXTURE_2D, 0,
+        0, 0,
+        size.width.as_int(), size.height.as_int(),
+        _, _,
+        buffer.pixel_buffer()));
+
+    buffer.bind();
+}
+
+TEST_F(ShmBufferTest, texture_of_different_size_or_format_is_reused_with_new_storage)
+{
+    GLuint const tex_id{0x8086};
+    EXPECT_CALL(mock_gl, glGenTextures(1,_))
+        .WillOnce(SetArgPointee<1>(tex_id));
+
+    {
+        PlatformlessShmBuffer buffer{size, mir_pixel_format_argb_8888, textures};
+        buffer.bind();
+    }
+
+    {
+        geom::Size const other_size{size.width, size.height.as_int() + 1};
+        PlatformlessShmBuffer buffer{other_size, mir_pixel_format_argb_8888, textures};
+
+        EXPECT_CALL(mock_gl, glBindTexture(GL_TEXTURE_2D, tex_id));
+        EXPECT_CALL(mock_gl, glTexImage2D(
+            GL_TEXTURE_2D, 0, _, other_size.width.as_int(), other_size.height.as_int(), _, _, _, _));
+        buffer.bind();
+        Mock::VerifyAndClearExpectations(&mock_gl);
+    }
+
+    PlatformlessShmBuffer other_format{size, mir_pixel_format_rgb_565, textures};
+    EXPECT_CALL(mock_gl, glBindTexture(GL_TEXTURE_2D, tex_id));
+    EXPECT_CALL(mock_gl, glTexImage2D(_,_,_,_,_,_,_,_,_));
+    other_format.bind();
+}
+
+TEST_F(ShmBufferTest, texture_is_generated_when_pool_is_empty)
+{
+    EXPECT_CALL(mock_gl, glGenTextures(1,_))
+        .WillOnce(SetArgPointee<1>(1))
+        .WillOnce(SetArgPointee<1>(2));
+
+    PlatformlessShmBuffer first{size, mir_pixel_format_argb_8888, textures};
+    first.bind();
+
+    PlatformlessShmBuffer second{size, mir_pixel_format_argb_8888, textures};
+    EXPECT_CALL(mock_gl, glTexImage2D(_,_,_,_,_,_,_,_,_));
+    second.bind();
+}
+
+TEST_F(ShmBufferTest, pool_deletes_least_recently_released_textures_beyond_its_budget)
+{
+    auto const bytes_per_buffer = size.width.as_uint32_t() * size.height.as_uint32_t() * 4;
+    GLuint const first_tex_id{0x8086}, second_tex_id{0x8087};
+
+    EXPECT_CALL(mock_gl, glGenTextures(1,_))
+        .WillOnce(SetArgPointee<1>(first_tex_id))
+        .WillOnce(SetArgPointee<1>(second_tex_id));
+    EXPECT_CALL(mock_gl, glDeleteTextures(1, Pointee(Eq(first_tex_id))));
+    EXPECT_CALL(mock_gl, glDeleteTextures(1, Pointee(Eq(second_tex_id)))).Times(0);
+
+    {
+        auto const egl_delegate = std::make_shared<mgc::EGLContextExecutor>(
+            std::make_unique<DumbGLContext>(dummy));
+        auto const textures = std::make_shared<mgc::ShmTexturePool>(egl_delegate, bytes_per_buffer);
+
+        auto first = std::make_unique<PlatformlessShmBuffer>(size, mir_pixel_format_argb_8888, textures);
+        auto second = std::make_unique<PlatformlessShmBuffer>(size, mir_pixel_format_argb_8888, textures);
+        first->bind();
+        second->bind();
+
+        first.reset();
+        second.reset();
+
+        wait_for_egl_thread(*egl_delegate);
+        Mock::VerifyAndClearExpectations(&mock_gl);
+
+        // Draining the EGLContextExecutor's queue: the pool's destructor deletes what remains
+        EXPECT_CALL(mock_gl, glDeleteTextures(1, Pointee(Eq(second_tex_id))));
+    }
+}
+
+TEST_F(ShmBufferTest, rebinding_unchanged_buffer_does_not_upload_again)
+{
+    GLuint const tex_id{0x8086};
+    EXPECT_CALL(mock_gl, glGenTextures(1,_))
+        .WillOnce(SetArgPointee<1>(tex_id));
+
+    PlatformlessShmBuffer buffer{size, mir_pixel_format_argb_8888, textures};
+    buffer.bind();
+
+    EXPECT_CALL(mock_gl, glTexImage2D(_,_,_,_,_,_,_,_,_)).Times(0);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_,_,_,_,_,_,_,_,_)).Times(0);
+
+    buffer.bind();
+    buffer.bind();
+}
+
+TEST_F(ShmBufferTest, rebinding_buffer_uploads_what_was_written)
+{
+    GLuint const tex_id{0x8086};
+    EXPECT_CALL(mock_gl, glGenTextures(1,_))
+        .WillOnce(SetArgPointee<1>(tex_id));
+
+    auto const bytes = size.width.as_uint32_t() * size.height.as_uint32_t() * 4;
+    std::vector<unsigned char> const pixels(bytes, 0x55);
+
+    PlatformlessShmBuffer buffer{size, mir_pixel_format_argb_8888, textures};
+    buffer.bind();
+    buffer.write(pixels.data(), pixels.size());
+
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_,_,_,_,_,_,_,_,buffer.pixel_buffer()));
+
+    buffer.bind();
+    Mock::VerifyAndClearExpectations(&mock_gl);
+
+    EXPECT_CALL(mock_gl, glTexImage2D(_,_,_,_,_,_,_,_,_)).Times(0);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_,_,_,_,_,_,_,_,_)).Times(0);
+    buffer.bind();
+}
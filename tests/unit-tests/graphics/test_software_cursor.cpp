@@ -49,11 +49,11 @@ struct MockInputScene : mtd::StubInputScene
 
 struct StubCursorImage : mg::CursorImage
 {
-    StubCursorImage(geom::Displacement const& hotspot)
+    StubCursorImage(geom::Displacement const& hotspot, unsigned char fill = 0x55)
         : hotspot_{hotspot},
           pixels(
             size().width.as_uint32_t() * size().height.as_uint32_t() * bytes_per_pixel,
-            0x55)
+            fill)
     {
     }
 
@@ -295,7 +295,7 @@ TEST_F(SoftwareCursor, places_new_cursor_renderable_at_correct_position)
 }
 
 //lp: #1413211
-TEST_F(SoftwareCursor, new_buffer_on_each_show)
+TEST_F(SoftwareCursor, new_buffer_for_each_new_image)
 {
     struct MockBufferAllocator : public mg::GraphicBufferAllocator
     {
@@ -305,15 +305,44 @@ TEST_F(SoftwareCursor, new_buffer_on_each_show)
         std::vector<MirPixelFormat> supported_pixel_formats() { return {mir_pixel_format_abgr_8888}; } 
     } mock_allocator;
 
+    StubCursorImage const third_stub_cursor_image{{3,4}, 0x77};
+    StubCursorImage const fourth_stub_cursor_image{{3,4}, 0x99};
+
     EXPECT_CALL(mock_allocator, alloc_software_buffer(testing::_, testing::_))
         .Times(3)
-        .WillRepeatedly(testing::Return(std::make_shared<mtd::StubBuffer>()));;
+        .WillRepeatedly(testing::Invoke([](auto, auto) { return std::make_shared<mtd::StubBuffer>(); }));
     mg::SoftwareCursor cursor{
         mt::fake_shared(mock_allocator),
         mt::fake_shared(mock_input_scene)};
+    cursor.show(stub_cursor_image);
+    cursor.show(third_stub_cursor_image);
+    cursor.show(fourth_stub_cursor_image);
+}
+
+TEST_F(SoftwareCursor, buffer_is_reused_when_recent_image_is_shown_again)
+{
+    using namespace testing;
+
+    StubCursorImage const different_stub_cursor_image{{3,4}, 0x77};
+    std::vector<std::shared_ptr<mg::Buffer>> buffers;
+
+    EXPECT_CALL(mock_input_scene, add_input_visualization(_))
+        .WillRepeatedly(Invoke(
+            [&buffers](std::shared_ptr<mg::Renderable> const& renderable)
+            {
+                buffers.push_back(renderable->buffer());
+            }));
+
+    // Same pixels, different hotspot
+    cursor.show(stub_cursor_image);
     cursor.show(another_stub_cursor_image);
-    cursor.show(another_stub_cursor_image);
+    cursor.show(different_stub_cursor_image);
     cursor.show(stub_cursor_image);
+
+    ASSERT_THAT(buffers.size(), Eq(4u));
+    EXPECT_THAT(buffers[1], Eq(buffers[0]));
+    EXPECT_THAT(buffers[2], Ne(buffers[0]));
+    EXPECT_THAT(buffers[3], Eq(buffers[0]));
 }
 
 //lp: 1483779
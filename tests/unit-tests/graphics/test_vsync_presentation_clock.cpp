@@ -0,0 +1,186 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/vsync_presentation_clock.h"
+
+#include "mir/test/doubles/mock_display_report.h"
+#include "mir/test/doubles/fake_alarm_factory.h"
+#include "mir/test/fake_shared.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <thread>
+
+namespace mg = mir::graphics;
+namespace mt = mir::time;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+using namespace std::literals::chrono_literals;
+
+namespace
+{
+struct VsyncPresentationClock : Test
+{
+    auto frame(int64_t msc, std::chrono::nanoseconds ust) -> mg::Frame
+    {
+        return mg::Frame{msc, mt::PosixTimestamp{CLOCK_MONOTONIC, ust}};
+    }
+
+    /// Runs f on a thread of its own, as a platform reporting flips on one output and a compositor consuming
+    /// buffers for it do
+    template<typename F>
+    void on_another_thread(F f)
+    {
+        std::thread{f}.join();
+    }
+
+    std::shared_ptr<NiceMock<mtd::MockDisplayReport>> const report{
+        std::make_shared<NiceMock<mtd::MockDisplayReport>>()};
+    mtd::FakeAlarmFactory alarm_factory;
+    mg::VsyncPresentationClock clock{report, mir::test::fake_shared(alarm_factory), 100ms};
+    std::vector<mg::PresentationClock::Presentation> presentations;
+    std::function<void(mg::PresentationClock::Presentation const&)> const record =
+        [this](auto const& presentation) { presentations.push_back(presentation); };
+};
+}
+
+TEST_F(VsyncPresentationClock, forwards_reports)
+{
+    auto const flip = frame(7, 1s);
+
+    EXPECT_CALL(*report, report_vsync(3, Field(&mg::Frame::msc, Eq(7))));
+    EXPECT_CALL(*report, report_drm_master_failure(42));
+
+    clock.report_vsync(3, flip);
+    clock.report_drm_master_failure(42);
+}
+
+TEST_F(VsyncPresentationClock, without_flips_presents_immediately)
+{
+    auto const before = mt::PosixTimestamp::now(CLOCK_MONOTONIC);
+
+    clock.on_next_presentation(record);
+
+    ASSERT_THAT(presentations.size(), Eq(1u));
+    EXPECT_FALSE(presentations[0].vsync);
+    EXPECT_THAT(presentations[0].frame.ust, Ge(before));
+    EXPECT_THAT(presentations[0].refresh, Eq(0ns));
+}
+
+TEST_F(VsyncPresentationClock, once_flips_are_reported_presents_on_next_flip)
+{
+    clock.report_vsync(1, frame(1, 1000ms));
+
+    clock.on_next_presentation(record);
+    EXPECT_THAT(presentations.size(), Eq(0u));
+
+    clock.report_vsync(1, frame(2, 1016ms));
+    ASSERT_THAT(presentations.size(), Eq(1u));
+    EXPECT_TRUE(presentations[0].vsync);
+    EXPECT_THAT(presentations[0].frame.msc, Eq(2));
+    EXPECT_THAT(presentations[0].frame.ust.nanoseconds, Eq(1016ms));
+
+    clock.report_vsync(1, frame(3, 1032ms));
+    EXPECT_THAT(presentations.size(), Eq(1u));
+}
+
+TEST_F(VsyncPresentationClock, estimates_refresh_from_consecutive_flips_on_an_output)
+{
+    clock.report_vsync(1, frame(10, 1000ms));
+    clock.report_vsync(2, frame(50, 1005ms));
+
+    clock.on_next_presentation(record);
+    clock.report_vsync(1, frame(12, 1032ms));
+
+    ASSERT_THAT(presentations.size(), Eq(1u));
+    EXPECT_THAT(presentations[0].refresh, Eq(16ms));
+}
+
+TEST_F(VsyncPresentationClock, presents_on_flip_of_output_composited_by_registering_thread)
+{
+    // This thread composites the slower output 2; another composites output 1
+    clock.report_vsync(2, frame(1, 1000ms));
+    on_another_thread([&]{ clock.report_vsync(1, frame(1, 1000ms)); });
+
+    clock.on_next_presentation(record);
+
+    on_another_thread([&]{ clock.report_vsync(1, frame(2, 1016ms)); });
+    EXPECT_THAT(presentations.size(), Eq(0u));
+
+    clock.report_vsync(2, frame(2, 1033ms));
+    ASSERT_THAT(presentations.size(), Eq(1u));
+    EXPECT_THAT(presentations[0].frame.ust.nanoseconds, Eq(1033ms));
+    EXPECT_THAT(presentations[0].refresh, Eq(33ms));
+}
+
+TEST_F(VsyncPresentationClock, from_thread_without_flips_presents_on_flip_of_any_output)
+{
+    clock.report_vsync(1, frame(1, 1000ms));
+
+    on_another_thread([&]{ clock.on_next_presentation(record); });
+    EXPECT_THAT(presentations.size(), Eq(0u));
+
+    on_another_thread([&]{ clock.report_vsync(2, frame(7, 1005ms)); });
+    ASSERT_THAT(presentations.size(), Eq(1u));
+    EXPECT_THAT(presentations[0].frame.msc, Eq(7));
+}
+
+TEST_F(VsyncPresentationClock, ignores_flips_the_registering_thread_reported_to_another_clock)
+{
+    mg::VsyncPresentationClock other_clock{report, mir::test::fake_shared(alarm_factory), 100ms};
+    other_clock.report_vsync(2, frame(1, 1000ms));
+    on_another_thread([&]{ clock.report_vsync(1, frame(1, 1000ms)); });
+
+    clock.on_next_presentation(record);
+
+    on_another_thread([&]{ clock.report_vsync(1, frame(2, 1016ms)); });
+    EXPECT_THAT(presentations.size(), Eq(1u));
+}
+
+TEST_F(VsyncPresentationClock, presents_without_flip_after_timeout)
+{
+    clock.report_vsync(1, frame(1, 1000ms));
+
+    clock.on_next_presentation(record);
+    alarm_factory.advance_by(99ms);
+    EXPECT_THAT(presentations.size(), Eq(0u));
+
+    alarm_factory.advance_by(2ms);
+    ASSERT_THAT(presentations.size(), Eq(1u));
+    EXPECT_FALSE(presentations[0].vsync);
+
+    clock.report_vsync(1, frame(2, 1116ms));
+    EXPECT_THAT(presentations.size(), Eq(1u));
+}
+
+TEST_F(VsyncPresentationClock, flip_cancels_timeout)
+{
+    clock.report_vsync(1, frame(1, 1000ms));
+
+    clock.on_next_presentation(record);
+    clock.report_vsync(1, frame(2, 1016ms));
+    ASSERT_THAT(presentations.size(), Eq(1u));
+
+    clock.on_next_presentation(record);
+    alarm_factory.advance_by(99ms);
+    EXPECT_THAT(presentations.size(), Eq(1u));
+
+    alarm_factory.advance_by(2ms);
+    ASSERT_THAT(presentations.size(), Eq(2u));
+    EXPECT_FALSE(presentations[1].vsync);
+}
@@ -0,0 +1,264 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/report/metrics/metrics.h"
+#include "src/server/report/metrics/registry.h"
+#include "src/server/report/metrics/compositor_report.h"
+#include "src/server/report/metrics/scrape_endpoint.h"
+#include "mir/test/doubles/advanceable_clock.h"
+#include "mir/test/doubles/mock_event_handler_register.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace mtd = mir::test::doubles;
+namespace mrm = mir::report::metrics;
+
+using namespace testing;
+using namespace std::literals::chrono_literals;
+
+namespace
+{
+std::string exposition_of(mrm::Registry const& registry)
+{
+    std::ostringstream out;
+    registry.write_prometheus(out);
+    return out.str();
+}
+
+mir::Fd connect_to(std::string const& path)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    mir::Fd fd{socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+        return {};
+    return fd;
+}
+
+std::string read_all(int fd)
+{
+    std::string text;
+    char buffer[1024];
+    ssize_t got;
+    while ((got = read(fd, buffer, sizeof buffer)) > 0)
+        text.append(buffer, got);
+    return text;
+}
+
+struct MetricsScrapeEndpoint : Test
+{
+    MetricsScrapeEndpoint()
+    {
+        EXPECT_CALL(*handlers, register_fd_handler(_, _, _)).WillOnce(SaveArg<2>(&handler));
+    }
+
+    ~MetricsScrapeEndpoint()
+    {
+        rmdir(socket_path.substr(0, socket_path.rfind('/')).c_str());
+    }
+
+    static std::string temporary_socket_path()
+    {
+        char dir_template[] = "/tmp/mir-metrics-XXXXXX";
+        return std::string{mkdtemp(dir_template)} + "/socket";
+    }
+
+    std::string const socket_path{temporary_socket_path()};
+    std::shared_ptr<mrm::Registry> const registry{std::make_shared<mrm::Registry>()};
+    std::shared_ptr<NiceMock<mtd::MockEventHandlerRegister>> const handlers{
+        std::make_shared<NiceMock<mtd::MockEventHandlerRegister>>()};
+    std::function<void(int)> handler;
+};
+}
+
+TEST(MetricsHistogram, small_values_get_a_bucket_each)
+{
+    for (std::uint64_t v = 0; v != 16; ++v)
+    {
+        EXPECT_THAT(mrm::Histogram::bucket_index(v), Eq(v));
+        EXPECT_THAT(mrm::Histogram::bucket_lower_bound(v), Eq(v));
+    }
+}
+
+TEST(MetricsHistogram, buckets_are_contiguous_and_within_one_sixteenth)
+{
+    for (std::uint64_t v = 16; v < (std::uint64_t{1} << 24); v += v / 7 + 1)
+    {
+        auto const index = mrm::Histogram::bucket_index(v);
+        auto const lower = mrm::Histogram::bucket_lower_bound(index);
+        auto const upper = mrm::Histogram::bucket_lower_bound(index + 1);
+
+        EXPECT_THAT(v, AllOf(Ge(lower), Lt(upper))) << "value: " << v;
+        EXPECT_THAT(upper - lower, Le(lower / 16)) << "value: " << v;
+        EXPECT_THAT(mrm::Histogram::bucket_index(upper), Eq(index + 1)) << "value: " << v;
+    }
+}
+
+TEST(MetricsHistogram, huge_values_are_clamped_to_last_bucket)
+{
+    EXPECT_THAT(mrm::Histogram::bucket_index(~std::uint64_t{0}), Eq(mrm::Histogram::bucket_count - 1));
+    EXPECT_THAT(
+        mrm::Histogram::bucket_index((std::uint64_t{1} << mrm::Histogram::max_value_bits) - 1),
+        Eq(mrm::Histogram::bucket_count - 1));
+}
+
+TEST(MetricsHistogram, records_samples)
+{
+    mrm::Histogram histogram;
+
+    histogram.record(3);
+    histogram.record(1000);
+    histogram.record(1000);
+
+    auto const counts = histogram.bucket_counts();
+    EXPECT_THAT(counts[3], Eq(1u));
+    EXPECT_THAT(counts[mrm::Histogram::bucket_index(1000)], Eq(2u));
+    EXPECT_THAT(histogram.sum(), Eq(2003u));
+}
+
+TEST(MetricsCounter, sums_increments_from_all_threads)
+{
+    mrm::Counter counter;
+    int const thread_count{16};
+    int const increments{10000};
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i != thread_count; ++i)
+    {
+        threads.emplace_back(
+            [&counter]
+            {
+                for (int j = 0; j != increments; ++j)
+                    counter.increment();
+            });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_THAT(counter.value(), Eq(std::uint64_t{thread_count} * increments));
+}
+
+TEST(MetricsRegistry, returns_existing_metric_for_same_name)
+{
+    mrm::Registry registry;
+
+    auto& first = registry.counter("requests_total", "Requests");
+    auto& second = registry.counter("requests_total", "Requests");
+
+    EXPECT_THAT(&second, Eq(&first));
+}
+
+TEST(MetricsRegistry, rejects_reuse_of_name_for_different_type)
+{
+    mrm::Registry registry;
+
+    registry.counter("things", "Things");
+
+    EXPECT_THROW(registry.gauge("things", "Things"), std::logic_error);
+}
+
+TEST(MetricsRegistry, writes_prometheus_text_format)
+{
+    mrm::Registry registry;
+
+    registry.counter("requests_total", "Requests served").increment(3);
+    registry.gauge("surfaces", "Live surfaces").set(-2);
+    auto& latency = registry.histogram("latency_seconds", "Latency", 0.5);
+    latency.record(1);
+    latency.record(40);
+
+    auto const text = exposition_of(registry);
+
+    EXPECT_THAT(text, HasSubstr(
+        "# HELP requests_total Requests served\n"
+        "# TYPE requests_total counter\n"
+        "requests_total 3\n"));
+    EXPECT_THAT(text, HasSubstr(
+        "# TYPE surfaces gauge\n"
+        "surfaces -2\n"));
+    EXPECT_THAT(text, HasSubstr("# TYPE latency_seconds histogram\n"));
+    EXPECT_THAT(text, HasSubstr("latency_seconds_bucket{le=\"8\"} 1\n"));
+    EXPECT_THAT(text, HasSubstr("latency_seconds_bucket{le=\"32\"} 2\n"));
+    EXPECT_THAT(text, HasSubstr("latency_seconds_bucket{le=\"+Inf\"} 2\n"));
+    EXPECT_THAT(text, HasSubstr("latency_seconds_sum 20.5\n"));
+    EXPECT_THAT(text, HasSubstr("latency_seconds_count 2\n"));
+}
+
+TEST(MetricsCompositorReport, counts_rendered_and_bypassed_frames)
+{
+    auto const registry = std::make_shared<mrm::Registry>();
+    auto const clock = std::make_shared<mtd::AdvanceableClock>();
+    mrm::CompositorReport report{registry, clock};
+    void const* const display_id = nullptr;
+
+    report.began_frame(display_id);
+    clock->advance_by(4ms);
+    report.rendered_frame(display_id);
+    report.finished_frame(display_id);
+
+    report.began_frame(display_id);
+    report.finished_frame(display_id);
+
+    auto const text = exposition_of(*registry);
+
+    EXPECT_THAT(text, HasSubstr("mir_compositor_frames_total 2\n"));
+    EXPECT_THAT(text, HasSubstr("mir_compositor_bypassed_frames_total 1\n"));
+    EXPECT_THAT(text, HasSubstr("mir_compositor_render_seconds_count 1\n"));
+    EXPECT_THAT(text, HasSubstr("mir_compositor_render_seconds_sum 0.004\n"));
+}
+
+TEST_F(MetricsScrapeEndpoint, answers_requests)
+{
+    mrm::ScrapeEndpoint endpoint{socket_path, registry, handlers};
+    ASSERT_TRUE(handler);
+
+    auto const client = connect_to(socket_path);
+    ASSERT_THAT(client, Ge(0));
+    std::string const request{"GET /metrics HTTP/1.0\r\n\r\n"};
+    ASSERT_THAT(write(client, request.data(), request.size()), Eq(ssize_t(request.size())));
+
+    handler(-1);
+
+    EXPECT_THAT(read_all(client), StartsWith("HTTP/1.0 200 OK\r\n"));
+}
+
+TEST_F(MetricsScrapeEndpoint, does_not_wait_for_clients_to_send_their_request)
+{
+    mrm::ScrapeEndpoint endpoint{socket_path, registry, handlers};
+    ASSERT_TRUE(handler);
+
+    auto const client = connect_to(socket_path);
+    ASSERT_THAT(client, Ge(0));
+
+    auto const before = std::chrono::steady_clock::now();
+    handler(-1);
+    EXPECT_THAT(std::chrono::steady_clock::now() - before, Lt(10ms));
+
+    EXPECT_THAT(read_all(client), StartsWith("HTTP/1.0 200 OK\r\n"));
+}
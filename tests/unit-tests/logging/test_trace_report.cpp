@@ -0,0 +1,183 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/report/trace/tracer.h"
+#include "src/server/report/trace/compositor_report.h"
+#include "mir/test/doubles/advanceable_clock.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <future>
+#include <sstream>
+#include <thread>
+
+namespace mtd = mir::test::doubles;
+namespace mrt = mir::report::trace;
+
+using namespace testing;
+using namespace std::literals::chrono_literals;
+
+namespace
+{
+struct Tracer : Test
+{
+    std::string json() const
+    {
+        std::ostringstream out;
+        tracer->write_json(out);
+        return out.str();
+    }
+
+    std::shared_ptr<mtd::AdvanceableClock> const clock{std::make_shared<mtd::AdvanceableClock>()};
+    std::shared_ptr<mrt::Tracer> const tracer{std::make_shared<mrt::Tracer>(clock, 4)};
+};
+}
+
+TEST_F(Tracer, records_nothing_until_started)
+{
+    tracer->instant("test", "too early");
+    tracer->start();
+    tracer->instant("test", "on time");
+
+    EXPECT_THAT(json(), Not(HasSubstr("too early")));
+    EXPECT_THAT(json(), HasSubstr("\"name\":\"on time\""));
+}
+
+TEST_F(Tracer, omits_events_from_before_latest_start)
+{
+    tracer->start();
+    tracer->instant("test", "first recording");
+    tracer->stop();
+    tracer->instant("test", "while stopped");
+
+    clock->advance_by(1ms);
+    tracer->start();
+    tracer->instant("test", "second recording");
+
+    auto const text = json();
+    EXPECT_THAT(text, Not(HasSubstr("first recording")));
+    EXPECT_THAT(text, Not(HasSubstr("while stopped")));
+    EXPECT_THAT(text, HasSubstr("second recording"));
+}
+
+TEST_F(Tracer, keeps_most_recent_events_when_buffer_wraps)
+{
+    tracer->start();
+
+    char const* const names[] = {"e0", "e1", "e2", "e3", "e4", "e5"};
+    for (auto const name : names)
+        tracer->instant("test", name);
+
+    auto const text = json();
+    EXPECT_THAT(text, Not(HasSubstr("\"e1\"")));
+    EXPECT_THAT(text, HasSubstr("\"e2\""));
+    EXPECT_THAT(text, HasSubstr("\"e5\""));
+}
+
+TEST_F(Tracer, writes_chrome_trace_events)
+{
+    tracer->start();
+    auto const start = std::chrono::duration_cast<std::chrono::nanoseconds>(clock->now().time_since_epoch()).count();
+
+    auto const when = (start / 1000 + 1) * 1000 + 67;
+
+    tracer->instant_at(when, "test", "event", {"answer", 42}, {"negative", -1});
+
+    auto const text = json();
+    EXPECT_THAT(text, StartsWith("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+    EXPECT_THAT(text, HasSubstr("\"ph\":\"i\",\"cat\":\"test\",\"name\":\"event\""));
+    EXPECT_THAT(text, HasSubstr(",\"ts\":" + std::to_string(when / 1000) + ".067,\"s\":\"t\""));
+    EXPECT_THAT(text, HasSubstr("\"args\":{\"answer\":42,\"negative\":-1}"));
+    EXPECT_THAT(text, HasSubstr("\"ph\":\"M\",\"name\":\"thread_name\""));
+    EXPECT_THAT(text, EndsWith("]}\n"));
+}
+
+TEST_F(Tracer, records_each_thread_separately)
+{
+    tracer->start();
+
+    tracer->instant("test", "this thread");
+    std::thread{[this] { tracer->instant("test", "other thread"); }}.join();
+
+    auto const text = json();
+    auto const first_thread = text.find("\"thread_name\"");
+    auto const second_thread = text.find("\"thread_name\"", first_thread + 1);
+
+    EXPECT_THAT(second_thread, Ne(std::string::npos));
+    EXPECT_THAT(text, HasSubstr("other thread"));
+    EXPECT_THAT(text, HasSubstr("this thread"));
+}
+
+TEST_F(Tracer, reuses_buffers_of_exited_threads)
+{
+    tracer->start();
+
+    std::thread{[this] { tracer->instant("test", "exited thread"); }}.join();
+    EXPECT_THAT(json(), HasSubstr("exited thread"));
+
+    std::thread{[this] { tracer->instant("test", "later thread"); }}.join();
+
+    auto const text = json();
+    auto const first_thread = text.find("\"thread_name\"");
+    auto const second_thread = text.find("\"thread_name\"", first_thread + 1);
+
+    EXPECT_THAT(second_thread, Eq(std::string::npos));
+    EXPECT_THAT(text, Not(HasSubstr("exited thread")));
+    EXPECT_THAT(text, HasSubstr("later thread"));
+}
+
+TEST_F(Tracer, threads_may_outlive_the_tracers_they_recorded_to)
+{
+    auto doomed = std::make_unique<mrt::Tracer>(clock, 4);
+    doomed->start();
+
+    std::promise<void> recorded;
+    std::promise<void> destroyed;
+    std::thread thread{[&]
+        {
+            doomed->instant("test", "event");
+            recorded.set_value();
+            destroyed.get_future().wait();
+        }};
+
+    doomed->instant("test", "event");
+    recorded.get_future().wait();
+    doomed.reset();
+    destroyed.set_value();
+    thread.join();
+
+    tracer->start();
+    tracer->instant("test", "after");
+    EXPECT_THAT(json(), HasSubstr("\"name\":\"after\""));
+}
+
+TEST_F(Tracer, compositor_report_records_frames_as_slices)
+{
+    mrt::CompositorReport report{tracer};
+    void const* const display_id = nullptr;
+
+    tracer->start();
+    report.began_frame(display_id);
+    clock->advance_by(2ms);
+    report.rendered_frame(display_id);
+    report.finished_frame(display_id);
+
+    auto const text = json();
+    EXPECT_THAT(text, HasSubstr("\"ph\":\"B\",\"cat\":\"compositor\",\"name\":\"frame\""));
+    EXPECT_THAT(text, HasSubstr("\"ph\":\"i\",\"cat\":\"compositor\",\"name\":\"rendered\""));
+    EXPECT_THAT(text, HasSubstr("\"ph\":\"E\",\"cat\":\"compositor\",\"name\":\"frame\""));
+}
@@ -59,6 +59,28 @@ struct MockKMSOutput : public graphics::mesa::KMSOutput
     MOCK_METHOD1(schedule_page_flip_thunk, bool(graphics::mesa::FBHandle const*));
     MOCK_METHOD0(wait_for_page_flip, void());
 
+    bool add_page_flip(
+        graphics::mesa::AtomicCommit& commit,
+        graphics::mesa::FBHandle const& fb,
+        std::vector<graphics::mesa::OverlayLayer> const& overlays) override
+    {
+        return add_page_flip_thunk(&commit, &fb, overlays);
+    }
+    MOCK_METHOD3(add_page_flip_thunk, bool(
+        graphics::mesa::AtomicCommit*,
+        graphics::mesa::FBHandle const*,
+        std::vector<graphics::mesa::OverlayLayer> const&));
+
+    bool test_overlays(
+        graphics::mesa::FBHandle const& fb,
+        std::vector<graphics::mesa::OverlayLayer> const& overlays) override
+    {
+        return test_overlays_thunk(&fb, overlays);
+    }
+    MOCK_METHOD2(test_overlays_thunk, bool(
+        graphics::mesa::FBHandle const*,
+        std::vector<graphics::mesa::OverlayLayer> const&));
+
     MOCK_CONST_METHOD0(last_frame, graphics::Frame());
 
     MOCK_METHOD1(set_cursor, bool(gbm_bo*));
@@ -276,12 +276,34 @@ TEST_F(MesaBufferAllocatorTest, correct_buffer_handle_is_destroyed)
     allocator->alloc_buffer(buffer_properties);
 }
 
+TEST_F(MesaBufferAllocatorTest, buffer_object_exported_to_a_client_is_not_recycled)
+{
+    using namespace testing;
+    gbm_bo* bo{reinterpret_cast<gbm_bo*>(0xabcd)};
+
+    EXPECT_CALL(mock_gbm, gbm_bo_create(_,_,_,_,_))
+        .WillOnce(Return(bo));
+
+    auto buffer = allocator->alloc_buffer(buffer_properties);
+    buffer->native_buffer_handle();
+
+    EXPECT_CALL(mock_gbm, gbm_bo_destroy(bo));
+    buffer.reset();
+    Mock::VerifyAndClearExpectations(&mock_gbm);
+
+    EXPECT_CALL(mock_gbm, gbm_bo_create(_,_,_,_,_))
+        .WillOnce(Return(reinterpret_cast<gbm_bo*>(0xabce)));
+    allocator->alloc_buffer(buffer_properties);
+}
+
 TEST_F(MesaBufferAllocatorTest, throws_on_buffer_creation_failure)
 {
     using namespace testing;
 
+    // Once, then again after trimming the buffer pool
     EXPECT_CALL(mock_gbm, gbm_bo_create(_,_,_,_,_))
-        .WillOnce(Return(reinterpret_cast<gbm_bo*>(0)));
+        .Times(2)
+        .WillRepeatedly(Return(reinterpret_cast<gbm_bo*>(0)));
     EXPECT_CALL(mock_gbm, gbm_bo_destroy(_))
         .Times(0);
 
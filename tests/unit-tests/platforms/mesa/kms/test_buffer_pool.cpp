@@ -0,0 +1,280 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/mesa/server/buffer_pool.h"
+
+#include "mir/test/doubles/mock_gbm.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstring>
+#include <vector>
+
+namespace mgm = mir::graphics::mesa;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+uint32_t const bytes_per_pixel{4};
+
+struct BufferPoolTest : Test
+{
+    BufferPoolTest()
+    {
+        ON_CALL(mock_gbm, gbm_bo_create(_,_,_,_,_))
+            .WillByDefault(Invoke(
+                [this](gbm_device*, uint32_t width, uint32_t height, uint32_t, uint32_t)
+                {
+                    auto const bo = reinterpret_cast<gbm_bo*>(next_bo++);
+                    sizes.push_back({bo, {width, height}});
+                    return bo;
+                }));
+        ON_CALL(mock_gbm, gbm_bo_get_width(_))
+            .WillByDefault(Invoke([this](gbm_bo* bo) { return size_of(bo).width.as_uint32_t(); }));
+        ON_CALL(mock_gbm, gbm_bo_get_height(_))
+            .WillByDefault(Invoke([this](gbm_bo* bo) { return size_of(bo).height.as_uint32_t(); }));
+        ON_CALL(mock_gbm, gbm_bo_get_stride(_))
+            .WillByDefault(Invoke([this](gbm_bo* bo) { return size_of(bo).width.as_uint32_t() * bytes_per_pixel; }));
+        ON_CALL(mock_gbm, gbm_bo_map(_,_,_,_,_,_,_,_))
+            .WillByDefault(Invoke(
+                [this](gbm_bo* bo, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t* stride, void**)
+                {
+                    *stride = size_of(bo).width.as_uint32_t() * bytes_per_pixel;
+                    mapping.assign(*stride * size_of(bo).height.as_uint32_t(), 0xff);
+                    return mapping.data();
+                }));
+    }
+
+    auto size_of(gbm_bo* bo) const -> geom::Size
+    {
+        for (auto const& entry : sizes)
+        {
+            if (entry.first == bo)
+                return entry.second;
+        }
+        return {};
+    }
+
+    auto bytes_for(geom::Size size) const -> std::size_t
+    {
+        return size.width.as_uint32_t() * bytes_per_pixel * size.height.as_uint32_t();
+    }
+
+    NiceMock<mtd::MockGBM> mock_gbm;
+    gbm_device* const device{mock_gbm.fake_gbm.device};
+    uintptr_t next_bo{0x1000};
+    std::vector<std::pair<gbm_bo*, geom::Size>> sizes;
+    std::vector<unsigned char> mapping;
+
+    geom::Size const size{64, 32};
+    uint32_t const format{GBM_FORMAT_ARGB8888};
+    uint32_t const flags{GBM_BO_USE_RENDERING};
+};
+}
+
+TEST_F(BufferPoolTest, released_buffer_object_is_reused_for_matching_allocation)
+{
+    auto const pool = std::make_shared<mgm::BufferPool>(device, mgm::BufferPool::default_budget);
+
+    EXPECT_CALL(mock_gbm, gbm_bo_create(_,_,_,_,_)).Times(1);
+
+    gbm_bo* first_bo;
+    {
+        auto const first = pool->create_bo(size, format, flags);
+        first_bo = first.get();
+    }
+    EXPECT_THAT(pool->pooled_bytes(), Eq(bytes_for(size)));
+
+    auto const second = pool->create_bo(size, format, flags);
+    EXPECT_THAT(second.get(), Eq(first_bo));
+    EXPECT_THAT(pool->pooled_bytes(), Eq(0u));
+}
+
+TEST_F(BufferPoolTest, released_buffer_object_is_not_reused_for_different_allocation)
+{
+    auto const pool = std::make_shared<mgm::BufferPool>(device, mgm::BufferPool::default_budget);
+
+    EXPECT_CALL(mock_gbm, gbm_bo_create(_,_,_,_,_)).Times(4);
+
+    pool->create_bo(size, format, flags);
+
+    pool->create_bo(size, format, flags | GBM_BO_USE_SCANOUT);
+    pool->create_bo(size, GBM_FORMAT_XRGB8888, flags);
+    pool->create_bo({size.width, size.height + geom::DeltaY{1}}, format, flags);
+}
+
+TEST_F(BufferPoolTest, reused_buffer_object_is_cleared)
+{
+    auto const pool = std::make_shared<mgm::BufferPool>(device, mgm::BufferPool::default_budget);
+
+    pool->create_bo(size, format, flags);
+
+    EXPECT_CALL(mock_gbm, gbm_bo_map(_, 0, 0, size.width.as_uint32_t(), size.height.as_uint32_t(), _, _, _));
+    EXPECT_CALL(mock_gbm, gbm_bo_unmap(_,_));
+
+    pool->create_bo(size, format, flags);
+
+    EXPECT_THAT(mapping, Each(Eq(0)));
+}
+
+TEST_F(BufferPoolTest, buffer_object_that_cannot_be_cleared_is_not_reused)
+{
+    auto const pool = std::make_shared<mgm::BufferPool>(device, mgm::BufferPool::default_budget);
+
+    gbm_bo* first_bo;
+    {
+        auto const first = pool->create_bo(size, format, flags);
+        first_bo = first.get();
+    }
+
+    EXPECT_CALL(mock_gbm, gbm_bo_destroy(_)).Times(AnyNumber());
+    EXPECT_CALL(mock_gbm, gbm_bo_map(_,_,_,_,_,_,_,_)).WillOnce(Return(nullptr));
+    EXPECT_CALL(mock_gbm, gbm_bo_destroy(first_bo));
+    EXPECT_CALL(mock_gbm, gbm_bo_create(_,_,_,_,_));
+
+    auto const second = pool->create_bo(size, format, flags);
+    EXPECT_THAT(second.get(), Ne(first_bo));
+}
+
+TEST_F(BufferPoolTest, least_recently_released_is_freed_when_over_budget)
+{
+    auto const pool = std::make_shared<mgm::BufferPool>(device, 2 * bytes_for(size));
+
+    auto first = pool->create_bo(size, format, flags);
+    auto second = pool->create_bo(size, format, flags);
+    auto third = pool->create_bo(size, format, flags);
+    auto const first_bo = first.get();
+
+    EXPECT_CALL(mock_gbm, gbm_bo_destroy(_)).Times(0);
+    first.reset();
+    second.reset();
+    Mock::VerifyAndClearExpectations(&mock_gbm);
+
+    EXPECT_CALL(mock_gbm, gbm_bo_destroy(_)).Times(AnyNumber());
+    EXPECT_CALL(mock_gbm, gbm_bo_destroy(first_bo));
+    third.reset();
+
+    EXPECT_THAT(pool->pooled_bytes(), Eq(2 * bytes_for(size)));
+}
+
+TEST_F(BufferPoolTest, trim_frees_everything_pooled)
+{
+    auto const pool = std::make_shared<mgm::BufferPool>(device, mgm::BufferPool::default_budget);
+
+    pool->create_bo(size, format, flags);
+    pool->create_bo(size, format, flags | GBM_BO_USE_SCANOUT);
+
+    EXPECT_CALL(mock_gbm, gbm_bo_destroy(_)).Times(2);
+    pool->trim();
+
+    EXPECT_THAT(pool->pooled_bytes(), Eq(0u));
+}
+
+TEST_F(BufferPoolTest, pool_is_trimmed_and_allocation_retried_on_failure)
+{
+    auto const pool = std::make_shared<mgm::BufferPool>(device, mgm::BufferPool::default_budget);
+
+    pool->create_bo(size, format, flags);
+
+    EXPECT_CALL(mock_gbm, gbm_bo_destroy(_)).Times(AnyNumber());
+    {
+        InSequence seq;
+        EXPECT_CALL(mock_gbm, gbm_bo_create(_,_,_,_,GBM_BO_USE_SCANOUT)).WillOnce(Return(nullptr));
+        EXPECT_CALL(mock_gbm, gbm_bo_destroy(_));
+        EXPECT_CALL(mock_gbm, gbm_bo_create(_,_,_,_,GBM_BO_USE_SCANOUT));
+    }
+
+    EXPECT_THAT(pool->create_bo(size, format, GBM_BO_USE_SCANOUT), NotNull());
+}
+
+TEST_F(BufferPoolTest, throws_when_allocation_fails_after_trim)
+{
+    auto const pool = std::make_shared<mgm::BufferPool>(device, mgm::BufferPool::default_budget);
+
+    EXPECT_CALL(mock_gbm, gbm_bo_create(_,_,_,_,_)).Times(2).WillRepeatedly(Return(nullptr));
+
+    EXPECT_THROW({ pool->create_bo(size, format, flags); }, std::runtime_error);
+}
+
+TEST_F(BufferPoolTest, buffer_object_outliving_pool_is_destroyed_on_release)
+{
+    auto pool = std::make_shared<mgm::BufferPool>(device, mgm::BufferPool::default_budget);
+    auto bo = pool->create_bo(size, format, flags);
+    auto const raw_bo = bo.get();
+
+    pool.reset();
+
+    EXPECT_CALL(mock_gbm, gbm_bo_destroy(raw_bo));
+    bo.reset();
+}
+
+TEST_F(BufferPoolTest, exported_buffer_object_is_destroyed_not_pooled)
+{
+    auto const pool = std::make_shared<mgm::BufferPool>(device, mgm::BufferPool::default_budget);
+
+    EXPECT_CALL(mock_gbm, gbm_bo_create(_,_,_,_,_)).Times(2);
+
+    auto bo = pool->create_bo(size, format, flags);
+    auto const raw_bo = bo.get();
+    mgm::BufferPool::exported(bo);
+
+    EXPECT_CALL(mock_gbm, gbm_bo_destroy(_)).Times(AnyNumber());
+    EXPECT_CALL(mock_gbm, gbm_bo_destroy(raw_bo));
+    bo.reset();
+    EXPECT_THAT(pool->pooled_bytes(), Eq(0u));
+
+    auto const second = pool->create_bo(size, format, flags);
+    EXPECT_THAT(second.get(), Ne(raw_bo));
+}
+
+TEST_F(BufferPoolTest, exporting_a_buffer_object_from_elsewhere_is_harmless)
+{
+    auto const bo = std::shared_ptr<gbm_bo>{reinterpret_cast<gbm_bo*>(0xb0), [](gbm_bo*){}};
+
+    mgm::BufferPool::exported(bo);
+}
+
+TEST_F(BufferPoolTest, released_pixel_store_is_reused_for_same_size)
+{
+    auto const pool = std::make_shared<mgm::BufferPool>(device, mgm::BufferPool::default_budget);
+
+    unsigned char* first_pixels;
+    {
+        auto const first = pool->create_pixels(4096);
+        first_pixels = first.get();
+    }
+
+    EXPECT_THAT(pool->create_pixels(4096).get(), Eq(first_pixels));
+}
+
+TEST_F(BufferPoolTest, somewhat_larger_pixel_store_is_reused)
+{
+    auto const pool = std::make_shared<mgm::BufferPool>(device, mgm::BufferPool::default_budget);
+
+    unsigned char* first_pixels;
+    {
+        auto const first = pool->create_pixels(4096);
+        first_pixels = first.get();
+    }
+
+    EXPECT_THAT(pool->create_pixels(1024).get(), Ne(first_pixels));
+    EXPECT_THAT(pool->create_pixels(8192).get(), Ne(first_pixels));
+    EXPECT_THAT(pool->create_pixels(3000).get(), Eq(first_pixels));
+}
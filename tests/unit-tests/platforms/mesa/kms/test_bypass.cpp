@@ -268,3 +268,39 @@ TEST_F(BypassMatchTest, multimonitor_oversized_no_bypass)
     EXPECT_EQ(list.rend(), std::find_if(list.rbegin(), list.rend(), primary_matcher));
     EXPECT_EQ(list.rend(), std::find_if(list.rbegin(), list.rend(), secondary_matcher));
 }
+
+TEST_F(BypassMatchTest, windows_above_fullscreen_window_are_overlay_candidates)
+{
+    auto fullscreen = std::make_shared<mtd::FakeRenderable>(0, 0, 1920, 1200);
+    auto video_controls = std::make_shared<mtd::FakeRenderable>(0, 1000, 1920, 200);
+    auto notification = std::make_shared<mtd::FakeRenderable>(1600, 0, 320, 100);
+    auto offscreen = std::make_shared<mtd::FakeRenderable>(1920, 0, 100, 100);
+    mg::RenderableList list{fullscreen, video_controls, offscreen, notification};
+
+    mgm::ScanoutCandidates candidates;
+    ASSERT_TRUE(mgm::find_scanout_candidates(list, primary_monitor, candidates));
+    EXPECT_EQ(fullscreen, candidates.primary);
+    EXPECT_EQ((mg::RenderableList{video_controls, notification}), candidates.overlays);
+}
+
+TEST_F(BypassMatchTest, translucent_window_above_fullscreen_window_is_not_an_overlay_candidate)
+{
+    mg::RenderableList list{
+        std::make_shared<mtd::FakeRenderable>(0, 0, 1920, 1200),
+        std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{12, 34}, {56, 78}}, 0.5f)
+    };
+
+    mgm::ScanoutCandidates candidates;
+    EXPECT_FALSE(mgm::find_scanout_candidates(list, primary_monitor, candidates));
+}
+
+TEST_F(BypassMatchTest, window_straddling_monitors_is_not_an_overlay_candidate)
+{
+    mg::RenderableList list{
+        std::make_shared<mtd::FakeRenderable>(0, 0, 1920, 1200),
+        std::make_shared<mtd::FakeRenderable>(1800, 0, 240, 100)
+    };
+
+    mgm::ScanoutCandidates candidates;
+    EXPECT_FALSE(mgm::find_scanout_candidates(list, primary_monitor, candidates));
+}
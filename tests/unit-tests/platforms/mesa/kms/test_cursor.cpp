@@ -806,3 +806,31 @@ TEST_F(MesaCursorTest, show_cursor_sets_cursor_with_hotspot)
     cursor.move_to(cursor_location_2);
 }
 
+
+TEST_F(MesaCursorTest, showing_a_recent_image_again_does_not_rewrite_buffer)
+{
+    using namespace testing;
+
+    cursor.show(stub_image);
+    cursor.show(SinglePixelCursorImage());
+
+    // A different instance, but the same image
+    StubCursorImage const same_image;
+
+    EXPECT_CALL(mock_gbm, gbm_bo_write(_, _, _)).Times(0);
+    EXPECT_CALL(*output_container.outputs[0], set_cursor(_));
+
+    cursor.show(same_image);
+}
+
+TEST_F(MesaCursorTest, showing_same_image_after_rotation_rewrites_buffer)
+{
+    using namespace testing;
+
+    cursor.show(stub_image);
+    current_configuration.conf.set_orentation_of_output(mg::DisplayConfigurationOutputId{0}, mir_orientation_inverted);
+
+    EXPECT_CALL(mock_gbm, gbm_bo_write(_, _, _));
+
+    cursor.show(stub_image);
+}
@@ -20,6 +20,8 @@
 #include "mir/test/doubles/null_console_services.h"
 #include "src/platforms/mesa/server/kms/platform.h"
 #include "src/platforms/mesa/server/kms/display_buffer.h"
+#include "src/platforms/mesa/server/kms/page_flipper.h"
+#include "src/platforms/mesa/server/kms/atomic_commit.h"
 #include "src/platforms/mesa/include/native_buffer.h"
 #include "src/server/report/null_report_factory.h"
 #include "mir/test/doubles/mock_egl.h"
@@ -48,6 +50,18 @@ using namespace mir::graphics;
 using namespace mir::graphics::mesa;
 using mir::report::null_display_report;
 
+namespace
+{
+class MockPageFlipper : public PageFlipper
+{
+public:
+    MOCK_METHOD3(schedule_flip, bool(uint32_t,uint32_t,uint32_t));
+    MOCK_METHOD1(wait_for_flip, Frame(uint32_t));
+    MOCK_CONST_METHOD0(supports_atomic_flips, bool());
+    MOCK_METHOD1(schedule_atomic_flip, bool(AtomicCommit const&));
+};
+}
+
 class MesaDisplayBufferTest : public Test
 {
 public:
@@ -66,6 +80,8 @@ public:
         , stub_shm_native_buffer{
              std::make_shared<mir::graphics::mesa::NativeBuffer>()}
         , bypassable_list{fake_bypassable_renderable}
+        , overlay_buffer{std::make_shared<NiceMock<MockBuffer>>()}
+        , overlay_renderable{std::make_shared<FakeRenderable>(overlay_area)}
     {
         ON_CALL(mock_egl, eglChooseConfig(_,_,_,1,_))
             .WillByDefault(DoAll(SetArgPointee<2>(mock_egl.fake_configs[0]),
@@ -111,6 +127,12 @@ public:
         ON_CALL(*mock_software_buffer, native_buffer_handle())
             .WillByDefault(Return(stub_shm_native_buffer));
         fake_software_renderable->set_buffer(mock_software_buffer);
+
+        ON_CALL(*overlay_buffer, size())
+            .WillByDefault(Return(overlay_area.size));
+        ON_CALL(*overlay_buffer, native_buffer_handle())
+            .WillByDefault(Return(std::make_shared<StubGBMNativeBuffer>(overlay_area.size)));
+        overlay_renderable->set_buffer(overlay_buffer);
     }
 
 protected:
@@ -129,6 +151,8 @@ protected:
     int const width{56};
     int const height{78};
     mir::geometry::Rectangle const display_area{{12,34}, {width,height}};
+    /* Above the bypass buffer, and small enough for an overlay plane */
+    mir::geometry::Rectangle const overlay_area{{20,40}, {10,20}};
     glm::mat2 const identity;
     NiceMock<MockGBM> mock_gbm;
     NiceMock<MockEGL> mock_egl;
@@ -146,6 +170,17 @@ protected:
     std::shared_ptr<MockKMSOutput> mock_kms_output;
     StubGLConfig gl_config;
     mir::graphics::RenderableList const bypassable_list;
+    std::shared_ptr<MockBuffer> overlay_buffer;
+    std::shared_ptr<FakeRenderable> overlay_renderable;
+    std::shared_ptr<MockPageFlipper> const page_flipper{std::make_shared<NiceMock<MockPageFlipper>>()};
+
+    /* What a real output does with a commit: expect a flip through page_flipper */
+    std::function<bool(AtomicCommit*, FBHandle const*, std::vector<OverlayLayer> const&)> const add_flip =
+        [this](AtomicCommit* commit, FBHandle const*, std::vector<OverlayLayer> const&)
+        {
+            commit->add_flip(page_flipper, 10, 20);
+            return true;
+        };
 };
 
 TEST_F(MesaDisplayBufferTest, unrotated_view_area_is_untouched)
@@ -360,6 +395,43 @@ TEST_F(MesaDisplayBufferTest, fullscreen_software_buffer_not_used_as_gbm_bo)
     db.overlay(list);
 }
 
+TEST_F(MesaDisplayBufferTest, fullscreen_xrgb_software_buffer_is_copied_for_scanout)
+{
+    auto const shm_buffer = std::make_shared<StubBuffer>(
+        BufferProperties{display_area.size, mir_pixel_format_xrgb_8888, BufferUsage::software});
+    auto const shm_renderable = std::make_shared<FakeRenderable>(display_area);
+    shm_renderable->set_buffer(shm_buffer);
+
+    std::vector<unsigned char> scanout_pixels(width * height * 4);
+    auto const scanout_bo = reinterpret_cast<gbm_bo*>(0x5ca0);
+    ON_CALL(mock_gbm, gbm_bo_create(_, width, height, _, _))
+        .WillByDefault(Return(scanout_bo));
+    ON_CALL(mock_gbm, gbm_bo_map(scanout_bo, _, _, _, _, _, _, _))
+        .WillByDefault(DoAll(SetArgPointee<6>(width * 4), Return(scanout_pixels.data())));
+
+    /* The composite buffer set on the CRTC at startup */
+    EXPECT_CALL(*mock_kms_output, fb_for(_))
+        .Times(AnyNumber());
+    EXPECT_CALL(*mock_kms_output, fb_for(scanout_bo))
+        .WillOnce(Return(reinterpret_cast<FBHandle*>(0x5cab)));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    auto const original_count = shm_buffer.use_count();
+
+    EXPECT_TRUE(db.overlay({shm_renderable}));
+    db.post();
+
+    // The client can have its buffer back as soon as it has been copied
+    EXPECT_EQ(original_count, shm_buffer.use_count());
+}
+
 TEST_F(MesaDisplayBufferTest, transformation_not_implemented_internally)
 {
     glm::mat2 const rotate_left = transformation(mir_orientation_left);
@@ -445,6 +517,114 @@ TEST_F(MesaDisplayBufferTest, clone_mode_waits_for_page_flip_on_second_flip)
     db.post();
 }
 
+TEST_F(MesaDisplayBufferTest, clone_mode_flips_every_output_in_one_atomic_commit)
+{
+    EXPECT_CALL(*mock_kms_output, add_page_flip_thunk(_, _, _))
+        .Times(2)
+        .WillRepeatedly(Return(true));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .Times(0);
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output, mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    db.swap_buffers();
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, falls_back_to_legacy_flips_if_an_output_cant_flip_atomically)
+{
+    auto const legacy_output = std::make_shared<NiceMock<MockKMSOutput>>();
+
+    EXPECT_CALL(*mock_kms_output, add_page_flip_thunk(_, _, _))
+        .Times(1)
+        .WillOnce(Return(true));
+    EXPECT_CALL(*legacy_output, add_page_flip_thunk(_, _, _))
+        .Times(1)
+        .WillOnce(Return(false));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .Times(2)
+        .WillRepeatedly(Return(true));
+    EXPECT_CALL(*legacy_output, schedule_page_flip_thunk(_))
+        .Times(2)
+        .WillRepeatedly(Return(true));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output, legacy_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    db.swap_buffers();
+    db.post();
+
+    db.swap_buffers();
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, keeps_atomic_flips_after_a_commit_fails_transiently)
+{
+    EXPECT_CALL(*mock_kms_output, add_page_flip_thunk(_, _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke(add_flip));
+    EXPECT_CALL(*page_flipper, schedule_atomic_flip(_))
+        .WillOnce(Return(false))
+        .WillOnce(Return(true));
+    // The commit is valid; the kernel was merely busy
+    ON_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_TEST_ONLY, _))
+        .WillByDefault(Return(0));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .Times(1);
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    db.swap_buffers();
+    db.post();
+
+    db.swap_buffers();
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, stops_atomic_flips_if_the_kernel_rejects_them)
+{
+    EXPECT_CALL(*mock_kms_output, add_page_flip_thunk(_, _, _))
+        .Times(1)
+        .WillOnce(Invoke(add_flip));
+    EXPECT_CALL(*page_flipper, schedule_atomic_flip(_))
+        .WillOnce(Return(false));
+    ON_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_TEST_ONLY, _))
+        .WillByDefault(Return(-EINVAL));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .Times(2);
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    db.swap_buffers();
+    db.post();
+
+    db.swap_buffers();
+    db.post();
+}
+
 TEST_F(MesaDisplayBufferTest, skips_bypass_because_of_incompatible_list)
 {
     graphics::RenderableList list{
@@ -463,6 +643,107 @@ TEST_F(MesaDisplayBufferTest, skips_bypass_because_of_incompatible_list)
     EXPECT_FALSE(db.overlay(list));
 }
 
+TEST_F(MesaDisplayBufferTest, scans_out_renderables_above_bypass_buffer_on_overlay_planes)
+{
+    graphics::RenderableList const list{fake_bypassable_renderable, overlay_renderable};
+    geometry::Rectangle const expected_position{{8, 6}, overlay_area.size};
+
+    EXPECT_CALL(*mock_kms_output, test_overlays_thunk(_, ElementsAre(Field(&OverlayLayer::position, expected_position))))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*mock_kms_output, add_page_flip_thunk(_, _, ElementsAre(Field(&OverlayLayer::position, expected_position))))
+        .WillOnce(Return(true));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    EXPECT_TRUE(db.overlay(list));
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, does_not_show_a_frame_without_overlay_planes_rejected_at_commit)
+{
+    ON_CALL(*mock_kms_output, test_overlays_thunk(_, _))
+        .WillByDefault(Return(true));
+
+    EXPECT_CALL(*mock_kms_output, add_page_flip_thunk(_, _, SizeIs(1)))
+        .WillOnce(Invoke(add_flip));
+    EXPECT_CALL(*mock_kms_output, add_page_flip_thunk(_, _, IsEmpty()))
+        .Times(0);
+    EXPECT_CALL(*page_flipper, schedule_atomic_flip(_))
+        .WillOnce(Return(false));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .Times(0);
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    EXPECT_CALL(*mock_kms_output, set_crtc_thunk(_))
+        .Times(0);
+
+    auto const original_count = overlay_buffer.use_count();
+
+    EXPECT_TRUE(db.overlay({fake_bypassable_renderable, overlay_renderable}));
+    db.post();
+
+    EXPECT_THAT(overlay_buffer.use_count(), Eq(original_count));
+}
+
+TEST_F(MesaDisplayBufferTest, composites_the_frame_after_overlay_planes_are_rejected_at_commit)
+{
+    ON_CALL(*mock_kms_output, test_overlays_thunk(_, _))
+        .WillByDefault(Return(true));
+    ON_CALL(*mock_kms_output, add_page_flip_thunk(_, _, _))
+        .WillByDefault(Invoke(add_flip));
+    EXPECT_CALL(*page_flipper, schedule_atomic_flip(_))
+        .WillOnce(Return(false))
+        .WillRepeatedly(Return(true));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    ASSERT_TRUE(db.overlay({fake_bypassable_renderable, overlay_renderable}));
+    db.post();
+
+    EXPECT_FALSE(db.overlay({fake_bypassable_renderable, overlay_renderable}));
+    db.swap_buffers();
+    db.post();
+
+    // Having composited one frame, overlay planes are worth another try
+    EXPECT_TRUE(db.overlay({fake_bypassable_renderable, overlay_renderable}));
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, composites_if_driver_rejects_overlay_planes)
+{
+    EXPECT_CALL(*mock_kms_output, test_overlays_thunk(_, _))
+        .WillOnce(Return(false));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    EXPECT_FALSE(db.overlay({fake_bypassable_renderable, overlay_renderable}));
+}
+
 TEST_F(MesaDisplayBufferTest, skips_bypass_because_of_incompatible_bypass_buffer)
 {
     auto fullscreen = std::make_shared<FakeRenderable>(display_area);
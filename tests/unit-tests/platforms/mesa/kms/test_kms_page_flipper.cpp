@@ -17,6 +17,7 @@
  */
 
 #include "src/platforms/mesa/server/kms/kms_page_flipper.h"
+#include "src/platforms/mesa/server/kms/atomic_commit.h"
 
 #include "mir/test/doubles/mock_drm.h"
 #include "mir/test/doubles/mock_display_report.h"
@@ -69,6 +70,16 @@ ACTION_P(InvokePageFlipHandler, param)
     ASSERT_EQ(1, read(arg0, &dummy, 1));
 }
 
+ACTION_P2(InvokePageFlipHandler2, crtc_ids, param)
+{
+    int const dont_care{0};
+    char dummy;
+
+    for (auto crtc_id : crtc_ids)
+        arg1->page_flip_handler2(dont_care, dont_care, dont_care, dont_care, crtc_id, *param);
+    ASSERT_EQ(1, read(arg0, &dummy, 1));
+}
+
 }
 
 TEST_F(KMSPageFlipperTest, schedule_flip_calls_drm_page_flip)
@@ -149,6 +160,56 @@ TEST_F(KMSPageFlipperTest, wait_for_flip_reports_vsync)
     page_flipper.wait_for_flip(crtc_id);
 }
 
+TEST_F(KMSPageFlipperTest, legacy_flip_event_without_crtc_completes_flip)
+{
+    using namespace testing;
+    uint32_t const crtc_id{10};
+    uint32_t const fb_id{101};
+    uint32_t const connector_id{345};
+    // Kernels before 4.12 don't fill in the CRTC of legacy flip events
+    std::vector<uint32_t> const event_crtc_ids{0};
+    void* user_data{nullptr};
+
+    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, fb_id, _, _))
+        .WillOnce(DoAll(SaveArg<4>(&user_data), Return(0)));
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .WillOnce(DoAll(InvokePageFlipHandler2(event_crtc_ids, &user_data), Return(0)));
+    EXPECT_CALL(report, report_vsync(connector_id, _));
+
+    page_flipper.schedule_flip(crtc_id, fb_id, connector_id);
+    mock_drm.generate_event_on(drm_device);
+    page_flipper.wait_for_flip(crtc_id);
+}
+
+TEST_F(KMSPageFlipperTest, uses_legacy_flips_if_events_dont_name_their_crtc)
+{
+    using namespace testing;
+
+    // Kernels from 4.2 to 4.11 accept atomic commits but leave the CRTC of their events as 0
+    ON_CALL(mock_drm, drmGetCap(drm_fd, DRM_CAP_CRTC_IN_VBLANK_EVENT, _))
+        .WillByDefault(DoAll(SetArgPointee<2>(0), Return(0)));
+    EXPECT_CALL(mock_drm, drmSetClientCap(drm_fd, DRM_CLIENT_CAP_ATOMIC, _))
+        .Times(0);
+
+    mgm::KMSPageFlipper const flipper{drm_fd, mt::fake_shared(report)};
+
+    EXPECT_FALSE(flipper.supports_atomic_flips());
+}
+
+TEST_F(KMSPageFlipperTest, uses_atomic_flips_if_events_name_their_crtc)
+{
+    using namespace testing;
+
+    ON_CALL(mock_drm, drmGetCap(drm_fd, DRM_CAP_CRTC_IN_VBLANK_EVENT, _))
+        .WillByDefault(DoAll(SetArgPointee<2>(1), Return(0)));
+    EXPECT_CALL(mock_drm, drmSetClientCap(drm_fd, DRM_CLIENT_CAP_ATOMIC, 1))
+        .WillOnce(Return(0));
+
+    mgm::KMSPageFlipper const flipper{drm_fd, mt::fake_shared(report)};
+
+    EXPECT_TRUE(flipper.supports_atomic_flips());
+}
+
 TEST_F(KMSPageFlipperTest, wait_for_non_scheduled_page_flip_doesnt_block)
 {
     using namespace testing;
@@ -224,6 +285,117 @@ TEST_F(KMSPageFlipperTest, wait_for_flips_interleaved)
         page_flipper.wait_for_flip(crtc_id);
 }
 
+TEST_F(KMSPageFlipperTest, flip_is_reported_from_thread_waiting_for_it)
+{
+    using namespace testing;
+
+    uint32_t const fb_id{101};
+    uint32_t const crtc_ids[] = {10, 11};
+    uint32_t const connector_ids[] = {23, 45};
+    void* user_data[] = {nullptr, nullptr};
+    std::thread::id reporting_thread, waiting_thread;
+
+    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, _, fb_id, _, _))
+        .WillOnce(DoAll(SaveArg<4>(&user_data[0]), Return(0)))
+        .WillOnce(DoAll(SaveArg<4>(&user_data[1]), Return(0)));
+
+    /* This thread handles the event for the other thread's flip too */
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[1]), Return(0)))
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data[0]), Return(0)));
+
+    EXPECT_CALL(report, report_vsync(connector_ids[0], _));
+    EXPECT_CALL(report, report_vsync(connector_ids[1], _))
+        .WillOnce(InvokeWithoutArgs([&]{ reporting_thread = std::this_thread::get_id(); }));
+
+    for (int i = 0; i != 2; ++i)
+        page_flipper.schedule_flip(crtc_ids[i], fb_id, connector_ids[i]);
+
+    mock_drm.generate_event_on(drm_device);
+    mock_drm.generate_event_on(drm_device);
+
+    page_flipper.wait_for_flip(crtc_ids[0]);
+    EXPECT_THAT(reporting_thread, Eq(std::thread::id{}));
+
+    std::thread{
+        [&]
+        {
+            waiting_thread = std::this_thread::get_id();
+            page_flipper.wait_for_flip(crtc_ids[1]);
+        }}.join();
+
+    EXPECT_THAT(reporting_thread, Eq(waiting_thread));
+}
+
+TEST_F(KMSPageFlipperTest, schedule_atomic_flip_tests_before_committing)
+{
+    using namespace testing;
+
+    mgm::AtomicCommit commit{drm_fd};
+    commit.add_flip(mt::fake_shared(page_flipper), 10, 23);
+    commit.add_flip(mt::fake_shared(page_flipper), 11, 45);
+
+    InSequence seq;
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, commit.request(), DRM_MODE_ATOMIC_TEST_ONLY, _))
+        .WillOnce(Return(0));
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(
+        drm_fd, commit.request(), DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT, NotNull()))
+        .WillOnce(Return(0));
+
+    EXPECT_TRUE(page_flipper.schedule_atomic_flip(commit));
+}
+
+TEST_F(KMSPageFlipperTest, rejected_atomic_flip_schedules_nothing)
+{
+    using namespace testing;
+
+    uint32_t const crtc_id{10};
+    uint32_t const connector_id{23};
+
+    mgm::AtomicCommit commit{drm_fd};
+    commit.add_flip(mt::fake_shared(page_flipper), crtc_id, connector_id);
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, DRM_MODE_ATOMIC_TEST_ONLY, _))
+        .WillOnce(Return(-EINVAL));
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, Ne(DRM_MODE_ATOMIC_TEST_ONLY), _))
+        .Times(0);
+    EXPECT_CALL(mock_drm, drmHandleEvent(_, _))
+        .Times(0);
+
+    EXPECT_FALSE(page_flipper.schedule_atomic_flip(commit));
+
+    EXPECT_NO_THROW(page_flipper.wait_for_flip(crtc_id));
+    EXPECT_NO_THROW(page_flipper.schedule_flip(crtc_id, 101, connector_id));
+}
+
+TEST_F(KMSPageFlipperTest, one_atomic_commit_completes_flips_on_every_crtc)
+{
+    using namespace testing;
+
+    std::vector<uint32_t> const crtc_ids{10, 11};
+    std::vector<uint32_t> const connector_ids{23, 45};
+    void* user_data{nullptr};
+
+    mgm::AtomicCommit commit{drm_fd};
+    for (auto i = 0u; i != crtc_ids.size(); ++i)
+        commit.add_flip(mt::fake_shared(page_flipper), crtc_ids[i], connector_ids[i]);
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, _, _))
+        .WillRepeatedly(DoAll(SaveArg<3>(&user_data), Return(0)));
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .Times(1)
+        .WillOnce(DoAll(InvokePageFlipHandler2(crtc_ids, &user_data), Return(0)));
+    EXPECT_CALL(report, report_vsync(connector_ids[0], _));
+    EXPECT_CALL(report, report_vsync(connector_ids[1], _));
+
+    ASSERT_TRUE(page_flipper.schedule_atomic_flip(commit));
+
+    mock_drm.generate_event_on(drm_device);
+
+    for (auto crtc_id : crtc_ids)
+        page_flipper.wait_for_flip(crtc_id);
+}
+
 namespace
 {
 
@@ -18,6 +18,7 @@
 
 #include "src/platforms/mesa/server/kms/real_kms_output.h"
 #include "src/platforms/mesa/server/kms/page_flipper.h"
+#include "src/platforms/mesa/server/kms/atomic_commit.h"
 #include "mir/fatal.h"
 
 #include "mir/test/fake_shared.h"
@@ -26,6 +27,8 @@
 #include "mir/test/doubles/mock_gbm.h"
 
 #include <stdexcept>
+#include <map>
+#include <cstring>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -47,6 +50,8 @@ class NullPageFlipper : public mgm::PageFlipper
 public:
     bool schedule_flip(uint32_t,uint32_t,uint32_t) override { return true; }
     mg::Frame wait_for_flip(uint32_t) override { return {}; }
+    bool supports_atomic_flips() const override { return false; }
+    bool schedule_atomic_flip(mgm::AtomicCommit const&) override { return false; }
 };
 
 class MockPageFlipper : public mgm::PageFlipper
@@ -54,6 +59,8 @@ class MockPageFlipper : public mgm::PageFlipper
 public:
     MOCK_METHOD3(schedule_flip, bool(uint32_t,uint32_t,uint32_t));
     MOCK_METHOD1(wait_for_flip, mg::Frame(uint32_t));
+    MOCK_CONST_METHOD0(supports_atomic_flips, bool());
+    MOCK_METHOD1(schedule_atomic_flip, bool(mgm::AtomicCommit const&));
 };
 
 class RealKMSOutputTest : public ::testing::Test
@@ -148,6 +155,117 @@ public:
         mock_drm.prepare(drm_device);
     }
 
+    struct FakePlane
+    {
+        uint32_t id;
+        uint64_t type;
+        std::vector<uint32_t> formats;
+        uint64_t zpos;
+    };
+
+    /* A connected output with a mode, on a CRTC with the given planes */
+    void setup_atomic_output(std::vector<FakePlane> const& planes)
+    {
+        uint32_t const possible_crtcs_mask{0x1};
+        drmModeModeInfo mode{};
+        mode.hdisplay = 1920;
+        mode.vdisplay = 1080;
+        mode.vrefresh = 60;
+        modes = {mode};
+
+        mock_drm.reset(drm_device);
+        mock_drm.add_crtc(drm_device, crtc_ids[0], mode);
+        mock_drm.add_encoder(drm_device, encoder_ids[0], crtc_ids[0], possible_crtcs_mask);
+        mock_drm.add_connector(
+            drm_device,
+            connector_ids[0],
+            DRM_MODE_CONNECTOR_DVID,
+            DRM_MODE_CONNECTED,
+            encoder_ids[0],
+            modes,
+            possible_encoder_ids1,
+            geom::Size());
+        mock_drm.prepare(drm_device);
+
+        for (auto const name : {"FB_ID", "CRTC_ID", "SRC_X", "SRC_Y", "SRC_W", "SRC_H",
+                                "CRTC_X", "CRTC_Y", "CRTC_W", "CRTC_H", "type", "zpos"})
+        {
+            auto& prop = properties[prop_id(name)];
+            prop.prop_id = prop_id(name);
+            strncpy(prop.name, name, sizeof prop.name - 1);
+        }
+
+        for (auto const& fake : planes)
+        {
+            auto& state = plane_states[fake.id];
+            state.formats = fake.formats;
+            state.plane.plane_id = fake.id;
+            state.plane.possible_crtcs = possible_crtcs_mask;
+            state.plane.count_formats = state.formats.size();
+            state.plane.formats = state.formats.data();
+
+            for (auto const& prop : properties)
+            {
+                state.prop_ids.push_back(prop.first);
+                state.prop_values.push_back(0);
+            }
+            state.prop_values[index_of("type")] = fake.type;
+            state.prop_values[index_of("zpos")] = fake.zpos;
+            state.props.count_props = state.prop_ids.size();
+            state.props.props = state.prop_ids.data();
+            state.props.prop_values = state.prop_values.data();
+
+            plane_ids.push_back(fake.id);
+        }
+        plane_resources.count_planes = plane_ids.size();
+        plane_resources.planes = plane_ids.data();
+
+        ON_CALL(mock_drm, drmModeGetPlaneResources(_))
+            .WillByDefault(Return(&plane_resources));
+        ON_CALL(mock_drm, drmModeGetPlane(_, _))
+            .WillByDefault(Invoke([this](int, uint32_t id) { return &plane_states.at(id).plane; }));
+        ON_CALL(mock_drm, drmModeObjectGetProperties(_, _, DRM_MODE_OBJECT_PLANE))
+            .WillByDefault(Invoke([this](int, uint32_t id, uint32_t) { return &plane_states.at(id).props; }));
+        ON_CALL(mock_drm, drmModeGetProperty(_, _))
+            .WillByDefault(Invoke([this](int, uint32_t id) { return &properties.at(id); }));
+        ON_CALL(mock_page_flipper, supports_atomic_flips())
+            .WillByDefault(Return(true));
+    }
+
+    /* Give the CRTC of setup_atomic_output() a GAMMA_LUT of gamma_lut_size entries */
+    void setup_crtc_gamma_lut(uint64_t gamma_lut_size)
+    {
+        for (auto const name : {"GAMMA_LUT", "GAMMA_LUT_SIZE"})
+        {
+            auto& prop = properties[prop_id(name)];
+            prop.prop_id = prop_id(name);
+            strncpy(prop.name, name, sizeof prop.name - 1);
+        }
+
+        crtc_prop_ids = {prop_id("GAMMA_LUT"), prop_id("GAMMA_LUT_SIZE")};
+        crtc_prop_values = {0, gamma_lut_size};
+        crtc_props.count_props = crtc_prop_ids.size();
+        crtc_props.props = crtc_prop_ids.data();
+        crtc_props.prop_values = crtc_prop_values.data();
+
+        ON_CALL(mock_drm, drmModeObjectGetProperties(_, crtc_ids[0], DRM_MODE_OBJECT_CRTC))
+            .WillByDefault(Return(&crtc_props));
+    }
+
+    static uint32_t prop_id(char const* name)
+    {
+        static std::vector<std::string> const names{
+            "FB_ID", "CRTC_ID", "SRC_X", "SRC_Y", "SRC_W", "SRC_H",
+            "CRTC_X", "CRTC_Y", "CRTC_W", "CRTC_H", "type", "zpos",
+            "GAMMA_LUT", "GAMMA_LUT_SIZE"};
+        return 200 + std::distance(names.begin(), std::find(names.begin(), names.end(), name));
+    }
+
+    size_t index_of(char const* name) const
+    {
+        return std::distance(properties.begin(), properties.find(prop_id(name)));
+    }
+
     void append_fb_id(uint32_t fb_id)
     {
         EXPECT_CALL(mock_drm, drmModeAddFB2(_,_,_,_,_,_,_,_,_))
@@ -162,6 +280,23 @@ public:
     MockPageFlipper mock_page_flipper;
     NullPageFlipper null_page_flipper;
     std::vector<drmModeModeInfo> modes_empty;
+    std::vector<drmModeModeInfo> modes;
+
+    struct PlaneState
+    {
+        std::vector<uint32_t> formats;
+        drmModePlane plane{};
+        std::vector<uint32_t> prop_ids;
+        std::vector<uint64_t> prop_values;
+        drmModeObjectProperties props{};
+    };
+    std::map<uint32_t, PlaneState> plane_states;
+    std::vector<uint32_t> plane_ids;
+    drmModePlaneRes plane_resources{};
+    std::map<uint32_t, drmModePropertyRes> properties;
+    std::vector<uint32_t> crtc_prop_ids;
+    std::vector<uint64_t> crtc_prop_values;
+    drmModeObjectProperties crtc_props{};
 
     char const* const drm_device = "/dev/dri/card0";
     int const drm_fd;
@@ -548,3 +683,236 @@ TEST_F(RealKMSOutputTest, drm_set_gamma_failure_does_not_throw)
 
     EXPECT_NO_THROW(output.set_gamma(gamma););
 }
+
+TEST_F(RealKMSOutputTest, commits_gamma_lut_straight_away)
+{
+    using namespace testing;
+
+    uint32_t const gamma_blob{77};
+    mg::GammaCurves const gamma{{1, 2}, {3, 4}, {5, 6}};
+
+    setup_atomic_output({{50, DRM_PLANE_TYPE_PRIMARY, {GBM_FORMAT_XRGB8888}, 0}});
+    setup_crtc_gamma_lut(gamma.red.size());
+
+    append_fb_id(42);
+
+    mgm::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    auto const fb = output.fb_for(fake_bo);
+    ASSERT_TRUE(output.set_crtc(*fb));
+
+    // There may be no page flip coming to carry the curves (e.g. on an idle screen)
+    EXPECT_CALL(mock_drm, drmModeCreatePropertyBlob(drm_fd, _, gamma.red.size() * sizeof(drm_color_lut), _))
+        .WillOnce(DoAll(SetArgPointee<3>(gamma_blob), Return(0)));
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, crtc_ids[0], prop_id("GAMMA_LUT"), gamma_blob));
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, 0, _))
+        .WillOnce(Return(0));
+    EXPECT_CALL(mock_drm, drmModeCrtcSetGamma(_, _, _, _, _, _))
+        .Times(0);
+
+    output.set_gamma(gamma);
+}
+
+TEST_F(RealKMSOutputTest, sets_legacy_gamma_if_gamma_lut_commit_fails)
+{
+    using namespace testing;
+
+    mg::GammaCurves const gamma{{1, 2}, {3, 4}, {5, 6}};
+
+    setup_atomic_output({{50, DRM_PLANE_TYPE_PRIMARY, {GBM_FORMAT_XRGB8888}, 0}});
+    setup_crtc_gamma_lut(gamma.red.size());
+
+    append_fb_id(42);
+
+    mgm::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    auto const fb = output.fb_for(fake_bo);
+    ASSERT_TRUE(output.set_crtc(*fb));
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, 0, _))
+        .WillOnce(Return(-EINVAL));
+    EXPECT_CALL(mock_drm, drmModeCrtcSetGamma(drm_fd, crtc_ids[0], gamma.red.size(), _, _, _));
+
+    output.set_gamma(gamma);
+}
+
+TEST_F(RealKMSOutputTest, atomic_flip_needs_a_primary_plane)
+{
+    setup_atomic_output({{50, DRM_PLANE_TYPE_OVERLAY, {GBM_FORMAT_XRGB8888}, 1}});
+
+    append_fb_id(42);
+
+    mgm::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    auto const fb = output.fb_for(fake_bo);
+    ASSERT_TRUE(output.set_crtc(*fb));
+
+    mgm::AtomicCommit commit{drm_fd};
+    EXPECT_FALSE(output.add_page_flip(commit, *fb, {}));
+}
+
+TEST_F(RealKMSOutputTest, only_uses_overlay_planes_stacked_above_the_primary_plane)
+{
+    uint32_t const primary_plane{50}, lower_overlay{51}, upper_overlay{52};
+    uint32_t const overlay_fb_id{43};
+    auto const overlay_bo = reinterpret_cast<gbm_bo*>(0x0ba7);
+
+    setup_atomic_output({
+        {primary_plane, DRM_PLANE_TYPE_PRIMARY, {GBM_FORMAT_XRGB8888}, 2},
+        {lower_overlay, DRM_PLANE_TYPE_OVERLAY, {GBM_FORMAT_XRGB8888}, 1},
+        {upper_overlay, DRM_PLANE_TYPE_OVERLAY, {GBM_FORMAT_XRGB8888}, 3}});
+
+    ON_CALL(mock_gbm, gbm_bo_get_format(overlay_bo))
+        .WillByDefault(Return(GBM_FORMAT_XRGB8888));
+    EXPECT_CALL(mock_drm, drmModeAddFB2(_,_,_,_,_,_,_,_,_))
+        .WillOnce(DoAll(SetArgPointee<7>(42), Return(0)))
+        .WillOnce(DoAll(SetArgPointee<7>(overlay_fb_id), Return(0)));
+
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, _, _, _))
+        .Times(AnyNumber());
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, upper_overlay, prop_id("FB_ID"), overlay_fb_id));
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, lower_overlay, _, _))
+        .Times(0);
+
+    mgm::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    auto const fb = output.fb_for(fake_bo);
+    auto const overlay_fb = output.fb_for(overlay_bo);
+    ASSERT_TRUE(output.set_crtc(*fb));
+
+    mgm::OverlayLayer const layer{overlay_fb, {{10, 10}, {100, 100}}};
+
+    mgm::AtomicCommit commit{drm_fd};
+    EXPECT_TRUE(output.add_page_flip(commit, *fb, {layer}));
+
+    mgm::AtomicCommit two_overlays{drm_fd};
+    EXPECT_FALSE(output.add_page_flip(two_overlays, *fb, {layer, layer}));
+}
+
+TEST_F(RealKMSOutputTest, assigns_overlay_to_a_plane_supporting_its_format)
+{
+    uint32_t const primary_plane{50}, xrgb_overlay{51}, argb_overlay{52};
+    uint32_t const overlay_fb_id{43};
+    auto const overlay_bo = reinterpret_cast<gbm_bo*>(0x0ba7);
+
+    setup_atomic_output({
+        {primary_plane, DRM_PLANE_TYPE_PRIMARY, {GBM_FORMAT_XRGB8888}, 0},
+        {xrgb_overlay, DRM_PLANE_TYPE_OVERLAY, {GBM_FORMAT_XRGB8888}, 1},
+        {argb_overlay, DRM_PLANE_TYPE_OVERLAY, {GBM_FORMAT_XRGB8888, GBM_FORMAT_ARGB8888}, 2}});
+
+    ON_CALL(mock_gbm, gbm_bo_get_format(overlay_bo))
+        .WillByDefault(Return(GBM_FORMAT_ARGB8888));
+    EXPECT_CALL(mock_drm, drmModeAddFB2(_,_,_,_,_,_,_,_,_))
+        .WillOnce(DoAll(SetArgPointee<7>(42), Return(0)))
+        .WillOnce(DoAll(SetArgPointee<7>(overlay_fb_id), Return(0)));
+
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, _, _, _))
+        .Times(AnyNumber());
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, argb_overlay, prop_id("FB_ID"), overlay_fb_id));
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, xrgb_overlay, _, _))
+        .Times(0);
+
+    mgm::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    auto const fb = output.fb_for(fake_bo);
+    auto const overlay_fb = output.fb_for(overlay_bo);
+    ASSERT_TRUE(output.set_crtc(*fb));
+
+    mgm::AtomicCommit commit{drm_fd};
+    EXPECT_TRUE(output.add_page_flip(commit, *fb, {{overlay_fb, {{10, 10}, {100, 100}}}}));
+}
+
+TEST_F(RealKMSOutputTest, disables_overlay_planes_on_the_next_flip_without_them)
+{
+    uint32_t const primary_plane{50}, overlay_plane{51};
+    auto const overlay_bo = reinterpret_cast<gbm_bo*>(0x0ba7);
+
+    setup_atomic_output({
+        {primary_plane, DRM_PLANE_TYPE_PRIMARY, {GBM_FORMAT_XRGB8888}, 0},
+        {overlay_plane, DRM_PLANE_TYPE_OVERLAY, {GBM_FORMAT_XRGB8888}, 1}});
+
+    ON_CALL(mock_gbm, gbm_bo_get_format(overlay_bo))
+        .WillByDefault(Return(GBM_FORMAT_XRGB8888));
+    EXPECT_CALL(mock_drm, drmModeAddFB2(_,_,_,_,_,_,_,_,_))
+        .WillOnce(DoAll(SetArgPointee<7>(42), Return(0)))
+        .WillOnce(DoAll(SetArgPointee<7>(43), Return(0)));
+    ON_CALL(mock_page_flipper, schedule_atomic_flip(_))
+        .WillByDefault(Return(true));
+
+    mgm::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    auto const fb = output.fb_for(fake_bo);
+    auto const overlay_fb = output.fb_for(overlay_bo);
+    ASSERT_TRUE(output.set_crtc(*fb));
+
+    {
+        mgm::AtomicCommit commit{drm_fd};
+        ASSERT_TRUE(output.add_page_flip(commit, *fb, {{overlay_fb, {{10, 10}, {100, 100}}}}));
+        ASSERT_TRUE(commit.submit());
+    }
+
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, _, _, _))
+        .Times(AnyNumber());
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, overlay_plane, prop_id("FB_ID"), 0));
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, overlay_plane, prop_id("CRTC_ID"), 0));
+
+    mgm::AtomicCommit commit{drm_fd};
+    EXPECT_TRUE(output.add_page_flip(commit, *fb, {}));
+}
+
+TEST_F(RealKMSOutputTest, overlay_planes_of_an_unsubmitted_commit_are_not_disabled)
+{
+    uint32_t const primary_plane{50}, overlay_plane{51};
+    auto const overlay_bo = reinterpret_cast<gbm_bo*>(0x0ba7);
+
+    setup_atomic_output({
+        {primary_plane, DRM_PLANE_TYPE_PRIMARY, {GBM_FORMAT_XRGB8888}, 0},
+        {overlay_plane, DRM_PLANE_TYPE_OVERLAY, {GBM_FORMAT_XRGB8888}, 1}});
+
+    ON_CALL(mock_gbm, gbm_bo_get_format(overlay_bo))
+        .WillByDefault(Return(GBM_FORMAT_XRGB8888));
+    EXPECT_CALL(mock_drm, drmModeAddFB2(_,_,_,_,_,_,_,_,_))
+        .WillOnce(DoAll(SetArgPointee<7>(42), Return(0)))
+        .WillOnce(DoAll(SetArgPointee<7>(43), Return(0)));
+
+    mgm::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    auto const fb = output.fb_for(fake_bo);
+    auto const overlay_fb = output.fb_for(overlay_bo);
+    ASSERT_TRUE(output.set_crtc(*fb));
+
+    {
+        // e.g. the kernel turned the overlay down; the commit is rebuilt without it
+        mgm::AtomicCommit commit{drm_fd};
+        ASSERT_TRUE(output.add_page_flip(commit, *fb, {{overlay_fb, {{10, 10}, {100, 100}}}}));
+    }
+
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, _, _, _))
+        .Times(AnyNumber());
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, overlay_plane, _, _))
+        .Times(0);
+
+    mgm::AtomicCommit commit{drm_fd};
+    EXPECT_TRUE(output.add_page_flip(commit, *fb, {}));
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/mesa/server/kms/shm_scanout.h"
+
+#include "mir/test/doubles/mock_gbm.h"
+#include "mir/test/doubles/stub_buffer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <vector>
+
+namespace mg = mir::graphics;
+namespace mgm = mir::graphics::mesa;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+using namespace ::testing;
+
+namespace
+{
+struct ShmScanoutTest : Test
+{
+    ShmScanoutTest()
+    {
+        ON_CALL(mock_gbm, gbm_bo_create(_, _, _, _, _))
+            .WillByDefault(Invoke([this](auto...) { return bos[bos_created++ % bos.size()]; }));
+        ON_CALL(mock_gbm, gbm_bo_map(_, _, _, _, _, _, _, _))
+            .WillByDefault(DoAll(SetArgPointee<6>(dest_stride), Return(dest_pixels.data())));
+    }
+
+    std::shared_ptr<mtd::StubBuffer> make_buffer(
+        geom::Size size = output_size,
+        MirPixelFormat format = mir_pixel_format_xrgb_8888)
+    {
+        auto const buffer = std::make_shared<mtd::StubBuffer>(
+            mg::BufferProperties{size, format, mg::BufferUsage::software});
+
+        std::vector<unsigned char> pixels(size.height.as_int() * size.width.as_int() * 4);
+        for (size_t i = 0; i != pixels.size(); ++i)
+            pixels[i] = static_cast<unsigned char>(i);
+        buffer->write(pixels.data(), pixels.size());
+
+        return buffer;
+    }
+
+    static geom::Size constexpr output_size{3, 2};
+    static uint32_t constexpr dest_stride{16};
+
+    NiceMock<mtd::MockGBM> mock_gbm;
+    std::array<gbm_bo*, 2> const bos{{reinterpret_cast<gbm_bo*>(0x1), reinterpret_cast<gbm_bo*>(0x2)}};
+    size_t bos_created{0};
+    std::vector<unsigned char> dest_pixels = std::vector<unsigned char>(dest_stride * 2, 0xff);
+};
+
+geom::Size constexpr ShmScanoutTest::output_size;
+uint32_t constexpr ShmScanoutTest::dest_stride;
+}
+
+TEST_F(ShmScanoutTest, allocates_output_sized_dumb_buffers)
+{
+    EXPECT_CALL(mock_gbm, gbm_bo_create(_, 3, 2, GBM_FORMAT_XRGB8888, GBM_BO_USE_SCANOUT | GBM_BO_USE_WRITE))
+        .Times(2);
+
+    mgm::ShmScanout scanout{0, output_size};
+}
+
+TEST_F(ShmScanoutTest, copies_rows_into_scanout_buffer_stride)
+{
+    mgm::ShmScanout scanout{0, output_size};
+    auto const buffer = make_buffer();
+
+    EXPECT_CALL(mock_gbm, gbm_bo_unmap(_, _));
+    EXPECT_THAT(scanout.import(*buffer), NotNull());
+
+    for (uint32_t row = 0; row != 2; ++row)
+    {
+        for (uint32_t byte = 0; byte != dest_stride; ++byte)
+        {
+            auto const expected = byte < 12 ? static_cast<unsigned char>(row * 12 + byte) : 0xff;
+            EXPECT_THAT(dest_pixels[row * dest_stride + byte], Eq(expected)) << "row " << row << ", byte " << byte;
+        }
+    }
+}
+
+TEST_F(ShmScanoutTest, alternates_between_scanout_buffers)
+{
+    mgm::ShmScanout scanout{0, output_size};
+
+    auto const first = scanout.import(*make_buffer());
+    auto const second = scanout.import(*make_buffer());
+    auto const third = scanout.import(*make_buffer());
+
+    EXPECT_THAT(first, Ne(second));
+    EXPECT_THAT(first, Eq(third));
+}
+
+TEST_F(ShmScanoutTest, doesnt_copy_the_same_buffer_twice)
+{
+    mgm::ShmScanout scanout{0, output_size};
+    auto const buffer = make_buffer();
+
+    EXPECT_CALL(mock_gbm, gbm_bo_map(_, _, _, _, _, _, _, _))
+        .Times(1);
+
+    auto const first = scanout.import(*buffer);
+    EXPECT_THAT(scanout.import(*buffer), Eq(first));
+}
+
+TEST_F(ShmScanoutTest, rejects_buffers_it_cant_scan_out)
+{
+    mgm::ShmScanout scanout{0, output_size};
+
+    EXPECT_CALL(mock_gbm, gbm_bo_map(_, _, _, _, _, _, _, _))
+        .Times(0);
+
+    EXPECT_THAT(scanout.import(*make_buffer({4, 2})), IsNull());
+    EXPECT_THAT(scanout.import(*make_buffer(output_size, mir_pixel_format_abgr_8888)), IsNull());
+}
@@ -316,6 +316,51 @@ TEST_F(GLRenderer, dont_set_scissor_test_when_unnecessary)
 }
 
 
+TEST_F(GLRenderer, uploads_vertices_for_whole_frame_at_once)
+{
+    renderable_list.push_back(renderable);
+    renderable_list.push_back(renderable);
+
+    EXPECT_CALL(mock_gl, glBufferData(GL_ARRAY_BUFFER, _, _, GL_STREAM_DRAW));
+
+    mrg::Renderer renderer(display_buffer);
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, doesnt_rebind_program_or_blending_for_renderables_sharing_them)
+{
+    renderable_list.push_back(renderable);
+    renderable_list.push_back(renderable);
+
+    EXPECT_CALL(mock_gl, glUseProgram(_));
+    EXPECT_CALL(mock_gl, glDisable(GL_BLEND));
+
+    mrg::Renderer renderer(display_buffer);
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, merges_primitives_of_a_renderable_into_one_draw)
+{
+    struct TwoQuadRenderer : mrg::Renderer
+    {
+        using mrg::Renderer::Renderer;
+
+        void tessellate(std::vector<mgl::Primitive>& primitives, mg::Renderable const&) const override
+        {
+            primitives.resize(2);
+        }
+    };
+
+    // Two triangle fans of 4 vertices each become 4 triangles
+    EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLES, 0, 12));
+
+    TwoQuadRenderer renderer(display_buffer);
+
+    renderer.render(renderable_list);
+}
+
 TEST_F(GLRenderer, unchanged_viewport_avoids_gl_calls)
 {
     int const screen_width = 1920;
@@ -0,0 +1,278 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/renderers/gl/program_binary_cache.h"
+
+#include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/mock_egl.h"
+#include "mir_test_framework/temporary_environment_value.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <boost/filesystem.hpp>
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace mrg = mir::renderer::gl;
+namespace mtd = mir::test::doubles;
+namespace mtf = mir_test_framework;
+using namespace testing;
+
+namespace
+{
+GLenum const program_binary_length = 0x8741;
+GLenum const num_program_binary_formats = 0x87FE;
+GLenum const binary_format = 0x875F;
+
+std::vector<char> const driver_binary{'l', 'l', 'v', 'm', 'p', 'i', 'p', 'e'};
+std::vector<char> binary_loaded;
+
+void fake_get_program_binary(GLuint, GLsizei buf_size, GLsizei* length, GLenum* format, void* binary)
+{
+    *length = std::min<GLsizei>(buf_size, driver_binary.size());
+    *format = binary_format;
+    memcpy(binary, driver_binary.data(), *length);
+}
+
+void fake_program_binary(GLuint, GLenum format, void const* binary, GLint length)
+{
+    EXPECT_THAT(format, Eq(binary_format));
+    auto const bytes = static_cast<char const*>(binary);
+    binary_loaded.assign(bytes, bytes + length);
+}
+
+struct ProgramParameter
+{
+    GLuint program;
+    GLenum pname;
+    GLint value;
+};
+std::vector<ProgramParameter> program_parameters;
+
+void fake_program_parameteri(GLuint program, GLenum pname, GLint value)
+{
+    program_parameters.push_back({program, pname, value});
+}
+
+auto gl_string(char const* value) -> GLubyte const*
+{
+    return reinterpret_cast<GLubyte const*>(value);
+}
+
+char const* const vertex_src = "void main() { gl_Position = vec4(0.0); }";
+char const* const fragment_src = "void main() { gl_FragColor = vec4(1.0); }";
+
+struct ProgramBinaryCache : Test
+{
+    ProgramBinaryCache()
+    {
+        // What Mesa's software rasteriser reports
+        ON_CALL(mock_gl, glGetString(GL_EXTENSIONS))
+            .WillByDefault(Return(gl_string("GL_OES_EGL_image GL_OES_get_program_binary GL_OES_texture_npot")));
+        ON_CALL(mock_gl, glGetString(GL_VENDOR))
+            .WillByDefault(Return(gl_string("Mesa/X.org")));
+        ON_CALL(mock_gl, glGetString(GL_RENDERER))
+            .WillByDefault(Return(gl_string("llvmpipe (LLVM 9.0.0, 256 bits)")));
+        ON_CALL(mock_gl, glGetString(GL_VERSION))
+            .WillByDefault(Return(gl_string("OpenGL ES 3.1 Mesa 19.2.8")));
+        ON_CALL(mock_gl, glGetIntegerv(num_program_binary_formats, _))
+            .WillByDefault(SetArgPointee<1>(1));
+        ON_CALL(mock_gl, glGetProgramiv(_, program_binary_length, _))
+            .WillByDefault(SetArgPointee<2>(driver_binary.size()));
+        ON_CALL(mock_gl, glCreateProgram())
+            .WillByDefault(Return(loaded_program));
+
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glGetProgramBinaryOES")))
+            .WillByDefault(Return(reinterpret_cast<mtd::MockEGL::generic_function_pointer_t>(&fake_get_program_binary)));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glProgramBinaryOES")))
+            .WillByDefault(Return(reinterpret_cast<mtd::MockEGL::generic_function_pointer_t>(&fake_program_binary)));
+
+        char temp_dir[] = "/tmp/mir_program_cache_XXXXXX";
+        if (!mkdtemp(temp_dir))
+            throw std::runtime_error{"Failed to create temporary directory"};
+        temporary_directory = temp_dir;
+        cache_dir = temporary_directory + "/mir/shaders";
+
+        binary_loaded.clear();
+        program_parameters.clear();
+    }
+
+    ~ProgramBinaryCache()
+    {
+        boost::filesystem::remove_all(temporary_directory);
+    }
+
+    auto cached_entries() const -> int
+    {
+        if (!boost::filesystem::exists(cache_dir))
+            return 0;
+
+        return std::distance(
+            boost::filesystem::directory_iterator{cache_dir},
+            boost::filesystem::directory_iterator{});
+    }
+
+    NiceMock<mtd::MockGL> mock_gl;
+    NiceMock<mtd::MockEGL> mock_egl;
+    GLuint const linked_program{5};
+    GLuint const loaded_program{7};
+    std::string temporary_directory;
+    std::string cache_dir;
+};
+}
+
+TEST_F(ProgramBinaryCache, stored_program_is_loaded_by_a_later_server)
+{
+    mrg::ProgramBinaryCache{cache_dir}.store(linked_program, vertex_src, fragment_src);
+
+    mrg::ProgramBinaryCache const cache{cache_dir};
+
+    EXPECT_THAT(cache.load(vertex_src, fragment_src), Eq(loaded_program));
+    EXPECT_THAT(binary_loaded, Eq(driver_binary));
+}
+
+TEST_F(ProgramBinaryCache, misses_when_nothing_is_stored)
+{
+    mrg::ProgramBinaryCache const cache{cache_dir};
+
+    EXPECT_CALL(mock_gl, glCreateProgram()).Times(0);
+    EXPECT_THAT(cache.load(vertex_src, fragment_src), Eq(0u));
+}
+
+TEST_F(ProgramBinaryCache, misses_when_shader_source_differs)
+{
+    mrg::ProgramBinaryCache const cache{cache_dir};
+    cache.store(linked_program, vertex_src, fragment_src);
+
+    EXPECT_THAT(cache.load(vertex_src, "void main() { gl_FragColor = vec4(0.5); }"), Eq(0u));
+    EXPECT_THAT(binary_loaded, IsEmpty());
+}
+
+TEST_F(ProgramBinaryCache, misses_when_driver_differs)
+{
+    mrg::ProgramBinaryCache{cache_dir}.store(linked_program, vertex_src, fragment_src);
+
+    ON_CALL(mock_gl, glGetString(GL_VERSION))
+        .WillByDefault(Return(gl_string("OpenGL ES 3.2 Mesa 20.0.0")));
+    mrg::ProgramBinaryCache const upgraded_cache{cache_dir};
+
+    EXPECT_THAT(upgraded_cache.load(vertex_src, fragment_src), Eq(0u));
+    EXPECT_THAT(binary_loaded, IsEmpty());
+}
+
+TEST_F(ProgramBinaryCache, discards_binary_rejected_by_driver)
+{
+    mrg::ProgramBinaryCache const cache{cache_dir};
+    cache.store(linked_program, vertex_src, fragment_src);
+    ASSERT_THAT(cached_entries(), Eq(1));
+
+    ON_CALL(mock_gl, glGetProgramiv(loaded_program, GL_LINK_STATUS, _))
+        .WillByDefault(SetArgPointee<2>(GL_FALSE));
+    EXPECT_CALL(mock_gl, glDeleteProgram(loaded_program));
+
+    EXPECT_THAT(cache.load(vertex_src, fragment_src), Eq(0u));
+    EXPECT_THAT(cached_entries(), Eq(0));
+}
+
+TEST_F(ProgramBinaryCache, discards_corrupt_entry)
+{
+    mrg::ProgramBinaryCache const cache{cache_dir};
+    cache.store(linked_program, vertex_src, fragment_src);
+
+    for (boost::filesystem::directory_iterator entry{cache_dir}, end; entry != end; ++entry)
+        boost::filesystem::resize_file(entry->path(), 10);
+
+    EXPECT_THAT(cache.load(vertex_src, fragment_src), Eq(0u));
+    EXPECT_THAT(cached_entries(), Eq(0));
+}
+
+TEST_F(ProgramBinaryCache, leaves_nothing_but_the_entry_in_the_cache_dir)
+{
+    mrg::ProgramBinaryCache const cache{cache_dir};
+    cache.store(linked_program, vertex_src, fragment_src);
+    cache.store(linked_program, vertex_src, fragment_src);
+
+    EXPECT_THAT(cached_entries(), Eq(1));
+}
+
+TEST_F(ProgramBinaryCache, asks_desktop_gl_to_keep_program_binaries_retrievable)
+{
+    GLenum const program_binary_retrievable_hint = 0x8257;
+
+    ON_CALL(mock_gl, glGetString(GL_EXTENSIONS))
+        .WillByDefault(Return(gl_string("GL_ARB_get_program_binary GL_ARB_texture_rg")));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glGetProgramBinary")))
+        .WillByDefault(Return(reinterpret_cast<mtd::MockEGL::generic_function_pointer_t>(&fake_get_program_binary)));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glProgramBinary")))
+        .WillByDefault(Return(reinterpret_cast<mtd::MockEGL::generic_function_pointer_t>(&fake_program_binary)));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glProgramParameteri")))
+        .WillByDefault(Return(reinterpret_cast<mtd::MockEGL::generic_function_pointer_t>(&fake_program_parameteri)));
+
+    mrg::ProgramBinaryCache const cache{cache_dir};
+    cache.prepare_for_link(linked_program);
+
+    ASSERT_THAT(program_parameters.size(), Eq(1u));
+    EXPECT_THAT(program_parameters[0].program, Eq(linked_program));
+    EXPECT_THAT(program_parameters[0].pname, Eq(program_binary_retrievable_hint));
+    EXPECT_THAT(program_parameters[0].value, Eq(GL_TRUE));
+}
+
+TEST_F(ProgramBinaryCache, is_disabled_without_program_binary_extension)
+{
+    ON_CALL(mock_gl, glGetString(GL_EXTENSIONS))
+        .WillByDefault(Return(gl_string("GL_OES_EGL_image GL_OES_texture_npot")));
+
+    mrg::ProgramBinaryCache const cache{cache_dir};
+    cache.store(linked_program, vertex_src, fragment_src);
+
+    EXPECT_FALSE(cache.enabled());
+    EXPECT_THAT(cached_entries(), Eq(0));
+}
+
+TEST_F(ProgramBinaryCache, is_disabled_when_driver_has_no_binary_formats)
+{
+    ON_CALL(mock_gl, glGetIntegerv(num_program_binary_formats, _))
+        .WillByDefault(SetArgPointee<1>(0));
+
+    mrg::ProgramBinaryCache const cache{cache_dir};
+
+    EXPECT_FALSE(cache.enabled());
+}
+
+TEST_F(ProgramBinaryCache, is_disabled_without_cache_dir)
+{
+    mrg::ProgramBinaryCache const cache{""};
+
+    EXPECT_FALSE(cache.enabled());
+}
+
+TEST_F(ProgramBinaryCache, default_cache_dir_is_under_xdg_cache_home)
+{
+    mtf::TemporaryEnvironmentValue const cache_home{"XDG_CACHE_HOME", "/xdg/cache"};
+
+    EXPECT_THAT(mrg::ProgramBinaryCache::default_cache_dir(), Eq("/xdg/cache/mir/shaders"));
+}
+
+TEST_F(ProgramBinaryCache, default_cache_dir_falls_back_to_home)
+{
+    mtf::TemporaryEnvironmentValue const cache_home{"XDG_CACHE_HOME", nullptr};
+    mtf::TemporaryEnvironmentValue const home{"HOME", "/home/user"};
+
+    EXPECT_THAT(mrg::ProgramBinaryCache::default_cache_dir(), Eq("/home/user/.cache/mir/shaders"));
+}
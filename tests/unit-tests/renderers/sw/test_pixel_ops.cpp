@@ -0,0 +1,159 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/renderers/sw/pixel_ops.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <random>
+#include <vector>
+
+namespace msw = mir::renderer::software;
+using namespace testing;
+
+namespace
+{
+uint32_t channel(uint32_t pixel, int index)
+{
+    return (pixel >> (8 * index)) & 0xff;
+}
+
+/// Straightforward floating point source-over, for comparison
+uint32_t reference_blend(uint32_t dst, uint32_t src, uint8_t alpha)
+{
+    auto const a = alpha / 255.0;
+    auto const inverse = 1.0 - channel(src, 3) * a / 255.0;
+
+    uint32_t result{0};
+    for (auto i = 0; i != 4; ++i)
+    {
+        auto const value = channel(src, i) * a + channel(dst, i) * inverse;
+        result |= std::min(255u, static_cast<uint32_t>(value + 0.5)) << (8 * i);
+    }
+    return result;
+}
+
+/// A premultiplied pixel, as a well-behaved client would produce
+uint32_t premultiplied(uint32_t a, uint32_t r, uint32_t g, uint32_t b)
+{
+    return (a << 24) | ((r * a / 255) << 16) | ((g * a / 255) << 8) | (b * a / 255);
+}
+
+struct PixelOps : Test
+{
+    std::vector<uint32_t> random_pixels(size_t count)
+    {
+        std::uniform_int_distribution<uint32_t> component{0, 255};
+        std::vector<uint32_t> pixels(count);
+        for (auto& pixel : pixels)
+        {
+            pixel = premultiplied(
+                component(generator), component(generator), component(generator), component(generator));
+        }
+        return pixels;
+    }
+
+    std::mt19937 generator{42};
+};
+
+MATCHER_P(IsWithinOneOf, expected, "")
+{
+    for (auto i = 0; i != 4; ++i)
+    {
+        auto const difference = int(channel(arg, i)) - int(channel(expected, i));
+        if (difference < -1 || difference > 1)
+            return false;
+    }
+    return true;
+}
+}
+
+TEST_F(PixelOps, copy_opaque_row_sets_alpha)
+{
+    // Long enough to exercise both vector and scalar tails
+    std::vector<uint32_t> const src{0x00112233, 0x80445566, 0xff778899, 0x12abcdef, 0x00000000, 0x7f010203, 0x00ffffff};
+    std::vector<uint32_t> dst(src.size(), 0);
+
+    msw::copy_opaque_row(dst.data(), src.data(), src.size());
+
+    for (size_t i = 0; i != src.size(); ++i)
+        EXPECT_THAT(dst[i], Eq(src[i] | 0xff000000)) << "pixel " << i;
+}
+
+TEST_F(PixelOps, blend_row_matches_reference_for_all_row_lengths)
+{
+    for (auto const alpha : {255, 200, 128, 1})
+    {
+        for (auto count = 0; count != 19; ++count)
+        {
+            auto const src = random_pixels(count);
+            auto dst = random_pixels(count);
+            auto const original = dst;
+
+            msw::blend_row(dst.data(), src.data(), count, alpha, true);
+
+            for (auto i = 0; i != count; ++i)
+            {
+                EXPECT_THAT(dst[i], IsWithinOneOf(reference_blend(original[i], src[i], alpha)))
+                    << "alpha " << alpha << ", pixel " << i << " of " << count;
+            }
+        }
+    }
+}
+
+TEST_F(PixelOps, blend_row_is_exact_for_opaque_and_transparent_pixels)
+{
+    std::vector<uint32_t> const src{0xff102030, 0x00000000, 0xff405060, 0x00000000, 0xff708090};
+    std::vector<uint32_t> dst{0xffaaaaaa, 0xffbbbbbb, 0xffcccccc, 0xffdddddd, 0xffeeeeee};
+
+    msw::blend_row(dst.data(), src.data(), src.size(), 255, true);
+
+    EXPECT_THAT(dst, ElementsAre(0xff102030, 0xffbbbbbb, 0xff405060, 0xffdddddd, 0xff708090));
+}
+
+TEST_F(PixelOps, blend_row_without_source_alpha_ignores_alpha_channel)
+{
+    std::vector<uint32_t> const src(5, 0x00ff0000);
+    std::vector<uint32_t> dst(5, 0xff0000ff);
+
+    msw::blend_row(dst.data(), src.data(), src.size(), 128, false);
+
+    for (auto const pixel : dst)
+        EXPECT_THAT(pixel, IsWithinOneOf(0xff80007f));
+}
+
+TEST_F(PixelOps, scale_row_samples_nearest_source_pixel)
+{
+    std::vector<uint32_t> const src{1, 2, 3, 4};
+    std::vector<uint32_t> doubled(8);
+    std::vector<uint32_t> halved(2);
+
+    msw::scale_row(doubled.data(), src.data(), doubled.size(), 0x8000 / 2, 0x8000);
+    msw::scale_row(halved.data(), src.data(), halved.size(), 0x20000 / 2, 0x20000);
+
+    EXPECT_THAT(doubled, ElementsAre(1, 1, 2, 2, 3, 3, 4, 4));
+    EXPECT_THAT(halved, ElementsAre(2, 4));
+}
+
+TEST_F(PixelOps, swap_red_blue_row_converts_between_argb_and_abgr)
+{
+    std::vector<uint32_t> pixels{0x11223344, 0xaabbccdd, 0x00ff0000, 0xff0000ff, 0x01020304};
+
+    msw::swap_red_blue_row(pixels.data(), pixels.size());
+
+    EXPECT_THAT(pixels, ElementsAre(0x11443322, 0xaaddccbb, 0x000000ff, 0xffff0000, 0x01040302));
+}
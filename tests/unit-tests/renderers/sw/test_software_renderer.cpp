@@ -0,0 +1,236 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/renderers/sw/renderer.h"
+#include "mir/renderer/sw/render_target.h"
+#include "mir/graphics/display_buffer.h"
+
+#include "mir/test/doubles/fake_renderable.h"
+#include "mir/test/doubles/stub_buffer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstring>
+
+namespace mg = mir::graphics;
+namespace msw = mir::renderer::software;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+class StubRenderTarget : public mg::DisplayBuffer,
+                         public mg::NativeDisplayBuffer,
+                         public msw::RenderTarget
+{
+public:
+    StubRenderTarget(geom::Size size)
+        : size_{size},
+          framebuffer(size.width.as_int() * size.height.as_int(), 0x12345678)
+    {
+    }
+
+    geom::Rectangle view_area() const override { return {{0, 0}, size_}; }
+    bool overlay(mg::RenderableList const&) override { return false; }
+    glm::mat2 transformation() const override { return glm::mat2{1}; }
+    mg::NativeDisplayBuffer* native_display_buffer() override { return this; }
+
+    geom::Size size() const override { return size_; }
+    geom::Stride stride() const override { return geom::Stride{size_.width.as_int() * sizeof(uint32_t)}; }
+    unsigned char* pixels() override { return reinterpret_cast<unsigned char*>(framebuffer.data()); }
+    void commit(std::vector<geom::Rectangle> const& damage) override { committed_damage = damage; }
+
+    uint32_t pixel_at(int x, int y) const { return framebuffer[y * size_.width.as_int() + x]; }
+
+    geom::Size const size_;
+    std::vector<uint32_t> framebuffer;
+    std::vector<geom::Rectangle> committed_damage;
+};
+
+class NonSoftwareDisplayBuffer : public mg::DisplayBuffer, public mg::NativeDisplayBuffer
+{
+public:
+    geom::Rectangle view_area() const override { return {{0, 0}, {1, 1}}; }
+    bool overlay(mg::RenderableList const&) override { return false; }
+    glm::mat2 transformation() const override { return glm::mat2{1}; }
+    mg::NativeDisplayBuffer* native_display_buffer() override { return this; }
+};
+
+struct CountingBuffer : mtd::StubBuffer
+{
+    using mtd::StubBuffer::StubBuffer;
+
+    void read(std::function<void(unsigned char const*)> const& do_with_pixels) override
+    {
+        ++reads;
+        mtd::StubBuffer::read(do_with_pixels);
+    }
+
+    int reads{0};
+};
+
+std::shared_ptr<CountingBuffer> buffer_of(geom::Size size, MirPixelFormat format, uint32_t pixel)
+{
+    auto const buffer = std::make_shared<CountingBuffer>(
+        mg::BufferProperties{size, format, mg::BufferUsage::software});
+
+    std::vector<uint32_t> pixels(size.width.as_int() * size.height.as_int(), pixel);
+    buffer->write(reinterpret_cast<unsigned char const*>(pixels.data()), pixels.size() * sizeof(uint32_t));
+    return buffer;
+}
+
+std::shared_ptr<mtd::FakeRenderable> renderable_of(
+    geom::Rectangle position,
+    std::shared_ptr<mg::Buffer> const& buffer,
+    float alpha = 1.0f,
+    bool shaped = false)
+{
+    auto const renderable = std::make_shared<mtd::FakeRenderable>(position, alpha, !shaped);
+    renderable->set_buffer(buffer);
+    return renderable;
+}
+
+struct SoftwareRenderer : Test
+{
+    void render(mg::RenderableList const& renderables)
+    {
+        renderer.set_output_transform(target.transformation());
+        renderer.set_viewport(target.view_area());
+        renderer.render(renderables);
+    }
+
+    StubRenderTarget target{{8, 8}};
+    msw::Renderer renderer{target};
+};
+}
+
+TEST(SoftwareRendererConstruction, rejects_display_buffer_without_software_render_target)
+{
+    NonSoftwareDisplayBuffer display_buffer;
+
+    EXPECT_THROW({ msw::Renderer renderer{display_buffer}; }, std::logic_error);
+}
+
+TEST_F(SoftwareRenderer, draws_opaque_renderable_over_cleared_background)
+{
+    auto const buffer = buffer_of({2, 2}, mir_pixel_format_xrgb_8888, 0x00a0b0c0);
+
+    render({renderable_of({{3, 4}, {2, 2}}, buffer)});
+
+    EXPECT_THAT(target.pixel_at(3, 4), Eq(0xffa0b0c0u));
+    EXPECT_THAT(target.pixel_at(4, 5), Eq(0xffa0b0c0u));
+    EXPECT_THAT(target.pixel_at(2, 4), Eq(0u));
+    EXPECT_THAT(target.pixel_at(5, 5), Eq(0u));
+    EXPECT_THAT(target.committed_damage, ElementsAre(geom::Rectangle{{0, 0}, {8, 8}}));
+}
+
+TEST_F(SoftwareRenderer, blends_shaped_renderable_over_renderable_below)
+{
+    auto const below = buffer_of({8, 8}, mir_pixel_format_xrgb_8888, 0xff0000ff);
+    auto const above = buffer_of({8, 8}, mir_pixel_format_argb_8888, 0x80800000);
+
+    render({
+        renderable_of({{0, 0}, {8, 8}}, below),
+        renderable_of({{0, 0}, {8, 8}}, above, 1.0f, true)});
+
+    EXPECT_THAT(target.pixel_at(0, 0), Eq(0xff80007fu));
+}
+
+TEST_F(SoftwareRenderer, scales_buffer_to_screen_position)
+{
+    auto const buffer = std::make_shared<CountingBuffer>(
+        mg::BufferProperties{{2, 1}, mir_pixel_format_xrgb_8888, mg::BufferUsage::software});
+    uint32_t const pixels[]{0x00000011, 0x00000022};
+    buffer->write(reinterpret_cast<unsigned char const*>(pixels), sizeof(pixels));
+
+    render({renderable_of({{0, 0}, {4, 2}}, buffer)});
+
+    EXPECT_THAT(target.pixel_at(0, 0), Eq(0xff000011u));
+    EXPECT_THAT(target.pixel_at(1, 1), Eq(0xff000011u));
+    EXPECT_THAT(target.pixel_at(2, 0), Eq(0xff000022u));
+    EXPECT_THAT(target.pixel_at(3, 1), Eq(0xff000022u));
+}
+
+TEST_F(SoftwareRenderer, converts_abgr_buffers)
+{
+    auto const buffer = buffer_of({1, 1}, mir_pixel_format_xbgr_8888, 0x00332211);
+
+    render({renderable_of({{0, 0}, {1, 1}}, buffer)});
+
+    EXPECT_THAT(target.pixel_at(0, 0), Eq(0xff112233u));
+}
+
+TEST_F(SoftwareRenderer, unchanged_frame_has_no_damage)
+{
+    auto const renderable = renderable_of({{1, 1}, {2, 2}}, buffer_of({2, 2}, mir_pixel_format_xrgb_8888, 0));
+
+    render({renderable});
+    render({renderable});
+
+    EXPECT_THAT(target.committed_damage, IsEmpty());
+}
+
+TEST_F(SoftwareRenderer, new_buffer_damages_only_its_renderable)
+{
+    auto const renderable = renderable_of({{1, 1}, {2, 2}}, buffer_of({2, 2}, mir_pixel_format_xrgb_8888, 0));
+
+    render({renderable});
+    renderable->set_buffer(buffer_of({2, 2}, mir_pixel_format_xrgb_8888, 0x00ffffff));
+    render({renderable});
+
+    EXPECT_THAT(target.committed_damage, ElementsAre(geom::Rectangle{{1, 1}, {2, 2}}));
+    EXPECT_THAT(target.pixel_at(1, 1), Eq(0xffffffffu));
+}
+
+TEST_F(SoftwareRenderer, removed_renderable_is_cleared)
+{
+    auto const renderable = renderable_of({{1, 1}, {2, 2}}, buffer_of({2, 2}, mir_pixel_format_xrgb_8888, 0x00ffffff));
+
+    render({renderable});
+    render({});
+
+    EXPECT_THAT(target.committed_damage, ElementsAre(geom::Rectangle{{1, 1}, {2, 2}}));
+    EXPECT_THAT(target.pixel_at(1, 1), Eq(0u));
+    EXPECT_THAT(target.pixel_at(2, 2), Eq(0u));
+}
+
+TEST_F(SoftwareRenderer, does_not_read_renderables_hidden_by_opaque_renderable)
+{
+    auto const hidden = buffer_of({2, 2}, mir_pixel_format_xrgb_8888, 0x00ff0000);
+    auto const cover = buffer_of({8, 8}, mir_pixel_format_xrgb_8888, 0x0000ff00);
+
+    render({
+        renderable_of({{2, 2}, {2, 2}}, hidden),
+        renderable_of({{0, 0}, {8, 8}}, cover)});
+
+    EXPECT_THAT(hidden->reads, Eq(0));
+    EXPECT_THAT(cover->reads, Eq(1));
+    EXPECT_THAT(target.pixel_at(2, 2), Eq(0xff00ff00u));
+}
+
+TEST_F(SoftwareRenderer, redraws_everything_after_suspend)
+{
+    auto const renderable = renderable_of({{1, 1}, {2, 2}}, buffer_of({2, 2}, mir_pixel_format_xrgb_8888, 0));
+
+    render({renderable});
+    renderer.suspend();
+    render({renderable});
+
+    EXPECT_THAT(target.committed_damage, ElementsAre(geom::Rectangle{{0, 0}, {8, 8}}));
+}
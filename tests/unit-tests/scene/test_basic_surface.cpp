@@ -1520,6 +1520,39 @@ TEST_F(BasicSurfaceTest, buffer_streams_produce_correctly_sized_renderables)
     EXPECT_THAT(renderables[1], IsRenderableOfSize(size1));
 }
 
+TEST_F(BasicSurfaceTest, renderables_follow_buffer_stream_resize_between_frames)
+{
+    using namespace testing;
+    geom::Size const size0{100, 101};
+    geom::Size const size1{40, 41};
+    EXPECT_CALL(*mock_buffer_stream, stream_size())
+        .WillOnce(Return(size0))
+        .WillRepeatedly(Return(size1));
+
+    auto renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    EXPECT_THAT(renderables[0], IsRenderableOfSize(size0));
+
+    renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    EXPECT_THAT(renderables[0], IsRenderableOfSize(size1));
+}
+
+TEST_F(BasicSurfaceTest, renderables_are_offset_when_window_margins_change)
+{
+    using namespace testing;
+
+    auto renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    EXPECT_THAT(renderables[0], IsRenderableOfPosition(rect.top_left));
+
+    surface.set_window_margins(geom::DeltaY{3}, geom::DeltaX{2}, geom::DeltaY{}, geom::DeltaX{});
+
+    renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    EXPECT_THAT(renderables[0], IsRenderableOfPosition(rect.top_left + geom::Displacement{2, 3}));
+}
+
 TEST_F(BasicSurfaceTest, renderables_of_transparent_buffer_streams_are_shaped)
 {
     using namespace testing;
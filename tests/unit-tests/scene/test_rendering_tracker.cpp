@@ -23,19 +23,32 @@
 #include <gmock/gmock.h>
 
 namespace mtd = mir::test::doubles;
-namespace mc = mir::compositor;
+namespace ms = mir::scene;
 
 namespace
 {
 
 struct RenderingTrackerTest : testing::Test
 {
+    // Stand in for the compositor, which publishes once it has finished a frame
+    void rendered_in(ms::RenderingTracker::CompositorMask compositor)
+    {
+        if (tracker.rendered_in(compositor))
+            tracker.publish_visibility();
+    }
+
+    void occluded_in(ms::RenderingTracker::CompositorMask compositor)
+    {
+        if (tracker.occluded_in(compositor))
+            tracker.publish_visibility();
+    }
+
     std::shared_ptr<testing::NiceMock<mtd::MockSurface>> const mock_surface{
         std::make_shared<testing::NiceMock<mtd::MockSurface>>()};
-    mir::scene::RenderingTracker tracker{mock_surface};
-    mc::CompositorID const compositor_id1{&mock_surface};
-    mc::CompositorID const compositor_id2{&compositor_id1};
-    mc::CompositorID const compositor_id3{&compositor_id2};
+    ms::RenderingTracker tracker{mock_surface};
+    ms::RenderingTracker::CompositorMask const compositor_id1{1 << 0};
+    ms::RenderingTracker::CompositorMask const compositor_id2{1 << 1};
+    ms::RenderingTracker::CompositorMask const compositor_id3{1 << 2};
 };
 
 }
@@ -44,7 +57,7 @@ TEST_F(RenderingTrackerTest, occludes_surface_when_occluded_in_single_compositor
 {
     using namespace testing;
 
-    std::set<mc::CompositorID> const compositors{compositor_id1};
+    auto const compositors = compositor_id1;
 
     EXPECT_CALL(
         *mock_surface,
@@ -52,14 +65,14 @@ TEST_F(RenderingTrackerTest, occludes_surface_when_occluded_in_single_compositor
 
     tracker.active_compositors(compositors);
 
-    tracker.occluded_in(compositor_id1);
+    occluded_in(compositor_id1);
 }
 
 TEST_F(RenderingTrackerTest, exposes_surface_when_rendered_in_single_compositor)
 {
     using namespace testing;
 
-    std::set<mc::CompositorID> const compositors{compositor_id1};
+    auto const compositors = compositor_id1;
 
     EXPECT_CALL(
         *mock_surface,
@@ -67,14 +80,14 @@ TEST_F(RenderingTrackerTest, exposes_surface_when_rendered_in_single_compositor)
 
     tracker.active_compositors(compositors);
 
-    tracker.rendered_in(compositor_id1);
+    rendered_in(compositor_id1);
 }
 
 TEST_F(RenderingTrackerTest, exposes_surface_when_rendered_in_one_of_many_compositors)
 {
     using namespace testing;
 
-    std::set<mc::CompositorID> const compositors{compositor_id1, compositor_id2, compositor_id3};
+    auto const compositors = compositor_id1 | compositor_id2 | compositor_id3;
 
     EXPECT_CALL(
         *mock_surface,
@@ -82,15 +95,15 @@ TEST_F(RenderingTrackerTest, exposes_surface_when_rendered_in_one_of_many_compos
 
     tracker.active_compositors(compositors);
 
-    tracker.occluded_in(compositor_id1);
-    tracker.rendered_in(compositor_id2);
+    occluded_in(compositor_id1);
+    rendered_in(compositor_id2);
 }
 
 TEST_F(RenderingTrackerTest, does_not_occlude_surface_when_not_occluded_in_all_compositors)
 {
     using namespace testing;
 
-    std::set<mc::CompositorID> const compositors{compositor_id1, compositor_id2, compositor_id3};
+    auto const compositors = compositor_id1 | compositor_id2 | compositor_id3;
 
     EXPECT_CALL(
         *mock_surface,
@@ -99,15 +112,15 @@ TEST_F(RenderingTrackerTest, does_not_occlude_surface_when_not_occluded_in_all_c
 
     tracker.active_compositors(compositors);
 
-    tracker.occluded_in(compositor_id1);
-    tracker.occluded_in(compositor_id2);
+    occluded_in(compositor_id1);
+    occluded_in(compositor_id2);
 }
 
 TEST_F(RenderingTrackerTest, occludes_surface_when_occluded_in_all_compositors)
 {
     using namespace testing;
 
-    std::set<mc::CompositorID> const compositors{compositor_id1, compositor_id2, compositor_id3};
+    auto const compositors = compositor_id1 | compositor_id2 | compositor_id3;
 
     EXPECT_CALL(
         *mock_surface,
@@ -115,22 +128,22 @@ TEST_F(RenderingTrackerTest, occludes_surface_when_occluded_in_all_compositors)
 
     tracker.active_compositors(compositors);
 
-    tracker.occluded_in(compositor_id1);
-    tracker.occluded_in(compositor_id2);
-    tracker.occluded_in(compositor_id3);
+    occluded_in(compositor_id1);
+    occluded_in(compositor_id2);
+    occluded_in(compositor_id3);
 }
 
 TEST_F(RenderingTrackerTest, occludes_surface_when_occluded_in_remaining_compositors_after_removing_compositor)
 {
     using namespace testing;
 
-    std::set<mc::CompositorID> compositors{compositor_id1, compositor_id2, compositor_id3};
+    auto compositors = compositor_id1 | compositor_id2 | compositor_id3;
 
     tracker.active_compositors(compositors);
 
-    tracker.occluded_in(compositor_id1);
-    tracker.occluded_in(compositor_id2);
-    tracker.rendered_in(compositor_id3);
+    occluded_in(compositor_id1);
+    occluded_in(compositor_id2);
+    rendered_in(compositor_id3);
 
     Mock::VerifyAndClearExpectations(mock_surface.get());
 
@@ -138,7 +151,7 @@ TEST_F(RenderingTrackerTest, occludes_surface_when_occluded_in_remaining_composi
         *mock_surface,
         configure(mir_window_attrib_visibility, mir_window_visibility_occluded));
 
-    compositors.erase(compositor_id3);
+    compositors &= ~compositor_id3;
     tracker.active_compositors(compositors);
 }
 
@@ -152,3 +165,53 @@ TEST_F(RenderingTrackerTest, throws_when_passed_inactive_compositor_id)
         tracker.rendered_in(compositor_id2);
     }, std::logic_error);
 }
+
+TEST_F(RenderingTrackerTest, publishes_visibility_only_when_it_changes)
+{
+    using namespace testing;
+
+    tracker.active_compositors(compositor_id1 | compositor_id2);
+
+    EXPECT_CALL(
+        *mock_surface,
+        configure(mir_window_attrib_visibility, mir_window_visibility_exposed));
+
+    for (int frame = 0; frame != 10; ++frame)
+    {
+        rendered_in(compositor_id1);
+        rendered_in(compositor_id2);
+    }
+}
+
+TEST_F(RenderingTrackerTest, asks_for_publishing_once_until_published)
+{
+    using namespace testing;
+
+    tracker.active_compositors(compositor_id1 | compositor_id2);
+
+    EXPECT_CALL(*mock_surface, configure(_, _)).Times(0);
+
+    EXPECT_TRUE(tracker.rendered_in(compositor_id1));
+    EXPECT_FALSE(tracker.rendered_in(compositor_id2));
+    EXPECT_FALSE(tracker.occluded_in(compositor_id1));
+
+    Mock::VerifyAndClearExpectations(mock_surface.get());
+
+    EXPECT_CALL(
+        *mock_surface,
+        configure(mir_window_attrib_visibility, mir_window_visibility_occluded));
+
+    EXPECT_FALSE(tracker.occluded_in(compositor_id2));
+    tracker.publish_visibility();
+}
+
+TEST_F(RenderingTrackerTest, is_exposed_in_compositors_it_was_not_occluded_in)
+{
+    tracker.active_compositors(compositor_id1 | compositor_id2);
+
+    occluded_in(compositor_id1);
+    rendered_in(compositor_id2);
+
+    EXPECT_FALSE(tracker.is_exposed_in(compositor_id1));
+    EXPECT_TRUE(tracker.is_exposed_in(compositor_id2));
+}
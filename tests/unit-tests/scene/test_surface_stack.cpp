@@ -712,15 +712,19 @@ TEST_F(SurfaceStack, occludes_not_rendered_surface)
     
     stack.add_surface(mock_surface, default_params.input_mode);
 
-    auto const elements = stack.scene_elements_for(compositor_id);
+    auto elements = stack.scene_elements_for(compositor_id);
     ASSERT_THAT(elements.size(), Eq(1u));
-    auto const elements2 = stack.scene_elements_for(compositor_id2);
+    auto elements2 = stack.scene_elements_for(compositor_id2);
     ASSERT_THAT(elements2.size(), Eq(1u));
 
     EXPECT_CALL(*mock_surface, configure(mir_window_attrib_visibility, mir_window_visibility_occluded));
 
     elements.back()->occluded();
     elements2.back()->occluded();
+
+    // The surface is told once the compositors are done with their elements
+    elements.clear();
+    elements2.clear();
 }
 
 TEST_F(SurfaceStack, exposes_rendered_surface)
@@ -733,17 +737,58 @@ TEST_F(SurfaceStack, exposes_rendered_surface)
     stack.register_compositor(compositor_id2);
 
     auto const mock_surface = std::make_shared<MockConfigureSurface>();
-        stack.add_surface(mock_surface, default_params.input_mode);
+    stack.add_surface(mock_surface, default_params.input_mode);
 
-    auto const elements = stack.scene_elements_for(compositor_id);
+    auto elements = stack.scene_elements_for(compositor_id);
     ASSERT_THAT(elements.size(), Eq(1u));
-    auto const elements2 = stack.scene_elements_for(compositor_id2);
+    auto elements2 = stack.scene_elements_for(compositor_id2);
     ASSERT_THAT(elements2.size(), Eq(1u));
 
     EXPECT_CALL(*mock_surface, configure(mir_window_attrib_visibility, mir_window_visibility_exposed));
 
     elements.back()->occluded();
     elements2.back()->rendered();
+
+    elements.clear();
+    elements2.clear();
+}
+
+TEST_F(SurfaceStack, does_not_tell_surface_about_visibility_while_compositing)
+{
+    using namespace testing;
+
+    stack.register_compositor(compositor_id);
+
+    auto const mock_surface = std::make_shared<MockConfigureSurface>();
+    stack.add_surface(mock_surface, default_params.input_mode);
+
+    auto elements = stack.scene_elements_for(compositor_id);
+    ASSERT_THAT(elements.size(), Eq(1u));
+
+    EXPECT_CALL(*mock_surface, configure(_, _)).Times(0);
+    elements.back()->rendered();
+    Mock::VerifyAndClearExpectations(mock_surface.get());
+
+    EXPECT_CALL(*mock_surface, configure(mir_window_attrib_visibility, mir_window_visibility_exposed));
+    elements.clear();
+}
+
+TEST_F(SurfaceStack, tells_surface_about_visibility_only_when_it_changes)
+{
+    using namespace testing;
+
+    stack.register_compositor(compositor_id);
+
+    auto const mock_surface = std::make_shared<MockConfigureSurface>();
+    stack.add_surface(mock_surface, default_params.input_mode);
+
+    EXPECT_CALL(*mock_surface, configure(mir_window_attrib_visibility, mir_window_visibility_exposed));
+
+    for (int frame = 0; frame != 10; ++frame)
+    {
+        for (auto const& element : stack.scene_elements_for(compositor_id))
+            element->rendered();
+    }
 }
 
 TEST_F(SurfaceStack, occludes_surface_when_unregistering_all_compositors_that_rendered_it)
@@ -760,20 +805,23 @@ TEST_F(SurfaceStack, occludes_surface_when_unregistering_all_compositors_that_re
     auto const mock_surface = std::make_shared<MockConfigureSurface>();
     stack.add_surface(mock_surface, default_params.input_mode);
 
-    auto const elements = stack.scene_elements_for(compositor_id);
+    auto elements = stack.scene_elements_for(compositor_id);
     ASSERT_THAT(elements.size(), Eq(1u));
-    auto const elements2 = stack.scene_elements_for(compositor_id2);
+    auto elements2 = stack.scene_elements_for(compositor_id2);
     ASSERT_THAT(elements2.size(), Eq(1u));
-    auto const elements3 = stack.scene_elements_for(compositor_id3);
+    auto elements3 = stack.scene_elements_for(compositor_id3);
     ASSERT_THAT(elements3.size(), Eq(1u));
 
-    EXPECT_CALL(*mock_surface, configure(mir_window_attrib_visibility, mir_window_visibility_exposed))
-        .Times(2);
+    EXPECT_CALL(*mock_surface, configure(mir_window_attrib_visibility, mir_window_visibility_exposed));
 
     elements.back()->occluded();
     elements2.back()->rendered();
     elements3.back()->rendered();
 
+    elements.clear();
+    elements2.clear();
+    elements3.clear();
+
     Mock::VerifyAndClearExpectations(mock_surface.get());
 
     EXPECT_CALL(*mock_surface, configure(mir_window_attrib_visibility, mir_window_visibility_occluded));
@@ -952,6 +1000,55 @@ TEST_F(SurfaceStack, for_each_enumerates_all_input_surfaces)
     EXPECT_THAT(num_exposed_surfaces, Eq(3));
 }
 
+TEST_F(SurfaceStack, for_each_callback_can_modify_the_stack)
+{
+    using namespace ::testing;
+
+    stack.add_surface(stub_surface1, default_params.input_mode);
+    stack.add_surface(stub_surface2, default_params.input_mode);
+
+    int num_surfaces = 0;
+    stack.for_each(
+        [&](std::shared_ptr<mi::Surface> const&)
+        {
+            ++num_surfaces;
+            stack.raise(stub_surface1);
+            stack.add_surface(stub_surface3, default_params.input_mode);
+            stack.remove_surface(stub_surface3);
+        });
+
+    EXPECT_THAT(num_surfaces, Eq(2));
+    EXPECT_THAT(
+        stack.scene_elements_for(compositor_id),
+        ElementsAre(
+            SceneElementForStream(stub_buffer_stream2),
+            SceneElementForStream(stub_buffer_stream1)));
+}
+
+TEST_F(SurfaceStack, scene_elements_are_consistent_while_surfaces_are_raised_concurrently)
+{
+    using namespace ::testing;
+
+    stack.add_surface(stub_surface1, default_params.input_mode);
+    stack.add_surface(stub_surface2, default_params.input_mode);
+    stack.add_surface(stub_surface3, default_params.input_mode);
+
+    std::atomic<bool> done{false};
+    auto raiser = std::async(
+        std::launch::async,
+        [&]
+        {
+            for (int i = 0; i != 1000; ++i)
+                stack.raise(i % 2 ? stub_surface1 : stub_surface2);
+            done = true;
+        });
+
+    while (!done)
+        ASSERT_THAT(stack.scene_elements_for(compositor_id).size(), Eq(3u));
+
+    raiser.get();
+}
+
 using namespace ::testing;
 
 TEST_F(SurfaceStack, returns_top_surface_under_cursor)
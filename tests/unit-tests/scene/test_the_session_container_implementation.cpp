@@ -85,3 +85,47 @@ TEST(SessionContainer, invalid_session_throw_behavior)
         container.remove_session(std::make_shared<mtd::StubSession>());
     }, std::logic_error);
 }
+
+TEST(SessionContainer, predecessor_of)
+{
+    using namespace ::testing;
+    ms::SessionContainer container;
+
+    auto session1 = std::make_shared<mtd::StubSession>();
+    auto session2 = std::make_shared<mtd::StubSession>();
+    auto session3 = std::make_shared<mtd::StubSession>();
+
+    container.insert_session(session1);
+    container.insert_session(session2);
+    container.insert_session(session3);
+
+    EXPECT_EQ(session3, container.predecessor_of(session1));
+    EXPECT_EQ(session1, container.predecessor_of(session2));
+    EXPECT_EQ(session2, container.predecessor_of(session3));
+
+    // Predecessor of no session is the first session.
+    EXPECT_EQ(session1, container.predecessor_of(std::shared_ptr<ms::Session>()));
+}
+
+TEST(SessionContainer, order_is_kept_when_sessions_are_removed)
+{
+    using namespace ::testing;
+    ms::SessionContainer container;
+
+    std::vector<std::shared_ptr<ms::Session>> sessions;
+    for (int i = 0; i != 5; ++i)
+    {
+        sessions.push_back(std::make_shared<mtd::StubSession>());
+        container.insert_session(sessions.back());
+    }
+
+    container.remove_session(sessions[1]);
+    container.remove_session(sessions[3]);
+
+    EXPECT_EQ(sessions[2], container.successor_of(sessions[0]));
+    EXPECT_EQ(sessions[4], container.successor_of(sessions[2]));
+    EXPECT_EQ(sessions[0], container.successor_of(sessions[4]));
+
+    EXPECT_THROW({ container.successor_of(sessions[1]); }, std::logic_error);
+    EXPECT_THROW({ container.remove_session(sessions[3]); }, std::logic_error);
+}
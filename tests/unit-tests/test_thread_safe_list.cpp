@@ -157,3 +157,91 @@ TEST_F(ThreadSafeListTest, clears_all_elements)
 
     EXPECT_THAT(elements_seen, Eq(0));
 }
+
+TEST_F(ThreadSafeListTest, can_add_element_while_iterating)
+{
+    using namespace testing;
+
+    list.add(element1);
+
+    list.for_each(
+        [&] (Element const& element)
+        {
+            if (element == element1)
+                list.add(element2);
+        });
+
+    std::vector<Element> elements_seen;
+
+    list.for_each(
+        [&] (Element const& element)
+        {
+            elements_seen.push_back(element);
+        });
+
+    EXPECT_THAT(elements_seen, ElementsAre(element1, element2));
+}
+
+TEST_F(ThreadSafeListTest, remove_waits_for_element_to_be_finished_with_in_different_thread)
+{
+    using namespace testing;
+
+    list.add(element1);
+
+    mir::test::Signal element_in_use;
+    std::atomic<bool> element_finished_with{false};
+
+    std::thread t{
+        [&]
+        {
+            list.for_each(
+                [&] (Element const&)
+                {
+                    element_in_use.raise();
+                    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+                    element_finished_with = true;
+                });
+        }};
+
+    element_in_use.wait_for(std::chrono::seconds{3});
+    list.remove(element1);
+
+    EXPECT_TRUE(element_finished_with);
+
+    t.join();
+}
+
+TEST_F(ThreadSafeListTest, iteration_is_not_blocked_by_element_in_use_in_different_thread)
+{
+    using namespace testing;
+
+    list.add(element1);
+    list.add(element2);
+
+    mir::test::Signal element_in_use;
+    mir::test::Signal iteration_finished;
+
+    std::thread t{
+        [&]
+        {
+            list.for_each(
+                [&] (Element const& element)
+                {
+                    if (element == element1)
+                    {
+                        element_in_use.raise();
+                        iteration_finished.wait_for(std::chrono::seconds{3});
+                    }
+                });
+        }};
+
+    element_in_use.wait_for(std::chrono::seconds{3});
+
+    int elements_seen = 0;
+    list.for_each([&] (Element const&) { ++elements_seen; });
+    iteration_finished.raise();
+
+    t.join();
+
+    EXPECT_THAT(elements_seen, Eq(2));
+}
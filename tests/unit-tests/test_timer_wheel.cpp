@@ -0,0 +1,234 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/time/timer_wheel.h"
+#include "mir/time/alarm.h"
+
+#include "mir/test/doubles/advanceable_clock.h"
+#include "mir/test/doubles/mock_event_handler_register.h"
+#include "mir/test/doubles/mock_lockable_callback.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mt = mir::time;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+using namespace std::literals::chrono_literals;
+
+namespace
+{
+struct TimerWheelTest : Test
+{
+    TimerWheelTest()
+    {
+        EXPECT_CALL(*event_register, register_fd_handler(_, _, _))
+            .WillOnce(SaveArg<2>(&timer_fd_handler));
+        EXPECT_CALL(*event_register, unregister_fd_handler(_)).Times(AnyNumber());
+
+        wheel = std::make_unique<mt::TimerWheel>(event_register, clock);
+    }
+
+    void advance_by(mt::Duration step)
+    {
+        clock->advance_by(step);
+        timer_fd_handler(-1);
+    }
+
+    std::shared_ptr<mtd::AdvanceableClock> const clock{std::make_shared<mtd::AdvanceableClock>()};
+    std::shared_ptr<NiceMock<mtd::MockEventHandlerRegister>> const event_register{
+        std::make_shared<NiceMock<mtd::MockEventHandlerRegister>>()};
+    std::function<void(int)> timer_fd_handler;
+    std::unique_ptr<mt::TimerWheel> wheel;
+};
+}
+
+TEST_F(TimerWheelTest, alarm_starts_in_cancelled_state)
+{
+    auto const alarm = wheel->create_alarm([]{});
+
+    EXPECT_THAT(alarm->state(), Eq(mt::Alarm::cancelled));
+}
+
+TEST_F(TimerWheelTest, alarm_fires_with_correct_delay)
+{
+    int call_count{0};
+    auto const alarm = wheel->create_alarm([&call_count]{ ++call_count; });
+    alarm->reschedule_in(50ms);
+
+    advance_by(49ms);
+    EXPECT_THAT(alarm->state(), Eq(mt::Alarm::pending));
+    EXPECT_THAT(call_count, Eq(0));
+
+    advance_by(1ms);
+    EXPECT_THAT(alarm->state(), Eq(mt::Alarm::triggered));
+    EXPECT_THAT(call_count, Eq(1));
+}
+
+TEST_F(TimerWheelTest, alarm_beyond_first_level_fires_on_time)
+{
+    for (auto const delay : {100ms, 5000ms, 300000ms, 20000000ms})
+    {
+        int call_count{0};
+        auto const alarm = wheel->create_alarm([&call_count]{ ++call_count; });
+        alarm->reschedule_in(delay);
+
+        for (auto remaining = delay - 1ms; remaining > 0ms;)
+        {
+            auto const step = std::min(remaining, delay / 7);
+            advance_by(step);
+            remaining -= step;
+        }
+
+        EXPECT_THAT(call_count, Eq(0)) << "delay: " << delay.count() << "ms";
+
+        advance_by(1ms);
+        EXPECT_THAT(call_count, Eq(1)) << "delay: " << delay.count() << "ms";
+    }
+}
+
+TEST_F(TimerWheelTest, all_due_alarms_fire_in_one_dispatch)
+{
+    int const alarm_count{500};
+    int call_count{0};
+    std::vector<std::unique_ptr<mt::Alarm>> alarms;
+
+    for (int i = 0; i != alarm_count; ++i)
+    {
+        alarms.push_back(wheel->create_alarm([&call_count]{ ++call_count; }));
+        alarms.back()->reschedule_in(std::chrono::milliseconds{1 + i % 200});
+    }
+
+    advance_by(200ms);
+
+    EXPECT_THAT(call_count, Eq(alarm_count));
+    for (auto const& alarm : alarms)
+        EXPECT_THAT(alarm->state(), Eq(mt::Alarm::triggered));
+}
+
+TEST_F(TimerWheelTest, cancelled_alarm_doesnt_fire)
+{
+    auto const alarm = wheel->create_alarm([]{ FAIL() << "Alarm handler of cancelled alarm called"; });
+    alarm->reschedule_in(100ms);
+
+    EXPECT_TRUE(alarm->cancel());
+    EXPECT_THAT(alarm->state(), Eq(mt::Alarm::cancelled));
+
+    advance_by(100ms);
+    EXPECT_THAT(alarm->state(), Eq(mt::Alarm::cancelled));
+}
+
+TEST_F(TimerWheelTest, destroyed_alarm_doesnt_fire)
+{
+    auto alarm = wheel->create_alarm([]{ FAIL() << "Alarm handler of destroyed alarm called"; });
+    alarm->reschedule_in(100ms);
+
+    alarm.reset();
+    advance_by(100ms);
+}
+
+TEST_F(TimerWheelTest, rescheduled_alarm_fires_at_new_time_only)
+{
+    int call_count{0};
+    auto const alarm = wheel->create_alarm([&call_count]{ ++call_count; });
+
+    alarm->reschedule_in(10ms);
+    EXPECT_TRUE(alarm->reschedule_in(30ms));
+
+    advance_by(20ms);
+    EXPECT_THAT(call_count, Eq(0));
+
+    advance_by(10ms);
+    EXPECT_THAT(call_count, Eq(1));
+}
+
+TEST_F(TimerWheelTest, alarm_can_reschedule_itself_from_callback)
+{
+    int call_count{0};
+    std::unique_ptr<mt::Alarm> alarm;
+    alarm = wheel->create_alarm(
+        [&]
+        {
+            if (++call_count < 3)
+                alarm->reschedule_in(10ms);
+        });
+    alarm->reschedule_in(10ms);
+
+    for (int i = 0; i != 5; ++i)
+        advance_by(10ms);
+
+    EXPECT_THAT(call_count, Eq(3));
+}
+
+TEST_F(TimerWheelTest, alarm_can_destroy_other_due_alarm_from_callback)
+{
+    std::unique_ptr<mt::Alarm> second;
+    auto const first = wheel->create_alarm([&]{ second.reset(); });
+    second = wheel->create_alarm([]{ FAIL() << "Alarm handler of destroyed alarm called"; });
+
+    first->reschedule_in(10ms);
+    second->reschedule_in(11ms);
+
+    advance_by(20ms);
+}
+
+TEST_F(TimerWheelTest, lockable_callback_is_locked_around_dispatch)
+{
+    auto const handler = new mtd::MockLockableCallback;
+    auto const alarm = wheel->create_alarm(std::unique_ptr<mir::LockableCallback>{handler});
+
+    {
+        InSequence seq;
+        EXPECT_CALL(*handler, lock());
+        EXPECT_CALL(*handler, functor());
+        EXPECT_CALL(*handler, unlock());
+    }
+
+    alarm->reschedule_in(10ms);
+    advance_by(10ms);
+}
+
+TEST_F(TimerWheelTest, alarms_still_fire_after_factory_is_destroyed)
+{
+    int call_count{0};
+    auto const alarm = wheel->create_alarm([&call_count]{ ++call_count; });
+    alarm->reschedule_in(10ms);
+
+    wheel.reset();
+    advance_by(10ms);
+
+    EXPECT_THAT(call_count, Eq(1));
+}
+
+TEST_F(TimerWheelTest, unregisters_fd_handler_once_factory_and_alarms_are_destroyed)
+{
+    auto const local_register = std::make_shared<NiceMock<mtd::MockEventHandlerRegister>>();
+    void const* owner{nullptr};
+
+    EXPECT_CALL(*local_register, register_fd_handler(_, _, _))
+        .WillOnce(SaveArg<1>(&owner));
+
+    auto local_wheel = std::make_unique<mt::TimerWheel>(local_register, clock);
+    auto alarm = local_wheel->create_alarm([]{});
+
+    EXPECT_CALL(*local_register, unregister_fd_handler(_)).Times(0);
+    local_wheel.reset();
+    Mock::VerifyAndClearExpectations(local_register.get());
+
+    EXPECT_CALL(*local_register, unregister_fd_handler(Eq(owner)));
+    alarm.reset();
+}
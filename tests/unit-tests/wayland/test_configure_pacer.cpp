@@ -0,0 +1,142 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/configure_pacer.h"
+
+#include <gtest/gtest.h>
+
+namespace mf = mir::frontend;
+
+namespace
+{
+struct ConfigurePacer : testing::Test
+{
+    /// What the toplevel does with a resize: sends it, if the pacer lets it
+    void resize()
+    {
+        if (pacer.resize_requested())
+            send_configure();
+    }
+
+    void commit()
+    {
+        if (pacer.committed())
+            send_configure();
+    }
+
+    void send_configure()
+    {
+        pacer.configure_sent(++serial);
+        ++configures_sent;
+    }
+
+    mf::ConfigurePacer pacer;
+    uint32_t serial{0};
+    int configures_sent{0};
+};
+}
+
+TEST_F(ConfigurePacer, resize_is_sent_when_nothing_is_outstanding)
+{
+    resize();
+
+    EXPECT_EQ(1, configures_sent);
+}
+
+TEST_F(ConfigurePacer, resizes_before_the_ack_are_deferred)
+{
+    resize();
+    resize();
+    resize();
+
+    EXPECT_EQ(1, configures_sent);
+}
+
+TEST_F(ConfigurePacer, deferred_resize_is_not_sent_on_the_ack)
+{
+    resize();
+    resize();
+    pacer.configure_acked(serial);
+
+    EXPECT_EQ(1, configures_sent);
+}
+
+TEST_F(ConfigurePacer, deferred_resize_is_sent_on_the_first_commit_after_the_ack)
+{
+    resize();
+    resize();
+    pacer.configure_acked(serial);
+    commit();
+
+    EXPECT_EQ(2, configures_sent);
+
+    commit();
+
+    EXPECT_EQ(2, configures_sent);
+}
+
+TEST_F(ConfigurePacer, commits_before_the_ack_dont_send_a_deferred_resize)
+{
+    resize();
+    resize();
+    commit();
+    commit();
+
+    EXPECT_EQ(1, configures_sent);
+}
+
+TEST_F(ConfigurePacer, ack_of_a_superseded_configure_leaves_the_latest_outstanding)
+{
+    send_configure();
+    auto const superseded = serial;
+    send_configure();
+    resize();
+
+    pacer.configure_acked(superseded);
+    commit();
+
+    EXPECT_EQ(2, configures_sent);
+}
+
+TEST_F(ConfigurePacer, other_configures_supersede_a_deferred_resize)
+{
+    resize();
+    resize();
+    send_configure();   // e.g. the window was activated
+    pacer.configure_acked(serial);
+    commit();
+
+    EXPECT_EQ(2, configures_sent);
+}
+
+TEST_F(ConfigurePacer, interactive_resize_sends_one_configure_per_client_frame)
+{
+    resize();
+
+    for (int frame = 0; frame != 10; ++frame)
+    {
+        // Pointer motion outpaces the client
+        resize();
+        resize();
+        resize();
+
+        commit();   // still at the old size
+        pacer.configure_acked(serial);
+        commit();   // at the acked size
+    }
+
+    EXPECT_EQ(11, configures_sent);
+}
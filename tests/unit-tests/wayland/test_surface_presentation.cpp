@@ -0,0 +1,189 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/surface_presentation.h"
+
+#include "mir/executor.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <deque>
+#include <vector>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace mt = mir::time;
+
+using namespace testing;
+using namespace std::literals::chrono_literals;
+
+namespace
+{
+struct QueueingExecutor : mir::Executor
+{
+    void spawn(std::function<void()>&& work) override
+    {
+        queued.push_back(std::move(work));
+    }
+
+    void run_queued()
+    {
+        while (!queued.empty())
+        {
+            auto const work = std::move(queued.front());
+            queued.pop_front();
+            work();
+        }
+    }
+
+    std::deque<std::function<void()>> queued;
+};
+
+struct FakePresentationClock : mg::PresentationClock
+{
+    void on_next_presentation(std::function<void(Presentation const&)> const& handler) override
+    {
+        waiting.push_back(handler);
+    }
+
+    void flip(std::chrono::nanoseconds ust)
+    {
+        auto handlers = std::move(waiting);
+        waiting.clear();
+        for (auto const& handler : handlers)
+            handler(Presentation{mg::Frame{1, mt::PosixTimestamp{CLOCK_MONOTONIC, ust}}, 16ms, true});
+    }
+
+    std::vector<std::function<void(Presentation const&)>> waiting;
+};
+
+struct SurfacePresentation : Test
+{
+    struct Feedback
+    {
+        int presented{0};
+        int discarded{0};
+        std::chrono::nanoseconds presented_at{0};
+    };
+
+    auto commit(Feedback& feedback) -> std::function<void()>
+    {
+        return presentation->buffer_committed(
+            [&feedback](mf::SurfacePresentation::Presentation const& presented)
+            {
+                ++feedback.presented;
+                feedback.presented_at = presented.frame.ust.nanoseconds;
+            },
+            [&feedback]() { ++feedback.discarded; });
+    }
+
+    std::shared_ptr<QueueingExecutor> const executor{std::make_shared<QueueingExecutor>()};
+    std::shared_ptr<FakePresentationClock> const clock{std::make_shared<FakePresentationClock>()};
+    std::vector<std::chrono::nanoseconds> frame_callbacks;
+    std::unique_ptr<mf::SurfacePresentation> presentation{std::make_unique<mf::SurfacePresentation>(
+        executor, clock, [this](std::chrono::nanoseconds timestamp) { frame_callbacks.push_back(timestamp); })};
+};
+}
+
+TEST_F(SurfacePresentation, consumed_buffer_is_presented_on_the_wayland_thread_at_next_flip)
+{
+    Feedback feedback;
+    auto const consumed = commit(feedback);
+
+    consumed();
+    executor->run_queued();
+    EXPECT_THAT(feedback.presented, Eq(0));
+    EXPECT_THAT(frame_callbacks, IsEmpty());
+
+    clock->flip(1016ms);
+    EXPECT_THAT(feedback.presented, Eq(0));
+
+    executor->run_queued();
+    EXPECT_THAT(feedback.presented, Eq(1));
+    EXPECT_THAT(feedback.presented_at, Eq(1016ms));
+    EXPECT_THAT(feedback.discarded, Eq(0));
+    EXPECT_THAT(frame_callbacks, ElementsAre(1016ms));
+}
+
+TEST_F(SurfacePresentation, buffer_superseded_before_consumption_is_discarded)
+{
+    Feedback first, second;
+    auto const first_consumed = commit(first);
+    presentation->discard_unconsumed();
+    auto const second_consumed = commit(second);
+
+    EXPECT_THAT(first.discarded, Eq(1));
+
+    second_consumed();
+    clock->flip(1016ms);
+    executor->run_queued();
+
+    EXPECT_THAT(first.presented, Eq(0));
+    EXPECT_THAT(second.presented, Eq(1));
+    EXPECT_THAT(second.discarded, Eq(0));
+}
+
+TEST_F(SurfacePresentation, consumed_buffer_is_not_discarded_when_superseded)
+{
+    Feedback feedback;
+    auto const consumed = commit(feedback);
+
+    consumed();
+    presentation->discard_unconsumed();
+    clock->flip(1016ms);
+    executor->run_queued();
+
+    EXPECT_THAT(feedback.discarded, Eq(0));
+    EXPECT_THAT(feedback.presented, Eq(1));
+}
+
+TEST_F(SurfacePresentation, buffer_consumed_more_than_once_is_presented_once)
+{
+    Feedback feedback;
+    auto const consumed = commit(feedback);
+
+    consumed();
+    consumed();
+    clock->flip(1016ms);
+    executor->run_queued();
+
+    EXPECT_THAT(feedback.presented, Eq(1));
+}
+
+TEST_F(SurfacePresentation, destruction_discards_unconsumed_buffer)
+{
+    Feedback feedback;
+    commit(feedback);
+
+    presentation.reset();
+
+    EXPECT_THAT(feedback.discarded, Eq(1));
+}
+
+TEST_F(SurfacePresentation, no_frame_callbacks_are_sent_after_destruction)
+{
+    Feedback feedback;
+    auto const consumed = commit(feedback);
+    consumed();
+
+    presentation.reset();
+    clock->flip(1016ms);
+    executor->run_queued();
+
+    EXPECT_THAT(feedback.presented, Eq(1));
+    EXPECT_THAT(frame_callbacks, IsEmpty());
+}
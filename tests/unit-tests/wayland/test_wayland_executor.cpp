@@ -159,3 +159,31 @@ TEST_F(WaylandExecutorTest, spawning_is_threadsafe)
 
     EXPECT_THAT(counter, Eq(thread_count));
 }
+
+TEST_F(WaylandExecutorTest, work_spawned_from_another_thread_runs_in_order_in_a_single_dispatch)
+{
+    mf::WaylandExecutor executor{the_event_loop};
+
+    int const task_count{1000};
+    std::vector<int> executed;
+
+    {
+        mt::AutoJoinThread spawner{
+            [&executor, &executed]()
+            {
+                for (auto i = 0; i < task_count; ++i)
+                {
+                    executor.spawn([&executed, i]() { executed.push_back(i); });
+                }
+            }};
+    }
+
+    wl_event_loop_dispatch(the_event_loop, 0);
+
+    ASSERT_THAT(executed.size(), Eq(task_count));
+    for (auto i = 0; i < task_count; ++i)
+    {
+        EXPECT_THAT(executed[i], Eq(i));
+    }
+    EXPECT_THAT(event_loop_fd, Not(FdIsReadable()));
+}